@@ -2,23 +2,57 @@
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include "bank.h"
+#include "autosaver.h"
+#include "bank_worker.h"
 #include "json_persistence.h"
+#include "journal_persistence.h"
+#include "transaction_history.h"
 #include "bank_bridge.h"
+#include "account_list_model.h"
+#include "metrics_exporter.h"
 
 int main(int argc, char *argv[])
+try
 {
     QGuiApplication app(argc, argv);
 
-    // Initialize bank system
-    JsonPersistence persistence("accounts.json");
-    Bank bank(persistence);
+    // Prometheus-format metrics: bank_metrics.prom is refreshed every few
+    // seconds, and bank_metrics.sock answers each connection with a dump
+    MetricsExportOptions metricsOptions;
+    metricsOptions.textFile = "bank_metrics.prom";
+    metricsOptions.socketPath = "bank_metrics.sock";
+    MetricsExporter metricsExporter(metricsOptions);
+
+    // Initialize bank system: JSON snapshot plus a write-ahead journal so
+    // mutations survive a crash between saves. Both are locked for as long
+    // as the window is open, so a second writer fails at startup
+    JsonPersistence snapshot("accounts.json");
+    JournalPersistence persistence(snapshot, "accounts.journal");
+    // Statements: the newest million balance changes stay in memory, older
+    // ones move to accounts.history
+    HistoryOptions historyOptions;
+    historyOptions.spillFile = "accounts.history";
+    TransactionHistory history(historyOptions);
+    // Accounts are read from the snapshot's index cache as they are
+    // touched, so the window comes up without loading the whole book
+    BankOptions bankOptions;
+    bankOptions.lazyLoad = true;
+    Bank bank(persistence, bankOptions);
+    bank.setHistory(&history);
+
+    // From here on the bank is only touched from the worker thread
+    BankWorker worker(bank);
+    // Changes reach the journal in the background every few seconds
+    AutoSaver autosaver(worker, persistence);
 
     // Create bridge and expose to QML
-    BankBridge bridge(bank);
+    BankBridge bridge(worker, &autosaver);
+    AccountListModel accountModel(worker);
 
     // Setup QML engine
     QQmlApplicationEngine engine;
     engine.rootContext()->setContextProperty("bankBridge", &bridge);
+    engine.rootContext()->setContextProperty("accountModel", &accountModel);
 
     const QUrl url(QStringLiteral("qrc:/app/main.qml"));
     engine.load(url);
@@ -28,8 +62,15 @@ int main(int argc, char *argv[])
 
     int result = app.exec();
 
-    // Save data on exit
-    bank.save();
+    // Save data on exit, after anything the UI still had queued
+    autosaver.saveNow();
+    autosaver.flush();
 
     return result;
-}
\ No newline at end of file
+}
+catch (const std::exception &ex)
+{
+    // Most likely another instance or a bank_daemon holds the book
+    qCritical("%s", ex.what());
+    return 1;
+}
@@ -54,6 +54,12 @@ ApplicationWindow {
             TabButton {
                 text: "5. All Accounts"
             }
+            TabButton {
+                text: "6. Diagnostics"
+            }
+            TabButton {
+                text: "7. Posting"
+            }
         }
 
         // Content area
@@ -158,16 +164,12 @@ ApplicationWindow {
                         
                         onClicked: {
                             if (createPersonNameField.text.length > 0 && createCardIdField.text.length >= 14) {
-                                var accountId = bankBridge.createAccount(
+                                // The new ID arrives through onAccountCreated
+                                bankBridge.createAccount(
                                     createPersonNameField.text,
                                     createCardIdField.text,
                                     parseFloat(initialBalanceField.text) || 0
                                 )
-                                if (accountId > 0) {
-                                    statusMessage.text = "✓ Account created successfully!\nThe Account ID is: " + accountId
-                                } else {
-                                    statusMessage.text = "❌ Failed to create account"
-                                }
                                 createPersonNameField.text = ""
                                 createCardIdField.text = ""
                                 initialBalanceField.text = ""
@@ -262,7 +264,45 @@ ApplicationWindow {
                                 Text { id: detailsLastOperation; text: "-"; Layout.fillWidth: true; wrapMode: Text.WordWrap }
                             }
 
-                            Item { Layout.fillHeight: true }
+                            Text { text: "Transaction History"; font.pixelSize: 14; font.bold: true }
+                            Rectangle { Layout.fillWidth: true; Layout.preferredHeight: 1; color: "#ddd" }
+
+                            ListView {
+                                id: historyList
+                                Layout.fillWidth: true
+                                Layout.fillHeight: true
+                                clip: true
+                                model: ListModel { id: historyModel }
+
+                                property int accountId: 0
+                                property real nextCursor: 0
+
+                                delegate: RowLayout {
+                                    width: historyList.width
+                                    Text { text: model.time; Layout.preferredWidth: 160; color: "#666" }
+                                    Text { text: model.type; Layout.preferredWidth: 120 }
+                                    Text {
+                                        text: (model.amount < 0 ? "- $ " : "+ $ ") + Math.abs(model.amount).toFixed(2)
+                                        Layout.fillWidth: true
+                                        horizontalAlignment: Text.AlignRight
+                                        color: model.amount < 0 ? "#f44336" : "#4CAF50"
+                                    }
+                                }
+
+                                Text {
+                                    anchors.centerIn: parent
+                                    visible: historyModel.count === 0
+                                    text: "No transactions"
+                                    color: "#999"
+                                }
+                            }
+
+                            Button {
+                                text: "Load Older"
+                                visible: historyList.nextCursor > 0
+                                Layout.preferredWidth: 150
+                                onClicked: bankBridge.getHistory(historyList.accountId, 20, historyList.nextCursor)
+                            }
                         }
                     }
                 }
@@ -322,6 +362,17 @@ ApplicationWindow {
                         }
                     }
 
+                    RowLayout {
+                        spacing: 10
+                        Text { text: "Transfer To:"; Layout.preferredWidth: 120 }
+                        TextField {
+                            id: transferTargetField
+                            Layout.fillWidth: true
+                            placeholderText: "Destination account ID (for transfers)"
+                            background: Rectangle { border.color: "#ccc"; border.width: 1; radius: 3 }
+                        }
+                    }
+
                     RowLayout {
                         spacing: 10
                         Layout.fillWidth: true
@@ -355,7 +406,6 @@ ApplicationWindow {
                                 if (accountId > 0 && parseFloat(transactionAmountField.text) > 0) {
                                     bankBridge.deposit(accountId, parseFloat(transactionAmountField.text))
                                     transactionAmountField.text = ""
-                                    loadAccountBalance()
                                 } else {
                                     statusMessage.text = "❌ Please enter valid account ID and amount"
                                 }
@@ -374,13 +424,31 @@ ApplicationWindow {
                                 if (accountId > 0 && parseFloat(transactionAmountField.text) > 0) {
                                     bankBridge.withdraw(accountId, parseFloat(transactionAmountField.text))
                                     transactionAmountField.text = ""
-                                    loadAccountBalance()
                                 } else {
                                     statusMessage.text = "❌ Please enter valid account ID and amount"
                                 }
                             }
                         }
 
+                        Button {
+                            text: "Transfer"
+                            Layout.preferredWidth: 120
+                            Layout.preferredHeight: 40
+                            background: Rectangle { color: "#9c27b0"; radius: 3 }
+                            contentItem: Text { text: parent.text; color: "white"; horizontalAlignment: Text.AlignHCenter; verticalAlignment: Text.AlignVCenter }
+
+                            onClicked: {
+                                var accountId = parseInt(manageAccountIdField.text)
+                                var targetId = parseInt(transferTargetField.text)
+                                if (accountId > 0 && targetId > 0 && parseFloat(transactionAmountField.text) > 0) {
+                                    bankBridge.transfer(accountId, targetId, parseFloat(transactionAmountField.text))
+                                    transactionAmountField.text = ""
+                                } else {
+                                    statusMessage.text = "❌ Please enter valid account IDs and amount"
+                                }
+                            }
+                        }
+
                         Button {
                             text: "Delete"
                             Layout.preferredWidth: 120
@@ -431,6 +499,42 @@ ApplicationWindow {
                             Layout.fillWidth: true
                             placeholderText: "Enter person's name"
                             background: Rectangle { border.color: "#ccc"; border.width: 1; radius: 3 }
+                            onTextChanged: bankBridge.suggestOwners(text)
+                        }
+                    }
+
+                    Flow {
+                        Layout.fillWidth: true
+                        spacing: 6
+                        visible: ownerSuggestions.count > 0
+
+                        Repeater {
+                            id: ownerSuggestions
+                            model: []
+
+                            delegate: Rectangle {
+                                width: suggestionText.implicitWidth + 16
+                                height: 26
+                                radius: 13
+                                color: suggestionArea.containsMouse ? "#BBDEFB" : "#E3F2FD"
+
+                                Text {
+                                    id: suggestionText
+                                    anchors.centerIn: parent
+                                    text: modelData
+                                    font.pixelSize: 12
+                                }
+
+                                MouseArea {
+                                    id: suggestionArea
+                                    anchors.fill: parent
+                                    hoverEnabled: true
+                                    onClicked: {
+                                        searchPersonNameField.text = modelData
+                                        bankBridge.getPersonAccounts(modelData)
+                                    }
+                                }
+                            }
                         }
                     }
 
@@ -486,9 +590,28 @@ ApplicationWindow {
 
             // ==================== TAB 5: ALL ACCOUNTS ====================
             Rectangle {
+                id: allAccountsTab
                 color: "white"
                 radius: 5
 
+                property var summary: null
+
+                function refreshSummary() {
+                    if (tabBar.currentIndex === 4)
+                        bankBridge.getBalanceSummary(100.0, 8)
+                }
+
+                Connections {
+                    target: tabBar
+                    function onCurrentIndexChanged() { allAccountsTab.refreshSummary() }
+                }
+
+                Connections {
+                    target: bankBridge
+                    function onAccountsUpdated() { allAccountsTab.refreshSummary() }
+                    function onBalanceSummaryRetrieved(summary) { allAccountsTab.summary = summary }
+                }
+
                 ColumnLayout {
                     anchors.fill: parent
                     anchors.margins: 20
@@ -507,8 +630,84 @@ ApplicationWindow {
                         background: Rectangle { color: "#2196F3"; radius: 3 }
                         contentItem: Text { text: parent.text; color: "white"; horizontalAlignment: Text.AlignHCenter; verticalAlignment: Text.AlignVCenter }
 
+                        // The list follows the bank live; this only rebuilds it.
                         onClicked: {
-                            bankBridge.getAllAccountDetails()
+                            accountModel.reload()
+                            allAccountsTab.refreshSummary()
+                        }
+                    }
+
+                    // Balance summary: aggregates only, no per-account text
+                    Rectangle {
+                        Layout.fillWidth: true
+                        Layout.preferredHeight: 150
+                        color: "#f9f9f9"
+                        border.color: "#ddd"
+                        border.width: 1
+                        radius: 3
+                        visible: allAccountsTab.summary !== null
+
+                        ColumnLayout {
+                            anchors.fill: parent
+                            anchors.margins: 15
+                            spacing: 6
+
+                            Text { text: "Balance Summary"; font.pixelSize: 14; font.bold: true }
+
+                            Text {
+                                property var s: allAccountsTab.summary
+                                text: s ? "Total: $ " + s.total.toFixed(2)
+                                          + "    Average: $ " + s.average.toFixed(2)
+                                          + "    Min: $ " + s.min.toFixed(2)
+                                          + "    Max: $ " + s.max.toFixed(2) : ""
+                                font.family: "Courier"
+                                font.pixelSize: 11
+                            }
+
+                            Text {
+                                property var s: allAccountsTab.summary
+                                text: s ? "Below $ " + s.lowBalance.toFixed(2) + ": " + s.belowLowBalance
+                                          + "    Overdrawn: " + s.negative : ""
+                                font.family: "Courier"
+                                font.pixelSize: 11
+                            }
+
+                            // Histogram, one bar per bucket scaled to the largest
+                            RowLayout {
+                                Layout.fillWidth: true
+                                Layout.fillHeight: true
+                                spacing: 4
+
+                                Repeater {
+                                    id: histogramBars
+                                    model: allAccountsTab.summary ? allAccountsTab.summary.histogram : []
+
+                                    property int peak: {
+                                        var most = 1
+                                        for (var i = 0; i < count; ++i)
+                                            most = Math.max(most, model[i].count)
+                                        return most
+                                    }
+
+                                    delegate: Item {
+                                        Layout.fillWidth: true
+                                        Layout.fillHeight: true
+
+                                        Rectangle {
+                                            anchors.bottom: parent.bottom
+                                            width: parent.width
+                                            height: parent.height * modelData.count / histogramBars.peak
+                                            color: "#2196F3"
+                                            radius: 2
+
+                                            ToolTip.visible: barHover.hovered
+                                            ToolTip.text: "$ " + modelData.from.toFixed(2) + " to $ "
+                                                          + modelData.to.toFixed(2) + ": " + modelData.count
+                                            HoverHandler { id: barHover }
+                                        }
+                                    }
+                                }
+                            }
                         }
                     }
 
@@ -525,26 +724,288 @@ ApplicationWindow {
                             anchors.margins: 15
                             spacing: 10
 
-                            Text { text: "All Accounts in System"; font.pixelSize: 14; font.bold: true }
+                            Text { text: "All Accounts in System (" + accountModel.total + ")"; font.pixelSize: 14; font.bold: true }
                             Rectangle { Layout.fillWidth: true; Layout.preferredHeight: 1; color: "#ddd" }
 
-                            ScrollView {
+                            Text {
+                                visible: accountModel.total === 0
+                                text: "No accounts in system"
+                                font.pixelSize: 11
+                            }
+
+                            ListView {
+                                id: allAccountsList
                                 Layout.fillWidth: true
                                 Layout.fillHeight: true
-
-                                TextArea {
-                                    id: allAccountsDisplay
-                                    readOnly: true
-                                    wrapMode: TextArea.Wrap
-                                    text: "Click 'Refresh All Accounts' to load data"
-                                    font.family: "Courier"
-                                    font.pixelSize: 11
+                                clip: true
+                                model: accountModel
+                                spacing: 4
+                                ScrollBar.vertical: ScrollBar {}
+
+                                delegate: Rectangle {
+                                    width: allAccountsList.width
+                                    height: 58
+                                    radius: 3
+                                    color: index % 2 === 0 ? "white" : "#f1f1f1"
+
+                                    Column {
+                                        anchors.fill: parent
+                                        anchors.margins: 6
+                                        spacing: 2
+
+                                        Text {
+                                            text: "Account ID: " + accountId + "    Owner: " + owner + "    Balance: $ " + balanceText
+                                            font.family: "Courier"
+                                            font.pixelSize: 11
+                                            font.bold: true
+                                        }
+                                        Text {
+                                            text: "Created: " + creationTime
+                                            font.family: "Courier"
+                                            font.pixelSize: 11
+                                        }
+                                        Text {
+                                            text: "Last Operation: " + lastOperationType + " (" + lastOperationTime + ")"
+                                            font.family: "Courier"
+                                            font.pixelSize: 11
+                                        }
+                                    }
                                 }
                             }
                         }
                     }
                 }
             }
+
+            // ==================== TAB 6: DIAGNOSTICS ====================
+            Rectangle {
+                id: diagnosticsTab
+                color: "white"
+                radius: 5
+
+                property var counters: ({})
+                property var timers: []
+                property bool metricsEnabled: true
+                property int autosaveFailures: 0
+                property string autosaveError: ""
+
+                // Only polls while the tab is showing
+                Timer {
+                    interval: 1000
+                    repeat: true
+                    triggeredOnStart: true
+                    running: tabBar.currentIndex === 5
+                    onTriggered: bankBridge.getMetrics()
+                }
+
+                Connections {
+                    target: bankBridge
+                    function onMetricsRetrieved(metrics) {
+                        diagnosticsTab.metricsEnabled = metrics.enabled
+                        diagnosticsTab.counters = metrics.counters
+                        diagnosticsTab.timers = metrics.timers
+                        diagnosticsTab.autosaveFailures = metrics.autosaveFailures || 0
+                        diagnosticsTab.autosaveError = metrics.autosaveError || ""
+                    }
+                }
+
+                ColumnLayout {
+                    anchors.fill: parent
+                    anchors.margins: 20
+                    spacing: 15
+
+                    Text {
+                        text: "Diagnostics"
+                        font.pixelSize: 20
+                        font.bold: true
+                    }
+
+                    Text {
+                        visible: !diagnosticsTab.metricsEnabled
+                        text: "Metrics are compiled out of this build (ENABLE_METRICS=OFF)"
+                        font.pixelSize: 12
+                        color: "#856404"
+                    }
+
+                    Text {
+                        visible: diagnosticsTab.autosaveFailures > 0
+                        text: "Autosave failed " + diagnosticsTab.autosaveFailures + " time(s); last error: "
+                              + diagnosticsTab.autosaveError
+                        font.pixelSize: 12
+                        color: "#721c24"
+                    }
+
+                    Text { text: "Operations"; font.pixelSize: 14; font.bold: true }
+
+                    GridLayout {
+                        columns: 4
+                        columnSpacing: 30
+                        rowSpacing: 4
+
+                        Repeater {
+                            model: Object.keys(diagnosticsTab.counters)
+                            delegate: Text {
+                                text: modelData + ": " + diagnosticsTab.counters[modelData]
+                                font.family: "Courier"
+                                font.pixelSize: 11
+                            }
+                        }
+                    }
+
+                    Rectangle { Layout.fillWidth: true; Layout.preferredHeight: 1; color: "#ddd" }
+
+                    Text { text: "Latency (microseconds)"; font.pixelSize: 14; font.bold: true }
+
+                    Text {
+                        text: "operation           count        mean         p50         p99         max"
+                        font.family: "Courier"
+                        font.pixelSize: 11
+                        font.bold: true
+                    }
+
+                    Repeater {
+                        model: diagnosticsTab.timers
+                        delegate: Text {
+                            function column(value, width) {
+                                var text = String(value)
+                                while (text.length < width)
+                                    text = " " + text
+                                return text
+                            }
+                            text: (modelData.name + "                    ").substring(0, 16)
+                                  + column(modelData.count, 9)
+                                  + column(modelData.meanUs.toFixed(2), 12)
+                                  + column(modelData.p50Us.toFixed(2), 12)
+                                  + column(modelData.p99Us.toFixed(2), 12)
+                                  + column(modelData.maxUs.toFixed(2), 12)
+                            font.family: "Courier"
+                            font.pixelSize: 11
+                        }
+                    }
+
+                    Item { Layout.fillHeight: true }
+                }
+            }
+
+            // ==================== TAB 7: POSTING ====================
+            Rectangle {
+                id: postingTab
+                color: "white"
+                radius: 5
+
+                property bool running: false
+                property int processed: 0
+                property int total: 0
+                property var report: null
+
+                Connections {
+                    target: bankBridge
+                    function onPostingProgress(processed, total) {
+                        postingTab.processed = processed
+                        postingTab.total = total
+                    }
+                    function onPostingFinished(report) {
+                        postingTab.running = false
+                        postingTab.report = report
+                    }
+                    function onError(message) {
+                        postingTab.running = false
+                    }
+                }
+
+                ColumnLayout {
+                    anchors.fill: parent
+                    anchors.margins: 20
+                    spacing: 15
+
+                    Text {
+                        text: "Interest and Fee Posting"
+                        font.pixelSize: 20
+                        font.bold: true
+                    }
+
+                    Text {
+                        text: "One tier per line: minBalance,maxBalance,ratePercent,fee (leave a bound empty for no limit). The first matching tier applies."
+                        font.pixelSize: 12
+                        color: "#555"
+                        wrapMode: Text.WordWrap
+                        Layout.fillWidth: true
+                    }
+
+                    Rectangle {
+                        Layout.fillWidth: true
+                        Layout.preferredHeight: 140
+                        color: "#f9f9f9"
+                        border.color: "#ddd"
+                        border.width: 1
+                        radius: 3
+
+                        ScrollView {
+                            anchors.fill: parent
+                            anchors.margins: 5
+
+                            TextArea {
+                                id: postingScheduleField
+                                font.family: "Courier"
+                                font.pixelSize: 12
+                                text: "# min,max,rate%,fee\n,0,1.5,0\n0,1000,0.10,2.00\n1000,,0.25,0"
+                            }
+                        }
+                    }
+
+                    RowLayout {
+                        spacing: 10
+
+                        Button {
+                            text: postingTab.report && !postingTab.report.complete ? "Resume Posting" : "Run Posting"
+                            enabled: !postingTab.running
+                            Layout.preferredWidth: 160
+                            Layout.preferredHeight: 40
+                            background: Rectangle { color: parent.enabled ? "#4CAF50" : "#9E9E9E"; radius: 3 }
+                            contentItem: Text { text: parent.text; color: "white"; horizontalAlignment: Text.AlignHCenter; verticalAlignment: Text.AlignVCenter }
+
+                            onClicked: {
+                                postingTab.running = true
+                                postingTab.processed = 0
+                                bankBridge.postInterestAndFees(postingScheduleField.text)
+                            }
+                        }
+
+                        Button {
+                            text: "Cancel"
+                            enabled: postingTab.running
+                            Layout.preferredWidth: 100
+                            Layout.preferredHeight: 40
+                            background: Rectangle { color: parent.enabled ? "#f44336" : "#9E9E9E"; radius: 3 }
+                            contentItem: Text { text: parent.text; color: "white"; horizontalAlignment: Text.AlignHCenter; verticalAlignment: Text.AlignVCenter }
+
+                            onClicked: bankBridge.cancelPosting()
+                        }
+                    }
+
+                    ProgressBar {
+                        Layout.fillWidth: true
+                        visible: postingTab.running || postingTab.total > 0
+                        from: 0
+                        to: Math.max(postingTab.total, 1)
+                        value: postingTab.processed
+                    }
+
+                    Text {
+                        property var r: postingTab.report
+                        visible: r !== null
+                        text: r ? (r.complete ? "Posting complete" : "Posting stopped; run again to resume") + "\n"
+                                  + "Posted: " + r.posted + "    Unchanged: " + r.unchanged
+                                  + "    Skipped: " + r.skipped + "    Failed: " + r.failed + "\n"
+                                  + "Interest: $ " + r.interest.toFixed(2) + "    Fees: $ " + r.fees.toFixed(2)
+                                  + "    Waived: $ " + r.waived.toFixed(2) : ""
+                        font.family: "Courier"
+                        font.pixelSize: 11
+                    }
+
+                    Item { Layout.fillHeight: true }
+                }
+            }
         }
 
         // Status message
@@ -590,8 +1051,8 @@ ApplicationWindow {
                 }
 
                 onClicked: {
+                    statusMessage.text = "Saving..."
                     bankBridge.saveData()
-                    statusMessage.text = "Data saved successfully!"
                 }
             }
 
@@ -618,14 +1079,7 @@ ApplicationWindow {
     function loadAccountBalance() {
         var accountId = manageAccountIdField.text
         if (accountId.length > 0) {
-            var account = bankBridge.getAccount(accountId)
-            if (account && account.accountId) {
-                manageBalanceDisplay.text = "$ " + account.balance.toFixed(2)
-                statusMessage.text = ""
-            } else {
-                statusMessage.text = "❌ Account not found"
-                manageBalanceDisplay.text = "$ 0.00"
-            }
+            bankBridge.getAccount(parseInt(accountId))
         }
     }
 
@@ -636,11 +1090,30 @@ ApplicationWindow {
             statusMessage.text = "❌ Error: " + message
         }
 
-        function onAccountCreated(info) {
-            statusMessage.text = "✓ Account created: " + info
+        function onAccountCreated(accountId) {
+            statusMessage.text = "✓ Account created successfully!\nThe Account ID is: " + accountId
+        }
+
+        function onAccountRetrieved(account) {
+            // Ignore answers for an ID the user has since typed over
+            if (account.accountId !== parseInt(manageAccountIdField.text))
+                return
+            manageBalanceDisplay.text = "$ " + account.balance.toFixed(2)
+            statusMessage.text = ""
+        }
+
+        function onOwnerSuggestionsRetrieved(prefix, names) {
+            if (prefix === searchPersonNameField.text)
+                ownerSuggestions.model = names
+        }
+
+        function onSaved() {
+            statusMessage.text = "Data saved successfully!"
         }
 
         function onBalanceChanged(accountId, newBalance) {
+            if (accountId !== parseInt(manageAccountIdField.text))
+                return
             statusMessage.text = "✓ Balance updated to: $" + newBalance.toFixed(2)
             manageBalanceDisplay.text = "$ " + newBalance.toFixed(2)
         }
@@ -653,21 +1126,29 @@ ApplicationWindow {
                 detailsCreatedTime.text = details.createdTime || "-"
                 detailsLastOperation.text = (details.lastOperationType || "None") + "\n" + (details.lastOperationTime || "-")
                 statusMessage.text = ""
+                historyModel.clear()
+                historyList.accountId = details.accountId || 0
+                historyList.nextCursor = 0
+                if (historyList.accountId > 0)
+                    bankBridge.getHistory(historyList.accountId, 20, 0)
             }
         }
 
-        function onPersonAccountsRetrieved(accountsList) {
-            personAccountsDisplay.text = accountsList || "No accounts found for this person"
-            statusMessage.text = ""
+        function onHistoryRetrieved(accountId, entries, nextCursor) {
+            if (accountId !== historyList.accountId)
+                return
+            for (var i = 0; i < entries.length; ++i)
+                historyModel.append(entries[i])
+            historyList.nextCursor = nextCursor
         }
 
-        function onAllAccountsRetrieved(accountsList) {
-            allAccountsDisplay.text = accountsList || "No accounts in system"
+        function onPersonAccountsRetrieved(accountsList) {
+            personAccountsDisplay.text = accountsList || "No accounts found for this person"
             statusMessage.text = ""
         }
 
-        function onAccountDeleted(message) {
-            statusMessage.text = "✓ " + message
+        function onAccountDeleted(accountId) {
+            statusMessage.text = "✓ Account " + accountId + " deleted"
         }
     }
 }
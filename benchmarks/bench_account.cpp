@@ -0,0 +1,183 @@
+#include <benchmark/benchmark.h>
+#include "account.h"
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#define BANK_HAVE_MALLINFO2 1
+#endif
+
+namespace {
+
+// The previous Account layout: every operation formatted the clock into a
+// string and stored the operation name as text.
+class StringStampedAccount {
+public:
+    explicit StringStampedAccount(double balance)
+        : balance_(balance), creationTime_(now()), lastOperationType_("None"), lastOperationTime_(creationTime_) {}
+
+    void deposit(double amount) {
+        balance_ += amount;
+        lastOperationType_ = "Deposit";
+        lastOperationTime_ = now();
+    }
+
+private:
+    static std::string now() {
+        std::time_t t = std::time(nullptr);
+        std::tm local{};
+        localtime_r(&t, &local);
+        std::stringstream ss;
+        ss << std::put_time(&local, "%Y-%m-%d %H:%M:%S");
+        return ss.str();
+    }
+
+    int accountId_ = 0;
+    std::string cardId_;
+    double balance_;
+    std::string personName_;
+    std::string creationTime_;
+    std::string lastOperationType_;
+    std::string lastOperationTime_;
+};
+
+void BM_AccountDepositStringStamp(benchmark::State& state) {
+    StringStampedAccount account(0.0);
+    for (auto _ : state) {
+        account.deposit(1.0);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes/account"] = sizeof(StringStampedAccount);
+}
+
+void BM_AccountDeposit(benchmark::State& state) {
+    Account account(1);
+    for (auto _ : state) {
+        account.deposit(Money(1.0));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes/account"] = sizeof(Account);
+}
+
+// Formatting is now paid only by code that displays the time.
+void BM_AccountFormatTimestamp(benchmark::State& state) {
+    Account account(1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(account.getLastOperationTime());
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_AccountCreate(benchmark::State& state) {
+    std::vector<Account> accounts;
+    accounts.reserve(static_cast<std::size_t>(state.max_iterations));
+    int id = 0;
+    for (auto _ : state)
+        accounts.emplace_back(++id, Money(100.0), "Person", "card");
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Bytes the allocator has handed out, mmapped blocks included; 0 where
+// glibc cannot say.
+std::size_t heapInUse() {
+#ifdef BANK_HAVE_MALLINFO2
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// The previous metadata layout: each account owned its name and card ID.
+struct OwnedMetadataAccount {
+    int accountId;
+    Money balance;
+    std::string personName;
+    std::string cardId;
+};
+
+// A book where four accounts share each owner, with names and card numbers
+// too long for the small-string buffer. `tag` keeps the strings of
+// different benchmarks apart, so neither finds the other's in the pool.
+std::string ownerName(const std::string& tag, int accountId) {
+    return tag + " Customer " + std::to_string(accountId / 4);
+}
+
+std::string cardNumber(int accountId) {
+    std::string digits = std::to_string(accountId);
+    return "4000" + std::string(12 - digits.size(), '0') + digits;
+}
+
+void BM_AccountMetadataOwned(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    std::size_t heapBytes = 0;
+    for (auto _ : state) {
+        std::size_t before = heapInUse();
+        std::vector<OwnedMetadataAccount> accounts;
+        accounts.reserve(static_cast<std::size_t>(count));
+        for (int id = 1; id <= count; ++id)
+            accounts.push_back({id, Money(), ownerName("owned", id), cardNumber(id)});
+        heapBytes = heapInUse() - before;
+        benchmark::DoNotOptimize(accounts.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["heap_bytes/account"] = static_cast<double>(heapBytes) / static_cast<double>(count);
+}
+
+// The same book in Account: handles into the string pool. Heap growth
+// includes the pool's arenas and tables.
+void BM_AccountMetadataPooled(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    std::size_t heapBytes = 0;
+    for (auto _ : state) {
+        std::size_t before = heapInUse();
+        std::vector<Account> accounts;
+        accounts.reserve(static_cast<std::size_t>(count));
+        for (int id = 1; id <= count; ++id)
+            accounts.emplace_back(id, Money(), ownerName("pooled", id), cardNumber(id));
+        heapBytes = heapInUse() - before;
+        benchmark::DoNotOptimize(accounts.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["heap_bytes/account"] = static_cast<double>(heapBytes) / static_cast<double>(count);
+    state.counters["pool_strings"] = static_cast<double>(string_pool::stats().strings);
+}
+
+// Totalling a book: plain doubles against overflow-checked minor units.
+void BM_SumBalancesDouble(benchmark::State& state) {
+    std::vector<double> balances(static_cast<std::size_t>(state.range(0)), 0.1);
+    for (auto _ : state) {
+        double total = 0.0;
+        for (double balance : balances)
+            total += balance;
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SumBalancesMoney(benchmark::State& state) {
+    std::vector<Money> balances(static_cast<std::size_t>(state.range(0)), Money(0.1));
+    for (auto _ : state) {
+        Money total;
+        for (Money balance : balances)
+            total += balance;
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(BM_AccountDepositStringStamp);
+BENCHMARK(BM_AccountDeposit);
+BENCHMARK(BM_AccountFormatTimestamp);
+BENCHMARK(BM_AccountCreate);
+// One iteration each: the first pooled run is the one that fills the pool.
+BENCHMARK(BM_AccountMetadataOwned)->Arg(1 << 20)->Iterations(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AccountMetadataPooled)->Arg(1 << 20)->Iterations(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SumBalancesDouble)->Arg(100000);
+BENCHMARK(BM_SumBalancesMoney)->Arg(100000);
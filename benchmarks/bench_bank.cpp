@@ -0,0 +1,330 @@
+#include <benchmark/benchmark.h>
+#include "account_report.h"
+#include "balance_stats.h"
+#include "bank.h"
+#include "bank_server.h"
+#include "concurrent_bank.h"
+#include "memory_persistence.h"
+#include "metrics.h"
+#include "remote_bank.h"
+#include <memory>
+#include <mutex>
+
+namespace {
+
+constexpr int kAccounts = 10000;
+
+// Never touches disk: the benchmarks only exercise in-memory paths.
+NullPersistence nullPersistence;
+
+// The single-map Bank, serialized externally the way callers must today.
+std::unique_ptr<Bank> lockedBank;
+std::mutex lockedBankMutex;
+
+std::unique_ptr<ConcurrentBank> concurrentBank;
+
+template <typename B>
+void populate(B& bank) {
+    for (int i = 0; i < kAccounts; ++i)
+        bank.createAccount("Person " + std::to_string(i), "card", Money(1000.0));
+}
+
+void BM_BankCreateAccount(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bank.createAccount("Person", "29901011234567", Money(100.0)));
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_BankDeposit(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    int i = 0;
+    for (auto _ : state)
+        bank.deposit(1 + (i++ % kAccounts), Money(1.0));
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_BankWithdraw(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    // 1000.00 per account covers far more withdrawals than any run makes.
+    int i = 0;
+    for (auto _ : state)
+        bank.withdraw(1 + (i++ % kAccounts), Money(0.01));
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LockedBankDeposit(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        lockedBank = std::make_unique<Bank>(nullPersistence);
+        populate(*lockedBank);
+    }
+    int id = 1 + state.thread_index() * (kAccounts / state.threads());
+    for (auto _ : state) {
+        std::lock_guard lock(lockedBankMutex);
+        lockedBank->deposit(id, Money(1.0));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ConcurrentBankDeposit(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        concurrentBank = std::make_unique<ConcurrentBank>(nullPersistence);
+        populate(*concurrentBank);
+    }
+    int id = 1 + state.thread_index() * (kAccounts / state.threads());
+    for (auto _ : state)
+        concurrentBank->deposit(id, Money(1.0));
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Moving money the old way: two calls, two lookups, two exception paths.
+void BM_BankWithdrawThenDeposit(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    int i = 0;
+    for (auto _ : state) {
+        int from = 1 + (i % kAccounts);
+        int to = 1 + ((i + 1) % kAccounts);
+        bank.withdraw(from, Money(1.0));
+        bank.deposit(to, Money(1.0));
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_BankTransfer(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    int i = 0;
+    for (auto _ : state) {
+        bank.transfer(1 + (i % kAccounts), 1 + ((i + 1) % kAccounts), Money(1.0));
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ConcurrentBankTransfer(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        concurrentBank = std::make_unique<ConcurrentBank>(nullPersistence);
+        populate(*concurrentBank);
+    }
+    int base = state.thread_index() * (kAccounts / state.threads());
+    int i = 0;
+    for (auto _ : state) {
+        // Ping-pong inside the thread's own range so balances never drain.
+        int a = 1 + base + ((i >> 1) % 64);
+        if (i & 1)
+            concurrentBank->transfer(a + 1, a, Money(1.0));
+        else
+            concurrentBank->transfer(a, a + 1, Money(1.0));
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// What the bridge's "Refresh All Accounts" used to do on every click.
+void BM_BankGetAllAccounts(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    for (auto _ : state) {
+        Money total;
+        for (const Account& account : bank.getAllAccounts())
+            total += account.balance();
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * kAccounts);
+}
+
+void BM_BankForEachAccount(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    for (auto _ : state) {
+        Money total;
+        bank.forEachAccount([&total](const Account& account) { total += account.balance(); });
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * kAccounts);
+}
+
+// The same total straight from the store's balance column.
+void BM_BankBalanceColumnScan(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    for (auto _ : state) {
+        Money total;
+        for (Money balance : bank.store().balances())
+            total += balance;
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * kAccounts);
+}
+
+// summarize() over a 1M-balance column at each instruction set level,
+// single-threaded. Levels this CPU lacks report what they fell back to.
+void BM_BalanceSummary(benchmark::State& state) {
+    std::vector<Money> balances(std::size_t{1} << 20, Money(1000.0));
+    balance_stats::Options options{static_cast<balance_stats::SimdLevel>(state.range(0)), 1};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(balance_stats::summarize(balances, options));
+    state.SetLabel(balance_stats::toString(std::min(options.level, balance_stats::detectSimdLevel())));
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(balances.size() * sizeof(Money)));
+}
+
+// The default options on a 16M-balance column: split across every core.
+void BM_BalanceHistogramParallel(benchmark::State& state) {
+    std::vector<Money> balances(std::size_t{1} << 24, Money(1000.0));
+    std::vector<Money> edges = {Money(0.0), Money(100.0), Money(1000.0), Money(10000.0)};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(balance_stats::histogram(balances, edges));
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(balances.size() * sizeof(Money)));
+}
+
+// getPersonAccounts before the owner index: scan the whole book.
+void BM_BankOwnerLookupScan(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    const std::string owner = "Person 4242";
+    for (auto _ : state) {
+        std::vector<int> ids;
+        bank.forEachAccount([&](const Account& account) {
+            if (account.getPersonName() == owner)
+                ids.push_back(account.getAccountId());
+        });
+        benchmark::DoNotOptimize(ids);
+    }
+}
+
+void BM_BankOwnerLookupIndexed(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    const std::string owner = "Person 4242";
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bank.findByOwner(owner));
+}
+
+void BM_BankOwnerPrefixSearch(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bank.searchOwners("person 42", 5));
+}
+
+// The "All Accounts" report as BankBridge used to build it: formatted
+// getters and a temporary per field.
+std::string describeAllAccountsNaive(const Bank& bank) {
+    std::string result;
+    bank.forEachAccount([&result](const Account& account) {
+        result += std::string("========================\n");
+        result += "Account ID: " + std::to_string(account.getAccountId()) + "\n";
+        result += "Owner: " + std::string(account.getPersonName()) + "\n";
+        result += "Balance: $ " + account.balance().toString() + "\n";
+        result += "Created: " + account.getCreationTime() + "\n";
+        result += "Last Operation: " + account.getLastOperationType() + " (" + account.getLastOperationTime() + ")\n\n";
+    });
+    return result;
+}
+
+void BM_DescribeAllAccountsNaive(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(describeAllAccountsNaive(bank));
+    state.SetItemsProcessed(state.iterations() * kAccounts);
+}
+
+void BM_DescribeAllAccounts(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(describeAllAccounts(bank));
+    state.SetItemsProcessed(state.iterations() * kAccounts);
+}
+
+void BM_DescribePersonAccounts(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(describePersonAccounts(bank, "Person 4242"));
+}
+
+// What an instrumented operation pays: a counter bump, plus a timed scope
+// (slow operations) or a sampled one (Bank's per-account operations).
+void BM_MetricsCount(benchmark::State& state) {
+    for (auto _ : state)
+        metrics::increment(metrics::Counter::Deposits);
+}
+
+void BM_MetricsTimer(benchmark::State& state) {
+    for (auto _ : state) {
+        metrics::ScopedTimer timer(metrics::Timer::Deposit);
+        benchmark::ClobberMemory();
+    }
+}
+
+void BM_MetricsSampledTimer(benchmark::State& state) {
+    for (auto _ : state) {
+        metrics::SampledTimer timer(metrics::Timer::Deposit);
+        benchmark::ClobberMemory();
+    }
+}
+
+// A deposit through the daemon's protocol: one round trip over the Unix
+// socket per call, or one per `state.range(0)` calls when pipelined.
+void BM_RemoteDeposit(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    BankServerOptions options;
+    options.socketPath = "bench_bank.sock";
+    BankServer server(bank, options);
+    RemoteBank remote(options.socketPath);
+    int i = 0;
+    for (auto _ : state)
+        remote.deposit(1 + (i++ % kAccounts), Money(1.0));
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RemotePipelinedDeposit(benchmark::State& state) {
+    Bank bank(nullPersistence);
+    populate(bank);
+    BankServerOptions options;
+    options.socketPath = "bench_bank.sock";
+    BankServer server(bank, options);
+    RemoteBank remote(options.socketPath);
+    RemotePipeline pipeline(remote);
+    int i = 0;
+    for (auto _ : state) {
+        for (int64_t n = 0; n < state.range(0); ++n)
+            pipeline.deposit(1 + (i++ % kAccounts), Money(1.0));
+        benchmark::DoNotOptimize(pipeline.run());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(BM_BankCreateAccount);
+BENCHMARK(BM_BankDeposit);
+BENCHMARK(BM_BankWithdraw);
+BENCHMARK(BM_LockedBankDeposit)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_ConcurrentBankDeposit)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_BankWithdrawThenDeposit);
+BENCHMARK(BM_BankTransfer);
+BENCHMARK(BM_ConcurrentBankTransfer)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_BankGetAllAccounts);
+BENCHMARK(BM_BankForEachAccount);
+BENCHMARK(BM_BankBalanceColumnScan);
+BENCHMARK(BM_BalanceSummary)->DenseRange(0, 3);
+BENCHMARK(BM_BalanceHistogramParallel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_BankOwnerLookupScan);
+BENCHMARK(BM_BankOwnerLookupIndexed);
+BENCHMARK(BM_BankOwnerPrefixSearch);
+BENCHMARK(BM_DescribeAllAccountsNaive)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DescribeAllAccounts)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DescribePersonAccounts);
+BENCHMARK(BM_MetricsCount);
+BENCHMARK(BM_MetricsTimer);
+BENCHMARK(BM_MetricsSampledTimer);
+BENCHMARK(BM_RemoteDeposit)->UseRealTime();
+BENCHMARK(BM_RemotePipelinedDeposit)->Arg(64)->Arg(1024)->UseRealTime();
@@ -0,0 +1,182 @@
+#include <benchmark/benchmark.h>
+#include "binary_persistence.h"
+#include "json_persistence.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+std::string benchFile(int count) {
+    return "bench_accounts_" + std::to_string(count) + ".json";
+}
+
+std::unordered_map<int, Account> makeAccounts(int count) {
+    Timestamp created;
+    Timestamp lastOperation;
+    parseTimestamp("2024-01-01 10:00:00", created);
+    parseTimestamp("2024-01-02 11:30:00", lastOperation);
+    std::unordered_map<int, Account> accounts;
+    accounts.reserve(count);
+    for (int id = 1; id <= count; ++id) {
+        accounts.try_emplace(id, id, Money(100.0 + id), "Person " + std::to_string(id % 5000),
+                             "2990101" + std::to_string(1000000 + id), created, OperationType::Deposit,
+                             lastOperation);
+    }
+    return accounts;
+}
+
+// Writes a book of `count` accounts once per size and reuses it.
+const std::string& ensureBook(int count) {
+    static std::unordered_map<int, std::string> files;
+    auto it = files.find(count);
+    if (it != files.end())
+        return it->second;
+
+    std::string file = benchFile(count);
+    JsonPersistence(file).save(makeAccounts(count));
+    return files.emplace(count, file).first->second;
+}
+
+const std::string& ensureBinaryBook(int count) {
+    static std::unordered_map<int, std::string> files;
+    auto it = files.find(count);
+    if (it != files.end())
+        return it->second;
+
+    std::string file = "bench_accounts_" + std::to_string(count) + ".bin";
+    JsonPersistence json(ensureBook(count));
+    BinaryPersistence binary(file);
+    convertSnapshot(json, binary);
+    return files.emplace(count, file).first->second;
+}
+
+// The pre-SAX loader: parse into a DOM, copy into Account, copy into the map.
+std::unordered_map<int, Account> loadViaDom(const std::string& filename) {
+    std::unordered_map<int, Account> accounts;
+    std::ifstream file(filename);
+    nlohmann::json j;
+    file >> j;
+    for (const auto& item : j) {
+        if (!item.is_object())
+            continue;  // the trailing checksum
+        int id = item.value("accountId", 0);
+        Timestamp created;
+        Timestamp lastOperation;
+        parseTimestamp(item.value("creationTime", ""), created);
+        parseTimestamp(item.value("lastOperationTime", ""), lastOperation);
+        Account acc(id, Money(item.value("balance", 0.0)), item.value("personName", ""), item.value("cardId", ""),
+                    created, parseOperationType(item.value("lastOperationType", "")), lastOperation);
+        accounts.emplace(id, acc);
+    }
+    return accounts;
+}
+
+// The pre-parallel save: build a DOM and dump(4) it (checksum left out).
+void saveViaDom(const std::unordered_map<int, Account>& accounts, const std::string& filename) {
+    nlohmann::json j = nlohmann::json::array();
+    for (const auto& pair : accounts) {
+        nlohmann::json accountJson;
+        accountJson["accountId"] = pair.first;
+        accountJson["balance"] = pair.second.balance().toDouble();
+        accountJson["personName"] = pair.second.getPersonName();
+        accountJson["cardId"] = pair.second.getCardId();
+        accountJson["creationTime"] = pair.second.getCreationTime();
+        accountJson["lastOperationType"] = pair.second.getLastOperationType();
+        accountJson["lastOperationTime"] = pair.second.getLastOperationTime();
+        j.push_back(accountJson);
+    }
+    std::ofstream(filename, std::ios::binary | std::ios::trunc) << j.dump(4);
+}
+
+// The JSON alone; the index cache is measured by the binary benchmarks.
+void BM_JsonSave(benchmark::State& state) {
+    const auto accounts = makeAccounts(static_cast<int>(state.range(0)));
+    JsonPersistence persistence("bench_save_" + std::to_string(state.range(0)) + ".json", false);
+    for (auto _ : state)
+        persistence.save(accounts);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_JsonSaveCompact(benchmark::State& state) {
+    const auto accounts = makeAccounts(static_cast<int>(state.range(0)));
+    const std::string file = "bench_save_" + std::to_string(state.range(0)) + ".json";
+    JsonPersistence persistence(file, false, JsonLayout::Compact);
+    for (auto _ : state)
+        persistence.save(accounts);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes/account"] =
+        static_cast<double>(std::filesystem::file_size(file)) / static_cast<double>(state.range(0));
+}
+
+void BM_JsonSaveDom(benchmark::State& state) {
+    const auto accounts = makeAccounts(static_cast<int>(state.range(0)));
+    const std::string file = "bench_save_" + std::to_string(state.range(0)) + ".json";
+    for (auto _ : state)
+        saveViaDom(accounts, file);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_JsonLoadSax(benchmark::State& state) {
+    const std::string& file = ensureBook(static_cast<int>(state.range(0)));
+    JsonPersistence persistence(file, false);
+    for (auto _ : state) {
+        auto accounts = persistence.load();
+        benchmark::DoNotOptimize(accounts);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes/account"] =
+        static_cast<double>(std::filesystem::file_size(file)) / static_cast<double>(state.range(0));
+}
+
+// Startup with an up-to-date index cache: checks the JSON's trailing
+// checksum and maps the cache instead of parsing.
+void BM_JsonLoadCached(benchmark::State& state) {
+    const std::string& file = ensureBook(static_cast<int>(state.range(0)));
+    JsonPersistence persistence(file);
+    for (auto _ : state) {
+        auto accounts = persistence.load();
+        benchmark::DoNotOptimize(accounts);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_JsonLoadDom(benchmark::State& state) {
+    const std::string& file = ensureBook(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        auto accounts = loadViaDom(file);
+        benchmark::DoNotOptimize(accounts);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_BinaryLoad(benchmark::State& state) {
+    BinaryPersistence persistence(ensureBinaryBook(static_cast<int>(state.range(0))));
+    for (auto _ : state) {
+        auto accounts = persistence.load();
+        benchmark::DoNotOptimize(accounts);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Cold start with a memory-mapped snapshot: open and answer one lookup.
+void BM_BinaryViewOpenAndFind(benchmark::State& state) {
+    const std::string& file = ensureBinaryBook(static_cast<int>(state.range(0)));
+    int id = static_cast<int>(state.range(0) / 2);
+    for (auto _ : state) {
+        BinarySnapshotView view(file);
+        benchmark::DoNotOptimize(view.balance(view.find(id)));
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_JsonSave)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonSaveCompact)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonSaveDom)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonLoadSax)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonLoadCached)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JsonLoadDom)->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BinaryLoad)->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BinaryViewOpenAndFind)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
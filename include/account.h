@@ -1,42 +1,79 @@
 // account.h
 #pragma once
+#include "money.h"
+#include "string_pool.h"
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <chrono>
+#include <cstdint>
 
 using UserId = std::string;
 
+// Microsecond ticks since the Unix epoch; also the on-disk representation.
+using Timestamp = std::chrono::time_point<std::chrono::system_clock, std::chrono::microseconds>;
+
+enum class OperationType : std::uint8_t {
+    None,
+    Deposit,
+    Withdrawal,
+    TransferIn,
+    TransferOut,
+    Posting  // interest and fees from a posting run
+};
+
+Timestamp currentTimestamp() noexcept;
+// "YYYY-MM-DD HH:MM:SS" in local time.
+std::string formatTimestamp(Timestamp timestamp);
+// Parses formatTimestamp() output; returns false on malformed input.
+bool parseTimestamp(const std::string& text, Timestamp& timestamp);
+const char* toString(OperationType type) noexcept;
+OperationType parseOperationType(const std::string& text) noexcept;
+
 class Account {
 public:
-    explicit Account(int accountId, double initialBalance = 0.0,
-                     const std::string& personName = "", 
-                     const std::string& cardId = "");
+    explicit Account(int accountId, Money initialBalance = Money(),
+                     std::string_view personName = {},
+                     std::string_view cardId = {});
+    // Restores a persisted account without touching the clock.
+    Account(int accountId, Money balance, std::string_view personName, std::string_view cardId,
+            Timestamp creationTime, OperationType lastOperationType, Timestamp lastOperationTime);
 
     int getAccountId() const noexcept { return accountId_; }
-    double balance() const noexcept;
-    void deposit(double amount);
-    void withdraw(double amount);
+    Money balance() const noexcept { return balance_; }
+    void deposit(Money amount);
+    void withdraw(Money amount);
+    void transferTo(Account& target, Money amount);
     
-    // Metadata getters
-    const std::string& getPersonName() const noexcept { return personName_; }
-    const std::string& getCardId() const noexcept { return cardId_; }
-    const std::string& getCreationTime() const noexcept { return creationTime_; }
-    const std::string& getLastOperationType() const noexcept { return lastOperationType_; }
-    const std::string& getLastOperationTime() const noexcept { return lastOperationTime_; }
+    // Metadata getters. The views stay valid while the account, or any
+    // other holder of the same pooled string, keeps it (see string_pool.h).
+    std::string_view getPersonName() const noexcept { return personName_.view(); }
+    std::string_view getCardId() const noexcept { return cardId_.view(); }
+    const PooledString& pooledPersonName() const noexcept { return personName_; }
+    const PooledString& pooledCardId() const noexcept { return cardId_; }
+    Timestamp creationTime() const noexcept { return creationTime_; }
+    OperationType lastOperationType() const noexcept { return lastOperationType_; }
+    Timestamp lastOperationTime() const noexcept { return lastOperationTime_; }
+
+    // Display text, formatted on demand
+    std::string getCreationTime() const { return formatTimestamp(creationTime_); }
+    std::string getLastOperationType() const { return toString(lastOperationType_); }
+    std::string getLastOperationTime() const { return formatTimestamp(lastOperationTime_); }
     
     // Metadata setters
-    void setPersonName(const std::string& name) { personName_ = name; }
-    void setCardId(const std::string& cardId) { cardId_ = cardId; }
-    void updateOperationInfo(const std::string& type);
+    void setPersonName(std::string_view name) { personName_ = string_pool::intern(name); }
+    void setCardId(std::string_view cardId) { cardId_ = string_pool::intern(cardId); }
+    void setBalance(Money balance) noexcept { balance_ = balance; }
+    void updateOperationInfo(OperationType type, Timestamp when = currentTimestamp()) noexcept;
 
 private:
     int accountId_;
-    std::string cardId_;
-    double balance_;
-    std::string personName_;
-    std::string creationTime_;
-    std::string lastOperationType_;
-    std::string lastOperationTime_;
-    
-    static std::string getCurrentTime();
+    OperationType lastOperationType_;
+    Money balance_;
+    Timestamp creationTime_;
+    Timestamp lastOperationTime_;
+    // Handles into the string pool rather than owned strings: an owner's
+    // name is stored once for all of their accounts.
+    PooledString cardId_;
+    PooledString personName_;
 };
@@ -0,0 +1,43 @@
+// account_index.h
+#pragma once
+#include "account.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Secondary indexes over a set of accounts: exact owner name, exact card
+// ID, and a case-insensitive owner-name prefix index for incremental
+// search. The owner of the accounts (Bank) keeps it in step with every
+// create, delete and load. Keys are views of pooled strings (see
+// string_pool.h), kept alive by a handle beside each key, so the index
+// copies no names.
+class AccountIndex {
+public:
+    void add(const Account& account);
+    void remove(const Account& account);
+    void clear();
+
+    const std::vector<int>& byOwner(const std::string& personName) const;
+    const std::vector<int>& byCard(const std::string& cardId) const;
+    // IDs of up to `limit` accounts whose owner name starts with `prefix`,
+    // ignoring ASCII case, ordered by owner name.
+    std::vector<int> byOwnerPrefix(const std::string& prefix, std::size_t limit) const;
+
+private:
+    struct Postings {
+        PooledString key;  // what the map's key views
+        std::vector<int> ids;
+    };
+
+    template <typename Map>
+    static void insert(Map& map, const PooledString& key, int accountId);
+    template <typename Map>
+    static void erase(Map& map, std::string_view key, int accountId);
+
+    std::unordered_map<std::string_view, Postings> byOwner_;
+    std::unordered_map<std::string_view, Postings> byCard_;
+    std::map<std::string_view, Postings> byLowerOwner_;
+};
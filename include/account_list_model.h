@@ -0,0 +1,98 @@
+#pragma once
+#include <QAbstractListModel>
+#include <QString>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bank_observer.h"
+#include "bank_worker.h"
+
+// List model over every account in a Bank, ordered by account ID. Rows
+// cache what the delegates display, and the model follows the bank through
+// IBankObserver: a deposit becomes one dataChanged for one row, a create
+// one inserted row. A ListView on top only instantiates visible delegates.
+// The bank lives on a BankWorker thread: rows are built there and handed
+// to the GUI thread, so nothing here ever waits on the bank. Rows arrive a
+// page at a time as the view scrolls (canFetchMore()/fetchMore()), so a
+// lazily loading bank only reads the accounts someone looks at.
+class AccountListModel : public QAbstractListModel, public IBankObserver {
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(int total READ total NOTIFY countChanged)
+
+public:
+    enum Roles {
+        AccountIdRole = Qt::UserRole + 1,
+        OwnerRole,
+        CardIdRole,
+        BalanceRole,
+        BalanceTextRole,
+        CreationTimeRole,
+        LastOperationTypeRole,
+        LastOperationTimeRole
+    };
+
+    explicit AccountListModel(BankWorker& worker, QObject* parent = nullptr);
+    ~AccountListModel() override;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    // Rows fetched so far, and accounts in the bank.
+    int count() const { return static_cast<int>(rows_.size()); }
+    int total() const { return total_; }
+    // Row of the account, or -1, also while it has not been fetched.
+    Q_INVOKABLE int rowOf(int accountId) const;
+    // Starts over from the first page, asynchronously. Calls made while a
+    // reload is still queued collapse into it.
+    Q_INVOKABLE void reload();
+
+    // Called on the worker thread.
+    void accountCreated(const Account& account) override;
+    void accountDeleted(int accountId) override;
+    void accountChanged(const Account& account) override;
+    void accountsChanged() override;
+
+signals:
+    void countChanged();
+
+private:
+    struct Row {
+        int accountId;
+        QString owner;
+        QString cardId;
+        Money balance;
+        Timestamp creationTime;
+        OperationType lastOperationType;
+        Timestamp lastOperationTime;
+    };
+
+    struct Page {
+        std::vector<Row> rows;
+        int nextCursor = 0;  // 0 once the last row is in
+        int total = 0;
+    };
+
+    static Row makeRow(const Account& account);
+    static Page fetchPage(const Bank& bank, int cursor);
+    void resetRows(Page page);
+    void appendRows(Page page);
+    // Not insertRow()/removeRow(): those would hide QAbstractItemModel's.
+    void insertAccountRow(const Row& row);
+    void removeAccountRow(int accountId);
+    void updateAccountRow(const Row& row);
+
+    BankWorker& worker_;
+    std::string reloadKey_;
+    std::vector<Row> rows_;
+    std::unordered_map<int, int> rowIndex_;
+    int cursor_ = 0;         // where the next page starts; 0 when complete
+    bool fetching_ = false;  // a page is on its way
+    int total_ = 0;
+    // Bumped by every reload, so a page fetched before it is dropped.
+    std::uint64_t generation_ = 0;
+};
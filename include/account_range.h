@@ -0,0 +1,23 @@
+// account_range.h
+#pragma once
+#include "account_store.h"
+#include <cstddef>
+
+// Read-only view over the accounts in an AccountStore. Iterating yields
+// `const Account&` straight out of the store, in slot order; nothing is
+// copied. Like any container iterator it is invalidated by inserting or
+// erasing.
+class AccountRange {
+public:
+    using iterator = AccountStore::const_iterator;
+
+    explicit AccountRange(const AccountStore& accounts) : accounts_(&accounts) {}
+
+    iterator begin() const { return accounts_->begin(); }
+    iterator end() const { return accounts_->end(); }
+    std::size_t size() const noexcept { return accounts_->size(); }
+    bool empty() const noexcept { return accounts_->empty(); }
+
+private:
+    const AccountStore* accounts_;
+};
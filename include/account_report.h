@@ -0,0 +1,13 @@
+// account_report.h
+#pragma once
+#include "bank.h"
+#include <string>
+
+// The plain-text account listings the GUI displays. They live in the core
+// library, free of Qt, so they can be tested and benchmarked without a GUI;
+// BankBridge converts the result to a QString once.
+
+// Every account, one block each; "No accounts in system" for an empty bank.
+std::string describeAllAccounts(const Bank& bank);
+// The accounts owned by `personName`, or a "No accounts found" line.
+std::string describePersonAccounts(const Bank& bank, const std::string& personName);
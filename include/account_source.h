@@ -0,0 +1,28 @@
+// account_source.h
+#pragma once
+#include "account.h"
+#include <cstddef>
+
+// Read-only, random-access view of a saved book, so Bank can load accounts
+// as they are touched instead of all at startup (see BankOptions). Accounts
+// are addressed by position in ascending ID order. Opening a source must
+// not read the whole book: its size and highest ID are known up front, and
+// a lookup only reads what it returns.
+class AccountSource {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    virtual ~AccountSource() = default;
+
+    virtual std::size_t size() const noexcept = 0;
+    // 0 when the book is empty.
+    virtual int maxAccountId() const noexcept = 0;
+    // Position of accountId, or npos.
+    virtual std::size_t find(int accountId) const noexcept = 0;
+    // Position of the first account with an ID of at least accountId, or size().
+    virtual std::size_t lowerBound(int accountId) const noexcept = 0;
+
+    virtual int accountId(std::size_t index) const = 0;
+    virtual Money balance(std::size_t index) const = 0;
+    virtual Account materialize(std::size_t index) const = 0;
+};
@@ -0,0 +1,84 @@
+// account_store.h
+#pragma once
+#include "account.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Dense, ID-indexed account storage for Bank.
+//
+// Accounts sit contiguously in slot order, and a flat table maps an ID to
+// its slot, so a lookup is two array reads and never hashes; IDs are handed
+// out sequentially, so the table stays about as long as the book. The table
+// is never allowed to outgrow the book by much, though: an ID far beyond it
+// (one loaded from a hand-edited file, say) goes in a hash map instead. The
+// fields scans care about (balance, last operation type and time) are also
+// kept in columns parallel to the slots, away from the names and card IDs,
+// so a full-book pass over them streams through memory. Whoever changes an
+// account through find() must call refresh() to bring its columns up to
+// date. Deleting moves the last account into the freed slot, so pointers and
+// slot numbers are only stable until the next insert or erase.
+class AccountStore {
+public:
+    using const_iterator = std::vector<Account>::const_iterator;
+
+    Account* find(int accountId) noexcept {
+        std::int32_t slot = slotOf(accountId);
+        return slot < 0 ? nullptr : &records_[static_cast<std::size_t>(slot)];
+    }
+    const Account* find(int accountId) const noexcept {
+        std::int32_t slot = slotOf(accountId);
+        return slot < 0 ? nullptr : &records_[static_cast<std::size_t>(slot)];
+    }
+    bool contains(int accountId) const noexcept { return slotOf(accountId) >= 0; }
+
+    // Adds an account under its own ID; returns nullptr if the ID is taken.
+    // Throws std::invalid_argument for a negative ID.
+    Account* insert(Account account);
+    bool erase(int accountId);
+    void clear();
+    void reserve(std::size_t count);
+    // Re-reads the hot fields of an account changed in place.
+    void refresh(const Account& account) noexcept {
+        auto slot = static_cast<std::size_t>(slotOf(account.getAccountId()));
+        balances_[slot] = account.balance();
+        lastOperationTypes_[slot] = account.lastOperationType();
+        lastOperationTimes_[slot] = account.lastOperationTime();
+    }
+
+    std::size_t size() const noexcept { return records_.size(); }
+    bool empty() const noexcept { return records_.empty(); }
+    const_iterator begin() const noexcept { return records_.begin(); }
+    const_iterator end() const noexcept { return records_.end(); }
+
+    // Columns, one entry per slot, in the same order as begin()..end().
+    const std::vector<Money>& balances() const noexcept { return balances_; }
+    const std::vector<OperationType>& lastOperationTypes() const noexcept { return lastOperationTypes_; }
+    const std::vector<Timestamp>& lastOperationTimes() const noexcept { return lastOperationTimes_; }
+
+    // Copies every account into the map persistence works with.
+    std::unordered_map<int, Account> toMap() const;
+
+private:
+    // An ID is in slots_ exactly when it is below slots_.size().
+    std::int32_t slotOf(int accountId) const noexcept {
+        auto index = static_cast<std::size_t>(accountId);
+        if (accountId >= 0 && index < slots_.size())
+            return slots_[index];
+        if (sparseSlots_.empty())
+            return -1;
+        auto it = sparseSlots_.find(accountId);
+        return it == sparseSlots_.end() ? -1 : it->second;
+    }
+    void setSlot(int accountId, std::int32_t slot) noexcept;
+    void releaseSlot(int accountId) noexcept;
+    void growTable(std::size_t index);
+
+    std::vector<std::int32_t> slots_;  // ID -> slot, -1 when unused
+    std::unordered_map<int, std::int32_t> sparseSlots_;  // IDs past the table
+    std::vector<Account> records_;
+    std::vector<Money> balances_;
+    std::vector<OperationType> lastOperationTypes_;
+    std::vector<Timestamp> lastOperationTimes_;
+};
@@ -0,0 +1,52 @@
+// atomic_file.h
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+// Replaces `filename` with the concatenation of `parts` so that, across a
+// crash or a full disk, readers see either the old contents or all of the
+// new ones, never a mix: the data goes to a temporary file beside the
+// target, is fsync'ed, renamed over it, and the rename is synced too.
+// Throws std::runtime_error on failure, leaving the target untouched.
+//
+// Unsynced skips both syncs, for files that are cheap to regenerate: readers
+// still never see a partial file, but a crash may lose the new contents.
+enum class Durability { Synced, Unsynced };
+void replaceFileAtomically(const std::string& filename, std::initializer_list<std::string_view> parts,
+                           Durability durability = Durability::Synced);
+
+// Writes all of `data` to `fd`, retrying short and interrupted writes.
+// Throws std::runtime_error on failure, by which time some of it may be in
+// the file.
+void writeAll(int fd, std::string_view data, const std::string& filename);
+
+// Appends `data` to a record file whose intact part ends at `end`, then
+// syncs it if asked. If any of that fails, the file is cut back to `end`
+// so the next append follows the last intact record rather than a torn
+// one, and std::runtime_error is thrown.
+void appendRecords(int fd, std::uint64_t end, std::string_view data, const std::string& filename,
+                   Durability durability = Durability::Synced);
+
+// Drops the torn tail a crash may have left after `validEnd`, before
+// appending again. Throws std::runtime_error on failure.
+void dropTornTail(int fd, std::uint64_t validEnd, const std::string& filename);
+
+// Holds an exclusive flock on `<filename>.lock` for its lifetime, so that a
+// second process opening the same file as a store fails at once instead of
+// interleaving its writes with ours. The lock file is removed again on
+// release. Throws std::runtime_error if the file is already locked or the
+// lock file cannot be created.
+class FileLock {
+public:
+    explicit FileLock(const std::string& filename);
+    ~FileLock();
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+    std::string lockFile_;
+    int fd_ = -1;
+};
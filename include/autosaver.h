@@ -0,0 +1,108 @@
+// autosaver.h
+#pragma once
+#include "bank_observer.h"
+#include "bank_worker.h"
+#include "ipersistence.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+struct AutoSaveOptions {
+    std::chrono::milliseconds interval{5000};
+    // Flush early once this many changes are waiting.
+    std::size_t changeThreshold = 10000;
+};
+
+// Background autosave for a Bank driven by a BankWorker.
+//
+// The bank is switched to deferred persistence, so mutations only mark
+// accounts dirty. Every `interval`, or sooner once `changeThreshold`
+// changes have piled up, a worker job swaps out the dirty set and copies
+// just those accounts; this thread then writes them with saveDelta(). The
+// worker never waits on the disk, and save I/O follows the volume of
+// change rather than the size of the book. Stores without delta support get
+// a full snapshot instead. All writes, deltas and snapshots alike, go out
+// from this one thread in the order the worker took them. A lazily loading
+// bank is handed the store's fresh source after each snapshot, so the
+// accounts it covers are no longer pinned.
+class AutoSaver : public IBankObserver {
+public:
+    // Receives the error message, or an empty string on success.
+    using Done = std::function<void(const std::string& error)>;
+
+    AutoSaver(BankWorker& worker, IPersistence& persistence, AutoSaveOptions options = AutoSaveOptions());
+    // Persists what is still dirty and returns the bank to write-through.
+    ~AutoSaver() override;
+
+    AutoSaver(const AutoSaver&) = delete;
+    AutoSaver& operator=(const AutoSaver&) = delete;
+
+    // Writes a full snapshot (which also compacts a journal). A request
+    // made while another is still queued replaces it.
+    void saveNow(Done done = Done());
+    // Blocks until every change made before the call is on disk.
+    void flush();
+
+    std::size_t deltasWritten() const noexcept { return deltasWritten_.load(std::memory_order_relaxed); }
+    std::size_t snapshotsWritten() const noexcept { return snapshotsWritten_.load(std::memory_order_relaxed); }
+    // Writes that failed, background ones included, and the latest error.
+    // A failure is retried as a full snapshot at the next interval.
+    std::size_t failedWrites() const noexcept { return failedWrites_.load(std::memory_order_relaxed); }
+    std::string lastError() const;
+
+    // Called on the worker thread.
+    void accountCreated(const Account& account) override;
+    void accountDeleted(int accountId) override;
+    void accountChanged(const Account& account) override;
+    void accountsChanged() override;
+
+private:
+    struct Write {
+        bool snapshot = false;
+        std::uint64_t mark = 0;  // Bank::markSnapshot(), if loading lazily
+        AccountDelta delta;
+        std::unordered_map<int, Account> accounts;
+        Done done;
+    };
+
+    void countChange();
+    void requestDelta();
+    // Worker-side: capture what must be written next and queue it.
+    void takeDelta(Bank& bank);
+    void takeSnapshot(Bank& bank, Done done);
+    void enqueue(Write write);
+    void perform(Write& write);
+    // Hands the bank the source that now holds the snapshot taken at `mark`.
+    void reopen(std::uint64_t mark);
+    void waitForWrites();
+    void run();
+
+    BankWorker& worker_;
+    IPersistence& persistence_;
+    AutoSaveOptions options_;
+    bool deltaSupported_;
+    std::string deltaKey_;
+    std::string snapshotKey_;
+    std::atomic<bool> snapshotNeeded_{false};
+    std::atomic<std::size_t> changes_{0};
+    std::atomic<std::size_t> deltasWritten_{0};
+    std::atomic<std::size_t> snapshotsWritten_{0};
+    std::atomic<std::size_t> failedWrites_{0};
+
+    mutable std::mutex mutex_;
+    std::string lastError_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::deque<Write> writes_;
+    bool busy_ = false;
+    bool stopping_ = false;
+    std::thread thread_;
+};
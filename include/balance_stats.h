@@ -0,0 +1,53 @@
+// balance_stats.h
+#pragma once
+#include "money.h"
+#include <cstddef>
+#include <vector>
+
+// Whole-book aggregates over a contiguous balance column, normally
+// AccountStore::balances(). The kernels use the widest instruction set the
+// CPU offers, chosen at run time, and columns of kParallelThreshold
+// balances or more are split across threads.
+namespace balance_stats {
+
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+// The widest level both this build and this CPU support.
+SimdLevel detectSimdLevel() noexcept;
+const char* toString(SimdLevel level) noexcept;
+
+constexpr std::size_t kParallelThreshold = std::size_t{1} << 18;
+
+// How to run a query. A level above detectSimdLevel() is lowered to it;
+// `threads` 0 means one per core once the column is big enough.
+struct Options {
+    SimdLevel level = detectSimdLevel();
+    unsigned threads = 0;
+};
+
+struct Summary {
+    std::size_t count = 0;
+    Money total;
+    Money min;  // zero for an empty column
+    Money max;
+};
+
+// Throws std::overflow_error if the total does not fit in a Money.
+Summary summarize(const std::vector<Money>& balances, const Options& options = Options());
+// Balances strictly below `threshold`.
+std::size_t countBelow(const std::vector<Money>& balances, Money threshold, const Options& options = Options());
+// Balances in [low, high); 0 when high <= low.
+std::size_t countInRange(const std::vector<Money>& balances, Money low, Money high,
+                         const Options& options = Options());
+// edges.size() + 1 buckets: below edges[0], then [edges[i-1], edges[i]),
+// then edges.back() and above. Throws std::invalid_argument unless the
+// edges are ascending.
+std::vector<std::size_t> histogram(const std::vector<Money>& balances, const std::vector<Money>& edges,
+                                   const Options& options = Options());
+
+} // namespace balance_stats
@@ -1,28 +1,221 @@
 // bank.h
 #pragma once
 #include "account.h"
+#include "account_index.h"
+#include "account_range.h"
+#include "account_source.h"
+#include "account_store.h"
+#include "balance_stats.h"
+#include "bank_observer.h"
+#include "dirty_tracker.h"
 #include "ibank.h"
 #include "ipersistence.h"
+#include "transaction_history.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+struct BankOptions {
+    // Load accounts as they are touched instead of all at startup, when the
+    // persistence can open its book as an AccountSource (see
+    // IPersistence::openSource()); otherwise the book is loaded as usual.
+    // Startup then only reads the book's size and highest ID. Accounts that
+    // were read but not changed stay loaded up to `residentAccounts`, least
+    // recently used going first; changed and new ones stay until save(),
+    // or an AutoSaver snapshot, has written them. Searching by owner or
+    // card, posting runs and whole-book iteration load everything, once,
+    // and the bank carries on as if it had loaded eagerly.
+    bool lazyLoad = false;
+    std::size_t residentAccounts = 100000;
+};
+
 class Bank : public IBank {
 public:
-    explicit Bank(IPersistence& persistence);
-    int createAccount(const std::string& personName, const std::string& cardId, double initialBalance = 0.0);
-    bool deleteAccount(int accountId);
-    void deposit(int accountId, double amount);
-    void withdraw(int accountId, double amount);
-    const Account& getAccount(int accountId) const;
+    explicit Bank(IPersistence& persistence, const BankOptions& options = BankOptions());
+    int createAccount(const std::string& personName, const std::string& cardId, Money initialBalance = Money()) override;
+    bool deleteAccount(int accountId) override;
+    void deposit(int accountId, Money amount) override;
+    void withdraw(int accountId, Money amount) override;
+    Account getAccount(int accountId) const override;
+    Money getBalance(int accountId) const override;
+    void transfer(int fromAccountId, int toAccountId, Money amount) override;
+    void transferMany(const std::vector<Transfer>& transfers) override;
+    BatchReport applyBatch(const std::vector<BatchOperation>& operations) override;
+    // One journal record per chunk of kPostingChunk IDs, written before the
+    // chunk runs; if it fails, `checkpoint` resumes at that chunk.
+    PostingReport applyPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint,
+                                const PostingProgress& progress = nullptr) override;
+    // Non-copying lookup without hashing: nullptr for an unknown ID,
+    // otherwise valid until the next create or delete, or, with lazy
+    // loading, the next lookup that has to load an account.
+    const Account* find(int accountId) const {
+        return source_ ? resident(accountId, false) : accounts_.find(accountId);
+    }
+    // Copies every account; prefer accounts() or forEachAccount().
     std::vector<Account> getAllAccounts() const;
+    // Copies every account into the map persistence saves. With lazy
+    // loading, accounts not loaded are read for the copy but not kept.
+    std::unordered_map<int, Account> snapshot() const;
+
+    // Non-copying iteration in unspecified order. References stay valid
+    // until the next create or delete.
+    AccountRange accounts() const {
+        loadAll();
+        return AccountRange(accounts_);
+    }
+    template <typename Visitor>
+    void forEachAccount(Visitor&& visit) const {
+        loadAll();
+        for (const Account& account : accounts_)
+            visit(account);
+    }
+    // The underlying store, for scans that only need its columns
+    // (balances(), lastOperationTimes(), ...).
+    const AccountStore& store() const {
+        loadAll();
+        return accounts_;
+    }
+
+    // Whole-book balance aggregates over the store's balance column, or,
+    // with lazy loading, over a copy of every balance.
+    balance_stats::Summary balanceSummary() const {
+        std::vector<Money> scratch;
+        return balance_stats::summarize(allBalances(scratch));
+    }
+    std::size_t countBalancesBelow(Money threshold) const {
+        std::vector<Money> scratch;
+        return balance_stats::countBelow(allBalances(scratch), threshold);
+    }
+    std::size_t countBalancesInRange(Money low, Money high) const {
+        std::vector<Money> scratch;
+        return balance_stats::countInRange(allBalances(scratch), low, high);
+    }
+    std::vector<std::size_t> balanceHistogram(const std::vector<Money>& edges) const {
+        std::vector<Money> scratch;
+        return balance_stats::histogram(allBalances(scratch), edges);
+    }
+
+    // One page of accounts in ID order starting at `cursor` (0 starts from
+    // the beginning). Each call costs O(limit + deleted IDs skipped).
+    struct AccountPage {
+        std::vector<const Account*> accounts;  // valid until the next create or delete
+        int nextCursor = 0;                    // 0 once the book is exhausted
+    };
+    AccountPage page(int cursor, std::size_t limit) const;
+
+    // Indexed lookups, O(matches). The returned references are valid until
+    // the next create or delete.
+    const std::vector<int>& findByOwner(const std::string& personName) const {
+        loadAll();
+        return index_.byOwner(personName);
+    }
+    const std::vector<int>& findByCard(const std::string& cardId) const {
+        loadAll();
+        return index_.byCard(cardId);
+    }
+    // Search-as-you-type: owners whose name starts with `prefix`, any case.
+    std::vector<int> searchOwners(const std::string& prefix, std::size_t limit = 50) const {
+        loadAll();
+        return index_.byOwnerPrefix(prefix, limit);
+    }
+
+    std::size_t accountCount() const noexcept { return source_ ? bookSize_ : accounts_.size(); }
+    // Accounts held in memory: all of them unless loading lazily.
+    std::size_t residentCount() const noexcept { return accounts_.size(); }
     void save();
 
+    // For savers that write snapshot() on another thread (AutoSaver). With
+    // lazy loading, save() releases the accounts pinned since the last one;
+    // such a saver takes markSnapshot() along with its copy and, once the
+    // copy is written, hands snapshotSaved() the store's fresh openSource().
+    // Accounts changed after the mark stay pinned.
+    bool loadsLazily() const noexcept { return source_ != nullptr; }
+    std::uint64_t markSnapshot() noexcept { return ++snapshotMarks_; }
+    void snapshotSaved(std::unique_ptr<AccountSource> source, std::uint64_t mark);
+
+    // Deferred persistence: instead of handing every mutation to the store's
+    // per-operation hooks, only remember which accounts changed. Whoever
+    // turns it on (AutoSaver) must persist takeDirty() regularly; turning it
+    // off does not persist what is still dirty.
+    void setDeferredPersistence(bool deferred);
+    bool deferredPersistence() const noexcept { return hooks_ != &persistence_; }
+    // Copies of the accounts changed since the last save() or takeDirty(),
+    // plus the deleted IDs, and starts a fresh change set.
+    AccountDelta takeDirty();
+    std::size_t dirtyCount() const noexcept { return dirty_.size(); }
+
+    // Observers are not owned and must be removed before they are destroyed.
+    void addObserver(IBankObserver* observer);
+    void removeObserver(IBankObserver* observer);
+
+    // From now on every balance change is appended to `history`; nullptr
+    // stops that. Not owned; detach it before it is destroyed.
+    void setHistory(TransactionHistory* history) noexcept { history_ = history; }
+    TransactionHistory* history() const noexcept { return history_; }
+
 private:
     Account& findAccount(int accountId);
     const Account& findAccount(int accountId) const;
+    // Lazy loading. resident() loads one account if needed and returns it,
+    // nullptr for an unknown ID. makeResident() loads several at once, so
+    // that references taken to them afterwards stay valid: accounts are only
+    // evicted, and the store only grows, when something has to be loaded.
+    // Pinned accounts have changed since the source was written and are
+    // never evicted.
+    Account* resident(int accountId, bool pin) const;
+    // Marks a resident account used, or pins it; true if it is unpinned.
+    bool touch(int accountId, bool pin) const;
+    void makeResident(std::vector<int> accountIds, bool pin) const;
+    void evictFor(std::size_t incoming, std::size_t spared) const;
+    void loadAll() const {
+        if (source_)
+            loadSource();
+    }
+    void loadSource() const;
+    // After save(): the source now holds every change, so nothing is pinned.
+    void reopenSource();
+    // Switches to `reopened`, which holds every change made before `mark`.
+    void adoptSource(std::unique_ptr<AccountSource> reopened, std::uint64_t mark);
+    void noteChange(int accountId) const { changedAfter_[accountId] = snapshotMarks_; }
+    bool inSource(int accountId) const;
+    // The store's balance column, or with lazy loading every balance,
+    // copied into `scratch`.
+    const std::vector<Money>& allBalances(std::vector<Money>& scratch) const;
+    void compactIfNeeded();
+    // Appends the change an operation just made, as stamped on the account.
+    void recordHistory(const Account& account, Money change) {
+        if (history_)
+            history_->append(account.getAccountId(), account.lastOperationType(), change,
+                             account.lastOperationTime());
+    }
+    template <typename Notify>
+    void notify(Notify&& notify) const {
+        for (IBankObserver* observer : observers_)
+            notify(*observer);
+    }
     int nextAccountId_;
 
 private:
-    std::unordered_map<int, Account> accounts_;
+    // While lazy loading, accounts_ holds the resident accounts only and
+    // index_ is empty; both fill up when loadSource() loads the rest.
+    mutable AccountStore accounts_;
+    mutable AccountIndex index_;
+    mutable std::unique_ptr<AccountSource> source_;
+    std::size_t residentLimit_ = 0;
+    std::size_t bookSize_ = 0;                 // accounts, loaded or not
+    std::unordered_set<int> deletedFromSource_;
+    // Pinned or deleted accounts, by the last snapshot mark before the change.
+    mutable std::unordered_map<int, std::uint64_t> changedAfter_;
+    std::uint64_t snapshotMarks_ = 0;
+    mutable std::list<int> unpinned_;          // least recently used first
+    mutable std::unordered_map<int, std::list<int>::iterator> unpinnedAt_;
+    std::vector<IBankObserver*> observers_;
     IPersistence& persistence_;
+    DirtyTracker dirty_;
+    IPersistence* hooks_;  // persistence_, or dirty_ while deferred
+    TransactionHistory* history_ = nullptr;
 };
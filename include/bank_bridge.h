@@ -1,28 +1,59 @@
 #pragma once
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QJsonArray>
 #include <QJsonObject>
-#include "bank.h"
+#include <atomic>
+#include <cstdint>
+#include "autosaver.h"
+#include "bank_worker.h"
 
+// QML facade over the bank. Every slot only queues a job on the
+// BankWorker and returns at once; results come back through the signals,
+// which Qt delivers to QML on the GUI thread. Read-only requests that the
+// UI fires repeatedly (refresh, lookups, save) are coalesced with a waiting
+// request for the same arguments; owner suggestions keep only the latest
+// keystroke. With an AutoSaver, saveData() goes through it so its writes
+// stay in order.
 class BankBridge : public QObject {
     Q_OBJECT
 
 public:
-    explicit BankBridge(Bank& bank, QObject* parent = nullptr);
+    explicit BankBridge(BankWorker& worker, AutoSaver* autosaver = nullptr, QObject* parent = nullptr);
     ~BankBridge();
 
 public slots:
-    int createAccount(const QString& personName, const QString& cardId, double initialBalance = 0.0);
-    bool deleteAccount(int accountId);
+    // QML hands amounts over as numbers; they become Money at this boundary.
+    void createAccount(const QString& personName, const QString& cardId, double initialBalance = 0.0);
+    void deleteAccount(int accountId);
     void deposit(int accountId, double amount);
     void withdraw(int accountId, double amount);
-    QJsonObject getAccount(int accountId);
-    QJsonArray getAllAccounts();
+    void transfer(int fromAccountId, int toAccountId, double amount);
+    void getAccount(int accountId);
+    void getAllAccounts();
     void saveData();
     void getAccountDetails(int accountId);
+    // One page of the account's transaction history, newest first. `before`
+    // is 0 for the newest page, then the nextCursor the previous page
+    // reported; a page with nextCursor 0 is the last.
+    void getHistory(int accountId, int limit = 20, double before = 0);
     void getPersonAccounts(const QString& personName);
+    // Distinct owner names starting with `prefix` (any case), for search-as-you-type.
+    void suggestOwners(const QString& prefix, int limit = 5);
     void getAllAccountDetails();
+    // Totals, extremes, a balance histogram and how many accounts sit below
+    // `lowBalance`, computed over the balance column without listing accounts.
+    void getBalanceSummary(double lowBalance = 100.0, int buckets = 8);
+    // Posts interest and fees to every account by `schedule`, the text of
+    // a schedule file (see posting.h). A run stopped by cancelPosting() is
+    // resumed by the next call. Progress arrives through postingProgress()
+    // after each chunk of accounts.
+    void postInterestAndFees(const QString& schedule);
+    void cancelPosting();
+    // Counters and latency percentiles for the diagnostics panel. Reads the
+    // metrics directly rather than queueing behind the bank's work.
+    void getMetrics();
 
 signals:
     void accountCreated(int accountId);
@@ -30,10 +61,25 @@ signals:
     void balanceChanged(int accountId, double newBalance);
     void error(const QString& message);
     void accountsUpdated();
+    void accountRetrieved(const QJsonObject& account);
+    void allAccountsListed(const QJsonArray& accounts);
+    void saved();
     void detailsRetrieved(const QJsonObject& details);
+    void historyRetrieved(int accountId, const QJsonArray& entries, double nextCursor);
     void personAccountsRetrieved(const QString& accountsList);
+    void ownerSuggestionsRetrieved(const QString& prefix, const QStringList& names);
     void allAccountsRetrieved(const QString& accountsList);
+    void balanceSummaryRetrieved(const QJsonObject& summary);
+    void postingProgress(int processed, int total);
+    void postingFinished(const QJsonObject& report);
+    void metricsRetrieved(const QJsonObject& metrics);
 
 private:
-    Bank& bank_;
+    BankWorker& worker_;
+    AutoSaver* autosaver_;
+    // Posting runs are numbered as they are queued; cancelPosting() cancels
+    // every run numbered up to cancelledRuns_.
+    std::uint64_t postingRuns_ = 0;  // GUI thread only
+    std::atomic<std::uint64_t> cancelledRuns_{0};
+    PostingCheckpoint postingCheckpoint_;  // only touched by worker jobs
 };
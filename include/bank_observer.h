@@ -0,0 +1,18 @@
+// bank_observer.h
+#pragma once
+#include "account.h"
+
+// Change notifications from Bank, delivered synchronously on the thread
+// that made the change, after the change has been journaled. Views use
+// them to update incrementally instead of re-reading the whole book.
+class IBankObserver {
+public:
+    virtual ~IBankObserver() = default;
+    virtual void accountCreated(const Account& account) { (void)account; }
+    virtual void accountDeleted(int accountId) { (void)accountId; }
+    // Balance or last-operation metadata changed.
+    virtual void accountChanged(const Account& account) { (void)account; }
+    // Many accounts changed at once (a posting run); there is no
+    // accountChanged() for each of them, so re-read what is shown.
+    virtual void accountsChanged() {}
+};
@@ -0,0 +1,130 @@
+// bank_protocol.h
+#pragma once
+#include "ibank.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Wire format between BankServer and RemoteBank. Both ends share a machine
+// (the transport is a Unix domain socket), so integers are in host byte
+// order. Every message is a frame:
+//   u32 size (of the rest) | u32 tag | u8 code | body
+// A request's code is an Op, a reply's a Status, and a reply carries its
+// request's tag. Replies come back in request order, so a client may write
+// any number of requests before reading the first reply.
+//
+// In bodies, strings are a u32 length and the bytes, Money its i64 minor
+// units and a Timestamp i64 microseconds since the epoch.
+namespace bank_protocol {
+
+constexpr std::size_t kHeaderSize = 9;
+// Larger frames are a broken or hostile peer; the connection is dropped.
+constexpr std::uint32_t kMaxFrame = 64u << 20;
+
+enum class Op : std::uint8_t {
+    CreateAccount = 1,  // str name, str card, money -> i32 id
+    DeleteAccount,      // i32 id -> u8 deleted
+    Deposit,            // i32 id, money ->
+    Withdraw,           // i32 id, money ->
+    GetAccount,         // i32 id -> account
+    GetBalance,         // i32 id -> money
+    Transfer,           // i32 from, i32 to, money ->
+    TransferMany,       // u32 n, n * (i32 from, i32 to, money) ->
+    ApplyBatch,         // u32 n, n * (u64 line, u8 type, i32 id, money) -> batch report
+    PostChunk,          // schedule, checkpoint -> checkpoint, posting report
+};
+
+// An error reply's body is the message of what the server's bank threw.
+enum class Status : std::uint8_t {
+    Ok = 0,
+    InvalidArgument,  // std::invalid_argument
+    Overflow,         // std::overflow_error
+    Failed,           // any other exception
+    BadRequest,       // unknown op or malformed body
+};
+
+// A frame or body that does not decode.
+class ProtocolError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Appends to `out`, which may already hold earlier frames.
+class Writer {
+public:
+    explicit Writer(std::string& out) noexcept : out_(out) {}
+
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void putMoney(Money amount) { put(amount.minorUnits()); }
+    void putTime(Timestamp time) { put(static_cast<std::int64_t>(time.time_since_epoch().count())); }
+    void putString(std::string_view text);
+
+    // Starts a frame; the size is filled in by endFrame().
+    void beginFrame(std::uint32_t tag, std::uint8_t code);
+    void endFrame();
+
+private:
+    std::string& out_;
+    std::size_t frameStart_ = 0;
+};
+
+// Reads a body front to back; running past its end throws ProtocolError.
+class Reader {
+public:
+    explicit Reader(std::string_view body) noexcept : body_(body) {}
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+    Money getMoney() { return Money::fromMinorUnits(get<std::int64_t>()); }
+    Timestamp getTime() { return Timestamp(std::chrono::microseconds(get<std::int64_t>())); }
+    std::string_view getString();
+    // A count of items at least `itemSize` bytes each, checked against what
+    // is left so a bad count cannot make the caller reserve gigabytes.
+    std::uint32_t getCount(std::size_t itemSize);
+    // Throws ProtocolError unless the whole body has been read.
+    void finish() const {
+        if (!body_.empty())
+            throw ProtocolError("Trailing bytes in bank protocol message");
+    }
+
+private:
+    const char* take(std::size_t size);
+
+    std::string_view body_;
+};
+
+// A complete frame at the front of `buffer`.
+struct Frame {
+    std::uint32_t tag;
+    std::uint8_t code;
+    std::string_view body;
+    std::size_t size;  // header included
+};
+// False while `buffer` holds less than one frame. Throws ProtocolError for
+// a size field out of range.
+bool nextFrame(std::string_view buffer, Frame& frame);
+
+void putAccount(Writer& out, const Account& account);
+Account getAccount(Reader& in);
+void putBatchReport(Writer& out, const BatchReport& report);
+BatchReport getBatchReport(Reader& in);
+void putSchedule(Writer& out, const PostingSchedule& schedule);
+PostingSchedule getSchedule(Reader& in);
+void putPostingReport(Writer& out, const PostingReport& report);
+PostingReport getPostingReport(Reader& in);
+
+} // namespace bank_protocol
@@ -0,0 +1,72 @@
+// bank_server.h
+#pragma once
+#include "ibank.h"
+#include "ipersistence.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct BankServerOptions {
+    std::string socketPath = "bank.sock";
+    // Connections beyond this are accepted and closed at once.
+    std::size_t maxConnections = 1024;
+    // A client whose unread replies exceed this is not read from until it
+    // catches up, so a client that only writes cannot grow the server
+    // without bound.
+    std::size_t maxPendingReplies = 4 << 20;
+    // The bank's journal, if any: synced once per round of the loop before
+    // any reply in that round goes out, so a client never hears of a change
+    // that a crash would lose. Must outlive the server.
+    IPersistence* journal = nullptr;
+};
+
+// Serves an IBank over a Unix domain socket in the format of
+// bank_protocol.h, to RemoteBank clients.
+//
+// One thread runs an epoll loop over every connection and is the only one
+// that calls the bank, so a plain Bank is safe to serve; leave it alone
+// while the server runs. Each time a connection is readable the loop reads
+// what has arrived, runs every complete request in it in order and answers
+// them with a single write, so a client that pipelines requests gets its
+// replies batched too. Those writes wait until the round has handled every
+// ready connection and the journal has been synced once for all of them. Requests from different clients interleave at that
+// granularity; each request, transferMany and applyBatch included, runs
+// whole before the next.
+//
+// Throws std::runtime_error if the socket cannot be set up.
+class BankServer {
+public:
+    BankServer(IBank& bank, BankServerOptions options);
+    // Stops after the request in progress, closes every connection
+    // (dropping replies not yet written) and removes the socket.
+    ~BankServer();
+
+    BankServer(const BankServer&) = delete;
+    BankServer& operator=(const BankServer&) = delete;
+
+private:
+    struct Connection;
+
+    void run();
+    void accept();
+    // Runs the requests that have arrived; the replies wait for answer().
+    void serve(Connection& connection);
+    // Syncs the journal, then writes the replies queued on `served`.
+    void answer(const std::vector<int>& served);
+    void handle(std::uint32_t tag, std::uint8_t code, std::string_view body, std::string& out);
+    // False once the connection is gone.
+    bool flush(Connection& connection);
+    void watch(Connection& connection);
+    void close(int fd);
+
+    IBank& bank_;
+    BankServerOptions options_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;  // an eventfd, signalled on shutdown
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;  // by fd
+    std::thread thread_;
+};
@@ -0,0 +1,61 @@
+// bank_worker.h
+#pragma once
+#include "bank.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Serializes every use of a Bank onto one dedicated thread so callers (the
+// GUI thread in particular) never block on it. Jobs run in the order they
+// were posted. Bank itself is not thread-safe: once a worker exists, touch
+// the bank only from jobs.
+class BankWorker {
+public:
+    using Job = std::function<void(Bank&)>;
+    // Receives what a job threw; called on the worker thread.
+    using ErrorHandler = std::function<void(const std::string& error)>;
+
+    explicit BankWorker(Bank& bank);
+    // Runs whatever is still queued, then joins the thread.
+    ~BankWorker();
+
+    BankWorker(const BankWorker&) = delete;
+    BankWorker& operator=(const BankWorker&) = delete;
+
+    void post(Job job);
+    // While a job posted under `key` is still waiting, a new one replaces it
+    // in place instead of queueing behind it, so ten refresh clicks during a
+    // slow save run one refresh. Returns false when it replaced a job.
+    bool postCoalesced(const std::string& key, Job job);
+    // Blocks until every job posted so far has finished.
+    void waitIdle();
+    // Jobs are expected to report their own errors; anything that escapes
+    // one goes to `handler`, if set, and the worker carries on.
+    void setErrorHandler(ErrorHandler handler);
+
+private:
+    struct Entry {
+        std::string key;
+        Job job;
+    };
+
+    void run();
+    // Hands a failed job's error to the handler; called with lock released.
+    void report(std::unique_lock<std::mutex>& lock, const std::string& error);
+
+    Bank& bank_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::deque<std::unique_ptr<Entry>> queue_;
+    std::unordered_map<std::string, Entry*> pending_;
+    ErrorHandler errorHandler_;
+    bool busy_ = false;
+    bool stopping_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,109 @@
+// batch.h
+#pragma once
+#include "account.h"
+#include "ipersistence.h"
+#include <algorithm>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class BatchOpType { Deposit, Withdraw };
+
+struct BatchOperation {
+    std::size_t line;
+    BatchOpType type;
+    int accountId;
+    Money amount;
+};
+
+struct BatchFailure {
+    std::size_t line;
+    std::string message;
+};
+
+struct BatchReport {
+    std::size_t applied = 0;
+    std::vector<BatchFailure> failures;
+
+    void merge(BatchReport&& other);
+    void sortFailuresByLine();
+};
+
+// Streams operations from a settlement file in bounded chunks.
+//
+// CSV (default):  op,accountId,amount     e.g. "deposit,12,100.50"
+// JSON Lines (.jsonl): {"op": "withdraw", "accountId": 12, "amount": 5}
+// Blank lines and lines starting with '#' are skipped, as is a CSV header.
+// Lines that cannot be parsed are reported as failures, not thrown.
+class BatchReader {
+public:
+    explicit BatchReader(const std::string& filename);
+    ~BatchReader();
+
+    // Reads up to maxOperations into `operations` (replacing its contents).
+    // Returns false once the file is exhausted and nothing was read.
+    bool next(std::vector<BatchOperation>& operations, std::vector<BatchFailure>& failures,
+              std::size_t maxOperations = 1 << 20);
+
+private:
+    std::unique_ptr<std::ifstream> file_;
+    bool jsonLines_;
+    std::size_t line_ = 0;
+};
+
+// Applies operations grouped by account: `order` is sorted (stably) by
+// account, each account is looked up once, and its operations run in file
+// order. Lookup returns nullptr for an unknown account. Deposits and
+// withdrawals on different accounts commute, so the result matches
+// applying the file line by line. An operation whose record `persistence`
+// cannot write is taken back and reported as a failure of its line.
+template <typename Lookup>
+void applyBatchGroups(const std::vector<BatchOperation>& operations, std::vector<std::size_t>& order,
+                      Lookup&& lookup, IPersistence& persistence, BatchReport& report) {
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return operations[a].accountId < operations[b].accountId;
+    });
+
+    for (std::size_t begin = 0; begin < order.size();) {
+        int accountId = operations[order[begin]].accountId;
+        std::size_t end = begin;
+        while (end < order.size() && operations[order[end]].accountId == accountId)
+            ++end;
+
+        Account* account = lookup(accountId);
+        for (std::size_t i = begin; i < end; ++i) {
+            const BatchOperation& op = operations[order[i]];
+            if (!account) {
+                report.failures.push_back({op.line, "Account not found"});
+                continue;
+            }
+            const Money balance = account->balance();
+            const OperationType lastType = account->lastOperationType();
+            const Timestamp lastTime = account->lastOperationTime();
+            try {
+                if (op.type == BatchOpType::Deposit)
+                    account->deposit(op.amount);
+                else
+                    account->withdraw(op.amount);
+            } catch (const std::exception& ex) {
+                report.failures.push_back({op.line, ex.what()});
+                continue;
+            }
+            try {
+                if (op.type == BatchOpType::Deposit)
+                    persistence.recordDeposit(*account, op.amount);
+                else
+                    persistence.recordWithdraw(*account, op.amount);
+            } catch (const std::exception& ex) {
+                account->setBalance(balance);
+                account->updateOperationInfo(lastType, lastTime);
+                report.failures.push_back({op.line, std::string("Not recorded: ") + ex.what()});
+                continue;
+            }
+            ++report.applied;
+        }
+        begin = end;
+    }
+}
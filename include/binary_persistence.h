@@ -0,0 +1,84 @@
+// binary_persistence.h
+#pragma once
+#include "account_source.h"
+#include "ipersistence.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Read-only, memory-mapped view of a binary snapshot.
+//
+// File layout (host byte order):
+//   Header | Record[count] sorted by accountId | string pool
+// written atomically (see replaceFileAtomically).
+// Each record is fixed width, holds its timestamps as integer microseconds
+// and refers to its strings by (offset, length) into the pool, so a lookup
+// only touches the pages it reads, which also makes it an AccountSource.
+class BinarySnapshotView final : public AccountSource {
+public:
+    explicit BinarySnapshotView(const std::string& filename);
+    ~BinarySnapshotView() override;
+
+    BinarySnapshotView(BinarySnapshotView&& other) noexcept;
+    BinarySnapshotView& operator=(BinarySnapshotView&& other) noexcept;
+    BinarySnapshotView(const BinarySnapshotView&) = delete;
+    BinarySnapshotView& operator=(const BinarySnapshotView&) = delete;
+
+    std::size_t size() const noexcept override { return count_; }
+    int maxAccountId() const noexcept override;
+    // Checksum of the file this snapshot was derived from, or 0. It lets a
+    // snapshot serve as a cache of that file (see JsonPersistence).
+    std::uint64_t sourceChecksum() const noexcept;
+    // Reads the records and string pool through and checks them against the
+    // checksum in the header.
+    bool verify() const noexcept;
+
+    // Index of the record for accountId, or npos. Binary search over the table.
+    std::size_t find(int accountId) const noexcept override;
+    std::size_t lowerBound(int accountId) const noexcept override;
+
+    int accountId(std::size_t index) const override;
+    Money balance(std::size_t index) const override;
+    std::string_view personName(std::size_t index) const;
+    std::string_view cardId(std::size_t index) const;
+    Timestamp creationTime(std::size_t index) const;
+    OperationType lastOperationType(std::size_t index) const;
+    Timestamp lastOperationTime(std::size_t index) const;
+
+    Account materialize(std::size_t index) const override;
+    std::unordered_map<int, Account> materializeAll() const;
+
+private:
+    struct Record;
+
+    const Record& record(std::size_t index) const;
+    std::string_view poolString(std::uint32_t offset, std::uint32_t length) const;
+
+    const char* data_ = nullptr;
+    std::size_t mappedSize_ = 0;
+    std::size_t count_ = 0;
+    const Record* records_ = nullptr;
+    const char* pool_ = nullptr;
+    std::size_t poolSize_ = 0;
+
+    friend class BinaryPersistence;
+};
+
+class BinaryPersistence : public IPersistence {
+public:
+    explicit BinaryPersistence(const std::string& filename);
+    void save(const std::unordered_map<int, Account>& accounts) override;
+    void save(const std::unordered_map<int, Account>& accounts, std::uint64_t sourceChecksum);
+    std::unordered_map<int, Account> load() override;
+    // Maps the file; nullptr if there is none.
+    std::unique_ptr<AccountSource> openSource() override;
+
+private:
+    std::string filename_;
+};
+
+// Rewrites a snapshot from one store into another, e.g. JSON -> binary.
+void convertSnapshot(IPersistence& from, IPersistence& to);
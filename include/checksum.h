@@ -0,0 +1,64 @@
+// checksum.h
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Multiply-xor over 8-byte words (host byte order). It only has to catch
+// damage, not resist forgery, and runs several times faster than a
+// byte-at-a-time FNV, which matters on a 30 MB book. Every step is a
+// bijection of the running state, so any one damaged word is always caught.
+//
+// The total length is part of the seed, so it must be known up front; the
+// data may then arrive in pieces of any size.
+class Checksum64 {
+public:
+    explicit Checksum64(std::uint64_t length) noexcept : hash_(14695981039346656037ull ^ length) {}
+
+    void update(std::string_view data) noexcept {
+        if (pending_ > 0) {
+            const std::size_t take = std::min(sizeof(buffer_) - pending_, data.size());
+            std::memcpy(buffer_ + pending_, data.data(), take);
+            pending_ += take;
+            data.remove_prefix(take);
+            if (pending_ < sizeof(buffer_))
+                return;
+            mix(buffer_);
+            pending_ = 0;
+        }
+        while (data.size() >= sizeof(std::uint64_t)) {
+            mix(data.data());
+            data.remove_prefix(sizeof(std::uint64_t));
+        }
+        std::memcpy(buffer_, data.data(), data.size());
+        pending_ = data.size();
+    }
+
+    // The trailing partial word goes in a byte at a time.
+    std::uint64_t finish() const noexcept {
+        std::uint64_t hash = hash_;
+        for (std::size_t i = 0; i < pending_; ++i)
+            hash = (hash ^ static_cast<unsigned char>(buffer_[i])) * 1099511628211ull;
+        return hash;
+    }
+
+private:
+    void mix(const char* bytes) noexcept {
+        std::uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        hash_ = (hash_ ^ word) * 0x9e3779b97f4a7c15ull;
+        hash_ ^= hash_ >> 32;
+    }
+
+    std::uint64_t hash_;
+    char buffer_[sizeof(std::uint64_t)];
+    std::size_t pending_ = 0;
+};
+
+inline std::uint64_t checksum64(std::string_view data) noexcept {
+    Checksum64 sum(data.size());
+    sum.update(data);
+    return sum.finish();
+}
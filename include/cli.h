@@ -1,13 +1,23 @@
 // cli.h
 #pragma once
 #include "ibank.h"
+#include <atomic>
 #include <iostream>
+#include <string>
 
 class CLI {
 public:
     explicit CLI(IBank& bank) : bank_(bank) {}
 
     void run();
+    // Non-interactive settlement: streams a CSV/JSONL file of operations
+    // through IBank::applyBatch and prints a summary with ops/sec.
+    BatchReport runBatch(const std::string& filename, std::ostream& out = std::cout);
+    // Posts interest and fees by the schedule in `scheduleFile`, resuming
+    // `checkpoint`, with a progress line per chunk and a summary at the
+    // end. Setting `interrupted` stops the run at the next chunk.
+    PostingReport runPostings(const std::string& scheduleFile, PostingCheckpoint& checkpoint,
+                              std::ostream& out = std::cout, const std::atomic<bool>* interrupted = nullptr);
 
 private:
     void showMenu() const;
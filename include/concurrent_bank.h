@@ -0,0 +1,61 @@
+// concurrent_bank.h
+#pragma once
+#include "account.h"
+#include "ibank.h"
+#include "ipersistence.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+// Thread-safe bank. Accounts are sharded by ID across independently locked
+// partitions, so operations on accounts in different shards run in
+// parallel. Reads take a shared lock; IDs come from an atomic counter.
+class ConcurrentBank : public IBank {
+public:
+    // shardCount is rounded up to a power of two; 0 picks one from the
+    // number of hardware threads.
+    explicit ConcurrentBank(IPersistence& persistence, std::size_t shardCount = 0);
+
+    int createAccount(const std::string& personName, const std::string& cardId, Money initialBalance = Money()) override;
+    bool deleteAccount(int accountId) override;
+    void deposit(int accountId, Money amount) override;
+    void withdraw(int accountId, Money amount) override;
+    Account getAccount(int accountId) const override;
+    Money getBalance(int accountId) const override;
+    // Shard locks are always taken in ascending shard order, so concurrent
+    // transfers in opposite directions cannot deadlock.
+    void transfer(int fromAccountId, int toAccountId, Money amount) override;
+    void transferMany(const std::vector<Transfer>& transfers) override;
+    // Operations are bucketed by shard and the shards are spread across
+    // worker threads; each shard is locked once for its whole bucket.
+    BatchReport applyBatch(const std::vector<BatchOperation>& operations) override;
+    // Holds every shard exclusively for the call; the accounts are still
+    // posted by several threads.
+    PostingReport applyPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint,
+                                const PostingProgress& progress = nullptr) override;
+
+    std::size_t accountCount() const;
+    std::size_t shardCount() const noexcept { return shardMask_ + 1; }
+    void save();
+
+private:
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<int, Account> accounts;
+    };
+
+    std::size_t shardIndex(int accountId) const noexcept { return static_cast<std::size_t>(accountId) & shardMask_; }
+    Shard& shardFor(int accountId) const noexcept { return shards_[shardIndex(accountId)]; }
+    static Account& findAccount(Shard& shard, int accountId);
+    void saveLocked();
+    void compactIfNeeded();
+
+    std::unique_ptr<Shard[]> shards_;
+    std::size_t shardMask_;
+    std::atomic<int> nextAccountId_{1};
+    std::mutex saveMutex_;
+    IPersistence& persistence_;
+};
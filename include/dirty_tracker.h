@@ -0,0 +1,63 @@
+// dirty_tracker.h
+#pragma once
+#include "ipersistence.h"
+#include <cstddef>
+#include <unordered_set>
+
+// Stands in for a store on the per-operation hooks and only remembers
+// which accounts they touched. Bank routes its hooks here while
+// persistence is deferred, so a mutation costs a set insert instead of
+// I/O, and a hot account costs one record per flush however often it
+// changed.
+class DirtyTracker : public IPersistence {
+public:
+    void save(const std::unordered_map<int, Account>& accounts) override { (void)accounts; }
+    std::unordered_map<int, Account> load() override { return {}; }
+
+    void recordCreate(const Account& account) override {
+        changed_.insert(account.getAccountId());
+        ++created_;
+    }
+    void recordDelete(int accountId) override {
+        changed_.erase(accountId);
+        deleted_.insert(accountId);
+    }
+    void recordDeposit(const Account& account, Money amount) override {
+        (void)amount;
+        changed_.insert(account.getAccountId());
+    }
+    void recordWithdraw(const Account& account, Money amount) override {
+        (void)amount;
+        changed_.insert(account.getAccountId());
+    }
+    void recordTransfer(const Account& from, const Account& to, Money amount) override {
+        (void)amount;
+        changed_.insert(from.getAccountId());
+        changed_.insert(to.getAccountId());
+    }
+    void recordTransfers(const std::vector<TransferRecord>& transfers, Timestamp when) override {
+        (void)when;
+        for (const TransferRecord& transfer : transfers) {
+            changed_.insert(transfer.fromAccountId);
+            changed_.insert(transfer.toAccountId);
+        }
+    }
+
+    // For changes that reach Bank without a per-account hook.
+    void markChanged(int accountId) { changed_.insert(accountId); }
+
+    const std::unordered_set<int>& changed() const noexcept { return changed_; }
+    const std::unordered_set<int>& deleted() const noexcept { return deleted_; }
+    std::size_t created() const noexcept { return created_; }
+    std::size_t size() const noexcept { return changed_.size() + deleted_.size(); }
+    void clear() noexcept {
+        changed_.clear();
+        deleted_.clear();
+        created_ = 0;
+    }
+
+private:
+    std::unordered_set<int> changed_;
+    std::unordered_set<int> deleted_;
+    std::size_t created_ = 0;
+};
@@ -1,13 +1,43 @@
 // ibank.h
 #pragma once
 #include "account.h"
+#include "batch.h"
+#include "posting.h"
+#include <vector>
+
+struct Transfer {
+    int fromAccountId;
+    int toAccountId;
+    Money amount;
+};
 
 class IBank {
 public:
     virtual ~IBank() = default;
-    virtual int createAccount(const std::string& personName, const std::string& cardId, double initialBalance = 0.0) = 0;
+    virtual int createAccount(const std::string& personName, const std::string& cardId, Money initialBalance = Money()) = 0;
     virtual bool deleteAccount(int accountId) = 0;
-    virtual void deposit(int accountId, double amount) = 0;
-    virtual void withdraw(int accountId, double amount) = 0;
-    virtual const Account& getAccount(int accountId) const = 0;
-};
\ No newline at end of file
+    virtual void deposit(int accountId, Money amount) = 0;
+    virtual void withdraw(int accountId, Money amount) = 0;
+    // Returned by value: a concurrent implementation cannot hand out a
+    // reference that outlives its lock.
+    virtual Account getAccount(int accountId) const = 0;
+    virtual Money getBalance(int accountId) const = 0;
+
+    // Moves money between two accounts atomically: either both balances
+    // change or neither does.
+    virtual void transfer(int fromAccountId, int toAccountId, Money amount) = 0;
+    // Applies the transfers in order, all or nothing. The whole batch is
+    // validated before any balance changes.
+    virtual void transferMany(const std::vector<Transfer>& transfers) = 0;
+
+    // Applies a batch of deposits/withdrawals. A failing operation is
+    // reported with its line number and does not stop the batch.
+    virtual BatchReport applyBatch(const std::vector<BatchOperation>& operations) = 0;
+
+    // Posts interest and fees to every account by `schedule` (see
+    // posting.h), picking up at `checkpoint` and advancing it. Stops early
+    // when `progress` returns false; the report says whether the run is
+    // complete.
+    virtual PostingReport applyPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint,
+                                        const PostingProgress& progress = nullptr) = 0;
+};
@@ -1,11 +1,88 @@
 // ipersistence.h
 #pragma once
 #include "account.h"
+#include "account_source.h"
+#include "posting.h"
+#include <memory>
 #include <unordered_map>
+#include <vector>
+
+// Everything that changed since the last persist: the current state of each
+// created or modified account and the IDs of deleted ones.
+struct AccountDelta {
+    std::vector<Account> changed;
+    std::vector<int> deleted;
+    // Accounts created since the last persist, including any since deleted.
+    std::size_t created = 0;
+
+    bool empty() const noexcept { return changed.empty() && deleted.empty(); }
+};
+
+// One transfer of a batch as journaled: the amount and the balances it
+// leaves on both sides.
+struct TransferRecord {
+    int fromAccountId;
+    Money fromBalance;
+    int toAccountId;
+    Money toBalance;
+    Money amount;
+};
 
 class IPersistence {
 public:
     virtual ~IPersistence() = default;
     virtual void save(const std::unordered_map<int, Account>& accounts) = 0;
     virtual std::unordered_map<int, Account> load() = 0;
-};
\ No newline at end of file
+    // For callers that copy the book under their own locks and call save()
+    // after releasing them: called while the copy still matches what the
+    // hooks have recorded, it tells the next save() that records arriving
+    // after this point are not in its snapshot.
+    virtual void beginSave() {}
+
+    // Per-operation hooks called by Bank after each mutation. Snapshot-only
+    // stores ignore them; journaling stores append a record.
+    virtual void recordCreate(const Account& account) { (void)account; }
+    virtual void recordDelete(int accountId) { (void)accountId; }
+    virtual void recordDeposit(const Account& account, Money amount) { (void)account; (void)amount; }
+    virtual void recordWithdraw(const Account& account, Money amount) { (void)account; (void)amount; }
+    virtual void recordTransfer(const Account& from, const Account& to, Money amount) {
+        (void)from;
+        (void)to;
+        (void)amount;
+    }
+    // A whole transferMany() batch, written before any balance changes, so
+    // replay applies all of it or none.
+    virtual void recordTransfers(const std::vector<TransferRecord>& transfers, Timestamp when) {
+        (void)transfers;
+        (void)when;
+    }
+    // One record per chunk of a posting run, not one per account, written
+    // before the chunk is posted.
+    virtual void recordPosting(const PostingSchedule& schedule, const PostingSegment& segment) {
+        (void)schedule;
+        (void)segment;
+    }
+
+    // Persists only the accounts in `delta` on top of what was saved before.
+    // Returns false, without writing anything, when the store can only write
+    // whole snapshots; callers then fall back to save().
+    virtual bool saveDelta(const AccountDelta& delta) {
+        (void)delta;
+        return false;
+    }
+    // Whether saveDelta() writes anything; asking costs no I/O.
+    virtual bool supportsDelta() const { return false; }
+
+    // Forces what the hooks have recorded so far to disk, for callers that
+    // acknowledge several operations at once.
+    virtual void flush() {}
+
+    // True when the store would like Bank to hand it a fresh snapshot.
+    virtual bool needsCompaction() const { return false; }
+
+    // The saved book as an AccountSource, for lazy loading, in place of
+    // load(). nullptr when the store cannot open one without reading
+    // everything; Bank then calls load(). Like load(), it prepares the store
+    // for the hooks that follow.
+    virtual std::unique_ptr<AccountSource> openSource() { return nullptr; }
+};
@@ -0,0 +1,110 @@
+// journal_persistence.h
+#pragma once
+#include "atomic_file.h"
+#include "ipersistence.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Append-only write-ahead journal layered over a snapshot store.
+//
+// Every mutation is appended as a small binary record (a transfer, and a
+// whole transferMany() batch, is one record, so it is never half-replayed);
+// records are written and fdatasync'ed in batches of `syncEvery`. save()
+// writes a compacted snapshot through the wrapped store and then truncates
+// the journal, and load() replays the journal on top of the last snapshot.
+//
+// Records carry the account state after the operation, so replay is
+// idempotent: a crash between the snapshot write and the journal rewrite
+// only replays operations the snapshot already contains. The journal lock
+// is not held while the snapshot is written; records appended meanwhile,
+// or since beginSave(), are kept in the fresh journal. A hook whose
+// record cannot be written drops it and throws, and Bank takes the change
+// back. All members are safe to call from several threads.
+//
+// Under deferred persistence (see AutoSaver) Bank skips the per-operation
+// hooks and saveDelta() appends the current state of each changed account.
+class JournalPersistence : public IPersistence {
+public:
+    JournalPersistence(IPersistence& snapshot, const std::string& journalFile,
+                       std::size_t syncEvery = 64, std::size_t compactThreshold = 100000);
+    ~JournalPersistence() override;
+
+    JournalPersistence(const JournalPersistence&) = delete;
+    JournalPersistence& operator=(const JournalPersistence&) = delete;
+
+    void save(const std::unordered_map<int, Account>& accounts) override;
+    std::unordered_map<int, Account> load() override;
+    void beginSave() override;
+    // The snapshot's source, provided the journal holds no records to
+    // replay; nullptr otherwise, so the book is loaded and replayed.
+    std::unique_ptr<AccountSource> openSource() override;
+
+    void recordCreate(const Account& account) override;
+    void recordDelete(int accountId) override;
+    void recordDeposit(const Account& account, Money amount) override;
+    void recordWithdraw(const Account& account, Money amount) override;
+    void recordTransfer(const Account& from, const Account& to, Money amount) override;
+    void recordTransfers(const std::vector<TransferRecord>& transfers, Timestamp when) override;
+    // Stores the schedule and the segment, not the accounts; replay runs
+    // the schedule again. Synced at once, like saveDelta().
+    void recordPosting(const PostingSchedule& schedule, const PostingSegment& segment) override;
+    // Appends one State record per changed account (its full state, so
+    // replay upserts it) and one Delete per removed ID, then syncs.
+    bool saveDelta(const AccountDelta& delta) override;
+    bool supportsDelta() const override { return true; }
+    bool needsCompaction() const override;
+
+    // Writes buffered records and forces them to disk.
+    void flush() override;
+
+    std::size_t journaledRecords() const;
+
+private:
+    enum class RecordType : std::uint8_t {
+        Create = 1,
+        Delete = 2,
+        Deposit = 3,
+        Withdraw = 4,
+        Transfer = 5,
+        State = 6,
+        Posting = 7,
+        TransferBatch = 8
+    };
+
+    // Where the journal stood when a snapshot was taken.
+    struct SaveMark {
+        std::size_t offset = 0;
+        std::size_t records = 0;
+        std::size_t liveAccounts = 0;
+    };
+
+    SaveMark markLocked() const;
+    // Replaces the journal with the records appended after `mark`.
+    void keepTailLocked(const SaveMark& mark);
+    void openJournal(bool truncate);
+    void closeJournal() noexcept;
+    void appendDeleteRecord(int accountId);
+    void appendBalanceRecord(RecordType type, const Account& account, Money amount);
+    void commitRecord(std::size_t start);
+    void flushLocked();
+    // Returns the end of the last intact record.
+    std::size_t replay(std::unordered_map<int, Account>& accounts);
+
+    mutable std::mutex mutex_;
+    std::mutex saveMutex_;  // one save() at a time
+    std::optional<SaveMark> saveMark_;
+    IPersistence& snapshot_;
+    FileLock lock_;  // held for the store's lifetime; see FileLock
+    std::string filename_;
+    std::size_t syncEvery_;
+    std::size_t compactThreshold_;
+    int fd_ = -1;
+    std::vector<char> buffer_;
+    std::size_t pending_ = 0;
+    std::size_t records_ = 0;
+    std::size_t liveAccounts_ = 0;
+};
@@ -1,14 +1,54 @@
 // json_persistence.h
 #pragma once
+#include "atomic_file.h"
 #include "ipersistence.h"
+#include <cstdint>
+#include <memory>
 #include <string>
 
+class BinarySnapshotView;
+
+// Human-readable snapshot store: a JSON array with one object per account.
+//
+// save() replaces the file atomically and ends the array with a checksum
+// element, "checksum64:<hex>", covering every byte before it; load() refuses a
+// file whose checksum does not match. Files from before checksums still
+// load, unverified.
+//
+// load() streams the file into the parser and checksums it on the way.
+//
+// With the index cache on, save() also writes a binary snapshot of the same
+// accounts to `<filename>.idx`, stamped with that checksum. load() reads
+// only the tail of the JSON, and when the cache carries the same checksum
+// and its own body checksum holds, it maps the cache instead of parsing.
+// A missing, stale or damaged cache just means a normal parse, after which
+// the cache is rebuilt. (The cache keeps timestamps to the microsecond; the
+// JSON text has whole seconds.) The cache is also what openSource() serves,
+// so lazy loading needs it to be current; there only its header is checked.
+//
+// save() serializes without a DOM: the accounts are split across threads,
+// each formats its share straight into a byte buffer, and the buffers are
+// joined and written in one go. Indented output is what nlohmann's
+// dump(4) produces (balances aside, which always carry both decimals);
+// compact output drops the whitespace, over a quarter of the file. load()
+// reads either.
+enum class JsonLayout { Indented, Compact };
+
 class JsonPersistence : public IPersistence {
 public:
-    explicit JsonPersistence(const std::string& filename);
+    explicit JsonPersistence(const std::string& filename, bool indexCache = true,
+                             JsonLayout layout = JsonLayout::Indented);
     void save(const std::unordered_map<int, Account>& accounts) override;
     std::unordered_map<int, Account> load() override;
+    std::unique_ptr<AccountSource> openSource() override;
 
 private:
+    std::unique_ptr<BinarySnapshotView> openCache(std::uint64_t checksum, bool verifyBody) const;
+    bool loadCache(std::uint64_t checksum, std::unordered_map<int, Account>& accounts) const;
+    void saveCache(const std::unordered_map<int, Account>& accounts, std::uint64_t checksum) const;
+
+    FileLock lock_;  // held for the store's lifetime; see FileLock
     std::string filename_;
-};
\ No newline at end of file
+    std::string cacheFile_;  // empty when the cache is off
+    JsonLayout layout_;
+};
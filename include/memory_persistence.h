@@ -0,0 +1,48 @@
+// memory_persistence.h
+#pragma once
+#include "ipersistence.h"
+#include <atomic>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// Stores that never touch the disk, for tests, benchmarks and tools that
+// only exercise the in-memory paths.
+
+// Starts empty and forgets every save.
+class NullPersistence : public IPersistence {
+public:
+    void save(const std::unordered_map<int, Account>&) override {}
+    std::unordered_map<int, Account> load() override { return {}; }
+};
+
+// Keeps the last save for the next load.
+class MemoryPersistence : public IPersistence {
+public:
+    void save(const std::unordered_map<int, Account>& accounts) override { accounts_ = accounts; }
+    std::unordered_map<int, Account> load() override { return accounts_; }
+
+private:
+    std::unordered_map<int, Account> accounts_;
+};
+
+// While `failing` is set, every per-operation hook throws, as a journal on
+// a full disk would.
+class FailingPersistence : public NullPersistence {
+public:
+    void recordCreate(const Account&) override { fail(); }
+    void recordDelete(int) override { fail(); }
+    void recordDeposit(const Account&, Money) override { fail(); }
+    void recordWithdraw(const Account&, Money) override { fail(); }
+    void recordTransfer(const Account&, const Account&, Money) override { fail(); }
+    void recordTransfers(const std::vector<TransferRecord>&, Timestamp) override { fail(); }
+    void recordPosting(const PostingSchedule&, const PostingSegment&) override { fail(); }
+
+    std::atomic<bool> failing{false};
+
+private:
+    void fail() const {
+        if (failing)
+            throw std::runtime_error("Journal write failed");
+    }
+};
@@ -0,0 +1,227 @@
+// metrics.h
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Process-wide operation counters and latency histograms.
+//
+// Every thread records into its own block of slots, so the hot path is a
+// couple of uncontended relaxed stores: no locks, no shared cache lines.
+// collect() sums the blocks of all live threads plus whatever exited threads
+// left behind. Latencies are taken from the CPU timestamp counter and kept
+// in log-linear buckets (eight per power of two, so any value is within
+// 12.5% of its bucket), HDR-histogram style; ticks become nanoseconds only
+// when read.
+//
+// Reading the clock twice costs more than a deposit, so the per-operation
+// Bank timers are sampled: each thread times one call in kSamplePeriod and
+// records it with that weight. Counters are always exact, and so are the
+// timers of slow operations (saves, loads, bridge requests).
+//
+// Build with BANK_METRICS undefined (cmake -DENABLE_METRICS=OFF) and the
+// BANK_METRIC_* macros expand to nothing; collect() then reports zeros.
+namespace metrics {
+
+enum class Counter {
+    AccountsCreated,
+    AccountsDeleted,
+    Deposits,
+    Withdrawals,
+    Transfers,
+    BatchOperations,
+    PostedAccounts,
+    HistorySpilled,
+    HistorySpillFailures,
+    JsonCacheHits,
+    JsonCacheMisses,
+    BridgeRequests,
+    BridgeErrors,
+    ServerRequests,
+    ServerErrors,
+    AccountsFaultedIn,  // lazy loading: read from the source
+    AccountsEvicted,    // lazy loading: dropped to stay under the limit
+    kCount
+};
+
+enum class Timer {
+    CreateAccount,
+    Deposit,
+    Withdraw,
+    Transfer,
+    PostingRun,
+    JsonSave,
+    JsonLoad,
+    BridgeRequest,  // from the slot call until the job has run
+    ServerRequest,
+    kCount
+};
+
+constexpr std::size_t kCounters = static_cast<std::size_t>(Counter::kCount);
+constexpr std::size_t kTimers = static_cast<std::size_t>(Timer::kCount);
+constexpr int kSubBucketBits = 3;
+constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+constexpr std::size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+constexpr std::uint32_t kSamplePeriod = 16;
+
+constexpr bool enabled() {
+#ifdef BANK_METRICS
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Name as exported, e.g. "deposits" or "json_save".
+const char* name(Counter counter);
+const char* name(Timer timer);
+
+inline std::uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    // Assumes an invariant TSC, which every x86 CPU of the last decade has.
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Bucket for a duration in ticks; values below 2 * kSubBuckets are exact.
+inline std::size_t bucketFor(std::uint64_t value) {
+    if (value < kSubBuckets)
+        return static_cast<std::size_t>(value);
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - kSubBucketBits;
+    return static_cast<std::size_t>(exponent - kSubBucketBits + 1) * kSubBuckets +
+           static_cast<std::size_t>((value >> shift) & (kSubBuckets - 1));
+}
+// Smallest value that falls into `bucket`.
+std::uint64_t bucketLowerBound(std::size_t bucket);
+
+struct ThreadSlots {
+    std::array<std::atomic<std::uint64_t>, kCounters> counters{};
+    std::array<std::array<std::atomic<std::uint64_t>, kBuckets>, kTimers> buckets{};
+    std::array<std::atomic<std::uint64_t>, kTimers> totals{};
+    // Owner-only; calls left until the next sample, per timer.
+    std::array<std::uint32_t, kTimers> sampleCountdown{};
+};
+
+// The calling thread's slots, registered on first use.
+ThreadSlots& registerThread();
+inline ThreadSlots& threadSlots() {
+    // Not `slots`, which Qt defines as a macro.
+    thread_local ThreadSlots* own = nullptr;
+    if (__builtin_expect(own == nullptr, 0))
+        own = &registerThread();
+    return *own;
+}
+
+// Only the owning thread writes its slots, so a plain load and store is
+// enough; the atomics just make concurrent collect() well defined.
+inline void bump(std::atomic<std::uint64_t>& slot, std::uint64_t by = 1) {
+    slot.store(slot.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+inline void increment(Counter counter, std::uint64_t by = 1) {
+    bump(threadSlots().counters[static_cast<std::size_t>(counter)], by);
+}
+
+// `weight` is the number of calls the measurement stands for.
+inline void recordTicks(Timer timer, std::uint64_t elapsed, std::uint32_t weight = 1) {
+    ThreadSlots& own = threadSlots();
+    auto index = static_cast<std::size_t>(timer);
+    bump(own.buckets[index][bucketFor(elapsed)], weight);
+    bump(own.totals[index], elapsed * weight);
+}
+
+// Records the time from construction to destruction, exceptions included.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Timer timer) : timer_(timer), start_(ticks()) {}
+    ~ScopedTimer() { recordTicks(timer_, ticks() - start_); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Timer timer_;
+    std::uint64_t start_;
+};
+
+// ScopedTimer for one call in kSamplePeriod; the others cost a decrement.
+class SampledTimer {
+public:
+    explicit SampledTimer(Timer timer) : timer_(timer) {
+        std::uint32_t& countdown = threadSlots().sampleCountdown[static_cast<std::size_t>(timer)];
+        if (countdown == 0) {
+            countdown = kSamplePeriod;
+            start_ = ticks();
+        }
+        --countdown;
+    }
+    ~SampledTimer() {
+        if (start_ != 0)
+            recordTicks(timer_, ticks() - start_, kSamplePeriod);
+    }
+    SampledTimer(const SampledTimer&) = delete;
+    SampledTimer& operator=(const SampledTimer&) = delete;
+
+private:
+    Timer timer_;
+    std::uint64_t start_ = 0;
+};
+
+struct TimerSnapshot {
+    std::uint64_t count = 0;
+    double totalNs = 0;
+    std::array<std::uint64_t, kBuckets> buckets{};
+
+    // Approximate `q`-quantile (0..1) in nanoseconds; 0 when empty.
+    double percentileNs(double q) const;
+    double maxNs() const { return percentileNs(1.0); }
+    double meanNs() const { return count == 0 ? 0 : totalNs / static_cast<double>(count); }
+};
+
+struct Snapshot {
+    std::array<std::uint64_t, kCounters> counters{};
+    std::array<TimerSnapshot, kTimers> timers{};
+
+    std::uint64_t counter(Counter c) const { return counters[static_cast<std::size_t>(c)]; }
+    const TimerSnapshot& timer(Timer t) const { return timers[static_cast<std::size_t>(t)]; }
+};
+
+// Sums every thread's slots. Takes a lock shared with thread start and exit
+// only; recording threads are never blocked.
+Snapshot collect();
+
+// Nanoseconds per tick of ticks(), measured once, on first use, over the
+// time since the library was loaded. Only a first call within 20 ms of
+// startup has to wait for the rest of that.
+double nanosecondsPerTick();
+
+// Prometheus text exposition format: counters as bank_<name>_total,
+// timers as bank_<name>_seconds histograms.
+std::string toPrometheus(const Snapshot& snapshot);
+
+} // namespace metrics
+
+#ifdef BANK_METRICS
+#define BANK_METRICS_CONCAT_(a, b) a##b
+#define BANK_METRICS_CONCAT(a, b) BANK_METRICS_CONCAT_(a, b)
+#define BANK_METRIC_COUNT(counter) ::metrics::increment(::metrics::Counter::counter)
+#define BANK_METRIC_ADD(counter, by) ::metrics::increment(::metrics::Counter::counter, (by))
+#define BANK_METRIC_TIME(timer) \
+    ::metrics::ScopedTimer BANK_METRICS_CONCAT(bankMetricTimer_, __LINE__)(::metrics::Timer::timer)
+#define BANK_METRIC_TIME_SAMPLED(timer) \
+    ::metrics::SampledTimer BANK_METRICS_CONCAT(bankMetricTimer_, __LINE__)(::metrics::Timer::timer)
+#else
+#define BANK_METRIC_COUNT(counter) ((void)0)
+#define BANK_METRIC_ADD(counter, by) ((void)0)
+#define BANK_METRIC_TIME(timer) ((void)0)
+#define BANK_METRIC_TIME_SAMPLED(timer) ((void)0)
+#endif
@@ -0,0 +1,37 @@
+// metrics_exporter.h
+#pragma once
+#include <chrono>
+#include <string>
+#include <thread>
+
+struct MetricsExportOptions {
+    // Rewritten atomically every `interval`, for a node_exporter textfile
+    // collector or a quick `cat`. Empty: no file.
+    std::string textFile;
+    // Unix socket that answers every connection with the current dump and
+    // closes it (`socat - UNIX-CONNECT:<path>`). Empty: no socket.
+    std::string socketPath;
+    std::chrono::milliseconds interval{10000};
+};
+
+// Publishes metrics::collect() in Prometheus text format from a thread of
+// its own. Throws std::runtime_error if the socket cannot be set up.
+class MetricsExporter {
+public:
+    explicit MetricsExporter(MetricsExportOptions options);
+    // Writes the file one last time and removes the socket.
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+private:
+    void run();
+    void writeFile() const;
+    void serveClient() const;
+
+    MetricsExportOptions options_;
+    int listenFd_ = -1;
+    int wakeFds_[2] = {-1, -1};  // written to on shutdown
+    std::thread thread_;
+};
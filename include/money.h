@@ -0,0 +1,153 @@
+// money.h
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+constexpr bool powerOfTen(std::int64_t value) {
+    while (value > 1 && value % 10 == 0)
+        value /= 10;
+    return value == 1;
+}
+
+// An exact currency amount held as a whole number of minor units (cents for
+// Scale = 100). Sums never drift, so balances can be compared and totalled
+// without tolerances. Arithmetic that would overflow throws
+// std::overflow_error instead of wrapping; the check is a single branch the
+// hot path never takes.
+template <std::int64_t Scale>
+class BasicMoney {
+public:
+    static_assert(Scale > 0 && powerOfTen(Scale), "currency scale must be a power of ten");
+
+    static constexpr std::int64_t kScale = Scale;
+
+    constexpr BasicMoney() noexcept = default;
+
+    // Whole currency units, rounded to the nearest minor unit. This is the
+    // boundary for floating-point input (QML, JSON numbers); throws
+    // std::invalid_argument for NaN, infinity or values out of range.
+    explicit BasicMoney(double units) : minor_(toMinorUnits(units)) {}
+
+    static constexpr BasicMoney fromMinorUnits(std::int64_t minor) noexcept {
+        BasicMoney money;
+        money.minor_ = minor;
+        return money;
+    }
+
+    // Parses plain decimal text such as "12", "-0.5" or "100.07" exactly.
+    // Digits beyond the scale are accepted only if they are zeros.
+    static bool parse(std::string_view text, BasicMoney& value) noexcept;
+
+    constexpr std::int64_t minorUnits() const noexcept { return minor_; }
+    double toDouble() const noexcept { return static_cast<double>(minor_) / static_cast<double>(Scale); }
+    // "-12.50" style, always with the full number of fraction digits.
+    std::string toString() const;
+
+    BasicMoney& operator+=(BasicMoney other) {
+        std::int64_t result;
+        if (__builtin_add_overflow(minor_, other.minor_, &result))
+            throw std::overflow_error("Money overflow");
+        minor_ = result;
+        return *this;
+    }
+
+    BasicMoney& operator-=(BasicMoney other) {
+        std::int64_t result;
+        if (__builtin_sub_overflow(minor_, other.minor_, &result))
+            throw std::overflow_error("Money overflow");
+        minor_ = result;
+        return *this;
+    }
+
+    friend BasicMoney operator+(BasicMoney a, BasicMoney b) { return a += b; }
+    friend BasicMoney operator-(BasicMoney a, BasicMoney b) { return a -= b; }
+    friend BasicMoney operator-(BasicMoney a) { return BasicMoney() - a; }
+
+    friend constexpr bool operator==(BasicMoney a, BasicMoney b) noexcept { return a.minor_ == b.minor_; }
+    friend constexpr bool operator!=(BasicMoney a, BasicMoney b) noexcept { return a.minor_ != b.minor_; }
+    friend constexpr bool operator<(BasicMoney a, BasicMoney b) noexcept { return a.minor_ < b.minor_; }
+    friend constexpr bool operator<=(BasicMoney a, BasicMoney b) noexcept { return a.minor_ <= b.minor_; }
+    friend constexpr bool operator>(BasicMoney a, BasicMoney b) noexcept { return a.minor_ > b.minor_; }
+    friend constexpr bool operator>=(BasicMoney a, BasicMoney b) noexcept { return a.minor_ >= b.minor_; }
+
+    friend std::ostream& operator<<(std::ostream& out, BasicMoney money) { return out << money.toString(); }
+
+private:
+    static constexpr int fractionDigits() {
+        int digits = 0;
+        for (std::int64_t s = Scale; s > 1; s /= 10)
+            ++digits;
+        return digits;
+    }
+
+    static std::int64_t toMinorUnits(double units) {
+        double scaled = units * static_cast<double>(Scale);
+        // 2^63 is exactly representable; anything at or beyond it is not an int64.
+        if (!std::isfinite(scaled) || std::fabs(scaled) >= 9223372036854775808.0)
+            throw std::invalid_argument("Amount out of range");
+        return std::llround(scaled);
+    }
+
+    std::int64_t minor_ = 0;
+};
+
+template <std::int64_t Scale>
+bool BasicMoney<Scale>::parse(std::string_view text, BasicMoney& value) noexcept {
+    std::size_t pos = 0;
+    bool negative = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+'))
+        negative = text[pos++] == '-';
+
+    std::int64_t minor = 0;
+    bool anyDigit = false;
+    for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+        anyDigit = true;
+        if (__builtin_mul_overflow(minor, std::int64_t{10}, &minor) ||
+            __builtin_add_overflow(minor, std::int64_t{text[pos] - '0'}, &minor))
+            return false;
+    }
+    if (__builtin_mul_overflow(minor, Scale, &minor))
+        return false;
+
+    if (pos < text.size() && text[pos] == '.') {
+        ++pos;
+        std::int64_t place = Scale;
+        for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+            anyDigit = true;
+            place /= 10;
+            if (place == 0) {
+                if (text[pos] != '0')
+                    return false;
+                continue;
+            }
+            if (__builtin_add_overflow(minor, (text[pos] - '0') * place, &minor))
+                return false;
+        }
+    }
+    if (!anyDigit || pos != text.size())
+        return false;
+    value.minor_ = negative ? -minor : minor;
+    return true;
+}
+
+template <std::int64_t Scale>
+std::string BasicMoney<Scale>::toString() const {
+    // Work in unsigned so INT64_MIN has a magnitude.
+    std::uint64_t magnitude = minor_ < 0 ? 0 - static_cast<std::uint64_t>(minor_) : static_cast<std::uint64_t>(minor_);
+    std::string text = std::to_string(magnitude / static_cast<std::uint64_t>(Scale));
+    if (minor_ < 0)
+        text.insert(text.begin(), '-');
+    if constexpr (fractionDigits() > 0) {
+        std::string fraction = std::to_string(magnitude % static_cast<std::uint64_t>(Scale));
+        text += '.';
+        text.append(static_cast<std::size_t>(fractionDigits()) - fraction.size(), '0');
+        text += fraction;
+    }
+    return text;
+}
+
+using Money = BasicMoney<100>;
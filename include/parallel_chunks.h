@@ -0,0 +1,40 @@
+// parallel_chunks.h
+#pragma once
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Splits [0, size) into one contiguous chunk per worker and calls
+// work(worker, begin, end) for each; chunk 0 runs on the calling thread, as
+// do the chunks of any thread that cannot be started. Every chunk runs to
+// its end or its exception; once all are done, the first exception (by
+// worker) is rethrown here.
+template <typename Work>
+void forEachChunk(std::size_t size, unsigned workers, Work&& work) {
+    std::vector<std::exception_ptr> errors(workers);
+    auto chunk = [&](unsigned worker) {
+        try {
+            work(worker, size * worker / workers, size * (worker + 1) / workers);
+        } catch (...) {
+            errors[worker] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    unsigned started = 1;
+    try {
+        for (; started < workers; ++started)
+            threads.emplace_back(chunk, started);
+    } catch (...) {
+        // Out of threads: the rest run here.
+    }
+    chunk(0);
+    for (unsigned w = started; w < workers; ++w)
+        chunk(w);
+    for (auto& thread : threads)
+        thread.join();
+    for (const std::exception_ptr& error : errors)
+        if (error)
+            std::rethrow_exception(error);
+}
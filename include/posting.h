@@ -0,0 +1,106 @@
+// posting.h
+#pragma once
+#include "account.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One tier of an interest and fee schedule. It covers balances in
+// [minBalance, maxBalance); the first tier that covers a balance wins.
+struct PostingRule {
+    Money minBalance = Money::fromMinorUnits(std::numeric_limits<std::int64_t>::min());
+    Money maxBalance = Money::fromMinorUnits(std::numeric_limits<std::int64_t>::max());
+    // Interest in parts per million of the balance, rounded half away from
+    // zero to the minor unit. A negative balance accrues negative interest,
+    // so a positive rate on an overdraft tier is a charge.
+    std::int64_t ratePpm = 0;
+    // Flat fee taken after interest. A fee never takes a balance below
+    // zero; whatever it cannot cover is waived.
+    Money fee;
+};
+
+struct PostingSchedule {
+    std::vector<PostingRule> rules;
+
+    const PostingRule* ruleFor(Money balance) const noexcept;
+
+    // One tier per line: "minBalance,maxBalance,ratePercent,fee", e.g.
+    // "0,1000,0.25,1.50". An empty bound is open; '#' lines, blank lines
+    // and a header are skipped. Throws std::invalid_argument naming the
+    // line for anything else, and std::runtime_error if the file cannot be
+    // opened.
+    static PostingSchedule parse(const std::string& text);
+    static PostingSchedule load(const std::string& filename);
+};
+
+// Where a posting run is. A default-constructed checkpoint starts a run over
+// every account that exists at that moment; an interrupted run hands back
+// a checkpoint that resumes it, even in a later process.
+struct PostingCheckpoint {
+    int nextAccountId = 0;  // 0 until the run starts
+    int endAccountId = 0;   // accounts created after the run started are left out
+
+    bool started() const noexcept { return nextAccountId != 0; }
+    bool done() const noexcept { return started() && nextAccountId >= endAccountId; }
+};
+
+// One chunk of a posting run, all stamped `asOf`. It is what the journal
+// records, before the chunk runs: replaying it over the same accounts gives
+// the same balances, and an account already stamped at or after `asOf` is
+// left alone, so replaying over a snapshot that has the run is harmless.
+struct PostingSegment {
+    int fromAccountId = 0;
+    int toAccountId = 0;
+    Timestamp asOf;
+};
+
+struct PostingReport {
+    std::size_t posted = 0;     // balance changed
+    std::size_t unchanged = 0;  // nothing due
+    std::size_t skipped = 0;    // already changed at or after the run's timestamp
+    std::vector<int> failed;    // the new balance would overflow; left as it was
+    // Totals saturate at the Money range.
+    Money interest;  // net interest credited; negative when charges dominate
+    Money fees;      // fees taken
+    Money waived;    // fees not taken to keep balances at zero
+    bool complete = false;
+
+    void merge(PostingReport&& other);
+};
+
+// Called after each chunk of accounts with the checkpoint so far; return
+// false to stop the run there.
+using PostingProgress = std::function<bool(const PostingCheckpoint& checkpoint)>;
+
+enum class PostingOutcome { Posted, Unchanged, Skipped, Failed };
+
+// A run's timestamp: later than every stamp taken before the call and no
+// later than any taken after it, so "stamped at or after asOf" means exactly
+// "touched by or since this run". Waits out the current clock tick.
+Timestamp postingTimestamp() noexcept;
+
+// Applies the schedule to one account as of `asOf`, adding what it posted
+// to `report`'s totals (not to its counts).
+PostingOutcome postAccount(Account& account, const PostingSchedule& schedule, Timestamp asOf,
+                           PostingReport& report) noexcept;
+
+// Accounts are taken in ID order, kPostingChunk IDs at a time, and each
+// chunk is split across threads. `lookup` returns nullptr for a missing ID
+// and `posted` is told about every changed account and how much its balance
+// moved; both are called from several threads at once, for distinct
+// accounts. `record`, if set, is handed each chunk's segment before the
+// chunk runs; if it throws, the chunk is left alone and the checkpoint
+// stays where it was.
+constexpr int kPostingChunk = 1 << 16;
+PostingReport runPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint, Timestamp asOf,
+                          const PostingProgress& progress, const std::function<Account*(int)>& lookup,
+                          const std::function<void(Account&, Money)>& posted,
+                          const std::function<void(const PostingSegment&)>& record);
+
+// Replays a journaled segment over loaded accounts.
+void replayPostings(std::unordered_map<int, Account>& accounts, const PostingSchedule& schedule,
+                    const PostingSegment& segment);
@@ -0,0 +1,101 @@
+// remote_bank.h
+#pragma once
+#include "bank_protocol.h"
+#include "ibank.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// IBank over a connection to a BankServer, so CLI and anything else written
+// against IBank can share one daemon's book instead of each loading its
+// own. Every call is one round trip and throws what the server's bank threw
+// (std::invalid_argument, std::overflow_error, or std::runtime_error with
+// the same message); losing the connection throws std::runtime_error and
+// leaves the object unusable. Calls from several threads are serialized.
+//
+// applyPostings() runs as one request per chunk of accounts, so `progress`
+// is still called after every chunk and can still stop the run.
+class RemoteBank : public IBank {
+public:
+    // Throws std::runtime_error if nothing listens at `socketPath`.
+    explicit RemoteBank(const std::string& socketPath);
+    ~RemoteBank() override;
+
+    RemoteBank(const RemoteBank&) = delete;
+    RemoteBank& operator=(const RemoteBank&) = delete;
+
+    int createAccount(const std::string& personName, const std::string& cardId, Money initialBalance = Money()) override;
+    bool deleteAccount(int accountId) override;
+    void deposit(int accountId, Money amount) override;
+    void withdraw(int accountId, Money amount) override;
+    Account getAccount(int accountId) const override;
+    Money getBalance(int accountId) const override;
+    void transfer(int fromAccountId, int toAccountId, Money amount) override;
+    void transferMany(const std::vector<Transfer>& transfers) override;
+    BatchReport applyBatch(const std::vector<BatchOperation>& operations) override;
+    PostingReport applyPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint,
+                                const PostingProgress& progress = nullptr) override;
+
+private:
+    friend class RemotePipeline;
+
+    // Sends `requests`, `count` frames tagged from `firstTag` up, and hands
+    // each reply's status and body to `onReply`, in order. Reading overlaps
+    // writing, so neither side's socket buffers have to hold the whole
+    // exchange. The caller holds mutex_.
+    template <typename OnReply>
+    void exchange(const std::string& requests, std::uint32_t firstTag, std::size_t count, OnReply&& onReply) const;
+    // One round trip: `encode` writes the request body, `decode` reads the
+    // reply's; an error reply is thrown instead.
+    template <typename Encode, typename Decode>
+    void call(bank_protocol::Op op, Encode&& encode, Decode&& decode) const;
+    // Receives what has arrived, blocking unless `flags` says otherwise.
+    void receive(int flags) const;
+    [[noreturn]] void fail(const std::string& message) const;
+
+    mutable std::mutex mutex_;
+    mutable int fd_ = -1;
+    mutable std::uint32_t nextTag_ = 1;
+    mutable std::string out_;            // requests being sent
+    mutable std::string in_;             // replies received
+    mutable std::size_t consumed_ = 0;   // of in_
+};
+
+// The result of one pipelined request.
+struct PipelineResult {
+    bool ok = false;
+    std::string error;  // when !ok: the server's message
+    Money balance;      // getBalance() only
+};
+
+// Queues small requests against a RemoteBank and sends them all at once: one
+// write, and replies read back as they come, instead of one round trip each.
+// Requests run in the order queued; one failing does not stop the rest.
+class RemotePipeline {
+public:
+    explicit RemotePipeline(RemoteBank& bank) : bank_(bank) {}
+
+    void deposit(int accountId, Money amount);
+    void withdraw(int accountId, Money amount);
+    void transfer(int fromAccountId, int toAccountId, Money amount);
+    void getBalance(int accountId);
+
+    std::size_t size() const noexcept { return requests_.size(); }
+    // Runs everything queued and empties the pipeline; one result per
+    // request, in the order they were queued. Throws std::runtime_error only
+    // if the connection fails.
+    std::vector<PipelineResult> run();
+
+private:
+    struct Request {
+        bank_protocol::Op op;
+        int accountId;
+        int toAccountId;  // transfer() only
+        Money amount;
+    };
+
+    RemoteBank& bank_;
+    std::vector<Request> requests_;
+};
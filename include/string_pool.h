@@ -0,0 +1,104 @@
+// string_pool.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+namespace string_pool::detail {
+
+// Ahead of the characters of every pooled string.
+struct Header {
+    std::atomic<std::uint32_t> refs;
+    std::uint32_t length;
+};
+
+// Drops what may be the last reference, under the shard's lock.
+void releaseLast(const char* data) noexcept;
+
+} // namespace string_pool::detail
+
+// Counted handle to an immutable string in the process-wide pool: one
+// pointer, so copying an Account copies no characters, only bumps a count.
+// The string is reclaimed when its last handle goes. The empty string is
+// a null handle and costs nothing.
+class PooledString {
+public:
+    PooledString() noexcept = default;
+    PooledString(const PooledString& other) noexcept : data_(other.data_) {
+        if (data_)
+            header()->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    PooledString(PooledString&& other) noexcept : data_(std::exchange(other.data_, nullptr)) {}
+    PooledString& operator=(PooledString other) noexcept {
+        std::swap(data_, other.data_);
+        return *this;
+    }
+    ~PooledString() { release(); }
+
+    std::string_view view() const noexcept {
+        return data_ ? std::string_view(data_, header()->length) : std::string_view();
+    }
+    operator std::string_view() const noexcept { return view(); }
+    bool empty() const noexcept { return data_ == nullptr; }
+
+    // Pooled strings are equal exactly when their handles are.
+    bool operator==(const PooledString& other) const noexcept { return data_ == other.data_; }
+    bool operator!=(const PooledString& other) const noexcept { return data_ != other.data_; }
+
+private:
+    // Adopts a reference the pool has already counted.
+    explicit PooledString(const char* data) noexcept : data_(data) {}
+
+    string_pool::detail::Header* header() const noexcept {
+        return reinterpret_cast<string_pool::detail::Header*>(const_cast<char*>(data_) -
+                                                             sizeof(string_pool::detail::Header));
+    }
+
+    // Any but the last reference goes without a lock. The last is dropped
+    // under the shard's lock, so intern() never hands out a string that is
+    // being reclaimed.
+    void release() noexcept {
+        if (!data_)
+            return;
+        std::uint32_t refs = header()->refs.load(std::memory_order_relaxed);
+        while (refs > 1) {
+            if (header()->refs.compare_exchange_weak(refs, refs - 1, std::memory_order_release,
+                                                     std::memory_order_relaxed))
+                return;
+        }
+        string_pool::detail::releaseLast(data_);
+    }
+
+    const char* data_ = nullptr;
+
+    friend class StringPoolShard;
+};
+
+// Account metadata lives in one process-wide pool rather than in per-account
+// heap strings. Each of its shards bump-allocates from large chunks and
+// keeps an open-addressing table of the strings interned in it; a string's
+// hash picks the shard, so threads loading accounts in parallel rarely meet
+// on a lock. A string no handle refers to any more leaves the table, and
+// its space goes on a free list for the next string of the same size (long
+// ones are allocated and freed on their own), so a long-running process
+// that keeps renaming and deleting owners stays at its peak, not its total.
+// The chunks themselves are kept until exit.
+namespace string_pool {
+
+// The pool's copy of `text`; equal strings share one copy, so an owner
+// name costs its bytes once however many accounts carry it, and loading
+// the same book again adds nothing.
+PooledString intern(std::string_view text);
+
+struct Stats {
+    std::size_t arenaBytes = 0;  // reserved in chunks, long strings included
+    std::size_t usedBytes = 0;   // held by live strings, headers included
+    std::size_t freeBytes = 0;   // released, waiting for reuse
+    std::size_t strings = 0;     // distinct live strings
+    std::size_t tableBytes = 0;  // lookup tables
+};
+Stats stats();
+
+} // namespace string_pool
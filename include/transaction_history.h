@@ -0,0 +1,139 @@
+// transaction_history.h
+#pragma once
+#include "account.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One balance change. `amount` is signed: what the operation added to the
+// balance, so withdrawals, outgoing transfers and fees are negative.
+struct HistoryEntry {
+    std::uint64_t sequence = 0;  // 1-based, in the order entries were appended
+    int accountId = 0;
+    OperationType type = OperationType::None;
+    Money amount;
+    Timestamp time;
+};
+
+struct HistoryOptions {
+    // Newest entries kept in memory. Older ones are spilled to `spillFile`
+    // in blocks, or dropped when there is none.
+    std::size_t retainInMemory = 1 << 20;
+    std::string spillFile;
+};
+
+// Append-only log of balance changes with a per-account index.
+//
+// Entries live in a ring of columns (account, type, amount, time, and the
+// sequence of the same account's previous entry), 29 bytes each, so the
+// newest `retainInMemory` cost a fixed amount of memory however the
+// operations are spread over accounts. Each account's entries form a chain
+// through that last column; the index is just the head of each chain,
+// one word per account ID. "Last N for an account" walks N links; a time
+// range binary-searches the time column, which appending keeps in order
+// as long as the clock does not step back.
+//
+// Spilled blocks keep the same columns, appended to the spill file
+// (host byte order):
+//   Header | Block[*], Block = BlockHeader | ids | types | amounts | times | prevs
+// Queries read them back a block at a time, so a chain that runs into
+// spilled history keeps going. Opening an existing spill file continues
+// its sequence and rebuilds the index from it, and the destructor spills
+// what is still in memory, so history survives a restart. It is an audit
+// trail, not the book of record: entries still in memory at a crash are
+// lost, while the journal keeps the balances. For the same reason append()
+// never fails on a spill: after a failed one the history keeps only what
+// fits in memory, as without a spill file, and reports why in spillError().
+//
+// Not thread-safe; Bank calls it from whichever thread owns the bank.
+class TransactionHistory {
+public:
+    explicit TransactionHistory(const HistoryOptions& options = HistoryOptions());
+    ~TransactionHistory();
+
+    TransactionHistory(const TransactionHistory&) = delete;
+    TransactionHistory& operator=(const TransactionHistory&) = delete;
+
+    void append(int accountId, OperationType type, Money amount, Timestamp time);
+
+    // Why spilling stopped, or empty while it works.
+    const std::string& spillError() const noexcept { return spillError_; }
+
+    // Entries ever appended, spilled and dropped ones included.
+    std::uint64_t size() const noexcept { return nextSequence_ - 1; }
+    std::size_t inMemory() const noexcept { return static_cast<std::size_t>(nextSequence_ - memoryFirst_); }
+    // Sequence of the oldest entry a query can still return.
+    std::uint64_t oldestAvailable() const noexcept { return blocks_.empty() ? memoryFirst_ : blocks_.front().first; }
+
+    // Newest first: up to `limit` of the account's entries older than
+    // sequence `before` (0 starts from the newest). Pass the last returned
+    // entry's sequence as `before` to fetch the next page.
+    std::vector<HistoryEntry> forAccount(int accountId, std::size_t limit, std::uint64_t before = 0) const;
+    // Oldest first: up to `limit` entries of any account with
+    // `from <= time < to`.
+    std::vector<HistoryEntry> inRange(Timestamp from, Timestamp to, std::size_t limit) const;
+    // Newest first, like forAccount(): the account's entries in the range.
+    std::vector<HistoryEntry> forAccountInRange(int accountId, Timestamp from, Timestamp to,
+                                                std::size_t limit) const;
+
+    // Spills everything still in memory and syncs the spill file, throwing
+    // if either fails. Does nothing without one.
+    void flush();
+
+private:
+    struct Block {
+        std::uint64_t first;
+        std::uint32_t count;
+        std::int64_t minTime;
+        std::int64_t maxTime;
+        std::uint64_t offset;  // of the block's columns in the spill file
+    };
+    // One spilled block's columns, read back on demand.
+    struct BlockColumns {
+        std::uint64_t first = 0;
+        std::vector<std::int32_t> ids;
+        std::vector<std::uint8_t> types;
+        std::vector<std::int64_t> amounts;
+        std::vector<std::int64_t> times;
+        std::vector<std::uint64_t> prevs;
+    };
+
+    std::size_t slot(std::uint64_t sequence) const noexcept {
+        return static_cast<std::size_t>((sequence - ringBase_) % capacity_);
+    }
+    std::uint64_t headFor(int accountId) const noexcept;
+    // The entry and the sequence of its account's previous one; `sequence`
+    // must be available.
+    HistoryEntry entry(std::uint64_t sequence, std::uint64_t& prev) const;
+    const BlockColumns& spilledBlock(std::uint64_t sequence) const;
+    // First available sequence whose time is >= `time`.
+    std::uint64_t lowerBound(std::int64_t time) const;
+    void openSpillFile();
+    // Makes room for `count` entries: spills them, or drops them when there
+    // is no spill file or the spill fails.
+    void evict(std::size_t count);
+    void spill(std::size_t count);
+    void stopSpilling(const std::string& error) noexcept;
+
+    std::size_t capacity_;
+    std::string spillFile_;
+    int fd_ = -1;
+    std::uint64_t fileSize_ = 0;
+    std::vector<Block> blocks_;
+    mutable BlockColumns cache_;
+    std::string spillError_;
+
+    // The ring: sequence s lives at slot(s) while memoryFirst_ <= s < nextSequence_.
+    // The columns grow up to capacity_ before they start to wrap.
+    std::vector<std::int32_t> ids_;
+    std::vector<OperationType> types_;
+    std::vector<std::int64_t> amounts_;
+    std::vector<std::int64_t> times_;
+    std::vector<std::uint64_t> prevs_;
+    std::uint64_t ringBase_ = 1;
+    std::uint64_t memoryFirst_ = 1;
+    std::uint64_t nextSequence_ = 1;
+    // Newest sequence per account ID, 0 for none.
+    std::vector<std::uint64_t> heads_;
+};
@@ -0,0 +1,76 @@
+// transfer_plan.h
+#pragma once
+#include "account.h"
+#include "ibank.h"
+#include "ipersistence.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct TransferPlan {
+    std::vector<std::pair<Account*, Account*>> accounts;  // both sides of each transfer
+    std::vector<TransferRecord> records;                    // the balances each one leaves
+};
+
+// The fields a balance change touches, saved so the change can be taken
+// back when its journal record cannot be written.
+class BalanceUndo {
+public:
+    explicit BalanceUndo(const Account& account)
+        : balance_(account.balance()), type_(account.lastOperationType()), time_(account.lastOperationTime()) {}
+
+    void restore(Account& account) const noexcept {
+        account.setBalance(balance_);
+        account.updateOperationInfo(type_, time_);
+    }
+
+private:
+    Money balance_;
+    OperationType type_;
+    Timestamp time_;
+};
+
+// Resolves both sides of every transfer once and checks the whole batch
+// against running balances, throwing before anything is modified. The
+// records can be journaled before anything changes; applyTransfers() then
+// cannot fail.
+template <typename Lookup>
+TransferPlan planTransfers(const std::vector<Transfer>& transfers, Lookup&& lookup) {
+    TransferPlan plan;
+    plan.accounts.reserve(transfers.size());
+    plan.records.reserve(transfers.size());
+    std::unordered_map<const Account*, Money> running;
+
+    for (std::size_t i = 0; i < transfers.size(); ++i) {
+        const Transfer& t = transfers[i];
+        std::string where = "Transfer " + std::to_string(i + 1) + ": ";
+        if (t.amount <= Money())
+            throw std::invalid_argument(where + "Transfer amount must be positive");
+        if (t.fromAccountId == t.toAccountId)
+            throw std::invalid_argument(where + "Cannot transfer to the same account");
+
+        Account& from = lookup(t.fromAccountId);
+        Account& to = lookup(t.toAccountId);
+        auto fromBalance = running.try_emplace(&from, from.balance()).first;
+        auto toBalance = running.try_emplace(&to, to.balance()).first;
+        if (t.amount > fromBalance->second)
+            throw std::runtime_error(where + "Insufficient balance");
+        fromBalance->second -= t.amount;
+        toBalance->second += t.amount;
+        plan.accounts.emplace_back(&from, &to);
+        plan.records.push_back({t.fromAccountId, fromBalance->second, t.toAccountId, toBalance->second, t.amount});
+    }
+    return plan;
+}
+
+// Sets the balances the plan worked out, stamping every account `when`.
+inline void applyTransfers(const TransferPlan& plan, Timestamp when) noexcept {
+    for (std::size_t i = 0; i < plan.accounts.size(); ++i) {
+        auto [from, to] = plan.accounts[i];
+        from->setBalance(plan.records[i].fromBalance);
+        from->updateOperationInfo(OperationType::TransferOut, when);
+        to->setBalance(plan.records[i].toBalance);
+        to->updateOperationInfo(OperationType::TransferIn, when);
+    }
+}
@@ -0,0 +1,10 @@
+// unix_socket.h
+#pragma once
+#include <string>
+
+// Binds a listening Unix stream socket to `path`; `flags` go to socket()
+// beside SOCK_STREAM and SOCK_CLOEXEC (e.g. SOCK_NONBLOCK). A socket file
+// already at the path is only taken over when nothing answers on it, i.e.
+// a run that crashed left it behind; a live server, or anything at the
+// path that is not a socket, is an error. Throws std::runtime_error.
+int listenOnUnixSocket(const std::string& path, int backlog, int flags = 0);
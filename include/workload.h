@@ -0,0 +1,111 @@
+// workload.h
+#pragma once
+#include "account.h"
+#include "ibank.h"
+#include "metrics.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Synthetic load for any IBank, so that storage and concurrency changes can
+// be measured under the same traffic.
+//
+// A workload is a population of accounts, created before the clock starts,
+// plus one stream of operations per client thread. It is generated from a
+// seed (generateWorkload) or read back from a trace (readTrace), so a run
+// can be repeated exactly. Operations name their account by its position in
+// the population, not by ID: runWorkload() creates the population and maps
+// positions to whatever IDs the bank hands out, so a trace also replays
+// against a bank that already holds accounts. Accounts created during the
+// run are never targeted.
+//
+// Each stream issues the same operations in the same order every time, but
+// threads interleave freely: with deletes in the mix, which operations find
+// their account gone can differ from run to run.
+enum class WorkloadOp : std::uint8_t { Create, Delete, Deposit, Withdraw, Lookup, kCount };
+
+constexpr std::size_t kWorkloadOps = static_cast<std::size_t>(WorkloadOp::kCount);
+
+// "create", "delete", "deposit", "withdraw" or "lookup".
+const char* toString(WorkloadOp op);
+bool parseWorkloadOp(const std::string& name, WorkloadOp& op);
+
+// How operations pick their account: all alike, or Zipf-skewed so that a
+// few hot accounts take most of the traffic. Hot accounts are scattered
+// over the population rather than being the oldest ones.
+enum class KeyDistribution { Uniform, Zipf };
+
+struct WorkloadOptions {
+    std::size_t accounts = 10000;    // population, created before the run
+    std::size_t operations = 100000; // per thread
+    std::size_t threads = 1;
+    // Relative weights, indexed by WorkloadOp.
+    std::array<unsigned, kWorkloadOps> mix{1, 1, 30, 20, 48};
+    KeyDistribution keys = KeyDistribution::Uniform;
+    double zipfExponent = 0.99;
+    std::uint64_t seed = 1;
+};
+
+// A population member, or the account a Create operation opens.
+struct WorkloadAccount {
+    std::uint32_t owner;  // index into Workload::owners
+    std::uint64_t card;   // 14 digits
+    Money balance;
+};
+
+struct WorkloadOperation {
+    WorkloadOp op;
+    // Create: index into Workload::owners. Otherwise: position in the
+    // population.
+    std::uint32_t account;
+    // Create: the new account's card; unused otherwise.
+    std::uint64_t card;
+    // Create: opening balance; Deposit/Withdraw: the amount.
+    Money amount;
+};
+
+struct Workload {
+    std::vector<std::string> owners;
+    std::vector<WorkloadAccount> population;
+    std::vector<std::vector<WorkloadOperation>> streams;  // one per thread
+
+    std::size_t operationCount() const;
+};
+
+// Card numbers are kept as integers and handed to the bank as 14 digits.
+std::string cardText(std::uint64_t card);
+
+// Owners follow a long tail: most hold one account, some several, and a
+// few of those accounts share a card. Balances and amounts are spread
+// log-uniformly. The same options always give the same workload.
+Workload generateWorkload(const WorkloadOptions& options);
+
+// Trace files are text, one record per line:
+//   owner,<name>
+//   account,<owner>,<card>,<balance>
+//   <thread>,<op>,<account or owner>,<amount>,<card>
+// (the amount and card are empty where an operation has none). Lines
+// starting with '#' are skipped. readTrace() throws std::runtime_error
+// naming the line of the first bad record.
+void writeTrace(const Workload& workload, const std::string& filename);
+Workload readTrace(const std::string& filename);
+
+struct WorkloadReport {
+    double seconds = 0;  // wall time of the streams, population excluded
+    std::array<std::uint64_t, kWorkloadOps> failed{};
+    // Latency of every operation, by type; failures included.
+    std::array<metrics::TimerSnapshot, kWorkloadOps> latency{};
+
+    std::uint64_t operations() const;
+    double throughput() const { return seconds > 0 ? static_cast<double>(operations()) / seconds : 0; }
+};
+
+// Creates the population through banks[0], then runs stream i on banks[i],
+// each on its own thread, all starting together. Pass the same bank for
+// every stream when it is safe to share, or one connection per stream (see
+// RemoteBank). An operation fails when the bank throws, or for a delete,
+// returns false; failures are counted, not reported. Throws if a thread
+// cannot be started, after stopping the ones that were.
+WorkloadReport runWorkload(const Workload& workload, const std::vector<IBank*>& banks);
@@ -1,46 +1,138 @@
 #include "account.h"
-#include <sstream>
-#include <iomanip>
 #include <ctime>
 
-Account::Account(int accountId, double initialBalance, const std::string& personName, const std::string& cardId)
-        : accountId_(accountId),
-            cardId_(cardId),
-            balance_(initialBalance),
-            personName_(personName),
-      creationTime_(getCurrentTime()),
-      lastOperationType_("None"),
-      lastOperationTime_(getCurrentTime()) {}
+Timestamp currentTimestamp() noexcept {
+    return std::chrono::time_point_cast<std::chrono::microseconds>(std::chrono::system_clock::now());
+}
 
-double Account::balance() const noexcept {
-    return balance_;
+std::string formatTimestamp(Timestamp timestamp) {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(timestamp);
+    std::tm local{};
+    localtime_r(&seconds, &local);  // std::localtime shares one buffer across threads
+    char buffer[32];
+    std::size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    return std::string(buffer, length);
 }
 
-void Account::deposit(double amount) {
-    if (amount <= 0)
+bool parseTimestamp(const std::string& text, Timestamp& timestamp) {
+    // Fixed layout "YYYY-MM-DD HH:MM:SS"; sscanf dominated load time.
+    if (text.size() != 19 || text[4] != '-' || text[7] != '-' || text[10] != ' ' || text[13] != ':' ||
+        text[16] != ':')
+        return false;
+    auto digits = [&text](std::size_t pos, std::size_t count, int& value) {
+        value = 0;
+        for (std::size_t i = pos; i < pos + count; ++i) {
+            if (text[i] < '0' || text[i] > '9')
+                return false;
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    };
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (!digits(0, 4, year) || !digits(5, 2, month) || !digits(8, 2, day) || !digits(11, 2, hour) ||
+        !digits(14, 2, minute) || !digits(17, 2, second))
+        return false;
+
+    // mktime() consults the time zone database on every call; a book only
+    // spans a handful of distinct hours, so remember recent ones.
+    struct HourSlot {
+        int key = -1;
+        std::time_t start = 0;
+    };
+    thread_local HourSlot cache[64];
+    int key = ((year * 16 + month) * 32 + day) * 32 + hour;
+    HourSlot& slot = cache[static_cast<unsigned>(key) % 64];
+    if (slot.key != key) {
+        std::tm local{};
+        local.tm_year = year - 1900;
+        local.tm_mon = month - 1;
+        local.tm_mday = day;
+        local.tm_hour = hour;
+        local.tm_isdst = -1;
+        std::time_t hourStart = std::mktime(&local);
+        if (hourStart == static_cast<std::time_t>(-1))
+            return false;
+        slot.key = key;
+        slot.start = hourStart;
+    }
+    std::time_t seconds = slot.start + minute * 60 + second;
+    timestamp = std::chrono::time_point_cast<std::chrono::microseconds>(std::chrono::system_clock::from_time_t(seconds));
+    return true;
+}
+
+const char* toString(OperationType type) noexcept {
+    switch (type) {
+    case OperationType::Deposit: return "Deposit";
+    case OperationType::Withdrawal: return "Withdrawal";
+    case OperationType::TransferIn: return "Transfer In";
+    case OperationType::TransferOut: return "Transfer Out";
+    case OperationType::Posting: return "Interest/Fees";
+    case OperationType::None: break;
+    }
+    return "None";
+}
+
+OperationType parseOperationType(const std::string& text) noexcept {
+    if (text == "Deposit") return OperationType::Deposit;
+    if (text == "Withdrawal") return OperationType::Withdrawal;
+    if (text == "Transfer In") return OperationType::TransferIn;
+    if (text == "Transfer Out") return OperationType::TransferOut;
+    if (text == "Interest/Fees") return OperationType::Posting;
+    return OperationType::None;
+}
+
+Account::Account(int accountId, Money initialBalance, std::string_view personName, std::string_view cardId)
+    : accountId_(accountId),
+      lastOperationType_(OperationType::None),
+      balance_(initialBalance),
+      creationTime_(currentTimestamp()),
+      lastOperationTime_(creationTime_),
+      cardId_(string_pool::intern(cardId)),
+      personName_(string_pool::intern(personName)) {}
+
+Account::Account(int accountId, Money balance, std::string_view personName, std::string_view cardId,
+                 Timestamp creationTime, OperationType lastOperationType, Timestamp lastOperationTime)
+    : accountId_(accountId),
+      lastOperationType_(lastOperationType),
+      balance_(balance),
+      creationTime_(creationTime),
+      lastOperationTime_(lastOperationTime),
+      cardId_(string_pool::intern(cardId)),
+      personName_(string_pool::intern(personName)) {}
+
+void Account::deposit(Money amount) {
+    if (amount <= Money())
         throw std::invalid_argument("Deposit amount must be positive");
     balance_ += amount;
-    updateOperationInfo("Deposit");
+    updateOperationInfo(OperationType::Deposit);
 }
 
-void Account::withdraw(double amount) {
-    if (amount <= 0)
+void Account::withdraw(Money amount) {
+    if (amount <= Money())
         throw std::invalid_argument("Withdraw amount must be positive");
     if (amount > balance_)
         throw std::runtime_error("Insufficient balance");
     balance_ -= amount;
-    updateOperationInfo("Withdrawal");
+    updateOperationInfo(OperationType::Withdrawal);
 }
 
-void Account::updateOperationInfo(const std::string& type) {
-    lastOperationType_ = type;
-    lastOperationTime_ = getCurrentTime();
+void Account::transferTo(Account& target, Money amount) {
+    if (amount <= Money())
+        throw std::invalid_argument("Transfer amount must be positive");
+    if (&target == this)
+        throw std::invalid_argument("Cannot transfer to the same account");
+    if (amount > balance_)
+        throw std::runtime_error("Insufficient balance");
+    Money credited = target.balance_ + amount;  // may throw; nothing has changed yet
+    balance_ -= amount;
+    target.balance_ = credited;
+
+    Timestamp now = currentTimestamp();
+    updateOperationInfo(OperationType::TransferOut, now);
+    target.updateOperationInfo(OperationType::TransferIn, now);
 }
 
-std::string Account::getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    return ss.str();
-}
\ No newline at end of file
+void Account::updateOperationInfo(OperationType type, Timestamp when) noexcept {
+    lastOperationType_ = type;
+    lastOperationTime_ = when;
+}
@@ -0,0 +1,77 @@
+// account_index.cpp
+#include "account_index.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+std::string lower(std::string_view text) {
+    std::string result(text);
+    for (char& c : result)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return result;
+}
+
+const std::vector<int> kNoAccounts;
+
+} // namespace
+
+void AccountIndex::add(const Account& account) {
+    insert(byOwner_, account.pooledPersonName(), account.getAccountId());
+    insert(byCard_, account.pooledCardId(), account.getAccountId());
+    insert(byLowerOwner_, string_pool::intern(lower(account.getPersonName())), account.getAccountId());
+}
+
+void AccountIndex::remove(const Account& account) {
+    erase(byOwner_, account.getPersonName(), account.getAccountId());
+    erase(byCard_, account.getCardId(), account.getAccountId());
+    erase(byLowerOwner_, lower(account.getPersonName()), account.getAccountId());
+}
+
+void AccountIndex::clear() {
+    byOwner_.clear();
+    byCard_.clear();
+    byLowerOwner_.clear();
+}
+
+const std::vector<int>& AccountIndex::byOwner(const std::string& personName) const {
+    auto it = byOwner_.find(personName);
+    return it == byOwner_.end() ? kNoAccounts : it->second.ids;
+}
+
+const std::vector<int>& AccountIndex::byCard(const std::string& cardId) const {
+    auto it = byCard_.find(cardId);
+    return it == byCard_.end() ? kNoAccounts : it->second.ids;
+}
+
+std::vector<int> AccountIndex::byOwnerPrefix(const std::string& prefix, std::size_t limit) const {
+    std::vector<int> result;
+    std::string key = lower(prefix);
+    for (auto it = byLowerOwner_.lower_bound(key); it != byLowerOwner_.end() && result.size() < limit; ++it) {
+        if (it->first.compare(0, key.size(), key) != 0)
+            break;
+        const std::vector<int>& ids = it->second.ids;
+        std::size_t take = std::min(limit - result.size(), ids.size());
+        result.insert(result.end(), ids.begin(), ids.begin() + static_cast<std::ptrdiff_t>(take));
+    }
+    return result;
+}
+
+template <typename Map>
+void AccountIndex::insert(Map& map, const PooledString& key, int accountId) {
+    auto [it, inserted] = map.try_emplace(key.view());
+    if (inserted)
+        it->second.key = key;
+    it->second.ids.push_back(accountId);
+}
+
+template <typename Map>
+void AccountIndex::erase(Map& map, std::string_view key, int accountId) {
+    auto it = map.find(key);
+    if (it == map.end())
+        return;
+    std::vector<int>& ids = it->second.ids;
+    ids.erase(std::remove(ids.begin(), ids.end(), accountId), ids.end());
+    if (ids.empty())
+        map.erase(it);
+}
@@ -0,0 +1,208 @@
+#include "account_list_model.h"
+#include <QMetaObject>
+#include <cstdint>
+
+namespace {
+
+// Rows per fetch: a few screens' worth.
+constexpr std::size_t kPageSize = 256;
+
+} // namespace
+
+AccountListModel::AccountListModel(BankWorker& worker, QObject* parent)
+    : QAbstractListModel(parent), worker_(worker),
+      reloadKey_("accountListModel.reload." + std::to_string(reinterpret_cast<std::uintptr_t>(this))) {
+    // Subscribe before the first snapshot so no change falls in between.
+    worker_.post([this](Bank& bank) { bank.addObserver(this); });
+    reload();
+}
+
+AccountListModel::~AccountListModel() {
+    // Queued row updates die with this object; only the worker must be told.
+    worker_.post([this](Bank& bank) { bank.removeObserver(this); });
+    worker_.waitIdle();
+}
+
+int AccountListModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : count();
+}
+
+QVariant AccountListModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() < 0 || index.row() >= count())
+        return {};
+    const Row& row = rows_[static_cast<std::size_t>(index.row())];
+    switch (role) {
+    case AccountIdRole: return row.accountId;
+    case Qt::DisplayRole:
+    case OwnerRole: return row.owner;
+    case CardIdRole: return row.cardId;
+    case BalanceRole: return row.balance.toDouble();
+    case BalanceTextRole: return QString::fromStdString(row.balance.toString());
+    // Timestamps are formatted only for rows a delegate actually shows.
+    case CreationTimeRole: return QString::fromStdString(formatTimestamp(row.creationTime));
+    case LastOperationTypeRole: return QString::fromLatin1(toString(row.lastOperationType));
+    case LastOperationTimeRole: return QString::fromStdString(formatTimestamp(row.lastOperationTime));
+    default: return {};
+    }
+}
+
+QHash<int, QByteArray> AccountListModel::roleNames() const {
+    return {
+        {AccountIdRole, "accountId"},
+        {OwnerRole, "owner"},
+        {CardIdRole, "cardId"},
+        {BalanceRole, "balance"},
+        {BalanceTextRole, "balanceText"},
+        {CreationTimeRole, "creationTime"},
+        {LastOperationTypeRole, "lastOperationType"},
+        {LastOperationTimeRole, "lastOperationTime"},
+    };
+}
+
+int AccountListModel::rowOf(int accountId) const {
+    auto it = rowIndex_.find(accountId);
+    return it == rowIndex_.end() ? -1 : it->second;
+}
+
+bool AccountListModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && cursor_ != 0;
+}
+
+void AccountListModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid() || cursor_ == 0 || fetching_)
+        return;
+    fetching_ = true;
+    worker_.post([this, cursor = cursor_, generation = generation_](Bank& bank) {
+        QMetaObject::invokeMethod(this, [this, generation, page = fetchPage(bank, cursor)]() mutable {
+            if (generation == generation_)
+                appendRows(std::move(page));
+        }, Qt::QueuedConnection);
+    });
+}
+
+void AccountListModel::reload() {
+    worker_.postCoalesced(reloadKey_, [this](Bank& bank) {
+        QMetaObject::invokeMethod(this, [this, page = fetchPage(bank, 0)]() mutable {
+            resetRows(std::move(page));
+        }, Qt::QueuedConnection);
+    });
+}
+
+AccountListModel::Page AccountListModel::fetchPage(const Bank& bank, int cursor) {
+    Bank::AccountPage accounts = bank.page(cursor, kPageSize);
+    Page page;
+    page.rows.reserve(accounts.accounts.size());
+    for (const Account* account : accounts.accounts)
+        page.rows.push_back(makeRow(*account));
+    page.nextCursor = accounts.nextCursor;
+    page.total = static_cast<int>(bank.accountCount());
+    return page;
+}
+
+// The observer callbacks run on the worker thread. Each one snapshots what
+// it needs and queues the model update to the GUI thread; queued calls keep
+// their order, so they apply in the same order the bank made the changes,
+// and in order with the pages fetched in between. A change to an account
+// not fetched yet needs nothing: its page, when it comes, is newer.
+
+void AccountListModel::accountCreated(const Account& account) {
+    QMetaObject::invokeMethod(this, [this, row = makeRow(account)] { insertAccountRow(row); }, Qt::QueuedConnection);
+}
+
+void AccountListModel::accountDeleted(int accountId) {
+    QMetaObject::invokeMethod(this, [this, accountId] { removeAccountRow(accountId); }, Qt::QueuedConnection);
+}
+
+void AccountListModel::accountChanged(const Account& account) {
+    QMetaObject::invokeMethod(this, [this, row = makeRow(account)] { updateAccountRow(row); }, Qt::QueuedConnection);
+}
+
+void AccountListModel::accountsChanged() {
+    reload();
+}
+
+void AccountListModel::resetRows(Page page) {
+    beginResetModel();
+    rows_ = std::move(page.rows);
+    rowIndex_.clear();
+    for (std::size_t i = 0; i < rows_.size(); ++i)
+        rowIndex_.emplace(rows_[i].accountId, static_cast<int>(i));
+    cursor_ = page.nextCursor;
+    total_ = page.total;
+    fetching_ = false;
+    ++generation_;
+    endResetModel();
+    emit countChanged();
+}
+
+void AccountListModel::appendRows(Page page) {
+    fetching_ = false;
+    cursor_ = page.nextCursor;
+    total_ = page.total;
+    if (!page.rows.empty()) {
+        const int first = count();
+        beginInsertRows(QModelIndex(), first, first + static_cast<int>(page.rows.size()) - 1);
+        for (Row& row : page.rows) {
+            rowIndex_.emplace(row.accountId, count());
+            rows_.push_back(std::move(row));
+        }
+        endInsertRows();
+    }
+    emit countChanged();
+}
+
+void AccountListModel::insertAccountRow(const Row& row) {
+    ++total_;
+    // Already picked up by a page, or it will be by the last one.
+    if (rowOf(row.accountId) >= 0 || cursor_ != 0) {
+        emit countChanged();
+        return;
+    }
+    // New IDs are always the highest, so appending keeps ID order.
+    int at = count();
+    beginInsertRows(QModelIndex(), at, at);
+    rowIndex_.emplace(row.accountId, at);
+    rows_.push_back(row);
+    endInsertRows();
+    emit countChanged();
+}
+
+void AccountListModel::removeAccountRow(int accountId) {
+    --total_;
+    int row = rowOf(accountId);
+    if (row < 0) {
+        emit countChanged();
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    rows_.erase(rows_.begin() + row);
+    rowIndex_.erase(accountId);
+    for (std::size_t i = static_cast<std::size_t>(row); i < rows_.size(); ++i)
+        rowIndex_[rows_[i].accountId] = static_cast<int>(i);
+    endRemoveRows();
+    emit countChanged();
+}
+
+void AccountListModel::updateAccountRow(const Row& row) {
+    int at = rowOf(row.accountId);
+    if (at < 0)
+        return;
+    Row& cached = rows_[static_cast<std::size_t>(at)];
+    cached.balance = row.balance;
+    cached.lastOperationType = row.lastOperationType;
+    cached.lastOperationTime = row.lastOperationTime;
+    QModelIndex changed = index(at);
+    emit dataChanged(changed, changed, {BalanceRole, BalanceTextRole, LastOperationTypeRole, LastOperationTimeRole});
+}
+
+AccountListModel::Row AccountListModel::makeRow(const Account& account) {
+    return Row{account.getAccountId(),
+               QString::fromUtf8(account.getPersonName()),
+               QString::fromUtf8(account.getCardId()),
+               account.balance(),
+               account.creationTime(),
+               account.lastOperationType(),
+               account.lastOperationTime()};
+}
+
+#include "moc_account_list_model.cpp"
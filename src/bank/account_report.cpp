@@ -0,0 +1,56 @@
+// account_report.cpp
+#include "account_report.h"
+
+namespace {
+
+// Rough size of one account block, to size the output in one allocation.
+constexpr std::size_t kApproxBlockSize = 192;
+
+} // namespace
+
+std::string describeAllAccounts(const Bank& bank) {
+    if (bank.accountCount() == 0)
+        return "No accounts in system";
+
+    std::string result;
+    result.reserve(bank.accountCount() * kApproxBlockSize);
+    bank.forEachAccount([&result](const Account& account) {
+        result += "========================\n";
+        result += "Account ID: ";
+        result += std::to_string(account.getAccountId());
+        result += "\nOwner: ";
+        result += account.getPersonName();
+        result += "\nBalance: $ ";
+        result += account.balance().toString();
+        result += "\nCreated: ";
+        result += formatTimestamp(account.creationTime());
+        result += "\nLast Operation: ";
+        result += toString(account.lastOperationType());
+        result += " (";
+        result += formatTimestamp(account.lastOperationTime());
+        result += ")\n\n";
+    });
+    return result;
+}
+
+std::string describePersonAccounts(const Bank& bank, const std::string& personName) {
+    const std::vector<int>& ids = bank.findByOwner(personName);
+    if (ids.empty())
+        return "No accounts found for person: " + personName;
+
+    std::string result;
+    result.reserve(ids.size() * kApproxBlockSize);
+    for (int accountId : ids) {
+        const Account* account = bank.find(accountId);
+        if (!account)
+            continue;
+        result += "Account ID: ";
+        result += std::to_string(accountId);
+        result += "\n  Owner: ";
+        result += account->getPersonName();
+        result += "\n  Balance: $ ";
+        result += account->balance().toString();
+        result += "\n\n";
+    }
+    return result;
+}
@@ -0,0 +1,122 @@
+// account_store.cpp
+#include "account_store.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// The ID table may be this much longer than the book, times kTableSlack.
+constexpr std::size_t kTableSlack = 4;
+constexpr std::size_t kMinTable = 4096;
+
+} // namespace
+
+Account* AccountStore::insert(Account account) {
+    int accountId = account.getAccountId();
+    if (accountId < 0)
+        throw std::invalid_argument("Invalid account ID");
+    if (contains(accountId))
+        return nullptr;
+    if (records_.size() >= static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+        throw std::length_error("Too many accounts");
+
+    // Everything that can throw comes first, so a failure leaves the columns
+    // and the table as they were.
+    auto index = static_cast<std::size_t>(accountId);
+    if (index >= slots_.size())
+        growTable(index);
+    if (records_.size() == records_.capacity())
+        reserve(std::max<std::size_t>(16, records_.size() * 2));
+    if (index >= slots_.size())
+        sparseSlots_.emplace(accountId, -1);
+
+    balances_.push_back(account.balance());
+    lastOperationTypes_.push_back(account.lastOperationType());
+    lastOperationTimes_.push_back(account.lastOperationTime());
+    records_.push_back(std::move(account));
+    setSlot(accountId, static_cast<std::int32_t>(records_.size() - 1));
+    return &records_.back();
+}
+
+bool AccountStore::erase(int accountId) {
+    std::int32_t slot = slotOf(accountId);
+    if (slot < 0)
+        return false;
+    auto freed = static_cast<std::size_t>(slot);
+    std::size_t last = records_.size() - 1;
+    if (freed != last) {
+        records_[freed] = std::move(records_[last]);
+        balances_[freed] = balances_[last];
+        lastOperationTypes_[freed] = lastOperationTypes_[last];
+        lastOperationTimes_[freed] = lastOperationTimes_[last];
+        setSlot(records_[freed].getAccountId(), slot);
+    }
+    records_.pop_back();
+    balances_.pop_back();
+    lastOperationTypes_.pop_back();
+    lastOperationTimes_.pop_back();
+    releaseSlot(accountId);
+    return true;
+}
+
+void AccountStore::setSlot(int accountId, std::int32_t slot) noexcept {
+    auto index = static_cast<std::size_t>(accountId);
+    if (index < slots_.size())
+        slots_[index] = slot;
+    else
+        sparseSlots_.find(accountId)->second = slot;
+}
+
+void AccountStore::releaseSlot(int accountId) noexcept {
+    auto index = static_cast<std::size_t>(accountId);
+    if (index < slots_.size())
+        slots_[index] = -1;
+    else
+        sparseSlots_.erase(accountId);
+}
+
+// Doubles the table, or stretches it to `index`, unless that would make it
+// much longer than the book; then the ID stays sparse.
+void AccountStore::growTable(std::size_t index) {
+    const std::size_t limit = std::max(kMinTable, (records_.size() + 1) * kTableSlack);
+    const std::size_t size = std::min(std::max(index + 1, slots_.size() * 2), std::max(limit, slots_.size()));
+    if (size <= slots_.size())
+        return;
+    std::vector<std::int32_t> grown(size, -1);
+    std::copy(slots_.begin(), slots_.end(), grown.begin());
+    // IDs the table now covers move into it.
+    std::unordered_map<int, std::int32_t> sparse;
+    for (const auto& [id, slot] : sparseSlots_) {
+        if (static_cast<std::size_t>(id) < size)
+            grown[static_cast<std::size_t>(id)] = slot;
+        else
+            sparse.emplace(id, slot);
+    }
+    slots_.swap(grown);
+    sparseSlots_.swap(sparse);
+}
+
+void AccountStore::clear() {
+    sparseSlots_.clear();
+    slots_.clear();
+    records_.clear();
+    balances_.clear();
+    lastOperationTypes_.clear();
+    lastOperationTimes_.clear();
+}
+
+void AccountStore::reserve(std::size_t count) {
+    records_.reserve(count);
+    balances_.reserve(count);
+    lastOperationTypes_.reserve(count);
+    lastOperationTimes_.reserve(count);
+}
+
+std::unordered_map<int, Account> AccountStore::toMap() const {
+    std::unordered_map<int, Account> result;
+    result.reserve(records_.size());
+    for (const Account& account : records_)
+        result.emplace(account.getAccountId(), account);
+    return result;
+}
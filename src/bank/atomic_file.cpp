@@ -0,0 +1,124 @@
+// atomic_file.cpp
+#include "atomic_file.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+[[noreturn]] void fail(const std::string& what, const std::string& filename) {
+    throw std::runtime_error(what + ": " + filename + ": " + std::strerror(errno));
+}
+
+std::string directoryOf(const std::string& filename) {
+    std::string::size_type slash = filename.rfind('/');
+    if (slash == std::string::npos)
+        return ".";
+    return slash == 0 ? "/" : filename.substr(0, slash);
+}
+
+} // namespace
+
+void replaceFileAtomically(const std::string& filename, std::initializer_list<std::string_view> parts,
+                           Durability durability) {
+    std::string tmp = filename + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        fail("Error opening file for writing", tmp);
+
+    try {
+        for (std::string_view part : parts)
+            writeAll(fd, part, tmp);
+        if (durability == Durability::Synced && ::fsync(fd) != 0)
+            fail("Error syncing file", tmp);
+    } catch (...) {
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        throw;
+    }
+    if (::close(fd) != 0) {
+        ::unlink(tmp.c_str());
+        fail("Error closing file", tmp);
+    }
+
+    if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+        int saved = errno;
+        ::unlink(tmp.c_str());
+        errno = saved;
+        fail("Error replacing file", filename);
+    }
+    if (durability == Durability::Unsynced)
+        return;
+    // Make the rename itself durable.
+    std::string directory = directoryOf(filename);
+    int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+}
+
+void writeAll(int fd, std::string_view data, const std::string& filename) {
+    while (!data.empty()) {
+        ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            fail("Error writing file", filename);
+        }
+        data.remove_prefix(static_cast<std::size_t>(written));
+    }
+}
+
+void appendRecords(int fd, std::uint64_t end, std::string_view data, const std::string& filename,
+                   Durability durability) {
+    try {
+        writeAll(fd, data, filename);
+        if (durability == Durability::Synced && ::fdatasync(fd) != 0)
+            fail("Error syncing file", filename);
+    } catch (...) {
+        if (::ftruncate(fd, static_cast<off_t>(end)) == 0)
+            ::lseek(fd, static_cast<off_t>(end), SEEK_SET);
+        throw;
+    }
+}
+
+void dropTornTail(int fd, std::uint64_t validEnd, const std::string& filename) {
+    if (::ftruncate(fd, static_cast<off_t>(validEnd)) != 0)
+        fail("Error truncating file", filename);
+    ::lseek(fd, static_cast<off_t>(validEnd), SEEK_SET);
+}
+
+FileLock::FileLock(const std::string& filename) : lockFile_(filename + ".lock") {
+    while (true) {
+        fd_ = ::open(lockFile_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+            fail("Error opening lock file", lockFile_);
+        if (::flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+            int saved = errno;
+            ::close(fd_);
+            errno = saved;
+            if (saved == EWOULDBLOCK)
+                throw std::runtime_error("In use by another process: " + filename);
+            fail("Error locking file", lockFile_);
+        }
+        // The holder before us unlinks the file before letting go; if it did
+        // so after we opened it, our lock is on a file nobody else will see.
+        struct stat opened {};
+        struct stat current {};
+        if (::fstat(fd_, &opened) == 0 && ::stat(lockFile_.c_str(), &current) == 0 &&
+            opened.st_dev == current.st_dev && opened.st_ino == current.st_ino)
+            return;
+        ::close(fd_);
+    }
+}
+
+FileLock::~FileLock() {
+    ::unlink(lockFile_.c_str());
+    ::close(fd_);
+}
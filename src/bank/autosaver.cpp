@@ -0,0 +1,190 @@
+// autosaver.cpp
+#include "autosaver.h"
+#include <cstdint>
+#include <memory>
+
+AutoSaver::AutoSaver(BankWorker& worker, IPersistence& persistence, AutoSaveOptions options)
+    : worker_(worker),
+      persistence_(persistence),
+      options_(options),
+      deltaSupported_(persistence.supportsDelta()),
+      deltaKey_("autosaver.delta." + std::to_string(reinterpret_cast<std::uintptr_t>(this))),
+      snapshotKey_("autosaver.snapshot." + std::to_string(reinterpret_cast<std::uintptr_t>(this))),
+      thread_(&AutoSaver::run, this) {
+    worker_.post([this](Bank& bank) {
+        bank.setDeferredPersistence(true);
+        bank.addObserver(this);
+    });
+}
+
+AutoSaver::~AutoSaver() {
+    worker_.post([this](Bank& bank) {
+        bank.removeObserver(this);
+        takeDelta(bank);
+        bank.setDeferredPersistence(false);
+    });
+    worker_.waitIdle();
+    waitForWrites();
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void AutoSaver::saveNow(Done done) {
+    worker_.postCoalesced(snapshotKey_, [this, done = std::move(done)](Bank& bank) { takeSnapshot(bank, done); });
+}
+
+void AutoSaver::flush() {
+    worker_.post([this](Bank& bank) { takeDelta(bank); });
+    worker_.waitIdle();
+    waitForWrites();
+}
+
+std::string AutoSaver::lastError() const {
+    std::lock_guard lock(mutex_);
+    return lastError_;
+}
+
+void AutoSaver::accountCreated(const Account&) {
+    countChange();
+}
+
+void AutoSaver::accountDeleted(int) {
+    countChange();
+}
+
+void AutoSaver::accountChanged(const Account&) {
+    countChange();
+}
+
+void AutoSaver::accountsChanged() {
+    // A posting run dirties most of the book; one snapshot beats a delta
+    // of that size.
+    snapshotNeeded_.store(true, std::memory_order_relaxed);
+    countChange();
+}
+
+void AutoSaver::countChange() {
+    if (changes_.fetch_add(1, std::memory_order_relaxed) + 1 == options_.changeThreshold) {
+        std::lock_guard lock(mutex_);
+        wake_.notify_one();
+    }
+}
+
+void AutoSaver::requestDelta() {
+    changes_.store(0, std::memory_order_relaxed);
+    worker_.postCoalesced(deltaKey_, [this](Bank& bank) { takeDelta(bank); });
+}
+
+void AutoSaver::takeDelta(Bank& bank) {
+    if (!deltaSupported_ || snapshotNeeded_.load(std::memory_order_relaxed)) {
+        if (bank.dirtyCount() > 0 || snapshotNeeded_.load(std::memory_order_relaxed))
+            takeSnapshot(bank, Done());
+        return;
+    }
+    Write write;
+    write.delta = bank.takeDirty();
+    if (!write.delta.empty())
+        enqueue(std::move(write));
+}
+
+void AutoSaver::takeSnapshot(Bank& bank, Done done) {
+    Write write;
+    write.snapshot = true;
+    // snapshot() rather than forEachAccount(): a lazily loading bank can
+    // copy accounts it has not loaded without loading them.
+    write.accounts = bank.snapshot();
+    if (bank.loadsLazily())
+        write.mark = bank.markSnapshot();
+    write.done = std::move(done);
+    // The snapshot covers everything dirty so far.
+    bank.takeDirty();
+    snapshotNeeded_.store(false, std::memory_order_relaxed);
+    enqueue(std::move(write));
+}
+
+void AutoSaver::enqueue(Write write) {
+    {
+        std::lock_guard lock(mutex_);
+        writes_.push_back(std::move(write));
+    }
+    wake_.notify_one();
+}
+
+void AutoSaver::perform(Write& write) {
+    try {
+        if (write.snapshot) {
+            persistence_.save(write.accounts);
+            snapshotsWritten_.fetch_add(1, std::memory_order_relaxed);
+            if (write.mark)
+                reopen(write.mark);
+        } else {
+            persistence_.saveDelta(write.delta);
+            deltasWritten_.fetch_add(1, std::memory_order_relaxed);
+            if (persistence_.needsCompaction())
+                saveNow();
+        }
+        if (write.done)
+            write.done(std::string());
+    } catch (const std::exception& e) {
+        // The changes in this write are no longer marked dirty; only a full
+        // snapshot is sure to cover them.
+        snapshotNeeded_.store(true, std::memory_order_relaxed);
+        {
+            std::lock_guard lock(mutex_);
+            lastError_ = e.what();
+        }
+        failedWrites_.fetch_add(1, std::memory_order_relaxed);
+        if (write.done)
+            write.done(e.what());
+    }
+}
+
+void AutoSaver::reopen(std::uint64_t mark) {
+    // Opened here, before any later write can change the store. A journal
+    // that cannot offer one leaves the bank as it is.
+    std::unique_ptr<AccountSource> source = persistence_.openSource();
+    if (!source)
+        return;
+    auto held = std::make_shared<std::unique_ptr<AccountSource>>(std::move(source));
+    worker_.post([held, mark](Bank& bank) { bank.snapshotSaved(std::move(*held), mark); });
+}
+
+void AutoSaver::waitForWrites() {
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [this] { return writes_.empty() && !busy_; });
+}
+
+void AutoSaver::run() {
+    std::unique_lock lock(mutex_);
+    auto deadline = std::chrono::steady_clock::now() + options_.interval;
+    while (!stopping_) {
+        wake_.wait_until(lock, deadline, [this] {
+            return stopping_ || !writes_.empty() ||
+                   changes_.load(std::memory_order_relaxed) >= options_.changeThreshold;
+        });
+        if (!writes_.empty()) {
+            Write write = std::move(writes_.front());
+            writes_.pop_front();
+            busy_ = true;
+            lock.unlock();
+            perform(write);
+            lock.lock();
+            busy_ = false;
+            if (writes_.empty())
+                idle_.notify_all();
+            continue;
+        }
+        if (stopping_)
+            break;
+        if (changes_.load(std::memory_order_relaxed) > 0 || snapshotNeeded_.load(std::memory_order_relaxed)) {
+            lock.unlock();
+            requestDelta();
+            lock.lock();
+        }
+        deadline = std::chrono::steady_clock::now() + options_.interval;
+    }
+}
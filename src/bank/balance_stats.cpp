@@ -0,0 +1,348 @@
+// balance_stats.cpp
+#include "balance_stats.h"
+#include "parallel_chunks.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BALANCE_STATS_X86 1
+#endif
+
+namespace balance_stats {
+namespace {
+
+// Money is a single int64 of minor units, so the kernels read the column as
+// plain int64s.
+static_assert(sizeof(Money) == sizeof(std::int64_t) && std::is_standard_layout_v<Money>,
+              "Money must be a bare int64 for the balance kernels");
+
+const std::int64_t* minorUnits(const std::vector<Money>& balances) {
+    return reinterpret_cast<const std::int64_t*>(balances.data());
+}
+
+// The sum wraps the way the vector adds do; summarize() decides whether the
+// wrapped value is the true total.
+struct Partial {
+    std::uint64_t sum = 0;
+    std::int64_t min = std::numeric_limits<std::int64_t>::max();
+    std::int64_t max = std::numeric_limits<std::int64_t>::min();
+};
+
+void merge(Partial& into, const Partial& from) {
+    into.sum += from.sum;
+    into.min = std::min(into.min, from.min);
+    into.max = std::max(into.max, from.max);
+}
+
+using ReduceKernel = Partial (*)(const std::int64_t* data, std::size_t size);
+using CountKernel = std::size_t (*)(const std::int64_t* data, std::size_t size, std::int64_t threshold);
+
+struct Kernels {
+    ReduceKernel reduce;
+    CountKernel countBelow;
+};
+
+// ---- Scalar: the fallback, and the tail of every vector kernel ----
+
+Partial reduceScalar(const std::int64_t* data, std::size_t size, Partial partial = Partial()) {
+    for (std::size_t i = 0; i < size; ++i) {
+        partial.sum += static_cast<std::uint64_t>(data[i]);
+        partial.min = std::min(partial.min, data[i]);
+        partial.max = std::max(partial.max, data[i]);
+    }
+    return partial;
+}
+
+Partial reduceScalarKernel(const std::int64_t* data, std::size_t size) {
+    return reduceScalar(data, size);
+}
+
+std::size_t countBelowScalar(const std::int64_t* data, std::size_t size, std::int64_t threshold) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < size; ++i)
+        count += data[i] < threshold;
+    return count;
+}
+
+#ifdef BALANCE_STATS_X86
+
+// ---- SSE2: two lanes ----
+
+// SSE2 has no 64-bit compare. a < b is the sign bit of
+// (a - b) ^ ((a ^ b) & ((a - b) ^ a)); spread it over the whole lane.
+inline __m128i lessThanSse2(__m128i a, __m128i b) {
+    __m128i diff = _mm_sub_epi64(a, b);
+    __m128i sign = _mm_xor_si128(diff, _mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(diff, a)));
+    return _mm_shuffle_epi32(_mm_srai_epi32(sign, 31), _MM_SHUFFLE(3, 3, 1, 1));
+}
+
+inline __m128i selectSse2(__m128i mask, __m128i ifSet, __m128i ifClear) {
+    return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifClear));
+}
+
+Partial reduceSse2(const std::int64_t* data, std::size_t size) {
+    __m128i sum = _mm_setzero_si128();
+    __m128i low = _mm_set1_epi64x(std::numeric_limits<std::int64_t>::max());
+    __m128i high = _mm_set1_epi64x(std::numeric_limits<std::int64_t>::min());
+    std::size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        sum = _mm_add_epi64(sum, v);
+        low = selectSse2(lessThanSse2(v, low), v, low);
+        high = selectSse2(lessThanSse2(high, v), v, high);
+    }
+    alignas(16) std::int64_t sums[2], lows[2], highs[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(sums), sum);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lows), low);
+    _mm_store_si128(reinterpret_cast<__m128i*>(highs), high);
+    Partial partial;
+    for (int lane = 0; lane < 2; ++lane)
+        merge(partial, {static_cast<std::uint64_t>(sums[lane]), lows[lane], highs[lane]});
+    return reduceScalar(data + i, size - i, partial);
+}
+
+std::size_t countBelowSse2(const std::int64_t* data, std::size_t size, std::int64_t threshold) {
+    // Each matching lane is -1; subtracting it counts up.
+    __m128i count = _mm_setzero_si128();
+    __m128i limit = _mm_set1_epi64x(threshold);
+    std::size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        count = _mm_sub_epi64(count, lessThanSse2(v, limit));
+    }
+    alignas(16) std::int64_t counts[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(counts), count);
+    return static_cast<std::size_t>(counts[0] + counts[1]) + countBelowScalar(data + i, size - i, threshold);
+}
+
+// ---- AVX2: four lanes ----
+
+__attribute__((target("avx2"))) Partial reduceAvx2(const std::int64_t* data, std::size_t size) {
+    __m256i sum = _mm256_setzero_si256();
+    __m256i low = _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::max());
+    __m256i high = _mm256_set1_epi64x(std::numeric_limits<std::int64_t>::min());
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        sum = _mm256_add_epi64(sum, v);
+        low = _mm256_blendv_epi8(low, v, _mm256_cmpgt_epi64(low, v));
+        high = _mm256_blendv_epi8(high, v, _mm256_cmpgt_epi64(v, high));
+    }
+    alignas(32) std::int64_t sums[4], lows[4], highs[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(sums), sum);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lows), low);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(highs), high);
+    Partial partial;
+    for (int lane = 0; lane < 4; ++lane)
+        merge(partial, {static_cast<std::uint64_t>(sums[lane]), lows[lane], highs[lane]});
+    return reduceScalar(data + i, size - i, partial);
+}
+
+__attribute__((target("avx2"))) std::size_t countBelowAvx2(const std::int64_t* data, std::size_t size,
+                                                           std::int64_t threshold) {
+    __m256i count = _mm256_setzero_si256();
+    __m256i limit = _mm256_set1_epi64x(threshold);
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        count = _mm256_sub_epi64(count, _mm256_cmpgt_epi64(limit, v));
+    }
+    alignas(32) std::int64_t counts[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(counts), count);
+    return static_cast<std::size_t>(counts[0] + counts[1] + counts[2] + counts[3]) +
+           countBelowScalar(data + i, size - i, threshold);
+}
+
+// ---- AVX-512: eight lanes ----
+
+__attribute__((target("avx512f"))) Partial reduceAvx512(const std::int64_t* data, std::size_t size) {
+    __m512i sum = _mm512_setzero_si512();
+    __m512i low = _mm512_set1_epi64(std::numeric_limits<std::int64_t>::max());
+    __m512i high = _mm512_set1_epi64(std::numeric_limits<std::int64_t>::min());
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m512i v = _mm512_loadu_si512(data + i);
+        sum = _mm512_add_epi64(sum, v);
+        // The unmasked min/max (and _mm512_reduce_*) pass GCC 12 an
+        // "undefined" vector it flags -Wmaybe-uninitialized. With every
+        // lane selected the masked forms compile to the same instruction.
+        low = _mm512_mask_min_epi64(low, 0xff, low, v);
+        high = _mm512_mask_max_epi64(high, 0xff, high, v);
+    }
+    alignas(64) std::int64_t sums[8], lows[8], highs[8];
+    _mm512_store_si512(sums, sum);
+    _mm512_store_si512(lows, low);
+    _mm512_store_si512(highs, high);
+    Partial partial;
+    for (int lane = 0; lane < 8; ++lane)
+        merge(partial, {static_cast<std::uint64_t>(sums[lane]), lows[lane], highs[lane]});
+    return reduceScalar(data + i, size - i, partial);
+}
+
+__attribute__((target("avx512f"))) std::size_t countBelowAvx512(const std::int64_t* data, std::size_t size,
+                                                               std::int64_t threshold) {
+    __m512i limit = _mm512_set1_epi64(threshold);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+        count += static_cast<std::size_t>(
+            __builtin_popcount(_mm512_cmplt_epi64_mask(_mm512_loadu_si512(data + i), limit)));
+    return count + countBelowScalar(data + i, size - i, threshold);
+}
+
+#endif // BALANCE_STATS_X86
+
+Kernels kernelsFor(SimdLevel level) {
+    switch (std::min(level, detectSimdLevel())) {
+#ifdef BALANCE_STATS_X86
+    case SimdLevel::AVX512:
+        return {reduceAvx512, countBelowAvx512};
+    case SimdLevel::AVX2:
+        return {reduceAvx2, countBelowAvx2};
+    case SimdLevel::SSE2:
+        return {reduceSse2, countBelowSse2};
+#endif
+    default:
+        return {reduceScalarKernel, countBelowScalar};
+    }
+}
+
+unsigned workerCount(std::size_t size, const Options& options) {
+    unsigned workers = options.threads;
+    if (workers == 0)
+        workers = size < kParallelThreshold ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<unsigned>(std::clamp<std::size_t>(size, 1, workers));
+}
+
+// How many balances fall below each edge, in one sweep over the column:
+// every edge is checked against a block while it is still in L1.
+std::vector<std::size_t> countBelowEach(const std::vector<Money>& balances, const std::vector<Money>& edges,
+                                        const Options& options) {
+    constexpr std::size_t kBlock = 4096;  // 32 KiB of balances
+    const std::int64_t* data = minorUnits(balances);
+    Kernels kernels = kernelsFor(options.level);
+    unsigned workers = workerCount(balances.size(), options);
+    std::vector<std::vector<std::size_t>> partials(workers, std::vector<std::size_t>(edges.size()));
+    forEachChunk(balances.size(), workers, [&](unsigned worker, std::size_t begin, std::size_t end) {
+        std::vector<std::size_t>& below = partials[worker];
+        for (std::size_t block = begin; block < end; block += kBlock) {
+            std::size_t length = std::min(kBlock, end - block);
+            for (std::size_t e = 0; e < edges.size(); ++e)
+                below[e] += kernels.countBelow(data + block, length, edges[e].minorUnits());
+        }
+    });
+    std::vector<std::size_t> below(edges.size());
+    for (const auto& partial : partials)
+        for (std::size_t e = 0; e < edges.size(); ++e)
+            below[e] += partial[e];
+    return below;
+}
+
+} // namespace
+
+SimdLevel detectSimdLevel() noexcept {
+#ifdef BALANCE_STATS_X86
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return SimdLevel::SSE2;
+        return SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const char* toString(SimdLevel level) noexcept {
+    switch (level) {
+    case SimdLevel::SSE2: return "SSE2";
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::AVX512: return "AVX-512";
+    default: return "Scalar";
+    }
+}
+
+Summary summarize(const std::vector<Money>& balances, const Options& options) {
+    Summary summary;
+    summary.count = balances.size();
+    if (balances.empty())
+        return summary;
+
+    const std::int64_t* data = minorUnits(balances);
+    Kernels kernels = kernelsFor(options.level);
+    unsigned workers = workerCount(balances.size(), options);
+    std::vector<Partial> partials(workers);
+    forEachChunk(balances.size(), workers, [&](unsigned worker, std::size_t begin, std::size_t end) {
+        partials[worker] = kernels.reduce(data + begin, end - begin);
+    });
+    Partial total;
+    for (const Partial& partial : partials)
+        merge(total, partial);
+
+    // The wrapped sum is exact whenever the true sum fits in an int64, and
+    // count * min <= sum <= count * max bounds it. Only when the bounds
+    // leave that range is the column added up again without wrapping.
+    __extension__ using Wide = __int128;
+    constexpr Wide kLowest = std::numeric_limits<std::int64_t>::min();
+    constexpr Wide kHighest = std::numeric_limits<std::int64_t>::max();
+    auto count = static_cast<Wide>(balances.size());
+    if (count * total.min < kLowest || count * total.max > kHighest) {
+        Wide exact = 0;
+        for (std::size_t i = 0; i < balances.size(); ++i)
+            exact += data[i];
+        if (exact < kLowest || exact > kHighest)
+            throw std::overflow_error("Money overflow");
+    }
+    summary.total = Money::fromMinorUnits(static_cast<std::int64_t>(total.sum));
+    summary.min = Money::fromMinorUnits(total.min);
+    summary.max = Money::fromMinorUnits(total.max);
+    return summary;
+}
+
+std::size_t countBelow(const std::vector<Money>& balances, Money threshold, const Options& options) {
+    const std::int64_t* data = minorUnits(balances);
+    Kernels kernels = kernelsFor(options.level);
+    unsigned workers = workerCount(balances.size(), options);
+    std::vector<std::size_t> partials(workers);
+    forEachChunk(balances.size(), workers, [&](unsigned worker, std::size_t begin, std::size_t end) {
+        partials[worker] = kernels.countBelow(data + begin, end - begin, threshold.minorUnits());
+    });
+    std::size_t count = 0;
+    for (std::size_t partial : partials)
+        count += partial;
+    return count;
+}
+
+std::size_t countInRange(const std::vector<Money>& balances, Money low, Money high, const Options& options) {
+    if (high <= low)
+        return 0;
+    std::vector<std::size_t> below = countBelowEach(balances, {low, high}, options);
+    return below[1] - below[0];
+}
+
+std::vector<std::size_t> histogram(const std::vector<Money>& balances, const std::vector<Money>& edges,
+                                   const Options& options) {
+    if (!std::is_sorted(edges.begin(), edges.end()))
+        throw std::invalid_argument("Histogram edges must be ascending");
+    std::vector<std::size_t> below = countBelowEach(balances, edges, options);
+    std::vector<std::size_t> buckets(edges.size() + 1);
+    std::size_t previous = 0;
+    for (std::size_t e = 0; e < edges.size(); ++e) {
+        buckets[e] = below[e] - previous;
+        previous = below[e];
+    }
+    buckets.back() = balances.size() - previous;
+    return buckets;
+}
+
+} // namespace balance_stats
@@ -1,62 +1,560 @@
 #include "bank.h"
+#include "metrics.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include "transfer_plan.h"
 
-Bank::Bank(IPersistence& persistence) : persistence_(persistence), nextAccountId_(0) {
-    accounts_ = persistence_.load();
-    // Find the highest account ID to continue from there
-    for (const auto& pair : accounts_) {
+namespace {
+
+// Hands the batch's per-operation hooks on and appends each balance change
+// to the history, if there is one; applyBatchGroups() has no other
+// per-operation view.
+class HistoryHooks : public IPersistence {
+public:
+    HistoryHooks(IPersistence& hooks, TransactionHistory* history) : hooks_(hooks), history_(history) {}
+
+    void save(const std::unordered_map<int, Account>& accounts) override { hooks_.save(accounts); }
+    std::unordered_map<int, Account> load() override { return hooks_.load(); }
+    void recordDeposit(const Account& account, Money amount) override {
+        hooks_.recordDeposit(account, amount);
+        if (history_)
+            history_->append(account.getAccountId(), OperationType::Deposit, amount, account.lastOperationTime());
+    }
+    void recordWithdraw(const Account& account, Money amount) override {
+        hooks_.recordWithdraw(account, amount);
+        if (history_)
+            history_->append(account.getAccountId(), OperationType::Withdrawal, -amount,
+                             account.lastOperationTime());
+    }
+
+private:
+    IPersistence& hooks_;
+    TransactionHistory* history_;
+};
+
+} // namespace
+
+Bank::Bank(IPersistence& persistence, const BankOptions& options)
+    : nextAccountId_(0), persistence_(persistence), hooks_(&persistence) {
+    if (options.lazyLoad) {
+        source_ = persistence_.openSource();
+        if (source_) {
+            residentLimit_ = options.residentAccounts;
+            bookSize_ = source_->size();
+            nextAccountId_ = source_->maxAccountId() + 1;
+            return;
+        }
+    }
+    std::unordered_map<int, Account> loaded = persistence_.load();
+    accounts_.reserve(loaded.size());
+    for (auto& pair : loaded) {
+        // Find the highest account ID to continue from there
         nextAccountId_ = std::max(nextAccountId_, pair.first);
+        index_.add(*accounts_.insert(std::move(pair.second)));
     }
     nextAccountId_++;  // Start with the next ID
 }
 
-int Bank::createAccount(const std::string& personName, const std::string& cardId, double initialBalance) {
-    int accountId = nextAccountId_++;
-    auto result = accounts_.emplace(accountId, Account{accountId, initialBalance, personName, cardId});
-    if (result.second) {
-        return accountId;
+int Bank::createAccount(const std::string& personName, const std::string& cardId, Money initialBalance) {
+    BANK_METRIC_TIME_SAMPLED(CreateAccount);
+    int accountId = nextAccountId_;
+    if (source_)
+        evictFor(1, 0);
+    Account* account = accounts_.insert(Account{accountId, initialBalance, personName, cardId});
+    if (!account)
+        throw std::runtime_error("Failed to create account");
+    try {
+        hooks_->recordCreate(*account);
+    } catch (...) {
+        accounts_.erase(accountId);
+        throw;
     }
-    nextAccountId_--;
-    throw std::runtime_error("Failed to create account");
+    ++nextAccountId_;
+    if (source_) {
+        ++bookSize_;  // pinned: the source has never seen it
+        noteChange(accountId);
+    } else
+        index_.add(*account);
+    if (history_ && initialBalance != Money())
+        history_->append(accountId, OperationType::Deposit, initialBalance, account->creationTime());
+    notify([&](IBankObserver& o) { o.accountCreated(*account); });
+    BANK_METRIC_COUNT(AccountsCreated);
+    compactIfNeeded();
+    return accountId;
 }
 
 bool Bank::deleteAccount(int accountId) {
-    return accounts_.erase(accountId) > 0;
+    // The record goes first: if it cannot be written the account stays.
+    if (source_) {
+        // No need to load it: forget it if resident, hide it if saved.
+        const bool saved = inSource(accountId);
+        if (!saved && !accounts_.contains(accountId))
+            return false;
+        hooks_->recordDelete(accountId);
+        if (auto at = unpinnedAt_.find(accountId); at != unpinnedAt_.end()) {
+            unpinned_.erase(at->second);
+            unpinnedAt_.erase(at);
+        }
+        accounts_.erase(accountId);
+        if (saved)
+            deletedFromSource_.insert(accountId);
+        noteChange(accountId);
+        --bookSize_;
+    } else {
+        const Account* account = accounts_.find(accountId);
+        if (!account)
+            return false;
+        hooks_->recordDelete(accountId);
+        index_.remove(*account);
+        accounts_.erase(accountId);
+    }
+    notify([&](IBankObserver& o) { o.accountDeleted(accountId); });
+    BANK_METRIC_COUNT(AccountsDeleted);
+    compactIfNeeded();
+    return true;
+}
+
+void Bank::deposit(int accountId, Money amount) {
+    BANK_METRIC_TIME_SAMPLED(Deposit);
+    Account& account = findAccount(accountId);
+    const BalanceUndo undo(account);
+    account.deposit(amount);
+    try {
+        hooks_->recordDeposit(account, amount);
+    } catch (...) {
+        undo.restore(account);
+        throw;
+    }
+    accounts_.refresh(account);
+    recordHistory(account, amount);
+    notify([&](IBankObserver& o) { o.accountChanged(account); });
+    BANK_METRIC_COUNT(Deposits);
+    compactIfNeeded();
+}
+
+void Bank::withdraw(int accountId, Money amount) {
+    BANK_METRIC_TIME_SAMPLED(Withdraw);
+    Account& account = findAccount(accountId);
+    const BalanceUndo undo(account);
+    account.withdraw(amount);
+    try {
+        hooks_->recordWithdraw(account, amount);
+    } catch (...) {
+        undo.restore(account);
+        throw;
+    }
+    accounts_.refresh(account);
+    recordHistory(account, -amount);
+    notify([&](IBankObserver& o) { o.accountChanged(account); });
+    BANK_METRIC_COUNT(Withdrawals);
+    compactIfNeeded();
 }
 
-void Bank::deposit(int accountId, double amount) {
-    findAccount(accountId).deposit(amount);
+void Bank::transfer(int fromAccountId, int toAccountId, Money amount) {
+    BANK_METRIC_TIME_SAMPLED(Transfer);
+    if (source_)
+        makeResident({fromAccountId, toAccountId}, true);
+    Account& from = findAccount(fromAccountId);
+    Account& to = findAccount(toAccountId);
+    const BalanceUndo undoFrom(from);
+    const BalanceUndo undoTo(to);
+    from.transferTo(to, amount);
+    try {
+        hooks_->recordTransfer(from, to, amount);
+    } catch (...) {
+        undoFrom.restore(from);
+        undoTo.restore(to);
+        throw;
+    }
+    accounts_.refresh(from);
+    accounts_.refresh(to);
+    recordHistory(from, -amount);
+    recordHistory(to, amount);
+    notify([&](IBankObserver& o) {
+        o.accountChanged(from);
+        o.accountChanged(to);
+    });
+    BANK_METRIC_COUNT(Transfers);
+    compactIfNeeded();
 }
 
-void Bank::withdraw(int accountId, double amount) {
-    findAccount(accountId).withdraw(amount);
+void Bank::transferMany(const std::vector<Transfer>& transfers) {
+    if (source_) {
+        std::vector<int> accountIds;
+        accountIds.reserve(2 * transfers.size());
+        for (const Transfer& transfer : transfers) {
+            accountIds.push_back(transfer.fromAccountId);
+            accountIds.push_back(transfer.toAccountId);
+        }
+        makeResident(std::move(accountIds), true);
+    }
+    TransferPlan plan = planTransfers(transfers, [this](int accountId) -> Account& { return findAccount(accountId); });
+    const Timestamp now = currentTimestamp();
+    hooks_->recordTransfers(plan.records, now);
+    applyTransfers(plan, now);
+    for (std::size_t i = 0; i < plan.accounts.size(); ++i) {
+        auto [from, to] = plan.accounts[i];
+        accounts_.refresh(*from);
+        accounts_.refresh(*to);
+        recordHistory(*from, -transfers[i].amount);
+        recordHistory(*to, transfers[i].amount);
+    }
+    for (const auto& [from, to] : plan.accounts) {
+        notify([&](IBankObserver& o) {
+            o.accountChanged(*from);
+            o.accountChanged(*to);
+        });
+    }
+    compactIfNeeded();
 }
 
-const Account& Bank::getAccount(int accountId) const {
+BatchReport Bank::applyBatch(const std::vector<BatchOperation>& operations) {
+    BatchReport report;
+    if (source_) {
+        std::vector<int> accountIds;
+        accountIds.reserve(operations.size());
+        for (const BatchOperation& op : operations)
+            accountIds.push_back(op.accountId);
+        makeResident(std::move(accountIds), true);
+    }
+    std::vector<std::size_t> order(operations.size());
+    std::iota(order.begin(), order.end(), 0);
+    HistoryHooks hooks(*hooks_, history_);
+    applyBatchGroups(operations, order, [this](int accountId) { return accounts_.find(accountId); }, hooks, report);
+    // `order` is now grouped by account: one refresh and notification per
+    // touched account.
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        int accountId = operations[order[i]].accountId;
+        if (i > 0 && operations[order[i - 1]].accountId == accountId)
+            continue;
+        if (const Account* account = accounts_.find(accountId)) {
+            accounts_.refresh(*account);
+            notify([&](IBankObserver& o) { o.accountChanged(*account); });
+        }
+    }
+    report.sortFailuresByLine();
+    BANK_METRIC_ADD(BatchOperations, operations.size());
+    compactIfNeeded();
+    return report;
+}
+
+PostingReport Bank::applyPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint,
+                                  const PostingProgress& progress) {
+    BANK_METRIC_TIME(PostingRun);
+    loadAll();
+    if (!checkpoint.started())
+        checkpoint = {1, nextAccountId_};
+    const Timestamp asOf = postingTimestamp();
+
+    // What each account in the current chunk was posted, by ID; the workers
+    // write distinct entries. Between chunks the posted accounts, the ones
+    // stamped with the run's time, go to the history and the dirty set.
+    const bool perAccount = history_ || deferredPersistence();
+    std::vector<Money> changes(history_ ? kPostingChunk : 0);
+    int chunkBegin = checkpoint.nextAccountId;
+    auto afterChunk = [&](const PostingCheckpoint& at) {
+        for (int id = chunkBegin; perAccount && id < at.nextAccountId; ++id) {
+            const Account* account = accounts_.find(id);
+            if (!account || account->lastOperationType() != OperationType::Posting ||
+                account->lastOperationTime() != asOf)
+                continue;
+            if (history_)
+                history_->append(id, OperationType::Posting, changes[static_cast<std::size_t>(id - chunkBegin)], asOf);
+            if (deferredPersistence())
+                dirty_.markChanged(id);
+        }
+        chunkBegin = at.nextAccountId;
+        return !progress || progress(at);
+    };
+    // Each chunk is journaled before it runs, so a failed record leaves its
+    // accounts and the checkpoint untouched; replay then redoes exactly the
+    // chunks that ran.
+    std::function<void(const PostingSegment&)> record;
+    if (!deferredPersistence())
+        record = [&](const PostingSegment& chunk) { hooks_->recordPosting(schedule, chunk); };
+    const int runBegin = checkpoint.nextAccountId;
+    PostingReport report;
+    try {
+        report = runPostings(
+            schedule, checkpoint, asOf, afterChunk, [this](int accountId) { return accounts_.find(accountId); },
+            [&](Account& account, Money change) {
+                accounts_.refresh(account);
+                if (history_)
+                    changes[static_cast<std::size_t>(account.getAccountId() - chunkBegin)] = change;
+            },
+            record);
+    } catch (...) {
+        // The chunks before the failed one stand; `checkpoint` resumes after them.
+        if (checkpoint.nextAccountId != runBegin)
+            notify([](IBankObserver& o) { o.accountsChanged(); });
+        throw;
+    }
+    if (report.posted == 0)
+        return report;
+
+    notify([](IBankObserver& o) { o.accountsChanged(); });
+    BANK_METRIC_ADD(PostedAccounts, report.posted);
+    compactIfNeeded();
+    return report;
+}
+
+Account Bank::getAccount(int accountId) const {
     return findAccount(accountId);
 }
 
+Money Bank::getBalance(int accountId) const {
+    return findAccount(accountId).balance();
+}
+
 std::vector<Account> Bank::getAllAccounts() const {
-    std::vector<Account> result;
-    for (const auto& pair : accounts_) {
-        result.push_back(pair.second);
+    loadAll();
+    return std::vector<Account>(accounts_.begin(), accounts_.end());
+}
+
+std::unordered_map<int, Account> Bank::snapshot() const {
+    if (!source_)
+        return accounts_.toMap();
+    std::unordered_map<int, Account> accounts = accounts_.toMap();
+    accounts.reserve(bookSize_);
+    for (std::size_t i = 0; i < source_->size(); ++i) {
+        int accountId = source_->accountId(i);
+        if (!accounts.count(accountId) && !deletedFromSource_.count(accountId))
+            accounts.try_emplace(accountId, source_->materialize(i));
+    }
+    return accounts;
+}
+
+Bank::AccountPage Bank::page(int cursor, std::size_t limit) const {
+    AccountPage result;
+    if (source_) {
+        // The source lists saved accounts in ID order; accounts created
+        // since are all resident and have higher IDs.
+        std::vector<int> accountIds;
+        int id = std::max(cursor, 1);
+        for (std::size_t i = source_->lowerBound(id); i < source_->size() && accountIds.size() < limit; ++i) {
+            id = source_->accountId(i);
+            if (!deletedFromSource_.count(id))
+                accountIds.push_back(id);
+            ++id;
+        }
+        if (accountIds.size() < limit)
+            id = std::max(id, source_->maxAccountId() + 1);
+        for (; id < nextAccountId_ && accountIds.size() < limit; ++id) {
+            if (accounts_.contains(id))
+                accountIds.push_back(id);
+        }
+        makeResident(accountIds, false);
+        result.accounts.reserve(accountIds.size());
+        for (int accountId : accountIds)
+            result.accounts.push_back(accounts_.find(accountId));
+        result.nextCursor = id < nextAccountId_ ? id : 0;
+        return result;
     }
+
+    // IDs are handed out sequentially, so walking the ID space visits the
+    // book in order without sorting it.
+    result.accounts.reserve(std::min(limit, accounts_.size()));
+    int id = std::max(cursor, 1);
+    for (; id < nextAccountId_ && result.accounts.size() < limit; ++id) {
+        if (const Account* account = accounts_.find(id))
+            result.accounts.push_back(account);
+    }
+    result.nextCursor = id < nextAccountId_ ? id : 0;
     return result;
 }
 
+void Bank::addObserver(IBankObserver* observer) {
+    observers_.push_back(observer);
+}
+
+void Bank::removeObserver(IBankObserver* observer) {
+    observers_.erase(std::remove(observers_.begin(), observers_.end(), observer), observers_.end());
+}
+
 void Bank::save() {
-    persistence_.save(accounts_);
+    persistence_.save(snapshot());
+    dirty_.clear();
+    if (source_)
+        reopenSource();
+}
+
+void Bank::setDeferredPersistence(bool deferred) {
+    hooks_ = deferred ? static_cast<IPersistence*>(&dirty_) : &persistence_;
+}
+
+AccountDelta Bank::takeDirty() {
+    AccountDelta delta;
+    delta.changed.reserve(dirty_.changed().size());
+    // Read through the const lookup: copying them is not a change.
+    for (int accountId : dirty_.changed())
+        delta.changed.push_back(std::as_const(*this).findAccount(accountId));
+    delta.deleted.assign(dirty_.deleted().begin(), dirty_.deleted().end());
+    delta.created = dirty_.created();
+    dirty_.clear();
+    return delta;
 }
 
 Account& Bank::findAccount(int accountId) {
-    auto it = accounts_.find(accountId);
-    if (it == accounts_.end())
+    Account* account = source_ ? resident(accountId, true) : accounts_.find(accountId);
+    if (!account)
         throw std::runtime_error("Account not found");
-    return it->second;
+    return *account;
 }
 
 const Account& Bank::findAccount(int accountId) const {
-    auto it = accounts_.find(accountId);
-    if (it == accounts_.end())
+    const Account* account = source_ ? resident(accountId, false) : accounts_.find(accountId);
+    if (!account)
         throw std::runtime_error("Account not found");
-    return it->second;
+    return *account;
+}
+
+Account* Bank::resident(int accountId, bool pin) const {
+    if (pin)
+        noteChange(accountId);
+    if (Account* account = accounts_.find(accountId)) {
+        touch(accountId, pin);
+        return account;
+    }
+    makeResident({accountId}, pin);
+    return accounts_.find(accountId);
+}
+
+bool Bank::touch(int accountId, bool pin) const {
+    auto at = unpinnedAt_.find(accountId);
+    if (at == unpinnedAt_.end())
+        return false;
+    if (pin) {
+        unpinned_.erase(at->second);
+        unpinnedAt_.erase(at);
+        return false;
+    }
+    unpinned_.splice(unpinned_.end(), unpinned_, at->second);
+    return true;
+}
+
+void Bank::makeResident(std::vector<int> accountIds, bool pin) const {
+    if (accountIds.size() > 1) {
+        std::sort(accountIds.begin(), accountIds.end());
+        accountIds.erase(std::unique(accountIds.begin(), accountIds.end()), accountIds.end());
+    }
+    // Mark the resident ones used (or pinned) first, so that eviction spares
+    // them, and find where the rest sit in the source.
+    std::size_t spared = 0;
+    std::vector<std::size_t> missing;
+    for (int accountId : accountIds) {
+        if (pin)
+            noteChange(accountId);
+        if (accounts_.contains(accountId)) {
+            spared += touch(accountId, pin) ? 1 : 0;
+        } else if (!deletedFromSource_.count(accountId)) {
+            std::size_t index = source_->find(accountId);
+            if (index != AccountSource::npos)
+                missing.push_back(index);
+        }
+    }
+    if (missing.empty())
+        return;
+
+    evictFor(missing.size(), spared);
+    BANK_METRIC_ADD(AccountsFaultedIn, missing.size());
+    for (std::size_t index : missing) {
+        Account* account = accounts_.insert(source_->materialize(index));
+        if (!pin)
+            unpinnedAt_.emplace(account->getAccountId(),
+                                unpinned_.insert(unpinned_.end(), account->getAccountId()));
+    }
+}
+
+void Bank::evictFor(std::size_t incoming, std::size_t spared) const {
+    // The `spared` most recently used stay, whatever the limit says.
+    while (accounts_.size() + incoming > residentLimit_ && unpinned_.size() > spared) {
+        int accountId = unpinned_.front();
+        unpinned_.pop_front();
+        unpinnedAt_.erase(accountId);
+        accounts_.erase(accountId);
+        BANK_METRIC_COUNT(AccountsEvicted);
+    }
+}
+
+void Bank::loadSource() const {
+    accounts_.reserve(bookSize_);
+    for (std::size_t i = 0; i < source_->size(); ++i) {
+        int accountId = source_->accountId(i);
+        if (!accounts_.contains(accountId) && !deletedFromSource_.count(accountId))
+            accounts_.insert(source_->materialize(i));
+    }
+    for (const Account& account : accounts_)
+        index_.add(account);
+    source_.reset();
+    unpinned_.clear();
+    unpinnedAt_.clear();
+    changedAfter_.clear();
+}
+
+void Bank::snapshotSaved(std::unique_ptr<AccountSource> source, std::uint64_t mark) {
+    // Loaded in full since the mark: nothing is pinned any more.
+    if (source_)
+        adoptSource(std::move(source), mark);
+}
+
+void Bank::reopenSource() {
+    adoptSource(persistence_.openSource(), markSnapshot());
+}
+
+void Bank::adoptSource(std::unique_ptr<AccountSource> reopened, std::uint64_t mark) {
+    if (!reopened)
+        return;  // the old source plus the pinned accounts are still the book
+    source_ = std::move(reopened);
+    bookSize_ = source_->size();
+    std::unordered_set<int> deleted;
+    for (auto at = changedAfter_.begin(); at != changedAfter_.end();) {
+        if (at->second < mark) {
+            at = changedAfter_.erase(at);
+            continue;
+        }
+        // Changed after the copy was taken, so still to be saved: kept
+        // pinned if resident, and hidden if deleted.
+        const bool saved = source_->find(at->first) != AccountSource::npos;
+        if (accounts_.contains(at->first)) {
+            bookSize_ += saved ? 0 : 1;
+        } else if (saved) {
+            deleted.insert(at->first);
+            --bookSize_;
+        }
+        ++at;
+    }
+    deletedFromSource_ = std::move(deleted);
+    unpinned_.clear();
+    unpinnedAt_.clear();
+    for (const Account& account : accounts_)
+        if (!changedAfter_.count(account.getAccountId()))
+            unpinnedAt_.emplace(account.getAccountId(), unpinned_.insert(unpinned_.end(), account.getAccountId()));
+    evictFor(0, 0);
+}
+
+bool Bank::inSource(int accountId) const {
+    return !deletedFromSource_.count(accountId) && source_->find(accountId) != AccountSource::npos;
+}
+
+const std::vector<Money>& Bank::allBalances(std::vector<Money>& scratch) const {
+    if (!source_)
+        return accounts_.balances();
+    scratch.reserve(bookSize_);
+    scratch = accounts_.balances();
+    for (std::size_t i = 0; i < source_->size(); ++i) {
+        int accountId = source_->accountId(i);
+        if (!accounts_.contains(accountId) && !deletedFromSource_.count(accountId))
+            scratch.push_back(source_->balance(i));
+    }
+    return scratch;
+}
+
+void Bank::compactIfNeeded() {
+    // Deferred changes reach the store through takeDirty(); whoever drains
+    // them decides when to compact.
+    if (deferredPersistence())
+        return;
+    if (persistence_.needsCompaction())
+        save();
 }
\ No newline at end of file
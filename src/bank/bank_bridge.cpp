@@ -1,173 +1,376 @@
 #include "bank_bridge.h"
+#include "account_report.h"
+#include "metrics.h"
 #include <QJsonObject>
 #include <QJsonArray>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
 
-BankBridge::BankBridge(Bank& bank, QObject* parent)
-    : QObject(parent), bank_(bank) {
+// Slots run on the GUI thread and only queue work; the jobs run on the
+// worker thread and emit from there. Signals crossing threads are queued by
+// Qt, so QML handlers still run on the GUI thread.
+
+namespace {
+
+// Counts a request and times it from the slot call until its job has run,
+// queueing included.
+template <typename Job>
+auto timed(Job job) {
+    BANK_METRIC_COUNT(BridgeRequests);
+#ifdef BANK_METRICS
+    return [job = std::move(job), start = metrics::ticks()](Bank& bank) mutable {
+        job(bank);
+        metrics::recordTicks(metrics::Timer::BridgeRequest, metrics::ticks() - start);
+    };
+#else
+    return job;
+#endif
 }
 
-BankBridge::~BankBridge() = default;
+} // namespace
 
-int BankBridge::createAccount(const QString& personName, const QString& cardId, double initialBalance) {
-    try {
-        if (personName.isEmpty() || cardId.isEmpty()) {
-            emit error("Person name and card ID cannot be empty");
-            return -1;
-        }
-        
-        int accountId = bank_.createAccount(
-            personName.toStdString(),
-            cardId.toStdString(),
-            initialBalance
-        );
-        
-        emit accountCreated(accountId);
-        emit accountsUpdated();
-        return accountId;
-    } catch (const std::exception& e) {
-        emit error(QString::fromStdString(e.what()));
-        return -1;
-    }
+BankBridge::BankBridge(BankWorker& worker, AutoSaver* autosaver, QObject* parent)
+    : QObject(parent), worker_(worker), autosaver_(autosaver) {
+    worker_.setErrorHandler([this](const std::string& message) { emit error(QString::fromStdString(message)); });
+#ifdef BANK_METRICS
+    // Direct connection: counted on whichever thread reports the error.
+    connect(this, &BankBridge::error, this, [] { BANK_METRIC_COUNT(BridgeErrors); }, Qt::DirectConnection);
+#endif
 }
 
-bool BankBridge::deleteAccount(int accountId) {
-    try {
-        bool success = bank_.deleteAccount(accountId);
-        if (success) {
-            emit accountDeleted(accountId);
+BankBridge::~BankBridge() {
+    // Queued jobs capture this; let them finish before it goes away.
+    worker_.waitIdle();
+    worker_.setErrorHandler(nullptr);
+}
+
+void BankBridge::createAccount(const QString& personName, const QString& cardId, double initialBalance) {
+    if (personName.isEmpty() || cardId.isEmpty()) {
+        emit error("Person name and card ID cannot be empty");
+        return;
+    }
+    worker_.post(timed([this, personName, cardId, initialBalance](Bank& bank) {
+        try {
+            int accountId = bank.createAccount(
+                personName.toStdString(),
+                cardId.toStdString(),
+                Money(initialBalance)
+            );
+
+            emit accountCreated(accountId);
             emit accountsUpdated();
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
         }
-        return success;
-    } catch (const std::exception& e) {
-        emit error(QString::fromStdString(e.what()));
-        return false;
-    }
+    }));
+}
+
+void BankBridge::deleteAccount(int accountId) {
+    worker_.post(timed([this, accountId](Bank& bank) {
+        try {
+            if (bank.deleteAccount(accountId)) {
+                emit accountDeleted(accountId);
+                emit accountsUpdated();
+            } else {
+                emit error("Account not found");
+            }
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
+        }
+    }));
 }
 
 void BankBridge::deposit(int accountId, double amount) {
-    try {
-        bank_.deposit(accountId, amount);
-        const auto& account = bank_.getAccount(accountId);
-        emit balanceChanged(accountId, account.balance());
-        emit accountsUpdated();
-    } catch (const std::exception& e) {
-        emit error(QString::fromStdString(e.what()));
-    }
+    worker_.post(timed([this, accountId, amount](Bank& bank) {
+        try {
+            bank.deposit(accountId, Money(amount));
+            emit balanceChanged(accountId, bank.getBalance(accountId).toDouble());
+            emit accountsUpdated();
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
+        }
+    }));
 }
 
 void BankBridge::withdraw(int accountId, double amount) {
-    try {
-        bank_.withdraw(accountId, amount);
-        const auto& account = bank_.getAccount(accountId);
-        emit balanceChanged(accountId, account.balance());
-        emit accountsUpdated();
-    } catch (const std::exception& e) {
-        emit error(QString::fromStdString(e.what()));
-    }
+    worker_.post(timed([this, accountId, amount](Bank& bank) {
+        try {
+            bank.withdraw(accountId, Money(amount));
+            emit balanceChanged(accountId, bank.getBalance(accountId).toDouble());
+            emit accountsUpdated();
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
+        }
+    }));
 }
 
-QJsonObject BankBridge::getAccount(int accountId) {
-    QJsonObject obj;
-    try {
-        const auto& account = bank_.getAccount(accountId);
-        obj["accountId"] = accountId;
-        obj["balance"] = account.balance();
-    } catch (const std::exception& e) {
-        emit error(QString::fromStdString(e.what()));
-    }
-    return obj;
+void BankBridge::transfer(int fromAccountId, int toAccountId, double amount) {
+    worker_.post(timed([this, fromAccountId, toAccountId, amount](Bank& bank) {
+        try {
+            bank.transfer(fromAccountId, toAccountId, Money(amount));
+            emit balanceChanged(fromAccountId, bank.getBalance(fromAccountId).toDouble());
+            emit balanceChanged(toAccountId, bank.getBalance(toAccountId).toDouble());
+            emit accountsUpdated();
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
+        }
+    }));
+}
+
+void BankBridge::getAccount(int accountId) {
+    worker_.postCoalesced("account:" + std::to_string(accountId), timed([this, accountId](Bank& bank) {
+        try {
+            QJsonObject obj;
+            obj["accountId"] = accountId;
+            obj["balance"] = bank.getBalance(accountId).toDouble();
+            emit accountRetrieved(obj);
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
+        }
+    }));
 }
 
-QJsonArray BankBridge::getAllAccounts() {
-    QJsonArray arr;
-    // Note: You may need to add a method to Bank class to iterate all accounts
-    // For now, this is a placeholder
-    return arr;
+void BankBridge::getAllAccounts() {
+    worker_.postCoalesced("allAccounts", timed([this](Bank& bank) {
+        QJsonArray arr;
+        bank.forEachAccount([&arr](const Account& account) {
+            QJsonObject obj;
+            obj["accountId"] = account.getAccountId();
+            obj["owner"] = QString::fromUtf8(account.getPersonName());
+            obj["balance"] = account.balance().toDouble();
+            arr.append(obj);
+        });
+        emit allAccountsListed(arr);
+    }));
 }
 
 void BankBridge::saveData() {
-    try {
-        bank_.save();
-    } catch (const std::exception& e) {
-        emit error(QString::fromStdString(e.what()));
+    if (autosaver_) {
+        autosaver_->saveNow([this](const std::string& message) {
+            if (message.empty())
+                emit saved();
+            else
+                emit error(QString::fromStdString(message));
+        });
+        return;
     }
+    worker_.postCoalesced("save", timed([this](Bank& bank) {
+        try {
+            bank.save();
+            emit saved();
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
+        }
+    }));
 }
 
 void BankBridge::getAccountDetails(int accountId) {
-    try {
-        const auto& account = bank_.getAccount(accountId);
-        QJsonObject details;
-        details["accountId"] = accountId;
-        details["owner"] = QString::fromStdString(account.getPersonName());
-        details["balance"] = account.balance();
-        details["createdTime"] = QString::fromStdString(account.getCreationTime());
-        details["lastOperationType"] = QString::fromStdString(account.getLastOperationType());
-        details["lastOperationTime"] = QString::fromStdString(account.getLastOperationTime());
-        
-        emit detailsRetrieved(details);
-    } catch (const std::exception& e) {
-        emit error("Account not found: " + QString::fromStdString(e.what()));
-        QJsonObject empty;
-        emit detailsRetrieved(empty);
-    }
+    worker_.postCoalesced("accountDetails:" + std::to_string(accountId), timed([this, accountId](Bank& bank) {
+        try {
+            const auto& account = bank.getAccount(accountId);
+            QJsonObject details;
+            details["accountId"] = accountId;
+            details["owner"] = QString::fromUtf8(account.getPersonName());
+            details["balance"] = account.balance().toDouble();
+            details["createdTime"] = QString::fromStdString(account.getCreationTime());
+            details["lastOperationType"] = QString::fromStdString(account.getLastOperationType());
+            details["lastOperationTime"] = QString::fromStdString(account.getLastOperationTime());
+
+            emit detailsRetrieved(details);
+        } catch (const std::exception& e) {
+            emit error("Account not found: " + QString::fromStdString(e.what()));
+            QJsonObject empty;
+            emit detailsRetrieved(empty);
+        }
+    }));
 }
 
-void BankBridge::getPersonAccounts(const QString& personName) {
-    try {
-        QString result;
-        const auto& allAccounts = bank_.getAllAccounts();
-        
-        bool found = false;
-        for (const auto& account : allAccounts) {
-            if (account.getPersonName() == personName.toStdString()) {
-                found = true;
-                result += QString("Account ID: %1\n")
-                    .arg(account.getAccountId());
-                result += QString("  Owner: %1\n")
-                    .arg(QString::fromStdString(account.getPersonName()));
-                result += QString("  Balance: $ %1\n\n")
-                    .arg(account.balance(), 0, 'f', 2);
+void BankBridge::getHistory(int accountId, int limit, double before) {
+    // Coalesce only identical requests: each page has its own caller.
+    std::string key = "history:" + std::to_string(accountId) + ":" + std::to_string(limit) + ":" +
+                      std::to_string(static_cast<std::uint64_t>(std::max(before, 0.0)));
+    worker_.postCoalesced(key, timed([this, accountId, limit, before](Bank& bank) {
+        try {
+            QJsonArray entries;
+            double nextCursor = 0;
+            if (const TransactionHistory* history = bank.history()) {
+                // One extra entry tells whether another page follows.
+                auto page = history->forAccount(accountId, static_cast<std::size_t>(std::max(limit, 1)) + 1,
+                                                static_cast<std::uint64_t>(std::max(before, 0.0)));
+                if (page.size() > static_cast<std::size_t>(std::max(limit, 1))) {
+                    page.pop_back();
+                    nextCursor = static_cast<double>(page.back().sequence);
+                }
+                for (const HistoryEntry& entry : page) {
+                    QJsonObject item;
+                    item["sequence"] = static_cast<double>(entry.sequence);
+                    item["type"] = QString::fromUtf8(toString(entry.type));
+                    item["amount"] = entry.amount.toDouble();
+                    item["time"] = QString::fromStdString(formatTimestamp(entry.time));
+                    entries.append(item);
+                }
             }
+            emit historyRetrieved(accountId, entries, nextCursor);
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
         }
-        
-        if (!found) {
-            result = QString("No accounts found for person: %1").arg(personName);
+    }));
+}
+
+void BankBridge::getPersonAccounts(const QString& personName) {
+    worker_.postCoalesced("personAccounts:" + personName.toStdString(), timed([this, personName](Bank& bank) {
+        try {
+            emit personAccountsRetrieved(
+                QString::fromStdString(describePersonAccounts(bank, personName.toStdString())));
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
         }
-        
-        emit personAccountsRetrieved(result);
-    } catch (const std::exception& e) {
-        emit error(QString::fromStdString(e.what()));
+    }));
+}
+
+void BankBridge::suggestOwners(const QString& prefix, int limit) {
+    if (prefix.isEmpty() || limit <= 0) {
+        emit ownerSuggestionsRetrieved(prefix, QStringList());
+        return;
     }
+    // Only the latest keystroke matters.
+    worker_.postCoalesced("suggestOwners", timed([this, prefix, limit](Bank& bank) {
+        QStringList names;
+        for (int accountId : bank.searchOwners(prefix.toStdString(), static_cast<std::size_t>(limit) * 4)) {
+            QString name = QString::fromUtf8(bank.find(accountId)->getPersonName());
+            if (!names.contains(name))
+                names.append(name);
+            if (names.size() >= limit)
+                break;
+        }
+        emit ownerSuggestionsRetrieved(prefix, names);
+    }));
 }
 
 void BankBridge::getAllAccountDetails() {
-    try {
-        QString result;
-        const auto& allAccounts = bank_.getAllAccounts();
-        
-        if (allAccounts.empty()) {
-            result = "No accounts in system";
-        } else {
-            for (const auto& account : allAccounts) {
-                result += QString("========================\n");
-                result += QString("Account ID: %1\n")
-                    .arg(account.getAccountId());
-                result += QString("Owner: %1\n")
-                    .arg(QString::fromStdString(account.getPersonName()));
-                result += QString("Balance: $ %1\n")
-                    .arg(account.balance(), 0, 'f', 2);
-                result += QString("Created: %1\n")
-                    .arg(QString::fromStdString(account.getCreationTime()));
-                result += QString("Last Operation: %1 (%2)\n\n")
-                    .arg(QString::fromStdString(account.getLastOperationType()),
-                         QString::fromStdString(account.getLastOperationTime()));
+    worker_.postCoalesced("allAccountDetails", timed([this](Bank& bank) {
+        try {
+            emit allAccountsRetrieved(QString::fromStdString(describeAllAccounts(bank)));
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
+        }
+    }));
+}
+
+void BankBridge::getBalanceSummary(double lowBalance, int buckets) {
+    std::string key = "balanceSummary:" + std::to_string(lowBalance) + ":" + std::to_string(buckets);
+    worker_.postCoalesced(key, timed([this, lowBalance, buckets](Bank& bank) {
+        try {
+            balance_stats::Summary summary = bank.balanceSummary();
+            QJsonObject result;
+            result["count"] = static_cast<double>(summary.count);
+            result["total"] = summary.total.toDouble();
+            result["min"] = summary.min.toDouble();
+            result["max"] = summary.max.toDouble();
+            result["average"] = summary.count ? summary.total.toDouble() / static_cast<double>(summary.count) : 0.0;
+            result["lowBalance"] = lowBalance;
+            result["belowLowBalance"] = static_cast<double>(bank.countBalancesBelow(Money(lowBalance)));
+            result["negative"] = static_cast<double>(bank.countBalancesBelow(Money()));
+
+            // Equal-width buckets from the lowest balance to the highest.
+            QJsonArray histogram;
+            if (summary.count > 0 && buckets > 0) {
+                auto low = static_cast<std::uint64_t>(summary.min.minorUnits());
+                std::uint64_t range = static_cast<std::uint64_t>(summary.max.minorUnits()) - low;
+                std::uint64_t width = range / static_cast<std::uint64_t>(buckets) + 1;
+                std::vector<Money> edges;
+                for (int b = 1; b < buckets; ++b) {
+                    std::uint64_t offset = width * static_cast<std::uint64_t>(b);
+                    if (offset > range)
+                        break;
+                    edges.push_back(Money::fromMinorUnits(static_cast<std::int64_t>(low + offset)));
+                }
+                std::vector<std::size_t> counts = bank.balanceHistogram(edges);
+                for (std::size_t b = 0; b < counts.size(); ++b) {
+                    QJsonObject bucket;
+                    bucket["from"] = (b == 0 ? summary.min : edges[b - 1]).toDouble();
+                    bucket["to"] = (b < edges.size() ? edges[b] : summary.max).toDouble();
+                    bucket["count"] = static_cast<double>(counts[b]);
+                    histogram.append(bucket);
+                }
             }
+            result["histogram"] = histogram;
+            emit balanceSummaryRetrieved(result);
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
         }
-        
-        emit allAccountsRetrieved(result);
+    }));
+}
+
+void BankBridge::postInterestAndFees(const QString& schedule) {
+    PostingSchedule parsed;
+    try {
+        parsed = PostingSchedule::parse(schedule.toStdString());
     } catch (const std::exception& e) {
         emit error(QString::fromStdString(e.what()));
+        return;
+    }
+    const std::uint64_t run = ++postingRuns_;
+    worker_.post(timed([this, run, parsed = std::move(parsed)](Bank& bank) {
+        try {
+            auto progress = [this, run](const PostingCheckpoint& at) {
+                emit postingProgress(at.nextAccountId - 1, at.endAccountId - 1);
+                return cancelledRuns_.load() < run;
+            };
+            PostingReport report = bank.applyPostings(parsed, postingCheckpoint_, progress);
+            if (report.complete)
+                postingCheckpoint_ = PostingCheckpoint();
+
+            QJsonObject result;
+            result["complete"] = report.complete;
+            result["posted"] = static_cast<double>(report.posted);
+            result["unchanged"] = static_cast<double>(report.unchanged);
+            result["skipped"] = static_cast<double>(report.skipped);
+            result["failed"] = static_cast<double>(report.failed.size());
+            result["interest"] = report.interest.toDouble();
+            result["fees"] = report.fees.toDouble();
+            result["waived"] = report.waived.toDouble();
+            emit postingFinished(result);
+            emit accountsUpdated();
+        } catch (const std::exception& e) {
+            emit error(QString::fromStdString(e.what()));
+        }
+    }));
+}
+
+void BankBridge::cancelPosting() {
+    // Stops the run in progress and any still queued, not later ones.
+    cancelledRuns_.store(postingRuns_);
+}
+
+void BankBridge::getMetrics() {
+    metrics::Snapshot snapshot = metrics::collect();
+    QJsonObject counters;
+    for (std::size_t c = 0; c < metrics::kCounters; ++c)
+        counters[metrics::name(static_cast<metrics::Counter>(c))] = static_cast<double>(snapshot.counters[c]);
+    QJsonArray timers;
+    for (std::size_t t = 0; t < metrics::kTimers; ++t) {
+        const metrics::TimerSnapshot& timer = snapshot.timers[t];
+        QJsonObject row;
+        row["name"] = metrics::name(static_cast<metrics::Timer>(t));
+        row["count"] = static_cast<double>(timer.count);
+        row["meanUs"] = timer.meanNs() / 1000;
+        row["p50Us"] = timer.percentileNs(0.5) / 1000;
+        row["p99Us"] = timer.percentileNs(0.99) / 1000;
+        row["maxUs"] = timer.maxNs() / 1000;
+        timers.append(row);
+    }
+    QJsonObject result;
+    result["enabled"] = metrics::enabled();
+    result["counters"] = counters;
+    result["timers"] = timers;
+    if (autosaver_) {
+        result["autosaveFailures"] = static_cast<double>(autosaver_->failedWrites());
+        result["autosaveError"] = QString::fromStdString(autosaver_->lastError());
     }
+    emit metricsRetrieved(result);
 }
 
 #include "moc_bank_bridge.cpp"
@@ -0,0 +1,162 @@
+// bank_protocol.cpp
+#include "bank_protocol.h"
+#include <limits>
+
+namespace bank_protocol {
+
+void Writer::putString(std::string_view text) {
+    if (text.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("String too long for the bank protocol");
+    put(static_cast<std::uint32_t>(text.size()));
+    out_.append(text.data(), text.size());
+}
+
+void Writer::beginFrame(std::uint32_t tag, std::uint8_t code) {
+    frameStart_ = out_.size();
+    put(std::uint32_t{0});
+    put(tag);
+    put(code);
+}
+
+void Writer::endFrame() {
+    const std::size_t size = out_.size() - frameStart_ - sizeof(std::uint32_t);
+    if (size > kMaxFrame)
+        throw std::length_error("Message too large for the bank protocol");
+    const auto field = static_cast<std::uint32_t>(size);
+    std::memcpy(&out_[frameStart_], &field, sizeof(field));
+}
+
+const char* Reader::take(std::size_t size) {
+    if (size > body_.size())
+        throw ProtocolError("Truncated bank protocol message");
+    const char* data = body_.data();
+    body_.remove_prefix(size);
+    return data;
+}
+
+std::string_view Reader::getString() {
+    const auto size = get<std::uint32_t>();
+    return {take(size), size};
+}
+
+std::uint32_t Reader::getCount(std::size_t itemSize) {
+    const auto count = get<std::uint32_t>();
+    if (count > body_.size() / itemSize)
+        throw ProtocolError("Bank protocol message count exceeds its size");
+    return count;
+}
+
+bool nextFrame(std::string_view buffer, Frame& frame) {
+    std::uint32_t size;
+    if (buffer.size() < sizeof(size))
+        return false;
+    std::memcpy(&size, buffer.data(), sizeof(size));
+    if (size < kHeaderSize - sizeof(size) || size > kMaxFrame)
+        throw ProtocolError("Bad bank protocol frame size " + std::to_string(size));
+    if (buffer.size() - sizeof(size) < size)
+        return false;
+    std::memcpy(&frame.tag, buffer.data() + sizeof(size), sizeof(frame.tag));
+    frame.code = static_cast<std::uint8_t>(buffer[8]);
+    frame.size = sizeof(size) + size;
+    frame.body = buffer.substr(kHeaderSize, frame.size - kHeaderSize);
+    return true;
+}
+
+void putAccount(Writer& out, const Account& account) {
+    out.put(static_cast<std::int32_t>(account.getAccountId()));
+    out.putMoney(account.balance());
+    out.putString(account.getPersonName());
+    out.putString(account.getCardId());
+    out.putTime(account.creationTime());
+    out.put(static_cast<std::uint8_t>(account.lastOperationType()));
+    out.putTime(account.lastOperationTime());
+}
+
+Account getAccount(Reader& in) {
+    const auto accountId = in.get<std::int32_t>();
+    const Money balance = in.getMoney();
+    const std::string_view personName = in.getString();
+    const std::string_view cardId = in.getString();
+    const Timestamp creationTime = in.getTime();
+    const auto type = in.get<std::uint8_t>();
+    if (type > static_cast<std::uint8_t>(OperationType::Posting))
+        throw ProtocolError("Bad operation type in bank protocol message");
+    const Timestamp lastOperationTime = in.getTime();
+    return Account(accountId, balance, personName, cardId, creationTime, static_cast<OperationType>(type),
+                   lastOperationTime);
+}
+
+void putBatchReport(Writer& out, const BatchReport& report) {
+    out.put(static_cast<std::uint64_t>(report.applied));
+    out.put(static_cast<std::uint32_t>(report.failures.size()));
+    for (const BatchFailure& failure : report.failures) {
+        out.put(static_cast<std::uint64_t>(failure.line));
+        out.putString(failure.message);
+    }
+}
+
+BatchReport getBatchReport(Reader& in) {
+    BatchReport report;
+    report.applied = static_cast<std::size_t>(in.get<std::uint64_t>());
+    const std::uint32_t failures = in.getCount(sizeof(std::uint64_t) + sizeof(std::uint32_t));
+    report.failures.reserve(failures);
+    for (std::uint32_t i = 0; i < failures; ++i) {
+        const auto line = static_cast<std::size_t>(in.get<std::uint64_t>());
+        report.failures.push_back({line, std::string(in.getString())});
+    }
+    return report;
+}
+
+void putSchedule(Writer& out, const PostingSchedule& schedule) {
+    out.put(static_cast<std::uint32_t>(schedule.rules.size()));
+    for (const PostingRule& rule : schedule.rules) {
+        out.putMoney(rule.minBalance);
+        out.putMoney(rule.maxBalance);
+        out.put(rule.ratePpm);
+        out.putMoney(rule.fee);
+    }
+}
+
+PostingSchedule getSchedule(Reader& in) {
+    PostingSchedule schedule;
+    const std::uint32_t rules = in.getCount(4 * sizeof(std::int64_t));
+    schedule.rules.resize(rules);
+    for (PostingRule& rule : schedule.rules) {
+        rule.minBalance = in.getMoney();
+        rule.maxBalance = in.getMoney();
+        rule.ratePpm = in.get<std::int64_t>();
+        rule.fee = in.getMoney();
+    }
+    return schedule;
+}
+
+void putPostingReport(Writer& out, const PostingReport& report) {
+    out.put(static_cast<std::uint64_t>(report.posted));
+    out.put(static_cast<std::uint64_t>(report.unchanged));
+    out.put(static_cast<std::uint64_t>(report.skipped));
+    out.putMoney(report.interest);
+    out.putMoney(report.fees);
+    out.putMoney(report.waived);
+    out.put(static_cast<std::uint8_t>(report.complete));
+    out.put(static_cast<std::uint32_t>(report.failed.size()));
+    for (int accountId : report.failed)
+        out.put(static_cast<std::int32_t>(accountId));
+}
+
+PostingReport getPostingReport(Reader& in) {
+    PostingReport report;
+    report.posted = static_cast<std::size_t>(in.get<std::uint64_t>());
+    report.unchanged = static_cast<std::size_t>(in.get<std::uint64_t>());
+    report.skipped = static_cast<std::size_t>(in.get<std::uint64_t>());
+    report.interest = in.getMoney();
+    report.fees = in.getMoney();
+    report.waived = in.getMoney();
+    report.complete = in.get<std::uint8_t>() != 0;
+    const std::uint32_t failed = in.getCount(sizeof(std::int32_t));
+    report.failed.reserve(failed);
+    for (std::uint32_t i = 0; i < failed; ++i)
+        report.failed.push_back(in.get<std::int32_t>());
+    return report;
+}
+
+} // namespace bank_protocol
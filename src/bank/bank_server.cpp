@@ -0,0 +1,347 @@
+// bank_server.cpp
+#include "bank_server.h"
+#include "bank_protocol.h"
+#include "metrics.h"
+#include "unix_socket.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace bank_protocol;
+
+namespace {
+
+constexpr std::size_t kReadSize = 64 * 1024;
+constexpr int kMaxEvents = 64;
+
+void replyError(Writer& out, std::uint32_t tag, Status status, const char* message) {
+    out.beginFrame(tag, static_cast<std::uint8_t>(status));
+    out.putString(message);
+    out.endFrame();
+}
+
+} // namespace
+
+struct BankServer::Connection {
+    int fd;
+    std::string in;        // unparsed request bytes
+    std::string out;       // replies not yet written
+    std::size_t sent = 0;  // of `out`
+    std::uint32_t events = 0;
+    bool served = false;      // in this round, replies not yet written
+    bool peerClosed = false;  // close once the replies are written
+};
+
+BankServer::BankServer(IBank& bank, BankServerOptions options) : bank_(bank), options_(std::move(options)) {
+    listenFd_ = listenOnUnixSocket(options_.socketPath, 128, SOCK_NONBLOCK);
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    epoll_event listenEvent{EPOLLIN, {}};
+    listenEvent.data.fd = listenFd_;
+    epoll_event wakeEvent{EPOLLIN, {}};
+    wakeEvent.data.fd = wakeFd_;
+    if (epollFd_ < 0 || wakeFd_ < 0 || ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &listenEvent) != 0 ||
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &wakeEvent) != 0) {
+        int error = errno;
+        for (int fd : {listenFd_, epollFd_, wakeFd_})
+            if (fd >= 0)
+                ::close(fd);
+        ::unlink(options_.socketPath.c_str());
+        throw std::runtime_error("Cannot set up the bank server: " + std::string(std::strerror(error)));
+    }
+    thread_ = std::thread(&BankServer::run, this);
+}
+
+BankServer::~BankServer() {
+    std::uint64_t one = 1;
+    (void)::write(wakeFd_, &one, sizeof(one));
+    thread_.join();
+    while (!connections_.empty())
+        close(connections_.begin()->first);
+    ::close(listenFd_);
+    ::unlink(options_.socketPath.c_str());
+    ::close(epollFd_);
+    ::close(wakeFd_);
+}
+
+void BankServer::run() {
+    epoll_event events[kMaxEvents];
+    std::vector<int> served;
+    for (;;) {
+        int ready = ::epoll_wait(epollFd_, events, kMaxEvents, -1);
+        if (ready < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "Bank server stopped: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        for (int i = 0; i < ready; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == wakeFd_)
+                return;
+            if (fd == listenFd_) {
+                accept();
+                continue;
+            }
+            auto found = connections_.find(fd);
+            if (found == connections_.end())
+                continue;  // closed earlier in this round
+            Connection& connection = *found->second;
+            if ((events[i].events & EPOLLOUT) && !flush(connection))
+                continue;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                serve(connection);
+                served.push_back(fd);
+            }
+        }
+        answer(served);
+        served.clear();
+    }
+}
+
+void BankServer::accept() {
+    for (;;) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;  // EAGAIN once the backlog is drained
+        if (connections_.size() >= options_.maxConnections) {
+            ::close(fd);
+            continue;
+        }
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        Connection& added = *connections_.emplace(fd, std::move(connection)).first->second;
+        watch(added);
+    }
+}
+
+void BankServer::serve(Connection& connection) {
+    // Drain what has arrived, up to the point where the replies to it would
+    // exceed the backlog a client is allowed.
+    connection.served = true;
+    while (connection.out.size() - connection.sent < options_.maxPendingReplies) {
+        const std::size_t used = connection.in.size();
+        connection.in.resize(used + kReadSize);
+        ssize_t n = ::recv(connection.fd, &connection.in[used], kReadSize, 0);
+        connection.in.resize(used + (n > 0 ? static_cast<std::size_t>(n) : 0));
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            connection.peerClosed = true;
+            break;
+        }
+        if (n < 0)
+            break;
+
+        std::size_t consumed = 0;
+        try {
+            Frame frame;
+            while (nextFrame(std::string_view(connection.in).substr(consumed), frame)) {
+                handle(frame.tag, frame.code, frame.body, connection.out);
+                consumed += frame.size;
+            }
+        } catch (const ProtocolError&) {
+            // The stream cannot be resynchronized after a bad frame size.
+            close(connection.fd);
+            return;
+        }
+        connection.in.erase(0, consumed);
+        if (static_cast<std::size_t>(n) < kReadSize)
+            break;
+    }
+}
+
+void BankServer::answer(const std::vector<int>& served) {
+    if (served.empty())
+        return;
+    bool durable = true;
+    if (options_.journal) {
+        try {
+            options_.journal->flush();
+        } catch (const std::exception& ex) {
+            // Better no answer than an acknowledgement of a change that may
+            // be lost; the clients see their connections drop.
+            std::cerr << "Bank server: " << ex.what() << std::endl;
+            durable = false;
+        }
+    }
+    for (int fd : served) {
+        auto found = connections_.find(fd);
+        // Gone since, or its fd reused by a connection accepted later on.
+        if (found == connections_.end() || !found->second->served)
+            continue;
+        Connection& connection = *found->second;
+        connection.served = false;
+        // One write for every reply produced in this round.
+        if (!durable || (flush(connection) && connection.peerClosed))
+            close(fd);
+    }
+}
+
+void BankServer::handle(std::uint32_t tag, std::uint8_t code, std::string_view body, std::string& out) {
+    BANK_METRIC_COUNT(ServerRequests);
+    BANK_METRIC_TIME_SAMPLED(ServerRequest);
+    Writer reply(out);
+    const std::size_t start = out.size();
+    try {
+        Reader in(body);
+        reply.beginFrame(tag, static_cast<std::uint8_t>(Status::Ok));
+        // Every case decodes its whole request before calling the bank, so a
+        // malformed one changes nothing.
+        switch (static_cast<Op>(code)) {
+        case Op::CreateAccount: {
+            std::string personName(in.getString());
+            std::string cardId(in.getString());
+            Money initialBalance = in.getMoney();
+            in.finish();
+            reply.put(static_cast<std::int32_t>(bank_.createAccount(personName, cardId, initialBalance)));
+            break;
+        }
+        case Op::DeleteAccount: {
+            int accountId = in.get<std::int32_t>();
+            in.finish();
+            reply.put(static_cast<std::uint8_t>(bank_.deleteAccount(accountId)));
+            break;
+        }
+        case Op::Deposit:
+        case Op::Withdraw: {
+            int accountId = in.get<std::int32_t>();
+            Money amount = in.getMoney();
+            in.finish();
+            if (static_cast<Op>(code) == Op::Deposit)
+                bank_.deposit(accountId, amount);
+            else
+                bank_.withdraw(accountId, amount);
+            break;
+        }
+        case Op::GetAccount: {
+            int accountId = in.get<std::int32_t>();
+            in.finish();
+            putAccount(reply, bank_.getAccount(accountId));
+            break;
+        }
+        case Op::GetBalance: {
+            int accountId = in.get<std::int32_t>();
+            in.finish();
+            reply.putMoney(bank_.getBalance(accountId));
+            break;
+        }
+        case Op::Transfer: {
+            int fromAccountId = in.get<std::int32_t>();
+            int toAccountId = in.get<std::int32_t>();
+            Money amount = in.getMoney();
+            in.finish();
+            bank_.transfer(fromAccountId, toAccountId, amount);
+            break;
+        }
+        case Op::TransferMany: {
+            std::vector<Transfer> transfers(in.getCount(2 * sizeof(std::int32_t) + sizeof(std::int64_t)));
+            for (Transfer& transfer : transfers) {
+                transfer.fromAccountId = in.get<std::int32_t>();
+                transfer.toAccountId = in.get<std::int32_t>();
+                transfer.amount = in.getMoney();
+            }
+            in.finish();
+            bank_.transferMany(transfers);
+            break;
+        }
+        case Op::ApplyBatch: {
+            std::vector<BatchOperation> operations(
+                in.getCount(sizeof(std::uint64_t) + sizeof(std::uint8_t) + sizeof(std::int32_t) + sizeof(std::int64_t)));
+            for (BatchOperation& op : operations) {
+                op.line = static_cast<std::size_t>(in.get<std::uint64_t>());
+                const auto type = in.get<std::uint8_t>();
+                if (type > static_cast<std::uint8_t>(BatchOpType::Withdraw))
+                    throw ProtocolError("Bad batch operation type in bank protocol request");
+                op.type = static_cast<BatchOpType>(type);
+                op.accountId = in.get<std::int32_t>();
+                op.amount = in.getMoney();
+            }
+            in.finish();
+            putBatchReport(reply, bank_.applyBatch(operations));
+            break;
+        }
+        case Op::PostChunk: {
+            // One chunk per request, so a long run neither stalls the other
+            // clients nor costs the client its progress callback.
+            PostingSchedule schedule = getSchedule(in);
+            PostingCheckpoint checkpoint;
+            checkpoint.nextAccountId = in.get<std::int32_t>();
+            checkpoint.endAccountId = in.get<std::int32_t>();
+            in.finish();
+            PostingReport report = bank_.applyPostings(schedule, checkpoint, [](const PostingCheckpoint&) {
+                return false;
+            });
+            reply.put(static_cast<std::int32_t>(checkpoint.nextAccountId));
+            reply.put(static_cast<std::int32_t>(checkpoint.endAccountId));
+            putPostingReport(reply, report);
+            break;
+        }
+        default:
+            throw ProtocolError("Unknown bank protocol operation " + std::to_string(code));
+        }
+        reply.endFrame();
+        return;
+    } catch (const ProtocolError& e) {
+        out.resize(start);
+        replyError(reply, tag, Status::BadRequest, e.what());
+    } catch (const std::invalid_argument& e) {
+        out.resize(start);
+        replyError(reply, tag, Status::InvalidArgument, e.what());
+    } catch (const std::overflow_error& e) {
+        out.resize(start);
+        replyError(reply, tag, Status::Overflow, e.what());
+    } catch (const std::exception& e) {
+        out.resize(start);
+        replyError(reply, tag, Status::Failed, e.what());
+    }
+    BANK_METRIC_COUNT(ServerErrors);
+}
+
+bool BankServer::flush(Connection& connection) {
+    while (connection.sent < connection.out.size()) {
+        ssize_t n = ::send(connection.fd, connection.out.data() + connection.sent,
+                           connection.out.size() - connection.sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            close(connection.fd);
+            return false;
+        }
+        connection.sent += static_cast<std::size_t>(n);
+    }
+    if (connection.sent == connection.out.size()) {
+        connection.out.clear();
+        connection.sent = 0;
+    }
+    watch(connection);
+    return true;
+}
+
+// Wants output readiness only while replies are queued, and input only
+// while the client is within its backlog.
+void BankServer::watch(Connection& connection) {
+    const std::size_t pending = connection.out.size() - connection.sent;
+    std::uint32_t events = 0;
+    if (pending < options_.maxPendingReplies)
+        events |= EPOLLIN;
+    if (pending > 0)
+        events |= EPOLLOUT;
+    if (events == connection.events)
+        return;
+    epoll_event event{events, {}};
+    event.data.fd = connection.fd;
+    ::epoll_ctl(epollFd_, connection.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, connection.fd, &event);
+    connection.events = events;
+}
+
+void BankServer::close(int fd) {
+    ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections_.erase(fd);
+}
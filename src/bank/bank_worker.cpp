@@ -0,0 +1,81 @@
+// bank_worker.cpp
+#include "bank_worker.h"
+
+BankWorker::BankWorker(Bank& bank) : bank_(bank), thread_(&BankWorker::run, this) {}
+
+BankWorker::~BankWorker() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void BankWorker::post(Job job) {
+    {
+        std::lock_guard lock(mutex_);
+        queue_.push_back(std::make_unique<Entry>(Entry{std::string(), std::move(job)}));
+    }
+    wake_.notify_one();
+}
+
+bool BankWorker::postCoalesced(const std::string& key, Job job) {
+    {
+        std::lock_guard lock(mutex_);
+        auto it = pending_.find(key);
+        if (it != pending_.end()) {
+            it->second->job = std::move(job);
+            return false;
+        }
+        queue_.push_back(std::make_unique<Entry>(Entry{key, std::move(job)}));
+        pending_.emplace(key, queue_.back().get());
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void BankWorker::waitIdle() {
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+void BankWorker::setErrorHandler(ErrorHandler handler) {
+    std::lock_guard lock(mutex_);
+    errorHandler_ = std::move(handler);
+}
+
+void BankWorker::report(std::unique_lock<std::mutex>& lock, const std::string& error) {
+    lock.lock();
+    ErrorHandler handler = errorHandler_;
+    lock.unlock();
+    if (handler)
+        handler(error);
+}
+
+void BankWorker::run() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty())
+            return;  // stopping, and everything posted has run
+
+        std::unique_ptr<Entry> entry = std::move(queue_.front());
+        queue_.pop_front();
+        if (!entry->key.empty())
+            pending_.erase(entry->key);
+        busy_ = true;
+        lock.unlock();
+        try {
+            entry->job(bank_);
+        } catch (const std::exception& ex) {
+            report(lock, ex.what());
+        } catch (...) {
+            report(lock, "Unknown error");
+        }
+        lock.lock();
+        busy_ = false;
+        if (queue_.empty())
+            idle_.notify_all();
+    }
+}
@@ -0,0 +1,214 @@
+// batch.cpp
+#include "batch.h"
+#include <nlohmann/json.hpp>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+
+namespace {
+
+std::string trim(const std::string& text, std::size_t begin, std::size_t end) {
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin])))
+        ++begin;
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1])))
+        --end;
+    return text.substr(begin, end - begin);
+}
+
+std::string lower(std::string text) {
+    for (char& c : text)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+bool parseOpType(const std::string& name, BatchOpType& type) {
+    std::string op = lower(name);
+    if (op == "deposit") {
+        type = BatchOpType::Deposit;
+        return true;
+    }
+    if (op == "withdraw" || op == "withdrawal") {
+        type = BatchOpType::Withdraw;
+        return true;
+    }
+    return false;
+}
+
+bool parseInt(const std::string& text, int& value) {
+    if (text.empty())
+        return false;
+    errno = 0;
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || parsed < INT32_MIN || parsed > INT32_MAX)
+        return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool parseCsv(const std::string& text, BatchOperation& op, std::string& error) {
+    std::size_t first = text.find(',');
+    std::size_t second = first == std::string::npos ? std::string::npos : text.find(',', first + 1);
+    if (second == std::string::npos || text.find(',', second + 1) != std::string::npos) {
+        error = "Expected op,accountId,amount";
+        return false;
+    }
+
+    std::string name = trim(text, 0, first);
+    if (lower(name) == "op" || lower(name) == "type")
+        return false;  // header row
+    if (!parseOpType(name, op.type)) {
+        error = "Unknown operation: " + name;
+        return false;
+    }
+    if (!parseInt(trim(text, first + 1, second), op.accountId)) {
+        error = "Invalid account ID";
+        return false;
+    }
+    if (!Money::parse(trim(text, second + 1, text.size()), op.amount)) {
+        error = "Invalid amount";
+        return false;
+    }
+    return true;
+}
+
+// The top-level fields of one JSON Lines operation, numbers as written, so
+// that IDs are range-checked and amounts parsed exactly as in CSV. A field
+// holding a value of the wrong kind is kept as "", which fails to parse.
+class OperationFields : public nlohmann::json_sax<nlohmann::json> {
+public:
+    bool object = false;
+    std::optional<std::string> op;
+    std::optional<std::string> type;
+    std::optional<std::string> accountId;
+    std::optional<std::string> amount;
+
+    bool null() override { return value(Kind::Other, {}); }
+    bool boolean(bool) override { return value(Kind::Other, {}); }
+    bool number_integer(number_integer_t number) override { return value(Kind::Integer, std::to_string(number)); }
+    bool number_unsigned(number_unsigned_t number) override { return value(Kind::Integer, std::to_string(number)); }
+    bool number_float(number_float_t, const string_t& text) override { return value(Kind::Number, text); }
+    bool string(string_t& text) override { return value(Kind::String, std::move(text)); }
+    bool binary(binary_t&) override { return value(Kind::Other, {}); }
+
+    bool start_object(std::size_t) override {
+        if (depth_ == 0)
+            object = true;
+        else
+            value(Kind::Other, {});
+        ++depth_;
+        return true;
+    }
+    bool key(string_t& name) override {
+        if (depth_ == 1)
+            key_ = std::move(name);
+        return true;
+    }
+    bool end_object() override {
+        --depth_;
+        return true;
+    }
+    bool start_array(std::size_t) override {
+        value(Kind::Other, {});
+        ++depth_;
+        return true;
+    }
+    bool end_array() override {
+        --depth_;
+        return true;
+    }
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override { return false; }
+
+private:
+    enum class Kind { Integer, Number, String, Other };
+
+    bool value(Kind kind, std::string text) {
+        if (depth_ != 1)
+            return true;
+        if (key_ == "op" || key_ == "type")
+            (key_ == "op" ? op : type) = kind == Kind::String ? std::move(text) : std::string();
+        else if (key_ == "accountId")
+            accountId = kind == Kind::Integer ? std::move(text) : std::string();
+        else if (key_ == "amount")
+            amount = kind == Kind::Integer || kind == Kind::Number ? std::move(text) : std::string();
+        key_.clear();
+        return true;
+    }
+
+    int depth_ = 0;
+    std::string key_;
+};
+
+bool parseJson(const std::string& text, BatchOperation& op, std::string& error) {
+    OperationFields fields;
+    if (!nlohmann::json::sax_parse(text, &fields) || !fields.object) {
+        error = "Invalid JSON";
+        return false;
+    }
+
+    const std::optional<std::string>& name = fields.op ? fields.op : fields.type;
+    if (!name || !parseOpType(*name, op.type)) {
+        error = "Missing or unknown operation";
+        return false;
+    }
+    if (!fields.accountId || !parseInt(*fields.accountId, op.accountId)) {
+        error = "Invalid account ID";
+        return false;
+    }
+    if (!fields.amount || !Money::parse(*fields.amount, op.amount)) {
+        error = "Invalid amount";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void BatchReport::merge(BatchReport&& other) {
+    applied += other.applied;
+    failures.insert(failures.end(), std::make_move_iterator(other.failures.begin()),
+                    std::make_move_iterator(other.failures.end()));
+}
+
+void BatchReport::sortFailuresByLine() {
+    std::sort(failures.begin(), failures.end(),
+              [](const BatchFailure& a, const BatchFailure& b) { return a.line < b.line; });
+}
+
+BatchReader::BatchReader(const std::string& filename)
+    : file_(std::make_unique<std::ifstream>(filename)), jsonLines_(endsWith(filename, ".jsonl")) {
+    if (!file_->is_open())
+        throw std::runtime_error("Error opening batch file: " + filename);
+}
+
+BatchReader::~BatchReader() = default;
+
+bool BatchReader::next(std::vector<BatchOperation>& operations, std::vector<BatchFailure>& failures,
+                       std::size_t maxOperations) {
+    operations.clear();
+    std::string text;
+    bool readAny = false;
+    while (operations.size() < maxOperations && std::getline(*file_, text)) {
+        ++line_;
+        readAny = true;
+        std::string trimmed = trim(text, 0, text.size());
+        if (trimmed.empty() || trimmed[0] == '#')
+            continue;
+
+        BatchOperation op{line_, BatchOpType::Deposit, 0, Money()};
+        std::string error;
+        bool ok = jsonLines_ ? parseJson(trimmed, op, error) : parseCsv(trimmed, op, error);
+        if (ok)
+            operations.push_back(op);
+        else if (!error.empty())
+            failures.push_back({line_, error});
+    }
+    return readAny;
+}
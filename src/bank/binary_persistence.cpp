@@ -0,0 +1,281 @@
+// binary_persistence.cpp
+#include "binary_persistence.h"
+#include "atomic_file.h"
+#include "checksum.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[4] = {'B', 'N', 'K', 'S'};
+constexpr std::uint32_t kVersion = 1;
+
+struct FileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t count;
+    std::uint64_t recordsOffset;
+    std::uint64_t poolOffset;
+    std::uint64_t poolSize;
+    std::int32_t maxAccountId;
+    std::uint32_t reserved;
+    std::uint64_t sourceChecksum;
+    std::uint64_t bodyChecksum;  // records then pool
+};
+static_assert(sizeof(FileHeader) == 64, "snapshot header layout changed");
+
+struct StringRef {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+enum StringField { PersonName, CardId, StringFieldCount };
+
+} // namespace
+
+struct BinarySnapshotView::Record {
+    std::int32_t accountId;
+    std::uint8_t lastOperationType;
+    std::uint8_t reserved[3];
+    std::int64_t balance;            // minor currency units
+    std::int64_t creationTime;       // microseconds since the epoch
+    std::int64_t lastOperationTime;  // microseconds since the epoch
+    StringRef strings[StringFieldCount];
+};
+
+BinarySnapshotView::BinarySnapshotView(const std::string& filename) {
+    static_assert(sizeof(Record) == 48, "snapshot record layout changed");
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("Error opening snapshot: " + filename + ": " + std::strerror(errno));
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Truncated snapshot: " + filename);
+    }
+    mappedSize_ = static_cast<std::size_t>(st.st_size);
+    void* mapped = ::mmap(nullptr, mappedSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        throw std::runtime_error("Error mapping snapshot: " + filename + ": " + std::strerror(errno));
+    data_ = static_cast<const char*>(mapped);
+
+    const auto* header = reinterpret_cast<const FileHeader*>(data_);
+    bool valid = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 && header->version == kVersion &&
+                 header->recordsOffset % alignof(Record) == 0 && header->recordsOffset <= mappedSize_ &&
+                 header->count <= (mappedSize_ - header->recordsOffset) / sizeof(Record) &&
+                 header->poolOffset <= mappedSize_ && header->poolSize <= mappedSize_ - header->poolOffset;
+    if (!valid) {
+        ::munmap(mapped, mappedSize_);
+        data_ = nullptr;
+        throw std::runtime_error("Invalid snapshot: " + filename);
+    }
+    count_ = static_cast<std::size_t>(header->count);
+    records_ = reinterpret_cast<const Record*>(data_ + header->recordsOffset);
+    pool_ = data_ + header->poolOffset;
+    poolSize_ = static_cast<std::size_t>(header->poolSize);
+}
+
+BinarySnapshotView::~BinarySnapshotView() {
+    if (data_)
+        ::munmap(const_cast<char*>(data_), mappedSize_);
+}
+
+BinarySnapshotView::BinarySnapshotView(BinarySnapshotView&& other) noexcept {
+    *this = std::move(other);
+}
+
+BinarySnapshotView& BinarySnapshotView::operator=(BinarySnapshotView&& other) noexcept {
+    if (this != &other) {
+        if (data_)
+            ::munmap(const_cast<char*>(data_), mappedSize_);
+        data_ = std::exchange(other.data_, nullptr);
+        mappedSize_ = std::exchange(other.mappedSize_, 0);
+        count_ = std::exchange(other.count_, 0);
+        records_ = std::exchange(other.records_, nullptr);
+        pool_ = std::exchange(other.pool_, nullptr);
+        poolSize_ = std::exchange(other.poolSize_, 0);
+    }
+    return *this;
+}
+
+int BinarySnapshotView::maxAccountId() const noexcept {
+    return data_ ? reinterpret_cast<const FileHeader*>(data_)->maxAccountId : 0;
+}
+
+std::uint64_t BinarySnapshotView::sourceChecksum() const noexcept {
+    return data_ ? reinterpret_cast<const FileHeader*>(data_)->sourceChecksum : 0;
+}
+
+bool BinarySnapshotView::verify() const noexcept {
+    if (!data_)
+        return false;
+    const auto* header = reinterpret_cast<const FileHeader*>(data_);
+    const std::string_view records(reinterpret_cast<const char*>(records_), count_ * sizeof(Record));
+    Checksum64 sum(records.size() + poolSize_);
+    sum.update(records);
+    sum.update(std::string_view(pool_, poolSize_));
+    return sum.finish() == header->bodyChecksum;
+}
+
+std::size_t BinarySnapshotView::find(int accountId) const noexcept {
+    const std::size_t index = lowerBound(accountId);
+    if (index == count_ || records_[index].accountId != accountId)
+        return npos;
+    return index;
+}
+
+std::size_t BinarySnapshotView::lowerBound(int accountId) const noexcept {
+    const Record* it = std::lower_bound(records_, records_ + count_, accountId,
+                                        [](const Record& r, int id) { return r.accountId < id; });
+    return static_cast<std::size_t>(it - records_);
+}
+
+int BinarySnapshotView::accountId(std::size_t index) const {
+    return record(index).accountId;
+}
+
+Money BinarySnapshotView::balance(std::size_t index) const {
+    return Money::fromMinorUnits(record(index).balance);
+}
+
+std::string_view BinarySnapshotView::personName(std::size_t index) const {
+    const StringRef& ref = record(index).strings[PersonName];
+    return poolString(ref.offset, ref.length);
+}
+
+std::string_view BinarySnapshotView::cardId(std::size_t index) const {
+    const StringRef& ref = record(index).strings[CardId];
+    return poolString(ref.offset, ref.length);
+}
+
+Timestamp BinarySnapshotView::creationTime(std::size_t index) const {
+    return Timestamp(std::chrono::microseconds(record(index).creationTime));
+}
+
+OperationType BinarySnapshotView::lastOperationType(std::size_t index) const {
+    std::uint8_t raw = record(index).lastOperationType;
+    return raw <= static_cast<std::uint8_t>(OperationType::Posting) ? static_cast<OperationType>(raw)
+                                                                    : OperationType::None;
+}
+
+Timestamp BinarySnapshotView::lastOperationTime(std::size_t index) const {
+    return Timestamp(std::chrono::microseconds(record(index).lastOperationTime));
+}
+
+Account BinarySnapshotView::materialize(std::size_t index) const {
+    return Account(accountId(index), balance(index), std::string(personName(index)), std::string(cardId(index)),
+                   creationTime(index), lastOperationType(index), lastOperationTime(index));
+}
+
+std::unordered_map<int, Account> BinarySnapshotView::materializeAll() const {
+    std::unordered_map<int, Account> accounts;
+    if (data_)
+        ::madvise(const_cast<char*>(data_), mappedSize_, MADV_SEQUENTIAL);
+    accounts.reserve(count_);
+    for (std::size_t i = 0; i < count_; ++i)
+        accounts.try_emplace(accountId(i), materialize(i));
+    return accounts;
+}
+
+const BinarySnapshotView::Record& BinarySnapshotView::record(std::size_t index) const {
+    if (index >= count_)
+        throw std::out_of_range("Snapshot record index out of range");
+    return records_[index];
+}
+
+std::string_view BinarySnapshotView::poolString(std::uint32_t offset, std::uint32_t length) const {
+    if (offset > poolSize_ || length > poolSize_ - offset)
+        throw std::runtime_error("Corrupt snapshot string reference");
+    return std::string_view(pool_ + offset, length);
+}
+
+BinaryPersistence::BinaryPersistence(const std::string& filename) : filename_(filename) {}
+
+void BinaryPersistence::save(const std::unordered_map<int, Account>& accounts) {
+    save(accounts, 0);
+}
+
+void BinaryPersistence::save(const std::unordered_map<int, Account>& accounts, std::uint64_t sourceChecksum) {
+    std::vector<const Account*> sorted;
+    sorted.reserve(accounts.size());
+    for (const auto& pair : accounts)
+        sorted.push_back(&pair.second);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Account* a, const Account* b) { return a->getAccountId() < b->getAccountId(); });
+
+    std::string pool;
+    auto appendString = [&pool](std::string_view value) {
+        StringRef ref{static_cast<std::uint32_t>(pool.size()), static_cast<std::uint32_t>(value.size())};
+        pool += value;
+        return ref;
+    };
+
+    std::vector<BinarySnapshotView::Record> records;
+    records.reserve(sorted.size());
+    for (const Account* account : sorted) {
+        BinarySnapshotView::Record record{};
+        record.accountId = account->getAccountId();
+        record.balance = account->balance().minorUnits();
+        record.strings[PersonName] = appendString(account->getPersonName());
+        record.strings[CardId] = appendString(account->getCardId());
+        record.lastOperationType = static_cast<std::uint8_t>(account->lastOperationType());
+        record.creationTime = account->creationTime().time_since_epoch().count();
+        record.lastOperationTime = account->lastOperationTime().time_since_epoch().count();
+        records.push_back(record);
+    }
+    if (pool.size() > UINT32_MAX)
+        throw std::runtime_error("Snapshot string pool exceeds 4 GiB");
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.count = records.size();
+    header.recordsOffset = sizeof(FileHeader);
+    header.poolOffset = header.recordsOffset + records.size() * sizeof(BinarySnapshotView::Record);
+    header.poolSize = pool.size();
+    header.maxAccountId = sorted.empty() ? 0 : sorted.back()->getAccountId();
+    header.sourceChecksum = sourceChecksum;
+    const std::string_view body(reinterpret_cast<const char*>(records.data()),
+                                records.size() * sizeof(BinarySnapshotView::Record));
+    Checksum64 sum(body.size() + pool.size());
+    sum.update(body);
+    sum.update(pool);
+    header.bodyChecksum = sum.finish();
+
+    replaceFileAtomically(filename_, {
+        std::string_view(reinterpret_cast<const char*>(&header), sizeof(header)),
+        body,
+        pool,
+    });
+}
+
+std::unordered_map<int, Account> BinaryPersistence::load() {
+    std::unordered_map<int, Account> accounts;
+    if (::access(filename_.c_str(), F_OK) != 0) {
+        // File doesn't exist, return empty
+        return accounts;
+    }
+
+    return BinarySnapshotView(filename_).materializeAll();
+}
+
+std::unique_ptr<AccountSource> BinaryPersistence::openSource() {
+    if (::access(filename_.c_str(), F_OK) != 0)
+        return nullptr;
+    return std::make_unique<BinarySnapshotView>(filename_);
+}
+
+void convertSnapshot(IPersistence& from, IPersistence& to) {
+    to.save(from.load());
+}
@@ -0,0 +1,277 @@
+// concurrent_bank.cpp
+#include "concurrent_bank.h"
+#include "transfer_plan.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::size_t roundUpToPowerOfTwo(std::size_t value) {
+    std::size_t result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+} // namespace
+
+ConcurrentBank::ConcurrentBank(IPersistence& persistence, std::size_t shardCount)
+    : persistence_(persistence) {
+    if (shardCount == 0)
+        shardCount = std::max(1u, std::thread::hardware_concurrency()) * 4;
+    shardCount = roundUpToPowerOfTwo(shardCount);
+    shards_ = std::make_unique<Shard[]>(shardCount);
+    shardMask_ = shardCount - 1;
+
+    int maxId = 0;
+    for (auto& pair : persistence_.load()) {
+        maxId = std::max(maxId, pair.first);
+        shardFor(pair.first).accounts.emplace(pair.first, std::move(pair.second));
+    }
+    nextAccountId_.store(maxId + 1, std::memory_order_relaxed);
+}
+
+int ConcurrentBank::createAccount(const std::string& personName, const std::string& cardId, Money initialBalance) {
+    int accountId = nextAccountId_.fetch_add(1, std::memory_order_relaxed);
+    {
+        Shard& shard = shardFor(accountId);
+        std::unique_lock lock(shard.mutex);
+        auto result = shard.accounts.emplace(accountId, Account{accountId, initialBalance, personName, cardId});
+        if (!result.second)
+            throw std::runtime_error("Failed to create account");
+        try {
+            persistence_.recordCreate(result.first->second);
+        } catch (...) {
+            shard.accounts.erase(result.first);
+            throw;
+        }
+    }
+    compactIfNeeded();
+    return accountId;
+}
+
+bool ConcurrentBank::deleteAccount(int accountId) {
+    {
+        Shard& shard = shardFor(accountId);
+        std::unique_lock lock(shard.mutex);
+        auto it = shard.accounts.find(accountId);
+        if (it == shard.accounts.end())
+            return false;
+        // The record goes first: if it cannot be written the account stays.
+        persistence_.recordDelete(accountId);
+        shard.accounts.erase(it);
+    }
+    compactIfNeeded();
+    return true;
+}
+
+void ConcurrentBank::deposit(int accountId, Money amount) {
+    {
+        Shard& shard = shardFor(accountId);
+        std::unique_lock lock(shard.mutex);
+        Account& account = findAccount(shard, accountId);
+        const BalanceUndo undo(account);
+        account.deposit(amount);
+        try {
+            persistence_.recordDeposit(account, amount);
+        } catch (...) {
+            undo.restore(account);
+            throw;
+        }
+    }
+    compactIfNeeded();
+}
+
+void ConcurrentBank::withdraw(int accountId, Money amount) {
+    {
+        Shard& shard = shardFor(accountId);
+        std::unique_lock lock(shard.mutex);
+        Account& account = findAccount(shard, accountId);
+        const BalanceUndo undo(account);
+        account.withdraw(amount);
+        try {
+            persistence_.recordWithdraw(account, amount);
+        } catch (...) {
+            undo.restore(account);
+            throw;
+        }
+    }
+    compactIfNeeded();
+}
+
+void ConcurrentBank::transfer(int fromAccountId, int toAccountId, Money amount) {
+    {
+        std::size_t first = shardIndex(fromAccountId);
+        std::size_t second = shardIndex(toAccountId);
+        if (first > second)
+            std::swap(first, second);
+        std::unique_lock firstLock(shards_[first].mutex);
+        std::unique_lock<std::shared_mutex> secondLock;
+        if (second != first)
+            secondLock = std::unique_lock(shards_[second].mutex);
+
+        Account& from = findAccount(shardFor(fromAccountId), fromAccountId);
+        Account& to = findAccount(shardFor(toAccountId), toAccountId);
+        const BalanceUndo undoFrom(from);
+        const BalanceUndo undoTo(to);
+        from.transferTo(to, amount);
+        try {
+            persistence_.recordTransfer(from, to, amount);
+        } catch (...) {
+            undoFrom.restore(from);
+            undoTo.restore(to);
+            throw;
+        }
+    }
+    compactIfNeeded();
+}
+
+void ConcurrentBank::transferMany(const std::vector<Transfer>& transfers) {
+    {
+        std::vector<std::size_t> involved;
+        involved.reserve(transfers.size() * 2);
+        for (const Transfer& t : transfers) {
+            involved.push_back(shardIndex(t.fromAccountId));
+            involved.push_back(shardIndex(t.toAccountId));
+        }
+        std::sort(involved.begin(), involved.end());
+        involved.erase(std::unique(involved.begin(), involved.end()), involved.end());
+
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        locks.reserve(involved.size());
+        for (std::size_t index : involved)
+            locks.emplace_back(shards_[index].mutex);
+
+        TransferPlan plan = planTransfers(transfers, [this](int accountId) -> Account& {
+            return findAccount(shardFor(accountId), accountId);
+        });
+        const Timestamp now = currentTimestamp();
+        persistence_.recordTransfers(plan.records, now);
+        applyTransfers(plan, now);
+    }
+    compactIfNeeded();
+}
+
+BatchReport ConcurrentBank::applyBatch(const std::vector<BatchOperation>& operations) {
+    const std::size_t shards = shardCount();
+    std::vector<std::vector<std::size_t>> byShard(shards);
+    for (std::size_t i = 0; i < operations.size(); ++i)
+        byShard[shardIndex(operations[i].accountId)].push_back(i);
+
+    // Small batches are not worth waking threads for.
+    std::size_t workers = operations.size() < 4096
+        ? 1
+        : std::min<std::size_t>(shards, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<BatchReport> reports(workers);
+    std::atomic<std::size_t> nextShard{0};
+
+    auto work = [&](std::size_t worker) {
+        for (std::size_t s = nextShard++; s < shards; s = nextShard++) {
+            if (byShard[s].empty())
+                continue;
+            Shard& shard = shards_[s];
+            std::unique_lock lock(shard.mutex);
+            applyBatchGroups(operations, byShard[s], [&shard](int accountId) -> Account* {
+                auto it = shard.accounts.find(accountId);
+                return it == shard.accounts.end() ? nullptr : &it->second;
+            }, persistence_, reports[worker]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t w = 1; w < workers; ++w)
+        threads.emplace_back(work, w);
+    work(0);
+    for (auto& thread : threads)
+        thread.join();
+
+    BatchReport report;
+    for (auto& partial : reports)
+        report.merge(std::move(partial));
+    report.sortFailuresByLine();
+    compactIfNeeded();
+    return report;
+}
+
+PostingReport ConcurrentBank::applyPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint,
+                                            const PostingProgress& progress) {
+    PostingReport report;
+    {
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        locks.reserve(shardMask_ + 1);
+        for (std::size_t i = 0; i <= shardMask_; ++i)
+            locks.emplace_back(shards_[i].mutex);
+
+        if (!checkpoint.started())
+            checkpoint = {1, nextAccountId_.load(std::memory_order_relaxed)};
+        // Shard maps are only read during the run, so lookups need no locks
+        // of their own. Each chunk is journaled before it runs, as in Bank.
+        report = runPostings(schedule, checkpoint, postingTimestamp(), progress, [this](int accountId) -> Account* {
+            Shard& shard = shardFor(accountId);
+            auto it = shard.accounts.find(accountId);
+            return it == shard.accounts.end() ? nullptr : &it->second;
+        }, nullptr, [&](const PostingSegment& chunk) { persistence_.recordPosting(schedule, chunk); });
+    }
+    compactIfNeeded();
+    return report;
+}
+
+Account ConcurrentBank::getAccount(int accountId) const {
+    Shard& shard = shardFor(accountId);
+    std::shared_lock lock(shard.mutex);
+    return findAccount(shard, accountId);
+}
+
+Money ConcurrentBank::getBalance(int accountId) const {
+    Shard& shard = shardFor(accountId);
+    std::shared_lock lock(shard.mutex);
+    return findAccount(shard, accountId).balance();
+}
+
+std::size_t ConcurrentBank::accountCount() const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i <= shardMask_; ++i) {
+        std::shared_lock lock(shards_[i].mutex);
+        count += shards_[i].accounts.size();
+    }
+    return count;
+}
+
+void ConcurrentBank::save() {
+    std::lock_guard lock(saveMutex_);
+    saveLocked();
+}
+
+void ConcurrentBank::saveLocked() {
+    // Hold every shard (always in index order) only while copying, so the
+    // snapshot is consistent; writers carry on during the write.
+    std::unordered_map<int, Account> snapshot;
+    {
+        std::vector<std::shared_lock<std::shared_mutex>> locks;
+        locks.reserve(shardMask_ + 1);
+        for (std::size_t i = 0; i <= shardMask_; ++i) {
+            locks.emplace_back(shards_[i].mutex);
+            snapshot.insert(shards_[i].accounts.begin(), shards_[i].accounts.end());
+        }
+        persistence_.beginSave();
+    }
+    persistence_.save(snapshot);
+}
+
+Account& ConcurrentBank::findAccount(Shard& shard, int accountId) {
+    auto it = shard.accounts.find(accountId);
+    if (it == shard.accounts.end())
+        throw std::runtime_error("Account not found");
+    return it->second;
+}
+
+void ConcurrentBank::compactIfNeeded() {
+    if (!persistence_.needsCompaction())
+        return;
+    // Whoever gets here first compacts; the others carry on.
+    std::unique_lock lock(saveMutex_, std::try_to_lock);
+    if (lock.owns_lock() && persistence_.needsCompaction())
+        saveLocked();
+}
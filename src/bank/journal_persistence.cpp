@@ -0,0 +1,579 @@
+// journal_persistence.cpp
+#include "journal_persistence.h"
+#include "atomic_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[4] = {'B', 'N', 'K', 'J'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kHeaderSize = sizeof(kMagic) + sizeof(kVersion);
+
+std::uint32_t checksum(const char* data, std::size_t size) {
+    // FNV-1a; only used to detect a torn tail record after a crash.
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+template <typename T>
+void put(std::vector<char>& buffer, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+void putString(std::vector<char>& buffer, std::string_view value) {
+    put(buffer, static_cast<std::uint32_t>(value.size()));
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+class RecordReader {
+public:
+    RecordReader(const char* data, std::size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (size_ - pos_ < sizeof(T))
+            return false;
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool getString(std::string& value) {
+        std::uint32_t length = 0;
+        if (!get(length) || size_ - pos_ < length)
+            return false;
+        value.assign(data_ + pos_, length);
+        pos_ += length;
+        return true;
+    }
+
+private:
+    const char* data_;
+    std::size_t size_;
+    std::size_t pos_ = 0;
+};
+
+std::int64_t toMicros(Timestamp timestamp) {
+    return static_cast<std::int64_t>(timestamp.time_since_epoch().count());
+}
+
+Timestamp fromMicros(std::int64_t micros) {
+    return Timestamp(std::chrono::microseconds(micros));
+}
+
+} // namespace
+
+JournalPersistence::JournalPersistence(IPersistence& snapshot, const std::string& journalFile,
+                                       std::size_t syncEvery, std::size_t compactThreshold)
+    : snapshot_(snapshot),
+      lock_(journalFile),
+      filename_(journalFile),
+      syncEvery_(std::max<std::size_t>(syncEvery, 1)),
+      compactThreshold_(compactThreshold) {}
+
+JournalPersistence::~JournalPersistence() {
+    try {
+        flushLocked();
+    } catch (...) {
+        // Nothing sensible to do during teardown; the tail is lost.
+    }
+    closeJournal();
+}
+
+void JournalPersistence::save(const std::unordered_map<int, Account>& accounts) {
+    std::lock_guard saving(saveMutex_);
+    std::unique_lock lock(mutex_);
+    const SaveMark mark = saveMark_ ? *saveMark_ : markLocked();
+    saveMark_.reset();
+    flushLocked();
+    // Hooks carry on appending while the snapshot is written; everything
+    // past the mark survives the rewrite below.
+    lock.unlock();
+    snapshot_.save(accounts);
+    lock.lock();
+    flushLocked();
+    keepTailLocked(mark);
+    records_ -= std::min(records_, mark.records);
+    liveAccounts_ = accounts.size() + liveAccounts_ - std::min(liveAccounts_, mark.liveAccounts);
+}
+
+void JournalPersistence::beginSave() {
+    std::lock_guard lock(mutex_);
+    saveMark_ = markLocked();
+}
+
+std::unordered_map<int, Account> JournalPersistence::load() {
+    std::lock_guard lock(mutex_);
+    closeJournal();
+    buffer_.clear();
+    pending_ = 0;
+
+    std::unordered_map<int, Account> accounts = snapshot_.load();
+    std::size_t validEnd = replay(accounts);
+    liveAccounts_ = accounts.size();
+
+    if (validEnd > 0) {
+        openJournal(false);
+        dropTornTail(fd_, validEnd, filename_);
+    } else {
+        openJournal(true);
+    }
+    return accounts;
+}
+
+std::unique_ptr<AccountSource> JournalPersistence::openSource() {
+    std::lock_guard lock(mutex_);
+    // Records cannot be replayed onto accounts that have not been read, so
+    // a source is only offered when there are none, as after a clean exit.
+    // Buffered ones count too: written out, they keep the source closed.
+    flushLocked();
+    struct stat st {};
+    if (::stat(filename_.c_str(), &st) == 0 && static_cast<std::size_t>(st.st_size) > kHeaderSize)
+        return nullptr;
+    std::unique_ptr<AccountSource> source = snapshot_.openSource();
+    if (!source)
+        return nullptr;
+
+    closeJournal();
+    // The journal holds at most a header; start it fresh.
+    openJournal(true);
+    records_ = 0;
+    liveAccounts_ = source->size();
+    return source;
+}
+
+void JournalPersistence::recordCreate(const Account& account) {
+    std::lock_guard lock(mutex_);
+    std::size_t start = buffer_.size();
+    put(buffer_, std::uint32_t{0});
+    put(buffer_, static_cast<std::uint8_t>(RecordType::Create));
+    put(buffer_, static_cast<std::int32_t>(account.getAccountId()));
+    put(buffer_, account.balance().minorUnits());
+    put(buffer_, toMicros(account.creationTime()));
+    putString(buffer_, account.getPersonName());
+    putString(buffer_, account.getCardId());
+    commitRecord(start);
+    ++liveAccounts_;
+}
+
+void JournalPersistence::recordDelete(int accountId) {
+    std::lock_guard lock(mutex_);
+    appendDeleteRecord(accountId);
+}
+
+void JournalPersistence::recordDeposit(const Account& account, Money amount) {
+    appendBalanceRecord(RecordType::Deposit, account, amount);
+}
+
+void JournalPersistence::recordWithdraw(const Account& account, Money amount) {
+    appendBalanceRecord(RecordType::Withdraw, account, amount);
+}
+
+void JournalPersistence::recordTransfer(const Account& from, const Account& to, Money amount) {
+    std::lock_guard lock(mutex_);
+    std::size_t start = buffer_.size();
+    put(buffer_, std::uint32_t{0});
+    put(buffer_, static_cast<std::uint8_t>(RecordType::Transfer));
+    put(buffer_, static_cast<std::int32_t>(from.getAccountId()));
+    put(buffer_, from.balance().minorUnits());
+    put(buffer_, static_cast<std::int32_t>(to.getAccountId()));
+    put(buffer_, to.balance().minorUnits());
+    put(buffer_, amount.minorUnits());
+    put(buffer_, toMicros(from.lastOperationTime()));
+    commitRecord(start);
+}
+
+void JournalPersistence::recordTransfers(const std::vector<TransferRecord>& transfers, Timestamp when) {
+    std::lock_guard lock(mutex_);
+    std::size_t start = buffer_.size();
+    put(buffer_, std::uint32_t{0});
+    put(buffer_, static_cast<std::uint8_t>(RecordType::TransferBatch));
+    put(buffer_, static_cast<std::int32_t>(transfers.size()));
+    put(buffer_, toMicros(when));
+    for (const TransferRecord& transfer : transfers) {
+        put(buffer_, static_cast<std::int32_t>(transfer.fromAccountId));
+        put(buffer_, transfer.fromBalance.minorUnits());
+        put(buffer_, static_cast<std::int32_t>(transfer.toAccountId));
+        put(buffer_, transfer.toBalance.minorUnits());
+        put(buffer_, transfer.amount.minorUnits());
+    }
+    commitRecord(start);
+}
+
+void JournalPersistence::recordPosting(const PostingSchedule& schedule, const PostingSegment& segment) {
+    std::lock_guard lock(mutex_);
+    std::size_t start = buffer_.size();
+    put(buffer_, std::uint32_t{0});
+    put(buffer_, static_cast<std::uint8_t>(RecordType::Posting));
+    put(buffer_, static_cast<std::int32_t>(segment.fromAccountId));
+    put(buffer_, static_cast<std::int32_t>(segment.toAccountId));
+    put(buffer_, toMicros(segment.asOf));
+    put(buffer_, static_cast<std::uint32_t>(schedule.rules.size()));
+    for (const PostingRule& rule : schedule.rules) {
+        put(buffer_, rule.minBalance.minorUnits());
+        put(buffer_, rule.maxBalance.minorUnits());
+        put(buffer_, rule.ratePpm);
+        put(buffer_, rule.fee.minorUnits());
+    }
+    commitRecord(start);
+    flushLocked();
+}
+
+bool JournalPersistence::saveDelta(const AccountDelta& delta) {
+    std::lock_guard lock(mutex_);
+    for (const Account& account : delta.changed) {
+        std::size_t start = buffer_.size();
+        put(buffer_, std::uint32_t{0});
+        put(buffer_, static_cast<std::uint8_t>(RecordType::State));
+        put(buffer_, static_cast<std::int32_t>(account.getAccountId()));
+        put(buffer_, account.balance().minorUnits());
+        put(buffer_, static_cast<std::uint8_t>(account.lastOperationType()));
+        put(buffer_, toMicros(account.creationTime()));
+        put(buffer_, toMicros(account.lastOperationTime()));
+        putString(buffer_, account.getPersonName());
+        putString(buffer_, account.getCardId());
+        commitRecord(start);
+    }
+    // Counted as recordCreate() counts them; the deletes below take theirs
+    // back off.
+    liveAccounts_ += delta.created;
+    for (int accountId : delta.deleted)
+        appendDeleteRecord(accountId);
+    flushLocked();
+    return true;
+}
+
+bool JournalPersistence::needsCompaction() const {
+    std::lock_guard lock(mutex_);
+    // Scaling the threshold with the book keeps snapshot cost amortized O(1).
+    return records_ >= std::max(compactThreshold_, liveAccounts_);
+}
+
+void JournalPersistence::flush() {
+    std::lock_guard lock(mutex_);
+    flushLocked();
+}
+
+std::size_t JournalPersistence::journaledRecords() const {
+    std::lock_guard lock(mutex_);
+    return records_;
+}
+
+void JournalPersistence::flushLocked() {
+    if (buffer_.empty())
+        return;
+    if (fd_ < 0)
+        openJournal(false);
+    const off_t end = ::lseek(fd_, 0, SEEK_END);
+    if (end < 0)
+        throw std::runtime_error("Error reading journal: " + filename_ + ": " + std::strerror(errno));
+    appendRecords(fd_, static_cast<std::uint64_t>(end), std::string_view(buffer_.data(), buffer_.size()), filename_);
+    buffer_.clear();
+    pending_ = 0;
+}
+
+JournalPersistence::SaveMark JournalPersistence::markLocked() const {
+    std::size_t onDisk = kHeaderSize;
+    struct stat st {};
+    if (fd_ >= 0 ? ::fstat(fd_, &st) == 0 : ::stat(filename_.c_str(), &st) == 0)
+        onDisk = std::max(onDisk, static_cast<std::size_t>(st.st_size));
+    return {onDisk + buffer_.size(), records_, liveAccounts_};
+}
+
+void JournalPersistence::keepTailLocked(const SaveMark& mark) {
+    std::vector<char> tail;
+    struct stat st {};
+    if (fd_ >= 0 && ::fstat(fd_, &st) == 0 && static_cast<std::size_t>(st.st_size) > mark.offset) {
+        tail.resize(static_cast<std::size_t>(st.st_size) - mark.offset);
+        std::size_t got = 0;
+        while (got < tail.size()) {
+            ssize_t n = ::pread(fd_, tail.data() + got, tail.size() - got, static_cast<off_t>(mark.offset + got));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                throw std::runtime_error("Error reading journal: " + filename_ + ": " + std::strerror(errno));
+            got += static_cast<std::size_t>(n);
+        }
+    }
+    std::vector<char> header(kMagic, kMagic + sizeof(kMagic));
+    put(header, kVersion);
+    closeJournal();
+    // Atomic, so a crash leaves either the old journal, whose records the
+    // snapshot already holds, or the tail.
+    replaceFileAtomically(filename_, {std::string_view(header.data(), header.size()),
+                                      std::string_view(tail.data(), tail.size())});
+    openJournal(false);
+}
+
+void JournalPersistence::openJournal(bool truncate) {
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0);
+    fd_ = ::open(filename_.c_str(), flags, 0644);
+    if (fd_ < 0)
+        throw std::runtime_error("Error opening journal: " + filename_ + ": " + std::strerror(errno));
+
+    struct stat st {};
+    if (::fstat(fd_, &st) != 0)
+        throw std::runtime_error("Error reading journal: " + filename_ + ": " + std::strerror(errno));
+    if (st.st_size == 0) {
+        std::vector<char> header(kMagic, kMagic + sizeof(kMagic));
+        put(header, kVersion);
+        writeAll(fd_, std::string_view(header.data(), header.size()), filename_);
+        ::fdatasync(fd_);
+    } else {
+        ::lseek(fd_, 0, SEEK_END);
+    }
+}
+
+void JournalPersistence::closeJournal() noexcept {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void JournalPersistence::appendDeleteRecord(int accountId) {
+    std::size_t start = buffer_.size();
+    put(buffer_, std::uint32_t{0});
+    put(buffer_, static_cast<std::uint8_t>(RecordType::Delete));
+    put(buffer_, static_cast<std::int32_t>(accountId));
+    commitRecord(start);
+    if (liveAccounts_ > 0)
+        --liveAccounts_;
+}
+
+void JournalPersistence::appendBalanceRecord(RecordType type, const Account& account, Money amount) {
+    std::lock_guard lock(mutex_);
+    std::size_t start = buffer_.size();
+    put(buffer_, std::uint32_t{0});
+    put(buffer_, static_cast<std::uint8_t>(type));
+    put(buffer_, static_cast<std::int32_t>(account.getAccountId()));
+    put(buffer_, account.balance().minorUnits());
+    put(buffer_, amount.minorUnits());
+    put(buffer_, toMicros(account.lastOperationTime()));
+    commitRecord(start);
+}
+
+void JournalPersistence::commitRecord(std::size_t start) {
+    // Layout: [u32 size][u8 type][payload][u32 checksum of type + payload]
+    const std::size_t bodyStart = start + sizeof(std::uint32_t);
+    const auto size = static_cast<std::uint32_t>(buffer_.size() - bodyStart);
+    std::memcpy(buffer_.data() + start, &size, sizeof(size));
+    put(buffer_, checksum(buffer_.data() + bodyStart, size));
+
+    ++records_;
+    if (++pending_ >= syncEvery_) {
+        try {
+            flushLocked();
+        } catch (...) {
+            // The caller takes its change back; the records buffered before
+            // this one stay for the next flush.
+            buffer_.resize(start);
+            --records_;
+            --pending_;
+            throw;
+        }
+    }
+}
+
+std::size_t JournalPersistence::replay(std::unordered_map<int, Account>& accounts) {
+    records_ = 0;
+    int fd = ::open(filename_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+
+    std::vector<char> data;
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        data.resize(static_cast<std::size_t>(st.st_size));
+        std::size_t got = 0;
+        while (got < data.size()) {
+            ssize_t n = ::read(fd, data.data() + got, data.size() - got);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            got += static_cast<std::size_t>(n);
+        }
+        data.resize(got);
+    }
+    ::close(fd);
+
+    if (data.size() < kHeaderSize || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0)
+        return 0;
+    std::uint32_t version = 0;
+    std::memcpy(&version, data.data() + sizeof(kMagic), sizeof(version));
+    if (version != kVersion)
+        throw std::runtime_error("Unsupported journal version in " + filename_);
+
+    auto getTime = [](RecordReader& reader, Timestamp& when) {
+        std::int64_t micros = 0;
+        if (!reader.get(micros))
+            return false;
+        when = fromMicros(micros);
+        return true;
+    };
+    auto getMoney = [](RecordReader& reader, Money& value) {
+        std::int64_t minor = 0;
+        if (!reader.get(minor))
+            return false;
+        value = Money::fromMinorUnits(minor);
+        return true;
+    };
+
+    std::size_t pos = kHeaderSize;
+    while (data.size() - pos >= sizeof(std::uint32_t)) {
+        std::uint32_t size = 0;
+        std::memcpy(&size, data.data() + pos, sizeof(size));
+        const std::size_t bodyStart = pos + sizeof(size);
+        if (size == 0 || data.size() - bodyStart < std::size_t{size} + sizeof(std::uint32_t))
+            break;
+        std::uint32_t expected = 0;
+        std::memcpy(&expected, data.data() + bodyStart + size, sizeof(expected));
+        if (checksum(data.data() + bodyStart, size) != expected)
+            break;
+
+        RecordReader reader(data.data() + bodyStart, size);
+        std::uint8_t rawType = 0;
+        std::int32_t id = 0;
+        reader.get(rawType);
+        if (!reader.get(id))
+            break;
+
+        switch (static_cast<RecordType>(rawType)) {
+        case RecordType::Create: {
+            Money balance;
+            Timestamp created;
+            std::string personName;
+            std::string cardId;
+            if (!getMoney(reader, balance) || !getTime(reader, created) || !reader.getString(personName) ||
+                !reader.getString(cardId))
+                return pos;
+            accounts.insert_or_assign(id, Account{id, balance, std::move(personName), std::move(cardId),
+                                                  created, OperationType::None, created});
+            break;
+        }
+        case RecordType::Delete:
+            accounts.erase(id);
+            break;
+        case RecordType::State: {
+            Money balance;
+            std::uint8_t operation = 0;
+            Timestamp created;
+            Timestamp lastOperation;
+            std::string personName;
+            std::string cardId;
+            if (!getMoney(reader, balance) || !reader.get(operation) || !getTime(reader, created) ||
+                !getTime(reader, lastOperation) || !reader.getString(personName) || !reader.getString(cardId))
+                return pos;
+            accounts.insert_or_assign(id, Account{id, balance, std::move(personName), std::move(cardId), created,
+                                                  static_cast<OperationType>(operation), lastOperation});
+            break;
+        }
+        case RecordType::Deposit:
+        case RecordType::Withdraw: {
+            Money balanceAfter;
+            Money amount;
+            Timestamp when;
+            if (!getMoney(reader, balanceAfter) || !getMoney(reader, amount) || !getTime(reader, when))
+                return pos;
+            // A missing account was deleted by a later record already folded
+            // into the snapshot; its delete record follows in this journal.
+            auto it = accounts.find(id);
+            if (it != accounts.end()) {
+                it->second.setBalance(balanceAfter);
+                it->second.updateOperationInfo(static_cast<RecordType>(rawType) == RecordType::Deposit
+                                                   ? OperationType::Deposit
+                                                   : OperationType::Withdrawal,
+                                               when);
+            }
+            break;
+        }
+        case RecordType::Transfer: {
+            Money fromBalance;
+            std::int32_t toId = 0;
+            Money toBalance;
+            Money amount;
+            Timestamp when;
+            if (!getMoney(reader, fromBalance) || !reader.get(toId) || !getMoney(reader, toBalance) ||
+                !getMoney(reader, amount) || !getTime(reader, when))
+                return pos;
+            auto from = accounts.find(id);
+            if (from != accounts.end()) {
+                from->second.setBalance(fromBalance);
+                from->second.updateOperationInfo(OperationType::TransferOut, when);
+            }
+            auto to = accounts.find(toId);
+            if (to != accounts.end()) {
+                to->second.setBalance(toBalance);
+                to->second.updateOperationInfo(OperationType::TransferIn, when);
+            }
+            break;
+        }
+        case RecordType::TransferBatch: {
+            // `id` is the number of transfers; they share one timestamp.
+            Timestamp when;
+            if (id < 0 || !getTime(reader, when))
+                return pos;
+            std::vector<TransferRecord> transfers(static_cast<std::size_t>(id));
+            for (TransferRecord& transfer : transfers) {
+                std::int32_t fromId = 0;
+                std::int32_t toId = 0;
+                if (!reader.get(fromId) || !getMoney(reader, transfer.fromBalance) || !reader.get(toId) ||
+                    !getMoney(reader, transfer.toBalance) || !getMoney(reader, transfer.amount))
+                    return pos;
+                transfer.fromAccountId = fromId;
+                transfer.toAccountId = toId;
+            }
+            for (const TransferRecord& transfer : transfers) {
+                auto from = accounts.find(transfer.fromAccountId);
+                if (from != accounts.end()) {
+                    from->second.setBalance(transfer.fromBalance);
+                    from->second.updateOperationInfo(OperationType::TransferOut, when);
+                }
+                auto to = accounts.find(transfer.toAccountId);
+                if (to != accounts.end()) {
+                    to->second.setBalance(transfer.toBalance);
+                    to->second.updateOperationInfo(OperationType::TransferIn, when);
+                }
+            }
+            break;
+        }
+        case RecordType::Posting: {
+            PostingSegment segment;
+            segment.fromAccountId = id;
+            std::int32_t toId = 0;
+            std::uint32_t ruleCount = 0;
+            if (!reader.get(toId) || !getTime(reader, segment.asOf) || !reader.get(ruleCount))
+                return pos;
+            segment.toAccountId = toId;
+            PostingSchedule schedule;
+            for (std::uint32_t r = 0; r < ruleCount; ++r) {
+                PostingRule rule;
+                if (!getMoney(reader, rule.minBalance) || !getMoney(reader, rule.maxBalance) ||
+                    !reader.get(rule.ratePpm) || !getMoney(reader, rule.fee))
+                    return pos;
+                schedule.rules.push_back(rule);
+            }
+            replayPostings(accounts, schedule, segment);
+            break;
+        }
+        default:
+            return pos;
+        }
+
+        pos = bodyStart + size + sizeof(std::uint32_t);
+        ++records_;
+    }
+    return pos;
+}
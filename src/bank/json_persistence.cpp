@@ -1,57 +1,649 @@
 // json_persistence.cpp
 #include "json_persistence.h"
+#include "atomic_file.h"
+#include "binary_persistence.h"
+#include "checksum.h"
+#include "metrics.h"
+#include "parallel_chunks.h"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
 #include <fstream>
-#include <iostream>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
 
-JsonPersistence::JsonPersistence(const std::string& filename) : filename_(filename) {}
+namespace {
+
+// Size of one pretty-printed account record, used to pre-size the map.
+constexpr std::size_t kApproxBytesPerAccount = 240;
+
+// The file ends with the array element "checksum64:<16 hex digits>".
+constexpr std::string_view kChecksumPrefix = "\"checksum64:";
+constexpr std::string_view kTrailerEnd = "\"\n]\n";
+constexpr std::size_t kChecksumDigits = 16;
+constexpr std::size_t kTrailerSize = kChecksumPrefix.size() + kChecksumDigits + kTrailerEnd.size();
+
+std::string formatTrailer(std::uint64_t sum) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string trailer(kChecksumPrefix);
+    for (int shift = 60; shift >= 0; shift -= 4)
+        trailer += kHex[(sum >> shift) & 0xf];
+    trailer += kTrailerEnd;
+    return trailer;
+}
+
+bool parseTrailer(std::string_view tail, std::uint64_t& sum) {
+    if (tail.size() != kTrailerSize || tail.substr(0, kChecksumPrefix.size()) != kChecksumPrefix ||
+        tail.substr(kTrailerSize - kTrailerEnd.size()) != kTrailerEnd)
+        return false;
+    sum = 0;
+    for (char c : tail.substr(kChecksumPrefix.size(), kChecksumDigits)) {
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (digit < 0)
+            return false;
+        sum = sum << 4 | static_cast<std::uint64_t>(digit);
+    }
+    return true;
+}
+
+// Reads the checksum off the end of a file of `size` bytes; false if it has
+// none.
+bool readTrailer(std::ifstream& file, std::size_t size, std::uint64_t& sum) {
+    if (size < kTrailerSize)
+        return false;
+    std::string tail(kTrailerSize, '\0');
+    file.seekg(static_cast<std::streamoff>(size - kTrailerSize));
+    file.read(tail.data(), static_cast<std::streamsize>(tail.size()));
+    return file && parseTrailer(tail, sum);
+}
+
+// Feeds the file to the parser a block at a time, checksumming its first
+// `covered` bytes on the way, so a load never holds the whole text.
+class ChecksummingBuffer : public std::streambuf {
+public:
+    ChecksummingBuffer(std::ifstream& file, const std::string& filename, std::size_t covered)
+        : file_(file), filename_(filename), covered_(covered), sum_(covered), block_(kBlockSize) {}
+
+    // Reads whatever the parser left, then returns the sum.
+    std::uint64_t finish() {
+        while (underflow() != traits_type::eof())
+            setg(eback(), egptr(), egptr());
+        return sum_.finish();
+    }
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+        file_.read(block_.data(), static_cast<std::streamsize>(block_.size()));
+        if (file_.bad())
+            throw std::runtime_error("Error reading file: " + filename_);
+        const auto got = static_cast<std::size_t>(file_.gcount());
+        if (got == 0)
+            return traits_type::eof();
+        sum_.update(std::string_view(block_.data(), std::min(got, covered_ - std::min(covered_, offset_))));
+        offset_ += got;
+        setg(block_.data(), block_.data(), block_.data() + got);
+        return traits_type::to_int_type(block_[0]);
+    }
+
+private:
+    static constexpr std::size_t kBlockSize = 1 << 16;
+
+    std::ifstream& file_;
+    const std::string& filename_;
+    std::size_t covered_;
+    std::size_t offset_ = 0;
+    Checksum64 sum_;
+    std::vector<char> block_;
+};
+
+// Below this many accounts per thread a save is not worth splitting.
+constexpr std::size_t kAccountsPerWorker = 16384;
+// Size of one account record, names included, to reserve the buffers.
+constexpr std::size_t kIndentedRecordSize = 300;
+constexpr std::size_t kCompactRecordSize = 220;
+
+void appendDecimal(std::string& out, std::uint64_t value) {
+    char buffer[20];
+    out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+
+// Exact minor units with every fraction digit ("-12.50"), which the loader
+// reads back digit for digit.
+void appendMoney(std::string& out, Money amount) {
+    const std::int64_t minor = amount.minorUnits();
+    const std::uint64_t magnitude =
+        minor < 0 ? 0 - static_cast<std::uint64_t>(minor) : static_cast<std::uint64_t>(minor);
+    const auto scale = static_cast<std::uint64_t>(Money::kScale);
+    if (minor < 0)
+        out += '-';
+    appendDecimal(out, magnitude / scale);
+    out += '.';
+    std::uint64_t fraction = magnitude % scale;
+    char digits[18];
+    int count = 0;
+    for (std::uint64_t unit = scale; unit > 1; unit /= 10)
+        ++count;
+    for (int i = count - 1; i >= 0; --i, fraction /= 10)
+        digits[i] = static_cast<char>('0' + fraction % 10);
+    out.append(digits, static_cast<std::size_t>(count));
+}
+
+// Length of the UTF-8 sequence starting `text`, 0 if it is not a valid
+// one (nlohmann's parser rejects those, so they must not be written).
+std::size_t utf8SequenceLength(std::string_view text) {
+    auto byte = [&](std::size_t i) { return i < text.size() ? static_cast<unsigned char>(text[i]) : 0u; };
+    auto continuation = [&](std::size_t i, unsigned low = 0x80, unsigned high = 0xbf) {
+        return byte(i) >= low && byte(i) <= high;
+    };
+    const unsigned lead = byte(0);
+    if (lead >= 0xc2 && lead <= 0xdf)
+        return continuation(1) ? 2 : 0;
+    if (lead >= 0xe0 && lead <= 0xef) {
+        const unsigned low = lead == 0xe0 ? 0xa0 : 0x80;   // overlong
+        const unsigned high = lead == 0xed ? 0x9f : 0xbf;  // surrogates
+        return continuation(1, low, high) && continuation(2) ? 3 : 0;
+    }
+    if (lead >= 0xf0 && lead <= 0xf4) {
+        const unsigned low = lead == 0xf0 ? 0x90 : 0x80;   // overlong
+        const unsigned high = lead == 0xf4 ? 0x8f : 0xbf;  // beyond U+10FFFF
+        return continuation(1, low, high) && continuation(2) && continuation(3) ? 4 : 0;
+    }
+    return 0;
+}
+
+// Appends `text` as a JSON string, escaped the way nlohmann escapes.
+// Returns false for text that is not valid UTF-8.
+bool appendString(std::string& out, std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    out += '"';
+    std::size_t i = 0;
+    while (i < text.size()) {
+        // Copy runs of plain ASCII in one go; names are nearly all of it.
+        std::size_t run = i;
+        while (run < text.size()) {
+            const auto c = static_cast<unsigned char>(text[run]);
+            if (c < 0x20 || c >= 0x80 || c == '"' || c == '\\')
+                break;
+            ++run;
+        }
+        out.append(text.data() + i, run - i);
+        i = run;
+        if (i == text.size())
+            break;
+
+        const auto c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x80) {
+            const std::size_t length = utf8SequenceLength(text.substr(i));
+            if (length == 0)
+                return false;
+            out.append(text.data() + i, length);
+            i += length;
+            continue;
+        }
+        out += '\\';
+        switch (c) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '\b': out += 'b'; break;
+        case '\f': out += 'f'; break;
+        case '\n': out += 'n'; break;
+        case '\r': out += 'r'; break;
+        case '\t': out += 't'; break;
+        default:
+            out += "u00";
+            out += kHex[c >> 4];
+            out += kHex[c & 0xf];
+        }
+        ++i;
+    }
+    out += '"';
+    return true;
+}
+
+// formatTimestamp() without a time zone lookup per call: localtime_r()
+// takes a process-wide lock, which would serialize the workers. It looks
+// up the UTC offset once per UTC day instead, keeping the last few
+// thousand days, and does the calendar arithmetic itself. A day whose
+// offset changes (a DST switch) goes through localtime_r() per call. One
+// per thread.
+class TimestampFormatter {
+public:
+    void append(std::string& out, Timestamp timestamp) {
+        const std::time_t seconds = std::chrono::system_clock::to_time_t(timestamp);
+        const std::int64_t day = floorDiv(seconds, kDay);
+        Day& cached = days_[static_cast<std::size_t>(day) % kCachedDays];
+        if (cached.day != day)
+            cached = lookUp(day);
+
+        std::int64_t local = seconds + cached.offset;
+        if (!cached.uniform) {
+            std::tm fields{};
+            localtime_r(&seconds, &fields);
+            local = seconds + fields.tm_gmtoff;
+        }
+        // Days to civil date, after Howard Hinnant's days_from_civil inverse.
+        const std::int64_t z = floorDiv(local, kDay) + 719468;
+        const std::int64_t era = floorDiv(z, 146097);
+        const std::int64_t dayOfEra = z - era * 146097;
+        const std::int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const std::int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const std::int64_t shiftedMonth = (5 * dayOfYear + 2) / 153;
+        const std::int64_t month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+        const std::int64_t year = yearOfEra + era * 400 + (month <= 2);
+        if (year < 0 || year > 9999) {
+            out += formatTimestamp(timestamp);
+            return;
+        }
+        const std::int64_t secondOfDay = local - floorDiv(local, kDay) * kDay;
+
+        char text[19] = {0, 0, 0, 0, '-', 0, 0, '-', 0, 0, ' ', 0, 0, ':', 0, 0, ':', 0, 0};
+        auto put = [&text](int at, std::int64_t value, int width) {
+            for (int i = at + width - 1; i >= at; --i, value /= 10)
+                text[i] = static_cast<char>('0' + value % 10);
+        };
+        put(0, year, 4);
+        put(5, month, 2);
+        put(8, dayOfYear - (153 * shiftedMonth + 2) / 5 + 1, 2);
+        put(11, secondOfDay / 3600, 2);
+        put(14, secondOfDay / 60 % 60, 2);
+        put(17, secondOfDay % 60, 2);
+        out.append(text, sizeof(text));
+    }
+
+private:
+    static constexpr std::int64_t kDay = 24 * 60 * 60;
+    static constexpr std::size_t kCachedDays = 4096;
+
+    struct Day {
+        std::int64_t day = std::numeric_limits<std::int64_t>::min();
+        long offset = 0;       // local time minus UTC, in seconds
+        bool uniform = false;  // the same offset all day
+    };
+
+    static std::int64_t floorDiv(std::int64_t value, std::int64_t divisor) {
+        return value / divisor - (value % divisor < 0);
+    }
+
+    // Offset switches are months apart, so one that is the same at both
+    // ends of the day holds all day.
+    static Day lookUp(std::int64_t day) {
+        const auto start = static_cast<std::time_t>(day * kDay);
+        const std::time_t end = start + kDay - 1;
+        std::tm first{};
+        std::tm last{};
+        localtime_r(&start, &first);
+        localtime_r(&end, &last);
+        return {day, first.tm_gmtoff, first.tm_gmtoff == last.tm_gmtoff};
+    }
+
+    std::vector<Day> days_ = std::vector<Day>(kCachedDays);
+};
+
+// The text between an account's values, keys in the order dump() sorts
+// them, for each layout. Quotes around timestamps and the operation type
+// are folded in.
+struct RecordLayout {
+    std::string_view accountId, balance, cardId, creationTime, lastOperationTime, lastOperationType, personName,
+        end;
+};
+constexpr RecordLayout kIndentedRecord{
+    "    {\n        \"accountId\": ",
+    ",\n        \"balance\": ",
+    ",\n        \"cardId\": ",
+    ",\n        \"creationTime\": \"",
+    "\",\n        \"lastOperationTime\": \"",
+    "\",\n        \"lastOperationType\": \"",
+    "\",\n        \"personName\": ",
+    "\n    }",
+};
+constexpr RecordLayout kCompactRecord{
+    "{\"accountId\":",
+    ",\"balance\":",
+    ",\"cardId\":",
+    ",\"creationTime\":\"",
+    "\",\"lastOperationTime\":\"",
+    "\",\"lastOperationType\":\"",
+    "\",\"personName\":",
+    "}",
+};
+
+// One account as an array element. Returns false if a string is not valid
+// UTF-8.
+bool appendAccount(std::string& out, int accountId, const Account& account, const RecordLayout& layout,
+                   TimestampFormatter& timestamps) {
+    out += layout.accountId;
+    if (accountId < 0)
+        out += '-';
+    appendDecimal(out, accountId < 0 ? 0 - static_cast<std::uint64_t>(accountId)
+                                     : static_cast<std::uint64_t>(accountId));
+    out += layout.balance;
+    appendMoney(out, account.balance());
+    out += layout.cardId;
+    if (!appendString(out, account.getCardId()))
+        return false;
+    out += layout.creationTime;
+    timestamps.append(out, account.creationTime());
+    out += layout.lastOperationTime;
+    timestamps.append(out, account.lastOperationTime());
+    out += layout.lastOperationType;
+    out += toString(account.lastOperationType());
+    out += layout.personName;
+    if (!appendString(out, account.getPersonName()))
+        return false;
+    out += layout.end;
+    return true;
+}
+
+// Streams the top-level account array straight into the map without
+// building a DOM. Unknown keys and nested values are skipped.
+class AccountSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+public:
+    explicit AccountSaxHandler(std::unordered_map<int, Account>& accounts) : accounts_(accounts) {}
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+
+    bool number_integer(number_integer_t value) override {
+        return number(static_cast<double>(value), value);
+    }
+
+    bool number_unsigned(number_unsigned_t value) override {
+        return number(static_cast<double>(value), static_cast<number_integer_t>(value));
+    }
+
+    bool number_float(number_float_t value, const string_t& text) override {
+        // Read the balance from the literal text so "0.1" is exactly 10 cents.
+        if (depth_ == kAccountDepth && field_ == Field::Balance && Money::parse(text, balance_))
+            return true;
+        return number(value, static_cast<number_integer_t>(value));
+    }
+
+    bool string(string_t& value) override {
+        if (depth_ != kAccountDepth)
+            return true;
+        switch (field_) {
+        case Field::PersonName: personName_ = std::move(value); break;
+        case Field::CardId: cardId_ = std::move(value); break;
+        case Field::CreationTime: creationTime_ = std::move(value); break;
+        case Field::LastOperationType: lastOperationType_ = std::move(value); break;
+        case Field::LastOperationTime: lastOperationTime_ = std::move(value); break;
+        default: break;
+        }
+        return true;
+    }
+
+    bool binary(binary_t&) override { return true; }
+
+    bool start_object(std::size_t) override {
+        if (++depth_ == kAccountDepth && inTopArray_)
+            resetRecord();
+        return true;
+    }
+
+    bool key(string_t& name) override {
+        if (depth_ == kAccountDepth)
+            field_ = fieldFor(name);
+        return true;
+    }
+
+    bool end_object() override {
+        if (depth_-- == kAccountDepth && inTopArray_)
+            emitRecord();
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (++depth_ == 1)
+            inTopArray_ = true;
+        return true;
+    }
+
+    bool end_array() override {
+        --depth_;
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        // `ex` is only the base of the parser's exception; rethrowing it would
+        // slice it, so report it as the load errors above are.
+        throw std::runtime_error("Malformed JSON at byte " + std::to_string(position) + ": " + ex.what());
+    }
+
+private:
+    enum class Field {
+        Other,
+        AccountId,
+        Balance,
+        PersonName,
+        CardId,
+        CreationTime,
+        LastOperationType,
+        LastOperationTime
+    };
+
+    static constexpr int kAccountDepth = 2;
+
+    static Field fieldFor(const std::string& name) {
+        if (name == "accountId") return Field::AccountId;
+        if (name == "balance") return Field::Balance;
+        if (name == "personName") return Field::PersonName;
+        if (name == "cardId") return Field::CardId;
+        if (name == "creationTime") return Field::CreationTime;
+        if (name == "lastOperationType") return Field::LastOperationType;
+        if (name == "lastOperationTime") return Field::LastOperationTime;
+        return Field::Other;
+    }
+
+    bool number(double asDouble, number_integer_t asInteger) {
+        if (depth_ != kAccountDepth)
+            return true;
+        if (field_ == Field::AccountId)
+            accountId_ = static_cast<int>(asInteger);
+        else if (field_ == Field::Balance)
+            balance_ = Money(asDouble);
+        return true;
+    }
+
+    void resetRecord() {
+        field_ = Field::Other;
+        accountId_ = 0;
+        balance_ = Money();
+        personName_.clear();
+        cardId_.clear();
+        creationTime_.clear();
+        lastOperationType_.clear();
+        lastOperationTime_.clear();
+    }
+
+    void emitRecord() {
+        Timestamp created;
+        if (!parseTimestamp(creationTime_, created)) {
+            // Older files carry no timestamps; stamp them as new.
+            accounts_.try_emplace(accountId_, accountId_, balance_, personName_, cardId_);
+            return;
+        }
+        Timestamp lastOperation = created;
+        parseTimestamp(lastOperationTime_, lastOperation);
+        accounts_.try_emplace(accountId_, accountId_, balance_, std::move(personName_), std::move(cardId_),
+                              created, parseOperationType(lastOperationType_), lastOperation);
+    }
+
+    std::unordered_map<int, Account>& accounts_;
+    int depth_ = 0;
+    bool inTopArray_ = false;
+    Field field_ = Field::Other;
+    int accountId_ = 0;
+    Money balance_;
+    std::string personName_;
+    std::string cardId_;
+    std::string creationTime_;
+    std::string lastOperationType_;
+    std::string lastOperationTime_;
+};
+
+} // namespace
+
+JsonPersistence::JsonPersistence(const std::string& filename, bool indexCache, JsonLayout layout)
+    : lock_(filename), filename_(filename), cacheFile_(indexCache ? filename + ".idx" : std::string()), layout_(layout) {}
 
 void JsonPersistence::save(const std::unordered_map<int, Account>& accounts) {
-    nlohmann::json j = nlohmann::json::array();
-    for (const auto& pair : accounts) {
-        nlohmann::json accountJson;
-        accountJson["accountId"] = pair.first;
-        accountJson["balance"] = pair.second.balance();
-        accountJson["personName"] = pair.second.getPersonName();
-        accountJson["cardId"] = pair.second.getCardId();
-        accountJson["creationTime"] = pair.second.getCreationTime();
-        accountJson["lastOperationType"] = pair.second.getLastOperationType();
-        accountJson["lastOperationTime"] = pair.second.getLastOperationTime();
-        j.push_back(accountJson);
-    }
-    std::ofstream file(filename_);
-    if (file.is_open()) {
-        file << j.dump(4);
-    } else {
-        std::cerr << "Error opening file for writing: " << filename_ << std::endl;
+    BANK_METRIC_TIME(JsonSave);
+    std::vector<const std::pair<const int, Account>*> entries;
+    entries.reserve(accounts.size());
+    for (const auto& pair : accounts)
+        entries.push_back(&pair);
+
+    const bool indented = layout_ == JsonLayout::Indented;
+    const RecordLayout& record = indented ? kIndentedRecord : kCompactRecord;
+    const std::string_view elementSeparator = indented ? ",\n" : ",";
+    const unsigned workers = static_cast<unsigned>(std::clamp<std::size_t>(
+        entries.size() / kAccountsPerWorker, 1, std::max(1u, std::thread::hardware_concurrency())));
+    std::vector<std::string> parts(workers);
+    std::vector<std::optional<int>> invalid(workers);  // an account whose text is not UTF-8
+    forEachChunk(entries.size(), workers, [&](unsigned worker, std::size_t begin, std::size_t end) {
+        std::string& out = parts[worker];
+        out.reserve((end - begin) * (indented ? kIndentedRecordSize : kCompactRecordSize));
+        TimestampFormatter timestamps;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (!appendAccount(out, entries[i]->first, entries[i]->second, record, timestamps)) {
+                invalid[worker] = entries[i]->first;
+                return;
+            }
+            out += elementSeparator;
+        }
+    });
+    for (const std::optional<int>& accountId : invalid)
+        if (accountId)
+            throw std::runtime_error("Cannot save account " + std::to_string(*accountId) +
+                                     ": its owner name or card ID is not valid UTF-8");
+
+    // Every record is followed by a separator, so the checksum simply becomes
+    // the last element.
+    std::size_t size = std::string_view("[\n    ").size();
+    for (const std::string& part : parts)
+        size += part.size();
+    std::string text;
+    text.reserve(size);
+    text += indented ? "[\n" : "[";
+    for (std::string& part : parts) {
+        text += part;
+        std::string().swap(part);
     }
+    if (indented)
+        text += "    ";
+    std::uint64_t sum = checksum64(text);
+    replaceFileAtomically(filename_, {text, formatTrailer(sum)});
+
+    if (!cacheFile_.empty())
+        saveCache(accounts, sum);
 }
 
 std::unordered_map<int, Account> JsonPersistence::load() {
+    BANK_METRIC_TIME(JsonLoad);
     std::unordered_map<int, Account> accounts;
-    std::ifstream file(filename_);
-    if (file.is_open()) {
-        nlohmann::json j;
-        file >> j;
-        if (j.is_array()) {
-            for (const auto& item : j) {
-                int id = item.value("accountId", 0);
-                double balance = item.value("balance", 0.0);
-                std::string personName = item.value("personName", "");
-                std::string cardId = item.value("cardId", "");
-
-                Account acc(id, balance, personName, cardId);
-                
-                // Restore operation info if available
-                if (item.contains("lastOperationType")) {
-                    // We can't directly set these without adding setters,
-                    // but they'll be initialized by the constructor
-                }
-                accounts.emplace(id, acc);
-            }
-        }
-    } else {
+    std::ifstream file(filename_, std::ios::binary);
+    if (!file.is_open()) {
         // File doesn't exist, return empty
+        return accounts;
+    }
+
+    file.seekg(0, std::ios::end);
+    const auto size = static_cast<std::size_t>(file.tellg());
+    std::uint64_t expected = 0;
+    const bool verified = readTrailer(file, size, expected);
+    if (verified && !cacheFile_.empty()) {
+        if (loadCache(expected, accounts)) {
+            BANK_METRIC_COUNT(JsonCacheHits);
+            return accounts;
+        }
+        BANK_METRIC_COUNT(JsonCacheMisses);
+    }
+
+    file.clear();
+    file.seekg(0);
+    ChecksummingBuffer buffer(file, filename_, verified ? size - kTrailerSize : 0);
+    std::istream stream(&buffer);
+    const std::string damaged = "Checksum mismatch in " + filename_ + ": the snapshot is damaged";
+    accounts.reserve(size / kApproxBytesPerAccount);
+    AccountSaxHandler handler(accounts);
+    try {
+        nlohmann::json::sax_parse(stream, &handler);
+    } catch (const std::exception&) {
+        // Damage often shows first as bad JSON; name it for what it is.
+        if (verified && buffer.finish() != expected)
+            throw std::runtime_error(damaged);
+        throw;
     }
+    if (verified && buffer.finish() != expected)
+        throw std::runtime_error(damaged);
+
+    if (verified && !cacheFile_.empty())
+        saveCache(accounts, expected);
     return accounts;
-}
\ No newline at end of file
+}
+
+std::unique_ptr<AccountSource> JsonPersistence::openSource() {
+    // Only the index cache can be read piecemeal; without a current one
+    // there is nothing to do but parse.
+    std::ifstream file(filename_, std::ios::binary);
+    if (cacheFile_.empty() || !file.is_open())
+        return nullptr;
+    file.seekg(0, std::ios::end);
+    std::uint64_t expected = 0;
+    if (!readTrailer(file, static_cast<std::size_t>(file.tellg()), expected))
+        return nullptr;
+    // Only the header is checked: reading the whole body here would cost
+    // what the lazy start is meant to save. Records are bounds-checked as
+    // they are materialized.
+    std::unique_ptr<BinarySnapshotView> cache = openCache(expected, false);
+    if (!cache) {
+        BANK_METRIC_COUNT(JsonCacheMisses);
+        return nullptr;
+    }
+    BANK_METRIC_COUNT(JsonCacheHits);
+    return cache;
+}
+
+std::unique_ptr<BinarySnapshotView> JsonPersistence::openCache(std::uint64_t checksum, bool verifyBody) const {
+    if (::access(cacheFile_.c_str(), F_OK) != 0)
+        return nullptr;
+    try {
+        auto view = std::make_unique<BinarySnapshotView>(cacheFile_);
+        if (view->sourceChecksum() != checksum || (verifyBody && !view->verify()))
+            return nullptr;
+        return view;
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+bool JsonPersistence::loadCache(std::uint64_t checksum, std::unordered_map<int, Account>& accounts) const {
+    std::unique_ptr<BinarySnapshotView> view = openCache(checksum, true);
+    if (!view)
+        return false;
+    try {
+        accounts = view->materializeAll();
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+void JsonPersistence::saveCache(const std::unordered_map<int, Account>& accounts, std::uint64_t checksum) const {
+    try {
+        BinaryPersistence(cacheFile_).save(accounts, checksum);
+    } catch (const std::exception&) {
+        // Only a speed-up: without it the next load parses the JSON.
+        std::remove(cacheFile_.c_str());
+    }
+}
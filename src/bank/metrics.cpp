@@ -0,0 +1,254 @@
+// metrics.cpp
+#include "metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace metrics {
+
+namespace {
+
+constexpr const char* kCounterNames[kCounters] = {
+    "accounts_created",
+    "accounts_deleted",
+    "deposits",
+    "withdrawals",
+    "transfers",
+    "batch_operations",
+    "posted_accounts",
+    "history_entries_spilled",
+    "history_spill_failures",
+    "json_cache_hits",
+    "json_cache_misses",
+    "bridge_requests",
+    "bridge_errors",
+    "server_requests",
+    "server_errors",
+    "accounts_faulted_in",
+    "accounts_evicted",
+};
+
+constexpr const char* kTimerNames[kTimers] = {
+    "create_account",
+    "deposit",
+    "withdraw",
+    "transfer",
+    "posting_run",
+    "json_save",
+    "json_load",
+    "bridge_request",
+    "server_request",
+};
+
+constexpr const char* kTimerHelp[kTimers] = {
+    "Time spent in Bank::createAccount (sampled).",
+    "Time spent in Bank::deposit (sampled).",
+    "Time spent in Bank::withdraw (sampled).",
+    "Time spent in Bank::transfer (sampled).",
+    "Time spent in one Bank::applyPostings call.",
+    "Time spent writing the JSON snapshot.",
+    "Time spent loading the JSON snapshot.",
+    "Time from a BankBridge call until its job has run on the worker.",
+    "Time BankServer spends running one request (sampled).",
+};
+
+// Prometheus bucket bounds in seconds; the fine HDR buckets are folded into these.
+constexpr double kExportBounds[] = {
+    250e-9, 500e-9, 1e-6, 2.5e-6, 5e-6, 10e-6, 25e-6, 50e-6, 100e-6, 250e-6, 500e-6,
+    1e-3, 2.5e-3, 5e-3, 10e-3, 25e-3, 50e-3, 100e-3, 250e-3, 500e-3, 1.0, 2.5, 5.0, 10.0,
+};
+
+class Registry {
+public:
+    ThreadSlots& add() {
+        auto slots = std::make_unique<ThreadSlots>();
+        ThreadSlots& result = *slots;
+        std::lock_guard lock(mutex_);
+        live_.push_back(std::move(slots));
+        return result;
+    }
+
+    // Folds an exiting thread's numbers into retired_ so they survive it.
+    void remove(ThreadSlots& slots) {
+        std::lock_guard lock(mutex_);
+        addTo(retired_, slots);
+        live_.erase(std::find_if(live_.begin(), live_.end(),
+                                 [&slots](const auto& p) { return p.get() == &slots; }));
+    }
+
+    Snapshot collect() {
+        ThreadSlots sum;
+        std::lock_guard lock(mutex_);
+        addTo(sum, retired_);
+        for (const auto& slots : live_)
+            addTo(sum, *slots);
+
+        Snapshot snapshot;
+        double nsPerTick = nanosecondsPerTick();
+        for (std::size_t c = 0; c < kCounters; ++c)
+            snapshot.counters[c] = sum.counters[c].load(std::memory_order_relaxed);
+        for (std::size_t t = 0; t < kTimers; ++t) {
+            TimerSnapshot& timer = snapshot.timers[t];
+            for (std::size_t b = 0; b < kBuckets; ++b) {
+                timer.buckets[b] = sum.buckets[t][b].load(std::memory_order_relaxed);
+                timer.count += timer.buckets[b];
+            }
+            timer.totalNs = static_cast<double>(sum.totals[t].load(std::memory_order_relaxed)) * nsPerTick;
+        }
+        return snapshot;
+    }
+
+private:
+    static void addTo(ThreadSlots& into, const ThreadSlots& from) {
+        for (std::size_t c = 0; c < kCounters; ++c)
+            bump(into.counters[c], from.counters[c].load(std::memory_order_relaxed));
+        for (std::size_t t = 0; t < kTimers; ++t) {
+            for (std::size_t b = 0; b < kBuckets; ++b) {
+                if (std::uint64_t n = from.buckets[t][b].load(std::memory_order_relaxed))
+                    bump(into.buckets[t][b], n);
+            }
+            bump(into.totals[t], from.totals[t].load(std::memory_order_relaxed));
+        }
+    }
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadSlots>> live_;
+    ThreadSlots retired_;
+};
+
+// Leaked on purpose: threads may still exit after static destruction.
+Registry& registry() {
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+struct ThreadRegistration {
+    ThreadSlots* slots = nullptr;
+    ~ThreadRegistration() {
+        if (slots)
+            registry().remove(*slots);
+    }
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+using Clock = std::chrono::steady_clock;
+constexpr auto kCalibrationTime = std::chrono::milliseconds(20);
+// Both clocks at static initialization, so the calibration interval has
+// usually passed by the time anything reads a timer, and nobody sleeps
+// (getMetrics, for one, runs on the GUI thread).
+const Clock::time_point kWallAtLoad = Clock::now();
+const std::uint64_t kTicksAtLoad = ticks();
+#endif
+
+double measureNanosecondsPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+    const auto elapsed = Clock::now() - kWallAtLoad;
+    if (elapsed < kCalibrationTime)
+        std::this_thread::sleep_for(kCalibrationTime - elapsed);
+    std::uint64_t tickEnd = ticks();
+    auto wallEnd = Clock::now();
+    double ns =
+        static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(wallEnd - kWallAtLoad).count());
+    return tickEnd > kTicksAtLoad ? ns / static_cast<double>(tickEnd - kTicksAtLoad) : 1.0;
+#else
+    using Period = std::chrono::steady_clock::period;
+    return 1e9 * static_cast<double>(Period::num) / static_cast<double>(Period::den);
+#endif
+}
+
+std::string formatDouble(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+} // namespace
+
+const char* name(Counter counter) {
+    return kCounterNames[static_cast<std::size_t>(counter)];
+}
+
+const char* name(Timer timer) {
+    return kTimerNames[static_cast<std::size_t>(timer)];
+}
+
+std::uint64_t bucketLowerBound(std::size_t bucket) {
+    if (bucket < kSubBuckets)
+        return bucket;
+    std::size_t exponent = bucket / kSubBuckets + kSubBucketBits - 1;
+    std::uint64_t sub = bucket % kSubBuckets;
+    return (kSubBuckets + sub) << (exponent - kSubBucketBits);
+}
+
+ThreadSlots& registerThread() {
+    thread_local ThreadRegistration registration;
+    if (!registration.slots)
+        registration.slots = &registry().add();
+    return *registration.slots;
+}
+
+double TimerSnapshot::percentileNs(double q) const {
+    if (count == 0)
+        return 0;
+    auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+    rank = std::max<std::uint64_t>(rank, 1);
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < kBuckets; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            // Middle of the bucket: within half a bucket width of the truth.
+            double low = static_cast<double>(bucketLowerBound(b));
+            double high = b + 1 < kBuckets ? static_cast<double>(bucketLowerBound(b + 1)) : low * 2;
+            return (low + high) / 2 * nanosecondsPerTick();
+        }
+    }
+    return 0;
+}
+
+Snapshot collect() {
+    return registry().collect();
+}
+
+double nanosecondsPerTick() {
+    static const double value = measureNanosecondsPerTick();
+    return value;
+}
+
+std::string toPrometheus(const Snapshot& snapshot) {
+    std::string out;
+    out.reserve(8192);
+    for (std::size_t c = 0; c < kCounters; ++c) {
+        std::string metric = std::string("bank_") + kCounterNames[c] + "_total";
+        out += "# TYPE " + metric + " counter\n";
+        out += metric + ' ' + std::to_string(snapshot.counters[c]) + '\n';
+    }
+
+    const double nsPerTick = nanosecondsPerTick();
+    for (std::size_t t = 0; t < kTimers; ++t) {
+        const TimerSnapshot& timer = snapshot.timers[t];
+        std::string metric = std::string("bank_") + kTimerNames[t] + "_seconds";
+        out += "# HELP " + metric + ' ' + kTimerHelp[t] + '\n';
+        out += "# TYPE " + metric + " histogram\n";
+
+        std::uint64_t cumulative = 0;
+        std::size_t b = 0;
+        for (double bound : kExportBounds) {
+            // A fine bucket counts towards `le` when it lies entirely below it.
+            for (; b + 1 < kBuckets &&
+                   static_cast<double>(bucketLowerBound(b + 1)) * nsPerTick * 1e-9 <= bound; ++b)
+                cumulative += timer.buckets[b];
+            out += metric + "_bucket{le=\"" + formatDouble(bound) + "\"} " + std::to_string(cumulative) + '\n';
+        }
+        out += metric + "_bucket{le=\"+Inf\"} " + std::to_string(timer.count) + '\n';
+        out += metric + "_sum " + formatDouble(timer.totalNs * 1e-9) + '\n';
+        out += metric + "_count " + std::to_string(timer.count) + '\n';
+    }
+    return out;
+}
+
+} // namespace metrics
@@ -0,0 +1,94 @@
+// metrics_exporter.cpp
+#include "metrics_exporter.h"
+#include "atomic_file.h"
+#include "metrics.h"
+#include "unix_socket.h"
+#include <cerrno>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+void closeFd(int& fd) {
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(MetricsExportOptions options) : options_(std::move(options)) {
+    if (!options_.socketPath.empty())
+        listenFd_ = listenOnUnixSocket(options_.socketPath, 16);
+    if (::pipe2(wakeFds_, O_CLOEXEC) != 0) {
+        closeFd(listenFd_);
+        throw std::runtime_error("Cannot create metrics exporter pipe");
+    }
+    thread_ = std::thread(&MetricsExporter::run, this);
+}
+
+MetricsExporter::~MetricsExporter() {
+    char byte = 0;
+    (void)::write(wakeFds_[1], &byte, 1);
+    thread_.join();
+    writeFile();
+    if (listenFd_ >= 0) {
+        closeFd(listenFd_);
+        ::unlink(options_.socketPath.c_str());
+    }
+    closeFd(wakeFds_[0]);
+    closeFd(wakeFds_[1]);
+}
+
+void MetricsExporter::run() {
+    using Clock = std::chrono::steady_clock;
+    auto nextWrite = Clock::now();
+    for (;;) {
+        auto now = Clock::now();
+        if (now >= nextWrite) {
+            writeFile();
+            nextWrite = now + options_.interval;
+        }
+        pollfd fds[2] = {{wakeFds_[0], POLLIN, 0}, {listenFd_, POLLIN, 0}};
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextWrite - now).count();
+        int ready = ::poll(fds, listenFd_ >= 0 ? 2 : 1, options_.textFile.empty() ? -1 : static_cast<int>(wait) + 1);
+        if (ready < 0 && errno != EINTR)
+            return;
+        if (fds[0].revents)
+            return;
+        if (listenFd_ >= 0 && (fds[1].revents & POLLIN))
+            serveClient();
+    }
+}
+
+void MetricsExporter::writeFile() const {
+    if (options_.textFile.empty())
+        return;
+    try {
+        // Rewritten every interval anyway; not worth a sync.
+        replaceFileAtomically(options_.textFile, {metrics::toPrometheus(metrics::collect())}, Durability::Unsynced);
+    } catch (const std::exception& e) {
+        std::cerr << "Metrics export failed: " << e.what() << std::endl;
+    }
+}
+
+void MetricsExporter::serveClient() const {
+    int client = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0)
+        return;
+    // The dump is a few kilobytes; a reader too slow to take it is dropped.
+    timeval timeout{1, 0};
+    ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    std::string text = metrics::toPrometheus(metrics::collect());
+    for (std::size_t sent = 0; sent < text.size();) {
+        ssize_t n = ::send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            break;
+        sent += static_cast<std::size_t>(n);
+    }
+    ::close(client);
+}
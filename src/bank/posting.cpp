@@ -0,0 +1,198 @@
+// posting.cpp
+#include "posting.h"
+#include "parallel_chunks.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+__extension__ using Wide = __int128;
+
+constexpr std::int64_t kMillion = 1000000;
+// Percent with four decimals is a whole number of parts per million.
+using Percent = BasicMoney<10000>;
+
+std::string trim(const std::string& text) {
+    std::size_t begin = 0;
+    std::size_t end = text.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin])))
+        ++begin;
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1])))
+        --end;
+    return text.substr(begin, end - begin);
+}
+
+bool fits(Wide value) {
+    return value >= std::numeric_limits<std::int64_t>::min() && value <= std::numeric_limits<std::int64_t>::max();
+}
+
+void accumulate(Money& total, Money amount) noexcept {
+    std::int64_t sum;
+    if (__builtin_add_overflow(total.minorUnits(), amount.minorUnits(), &sum))
+        sum = amount.minorUnits() < 0 ? std::numeric_limits<std::int64_t>::min()
+                                      : std::numeric_limits<std::int64_t>::max();
+    total = Money::fromMinorUnits(sum);
+}
+
+PostingRule parseRule(const std::string& text, std::size_t line) {
+    auto fail = [line](const std::string& message) {
+        return std::invalid_argument("Posting schedule line " + std::to_string(line) + ": " + message);
+    };
+    std::vector<std::string> fields;
+    std::stringstream stream(text);
+    for (std::string field; std::getline(stream, field, ',');)
+        fields.push_back(trim(field));
+    if (fields.size() != 4)
+        throw fail("expected minBalance,maxBalance,ratePercent,fee");
+
+    PostingRule rule;
+    if (!fields[0].empty() && !Money::parse(fields[0], rule.minBalance))
+        throw fail("invalid minimum balance");
+    if (!fields[1].empty() && !Money::parse(fields[1], rule.maxBalance))
+        throw fail("invalid maximum balance");
+    Percent rate;
+    if (!Percent::parse(fields[2], rate))
+        throw fail("invalid rate");
+    rule.ratePpm = rate.minorUnits();
+    if (!Money::parse(fields[3], rule.fee) || rule.fee < Money())
+        throw fail("invalid fee");
+    if (rule.maxBalance <= rule.minBalance)
+        throw fail("empty balance range");
+    return rule;
+}
+
+} // namespace
+
+const PostingRule* PostingSchedule::ruleFor(Money balance) const noexcept {
+    for (const PostingRule& rule : rules)
+        if (balance >= rule.minBalance && balance < rule.maxBalance)
+            return &rule;
+    return nullptr;
+}
+
+PostingSchedule PostingSchedule::parse(const std::string& text) {
+    PostingSchedule schedule;
+    std::stringstream stream(text);
+    std::size_t line = 0;
+    for (std::string raw; std::getline(stream, raw);) {
+        ++line;
+        std::string trimmed = trim(raw);
+        if (trimmed.empty() || trimmed[0] == '#')
+            continue;
+        if (schedule.rules.empty() && std::isalpha(static_cast<unsigned char>(trimmed[0])))
+            continue;  // header row
+        schedule.rules.push_back(parseRule(trimmed, line));
+    }
+    return schedule;
+}
+
+PostingSchedule PostingSchedule::load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open())
+        throw std::runtime_error("Error opening posting schedule: " + filename);
+    std::stringstream text;
+    text << file.rdbuf();
+    return parse(text.str());
+}
+
+void PostingReport::merge(PostingReport&& other) {
+    posted += other.posted;
+    unchanged += other.unchanged;
+    skipped += other.skipped;
+    failed.insert(failed.end(), other.failed.begin(), other.failed.end());
+    accumulate(interest, other.interest);
+    accumulate(fees, other.fees);
+    accumulate(waived, other.waived);
+}
+
+Timestamp postingTimestamp() noexcept {
+    const Timestamp asOf = currentTimestamp() + std::chrono::microseconds(1);
+    while (currentTimestamp() < asOf)
+        std::this_thread::yield();
+    return asOf;
+}
+
+PostingOutcome postAccount(Account& account, const PostingSchedule& schedule, Timestamp asOf,
+                           PostingReport& report) noexcept {
+    if (account.lastOperationTime() >= asOf)
+        return PostingOutcome::Skipped;
+    const PostingRule* rule = schedule.ruleFor(account.balance());
+    if (!rule)
+        return PostingOutcome::Unchanged;
+
+    Wide product = static_cast<Wide>(account.balance().minorUnits()) * rule->ratePpm;
+    Wide interest = (product + (product < 0 ? -kMillion / 2 : kMillion / 2)) / kMillion;
+    Wide balance = account.balance().minorUnits() + interest;
+    Wide fee = std::min<Wide>(rule->fee.minorUnits(), std::max<Wide>(balance, 0));
+    balance -= fee;
+    if (!fits(interest) || !fits(balance) || !fits(interest - fee))
+        return PostingOutcome::Failed;
+
+    accumulate(report.waived, rule->fee - Money::fromMinorUnits(static_cast<std::int64_t>(fee)));
+    if (interest == 0 && fee == 0)
+        return PostingOutcome::Unchanged;
+    accumulate(report.interest, Money::fromMinorUnits(static_cast<std::int64_t>(interest)));
+    accumulate(report.fees, Money::fromMinorUnits(static_cast<std::int64_t>(fee)));
+    account.setBalance(Money::fromMinorUnits(static_cast<std::int64_t>(balance)));
+    account.updateOperationInfo(OperationType::Posting, asOf);
+    return PostingOutcome::Posted;
+}
+
+PostingReport runPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint, Timestamp asOf,
+                          const PostingProgress& progress, const std::function<Account*(int)>& lookup,
+                          const std::function<void(Account&, Money)>& posted,
+                          const std::function<void(const PostingSegment&)>& record) {
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    PostingReport report;
+    while (!checkpoint.done()) {
+        const int begin = checkpoint.nextAccountId;
+        const int end = begin + std::min(kPostingChunk, checkpoint.endAccountId - begin);
+        if (record)
+            record(PostingSegment{begin, end, asOf});
+        // A small book is not worth waking threads for.
+        const unsigned workers = end - begin < 4096 ? 1 : cores;
+        std::vector<PostingReport> partials(workers);
+        forEachChunk(static_cast<std::size_t>(end - begin), workers,
+                     [&](unsigned worker, std::size_t first, std::size_t last) {
+            PostingReport& partial = partials[worker];
+            for (std::size_t offset = first; offset < last; ++offset) {
+                int accountId = begin + static_cast<int>(offset);
+                Account* account = lookup(accountId);
+                if (!account)
+                    continue;
+                const Money before = account->balance();
+                switch (postAccount(*account, schedule, asOf, partial)) {
+                case PostingOutcome::Posted:
+                    ++partial.posted;
+                    if (posted)
+                        posted(*account, account->balance() - before);
+                    break;
+                case PostingOutcome::Unchanged: ++partial.unchanged; break;
+                case PostingOutcome::Skipped: ++partial.skipped; break;
+                case PostingOutcome::Failed: partial.failed.push_back(accountId); break;
+                }
+            }
+        });
+        for (auto& partial : partials)
+            report.merge(std::move(partial));
+        checkpoint.nextAccountId = end;
+        if (progress && !progress(checkpoint))
+            break;
+    }
+    std::sort(report.failed.begin(), report.failed.end());
+    report.complete = checkpoint.done();
+    return report;
+}
+
+void replayPostings(std::unordered_map<int, Account>& accounts, const PostingSchedule& schedule,
+                    const PostingSegment& segment) {
+    PostingReport ignored;
+    for (auto& [accountId, account] : accounts)
+        if (accountId >= segment.fromAccountId && accountId < segment.toAccountId)
+            postAccount(account, schedule, segment.asOf, ignored);
+}
@@ -0,0 +1,331 @@
+// remote_bank.cpp
+#include "remote_bank.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace bank_protocol;
+
+namespace {
+
+constexpr std::size_t kReadSize = 64 * 1024;
+
+std::string messageOf(std::string_view errorBody) {
+    try {
+        Reader in(errorBody);
+        return std::string(in.getString());
+    } catch (const ProtocolError&) {
+        return "Malformed error reply from the bank server";
+    }
+}
+
+[[noreturn]] void throwError(Status status, std::string_view body) {
+    const std::string message = messageOf(body);
+    switch (status) {
+    case Status::InvalidArgument:
+        throw std::invalid_argument(message);
+    case Status::Overflow:
+        throw std::overflow_error(message);
+    case Status::BadRequest:
+        throw std::runtime_error("Bank server rejected the request: " + message);
+    default:
+        throw std::runtime_error(message);
+    }
+}
+
+} // namespace
+
+RemoteBank::RemoteBank(const std::string& socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Bank socket path too long: " + socketPath);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0)
+        throw std::runtime_error("Cannot create bank socket: " + std::string(std::strerror(errno)));
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        int error = errno;
+        ::close(fd_);
+        throw std::runtime_error("Cannot connect to the bank server at " + socketPath + ": " + std::strerror(error));
+    }
+}
+
+RemoteBank::~RemoteBank() {
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+void RemoteBank::fail(const std::string& message) const {
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+    in_.clear();
+    consumed_ = 0;
+    throw std::runtime_error(message);
+}
+
+void RemoteBank::receive(int flags) const {
+    const std::size_t used = in_.size();
+    in_.resize(used + kReadSize);
+    ssize_t n;
+    do
+        n = ::recv(fd_, &in_[used], kReadSize, flags);
+    while (n < 0 && errno == EINTR);
+    in_.resize(used + (n > 0 ? static_cast<std::size_t>(n) : 0));
+    if (n == 0)
+        fail("The bank server closed the connection");
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        fail("Lost the connection to the bank server: " + std::string(std::strerror(errno)));
+}
+
+template <typename OnReply>
+void RemoteBank::exchange(const std::string& requests, std::uint32_t firstTag, std::size_t count,
+                          OnReply&& onReply) const {
+    if (fd_ < 0)
+        throw std::runtime_error("Not connected to the bank server");
+    in_.erase(0, consumed_);
+    consumed_ = 0;
+    std::size_t sent = 0;
+    std::size_t received = 0;
+    while (received < count) {
+        if (sent < requests.size()) {
+            ssize_t n = ::send(fd_, requests.data() + sent, requests.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) {
+                sent += static_cast<std::size_t>(n);
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                fail("Lost the connection to the bank server: " + std::string(std::strerror(errno)));
+            // The socket is full: wait for it to drain or for replies, which
+            // the server may be waiting for us to read.
+            pollfd ready{fd_, POLLIN | POLLOUT, 0};
+            if (::poll(&ready, 1, -1) < 0 && errno != EINTR)
+                fail("Lost the connection to the bank server: " + std::string(std::strerror(errno)));
+            if (!(ready.revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+        }
+        // Block for replies only once everything is sent.
+        receive(sent < requests.size() ? MSG_DONTWAIT : 0);
+
+        Frame frame;
+        try {
+            while (received < count && nextFrame(std::string_view(in_).substr(consumed_), frame)) {
+                if (frame.tag != firstTag + received)
+                    throw ProtocolError("Bank server reply out of order");
+                consumed_ += frame.size;
+                ++received;
+                onReply(static_cast<Status>(frame.code), frame.body);
+            }
+        } catch (const ProtocolError& e) {
+            fail(e.what());
+        }
+        in_.erase(0, consumed_);
+        consumed_ = 0;
+    }
+}
+
+template <typename Encode, typename Decode>
+void RemoteBank::call(Op op, Encode&& encode, Decode&& decode) const {
+    std::lock_guard lock(mutex_);
+    out_.clear();
+    Writer request(out_);
+    const std::uint32_t tag = nextTag_++;
+    request.beginFrame(tag, static_cast<std::uint8_t>(op));
+    encode(request);
+    request.endFrame();
+    exchange(out_, tag, 1, [&](Status status, std::string_view body) {
+        if (status != Status::Ok)
+            throwError(status, body);
+        Reader in(body);
+        decode(in);
+        in.finish();
+    });
+}
+
+namespace {
+
+void noReply(Reader&) {}
+
+} // namespace
+
+int RemoteBank::createAccount(const std::string& personName, const std::string& cardId, Money initialBalance) {
+    int accountId = 0;
+    call(
+        Op::CreateAccount,
+        [&](Writer& out) {
+            out.putString(personName);
+            out.putString(cardId);
+            out.putMoney(initialBalance);
+        },
+        [&](Reader& in) { accountId = in.get<std::int32_t>(); });
+    return accountId;
+}
+
+bool RemoteBank::deleteAccount(int accountId) {
+    bool deleted = false;
+    call(
+        Op::DeleteAccount, [&](Writer& out) { out.put(static_cast<std::int32_t>(accountId)); },
+        [&](Reader& in) { deleted = in.get<std::uint8_t>() != 0; });
+    return deleted;
+}
+
+void RemoteBank::deposit(int accountId, Money amount) {
+    call(
+        Op::Deposit,
+        [&](Writer& out) {
+            out.put(static_cast<std::int32_t>(accountId));
+            out.putMoney(amount);
+        },
+        noReply);
+}
+
+void RemoteBank::withdraw(int accountId, Money amount) {
+    call(
+        Op::Withdraw,
+        [&](Writer& out) {
+            out.put(static_cast<std::int32_t>(accountId));
+            out.putMoney(amount);
+        },
+        noReply);
+}
+
+Account RemoteBank::getAccount(int accountId) const {
+    Account account(0);
+    call(
+        Op::GetAccount, [&](Writer& out) { out.put(static_cast<std::int32_t>(accountId)); },
+        [&](Reader& in) { account = bank_protocol::getAccount(in); });
+    return account;
+}
+
+Money RemoteBank::getBalance(int accountId) const {
+    Money balance;
+    call(
+        Op::GetBalance, [&](Writer& out) { out.put(static_cast<std::int32_t>(accountId)); },
+        [&](Reader& in) { balance = in.getMoney(); });
+    return balance;
+}
+
+void RemoteBank::transfer(int fromAccountId, int toAccountId, Money amount) {
+    call(
+        Op::Transfer,
+        [&](Writer& out) {
+            out.put(static_cast<std::int32_t>(fromAccountId));
+            out.put(static_cast<std::int32_t>(toAccountId));
+            out.putMoney(amount);
+        },
+        noReply);
+}
+
+void RemoteBank::transferMany(const std::vector<Transfer>& transfers) {
+    call(
+        Op::TransferMany,
+        [&](Writer& out) {
+            out.put(static_cast<std::uint32_t>(transfers.size()));
+            for (const Transfer& transfer : transfers) {
+                out.put(static_cast<std::int32_t>(transfer.fromAccountId));
+                out.put(static_cast<std::int32_t>(transfer.toAccountId));
+                out.putMoney(transfer.amount);
+            }
+        },
+        noReply);
+}
+
+BatchReport RemoteBank::applyBatch(const std::vector<BatchOperation>& operations) {
+    BatchReport report;
+    call(
+        Op::ApplyBatch,
+        [&](Writer& out) {
+            out.put(static_cast<std::uint32_t>(operations.size()));
+            for (const BatchOperation& op : operations) {
+                out.put(static_cast<std::uint64_t>(op.line));
+                out.put(static_cast<std::uint8_t>(op.type));
+                out.put(static_cast<std::int32_t>(op.accountId));
+                out.putMoney(op.amount);
+            }
+        },
+        [&](Reader& in) { report = getBatchReport(in); });
+    return report;
+}
+
+PostingReport RemoteBank::applyPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint,
+                                        const PostingProgress& progress) {
+    PostingReport report;
+    for (;;) {
+        PostingReport chunk;
+        call(
+            Op::PostChunk,
+            [&](Writer& out) {
+                putSchedule(out, schedule);
+                out.put(static_cast<std::int32_t>(checkpoint.nextAccountId));
+                out.put(static_cast<std::int32_t>(checkpoint.endAccountId));
+            },
+            [&](Reader& in) {
+                checkpoint.nextAccountId = in.get<std::int32_t>();
+                checkpoint.endAccountId = in.get<std::int32_t>();
+                chunk = getPostingReport(in);
+            });
+        report.merge(std::move(chunk));
+        const bool proceed = !progress || progress(checkpoint);
+        if (checkpoint.done() || !proceed)
+            break;
+    }
+    report.complete = checkpoint.done();
+    return report;
+}
+
+void RemotePipeline::deposit(int accountId, Money amount) {
+    requests_.push_back({Op::Deposit, accountId, 0, amount});
+}
+
+void RemotePipeline::withdraw(int accountId, Money amount) {
+    requests_.push_back({Op::Withdraw, accountId, 0, amount});
+}
+
+void RemotePipeline::transfer(int fromAccountId, int toAccountId, Money amount) {
+    requests_.push_back({Op::Transfer, fromAccountId, toAccountId, amount});
+}
+
+void RemotePipeline::getBalance(int accountId) {
+    requests_.push_back({Op::GetBalance, accountId, 0, Money()});
+}
+
+std::vector<PipelineResult> RemotePipeline::run() {
+    std::vector<Request> requests;
+    requests.swap(requests_);
+    std::vector<PipelineResult> results(requests.size());
+    if (requests.empty())
+        return results;
+
+    std::lock_guard lock(bank_.mutex_);
+    std::string& frames = bank_.out_;
+    frames.clear();
+    Writer out(frames);
+    const std::uint32_t firstTag = bank_.nextTag_;
+    for (const Request& request : requests) {
+        out.beginFrame(bank_.nextTag_++, static_cast<std::uint8_t>(request.op));
+        out.put(static_cast<std::int32_t>(request.accountId));
+        if (request.op == Op::Transfer)
+            out.put(static_cast<std::int32_t>(request.toAccountId));
+        if (request.op != Op::GetBalance)
+            out.putMoney(request.amount);
+        out.endFrame();
+    }
+
+    std::size_t next = 0;
+    bank_.exchange(frames, firstTag, requests.size(), [&](Status status, std::string_view body) {
+        PipelineResult& result = results[next];
+        result.ok = status == Status::Ok;
+        if (!result.ok)
+            result.error = messageOf(body);
+        else if (requests[next].op == Op::GetBalance)
+            result.balance = Reader(body).getMoney();
+        ++next;
+    });
+    return results;
+}
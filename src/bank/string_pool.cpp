@@ -0,0 +1,218 @@
+// string_pool.cpp
+#include "string_pool.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using string_pool::detail::Header;
+
+constexpr std::size_t kShards = 16;
+constexpr std::size_t kChunkSize = 256 * 1024;
+// Records are rounded up to this, which keeps the headers aligned and makes
+// a free list per multiple of it.
+constexpr std::size_t kGranule = 8;
+// Longer records are allocated and freed one by one.
+constexpr std::size_t kMaxChunked = 256;
+static_assert(sizeof(Header) == kGranule, "pooled string header layout changed");
+
+std::size_t hashOf(std::string_view text) noexcept {
+    return std::hash<std::string_view>{}(text);
+}
+
+std::string_view textOf(const char* data) noexcept {
+    return {data, reinterpret_cast<const Header*>(data - sizeof(Header))->length};
+}
+
+std::size_t recordSize(std::size_t length) noexcept {
+    return (sizeof(Header) + length + kGranule - 1) / kGranule * kGranule;
+}
+
+} // namespace
+
+class StringPoolShard {
+public:
+    PooledString intern(std::string_view text, std::size_t hash) {
+        std::lock_guard lock(mutex_);
+        if ((interned_ + 1) * 2 > table_.size())
+            grow();
+        const std::size_t mask = table_.size() - 1;
+        // The shard was picked by the high bits; probe with the low ones.
+        for (std::size_t at = hash & mask;; at = (at + 1) & mask) {
+            const char* entry = table_[at];
+            if (!entry) {
+                table_[at] = copy(text);
+                ++interned_;
+                return PooledString(table_[at]);
+            }
+            if (textOf(entry) == text) {
+                reinterpret_cast<Header*>(const_cast<char*>(entry) - sizeof(Header))
+                    ->refs.fetch_add(1, std::memory_order_relaxed);
+                return PooledString(entry);
+            }
+        }
+    }
+
+    void release(const char* data) noexcept {
+        auto* header = reinterpret_cast<Header*>(const_cast<char*>(data) - sizeof(Header));
+        std::lock_guard lock(mutex_);
+        // Someone may have interned the string again since the count was read.
+        if (header->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        remove(data);
+        --interned_;
+        const std::size_t size = recordSize(header->length);
+        usedBytes_ -= size;
+        header->~Header();
+        char* record = reinterpret_cast<char*>(header);
+        if (size > kMaxChunked) {
+            delete[] record;
+            arenaBytes_ -= size;
+            return;
+        }
+        freeLists_[size / kGranule].push_back(record);
+        freeBytes_ += size;
+    }
+
+    void addTo(string_pool::Stats& stats) {
+        std::lock_guard lock(mutex_);
+        stats.arenaBytes += arenaBytes_;
+        stats.usedBytes += usedBytes_;
+        stats.freeBytes += freeBytes_;
+        stats.strings += interned_;
+        stats.tableBytes += table_.size() * sizeof(const char*);
+    }
+
+private:
+    // Places a header, counted once, and the characters; returns the
+    // characters.
+    const char* copy(std::string_view text) {
+        if (text.size() > UINT32_MAX - kGranule)
+            throw std::length_error("String too long for the pool");
+        const std::size_t size = recordSize(text.size());
+        char* record = allocate(size);
+        new (record) Header{{1}, static_cast<std::uint32_t>(text.size())};
+        std::memcpy(record + sizeof(Header), text.data(), text.size());
+        usedBytes_ += size;
+        return record + sizeof(Header);
+    }
+
+    char* allocate(std::size_t size) {
+        if (size > kMaxChunked) {
+            char* record = new char[size];
+            arenaBytes_ += size;
+            return record;
+        }
+        std::vector<char*>& freeList = freeLists_[size / kGranule];
+        if (!freeList.empty()) {
+            char* record = freeList.back();
+            freeList.pop_back();
+            freeBytes_ -= size;
+            return record;
+        }
+        // Room for this record on its free list once it is released, so
+        // release() never allocates.
+        if (++carved_[size / kGranule] > freeList.capacity())
+            freeList.reserve(std::max<std::size_t>(freeList.capacity() * 2, 16));
+        if (size > left_) {
+            chunks_.emplace_back(new char[kChunkSize]);  // left uninitialized
+            arenaBytes_ += kChunkSize;
+            next_ = chunks_.back().get();
+            left_ = kChunkSize;
+        }
+        char* record = next_;
+        next_ += size;
+        left_ -= size;
+        return record;
+    }
+
+    // Backward-shift deletion, so probes never need tombstones.
+    void remove(const char* data) noexcept {
+        const std::size_t mask = table_.size() - 1;
+        std::size_t hole = hashOf(textOf(data)) & mask;
+        while (table_[hole] != data)
+            hole = (hole + 1) & mask;
+        for (std::size_t at = (hole + 1) & mask; table_[at]; at = (at + 1) & mask) {
+            const std::size_t home = hashOf(textOf(table_[at])) & mask;
+            // Entries whose home lies cyclically in (hole, at] stay put.
+            if (((at - home) & mask) >= ((at - hole) & mask)) {
+                table_[hole] = table_[at];
+                hole = at;
+            }
+        }
+        table_[hole] = nullptr;
+    }
+
+    void grow() {
+        std::vector<const char*> old(std::max<std::size_t>(table_.size() * 2, 64), nullptr);
+        old.swap(table_);
+        const std::size_t mask = table_.size() - 1;
+        for (const char* entry : old) {
+            if (!entry)
+                continue;
+            std::size_t at = hashOf(textOf(entry)) & mask;
+            while (table_[at])
+                at = (at + 1) & mask;
+            table_[at] = entry;
+        }
+    }
+
+    static constexpr std::size_t kClasses = kMaxChunked / kGranule + 1;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char* next_ = nullptr;
+    std::size_t left_ = 0;
+    std::array<std::vector<char*>, kClasses> freeLists_;
+    std::array<std::size_t, kClasses> carved_{};  // records cut from chunks, per class
+    std::vector<const char*> table_;  // power-of-two size, at most half full
+    std::size_t interned_ = 0;
+    std::size_t arenaBytes_ = 0;
+    std::size_t usedBytes_ = 0;
+    std::size_t freeBytes_ = 0;
+};
+
+namespace string_pool {
+
+namespace {
+
+// Never destroyed: handles in other static objects may be released after
+// it would have been.
+std::array<StringPoolShard, kShards>& shards() {
+    static auto* pool = new std::array<StringPoolShard, kShards>;
+    return *pool;
+}
+
+StringPoolShard& shardFor(std::size_t hash) {
+    return shards()[(hash >> (std::numeric_limits<std::size_t>::digits - 8)) % kShards];
+}
+
+} // namespace
+
+PooledString intern(std::string_view text) {
+    if (text.empty())
+        return PooledString();
+    const std::size_t hash = hashOf(text);
+    return shardFor(hash).intern(text, hash);
+}
+
+Stats stats() {
+    Stats result;
+    for (StringPoolShard& shard : shards())
+        shard.addTo(result);
+    return result;
+}
+
+void detail::releaseLast(const char* data) noexcept {
+    shardFor(hashOf(textOf(data))).release(data);
+}
+
+} // namespace string_pool
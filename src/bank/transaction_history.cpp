@@ -0,0 +1,377 @@
+// transaction_history.cpp
+#include "transaction_history.h"
+#include "atomic_file.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[4] = {'B', 'N', 'K', 'H'};
+constexpr std::uint32_t kVersion = 1;
+// Entries spilled at a time; also the most a ring holds beyond its retention.
+constexpr std::size_t kSpillBlock = 4096;
+
+struct FileHeader {
+    char magic[4];
+    std::uint32_t version;
+};
+static_assert(sizeof(FileHeader) == 8, "history header layout changed");
+
+struct BlockHeader {
+    std::uint64_t first;
+    std::uint32_t count;
+    std::uint32_t reserved;
+    std::int64_t minTime;
+    std::int64_t maxTime;
+};
+static_assert(sizeof(BlockHeader) == 32, "history block layout changed");
+
+// Bytes of one entry across the five columns.
+constexpr std::size_t kEntrySize = sizeof(std::int32_t) + sizeof(std::uint8_t) + 3 * sizeof(std::int64_t);
+
+std::int64_t toMicros(Timestamp timestamp) {
+    return static_cast<std::int64_t>(timestamp.time_since_epoch().count());
+}
+
+Timestamp fromMicros(std::int64_t micros) {
+    return Timestamp(std::chrono::microseconds(micros));
+}
+
+void readAll(int fd, char* data, std::size_t size, std::uint64_t offset, const std::string& filename) {
+    while (size > 0) {
+        ssize_t got = ::pread(fd, data, size, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            throw std::runtime_error("Error reading history: " + filename);
+        data += got;
+        size -= static_cast<std::size_t>(got);
+        offset += static_cast<std::uint64_t>(got);
+    }
+}
+
+template <typename T>
+void putColumn(std::vector<char>& buffer, const T* values, std::size_t count) {
+    const char* bytes = reinterpret_cast<const char*>(values);
+    buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+}
+
+template <typename T>
+const char* getColumn(const char* data, std::vector<T>& values, std::size_t count) {
+    values.resize(count);
+    std::memcpy(values.data(), data, count * sizeof(T));
+    return data + count * sizeof(T);
+}
+
+} // namespace
+
+TransactionHistory::TransactionHistory(const HistoryOptions& options)
+    : capacity_(std::max<std::size_t>(options.retainInMemory, 1) + kSpillBlock), spillFile_(options.spillFile) {
+    if (!spillFile_.empty())
+        openSpillFile();
+}
+
+TransactionHistory::~TransactionHistory() {
+    try {
+        flush();
+    } catch (...) {
+        // Nothing sensible to do during teardown; the newest entries are lost.
+    }
+    if (fd_ >= 0)
+        ::close(fd_);
+}
+
+void TransactionHistory::append(int accountId, OperationType type, Money amount, Timestamp time) {
+    if (accountId < 0)
+        throw std::invalid_argument("Negative account ID in history");
+    if (inMemory() == capacity_)
+        evict(kSpillBlock);
+
+    const std::uint64_t sequence = nextSequence_++;
+    const auto index = static_cast<std::size_t>(accountId);
+    if (index >= heads_.size())
+        heads_.resize(index + 1, 0);
+    const std::uint64_t prev = heads_[index];
+    heads_[index] = sequence;
+
+    const std::size_t at = slot(sequence);
+    if (at == ids_.size()) {
+        ids_.push_back(accountId);
+        types_.push_back(type);
+        amounts_.push_back(amount.minorUnits());
+        times_.push_back(toMicros(time));
+        prevs_.push_back(prev);
+    } else {
+        ids_[at] = accountId;
+        types_[at] = type;
+        amounts_[at] = amount.minorUnits();
+        times_[at] = toMicros(time);
+        prevs_[at] = prev;
+    }
+}
+
+std::vector<HistoryEntry> TransactionHistory::forAccount(int accountId, std::size_t limit,
+                                                         std::uint64_t before) const {
+    std::vector<HistoryEntry> result;
+    const std::uint64_t oldest = oldestAvailable();
+    std::uint64_t sequence = headFor(accountId);
+    std::uint64_t prev = 0;
+    if (before != 0 && before >= oldest && before < nextSequence_) {
+        // A cursor from an earlier page continues its chain directly.
+        if (entry(before, prev).accountId == accountId)
+            sequence = prev;
+    }
+    while (sequence >= oldest && sequence != 0 && result.size() < limit) {
+        HistoryEntry current = entry(sequence, prev);
+        if (before == 0 || sequence < before)
+            result.push_back(current);
+        sequence = prev;
+    }
+    return result;
+}
+
+std::vector<HistoryEntry> TransactionHistory::inRange(Timestamp from, Timestamp to, std::size_t limit) const {
+    std::vector<HistoryEntry> result;
+    const std::int64_t end = toMicros(to);
+    std::uint64_t prev = 0;
+    for (std::uint64_t sequence = lowerBound(toMicros(from)); sequence < nextSequence_ && result.size() < limit;
+         ++sequence) {
+        HistoryEntry current = entry(sequence, prev);
+        if (toMicros(current.time) >= end)
+            break;
+        result.push_back(current);
+    }
+    return result;
+}
+
+std::vector<HistoryEntry> TransactionHistory::forAccountInRange(int accountId, Timestamp from, Timestamp to,
+                                                                std::size_t limit) const {
+    std::vector<HistoryEntry> result;
+    const std::uint64_t oldest = oldestAvailable();
+    std::uint64_t prev = 0;
+    for (std::uint64_t sequence = headFor(accountId); sequence >= oldest && sequence != 0 && result.size() < limit;
+         sequence = prev) {
+        HistoryEntry current = entry(sequence, prev);
+        if (current.time < from)
+            break;
+        if (current.time < to)
+            result.push_back(current);
+    }
+    return result;
+}
+
+void TransactionHistory::flush() {
+    if (fd_ < 0)
+        return;
+    while (inMemory() > 0)
+        spill(std::min(inMemory(), kSpillBlock));
+    if (::fdatasync(fd_) != 0)
+        throw std::runtime_error("Error syncing history: " + spillFile_ + ": " + std::strerror(errno));
+}
+
+std::uint64_t TransactionHistory::headFor(int accountId) const noexcept {
+    const auto index = static_cast<std::size_t>(accountId);
+    return accountId >= 0 && index < heads_.size() ? heads_[index] : 0;
+}
+
+HistoryEntry TransactionHistory::entry(std::uint64_t sequence, std::uint64_t& prev) const {
+    HistoryEntry result;
+    result.sequence = sequence;
+    if (sequence >= memoryFirst_) {
+        const std::size_t at = slot(sequence);
+        result.accountId = ids_[at];
+        result.type = types_[at];
+        result.amount = Money::fromMinorUnits(amounts_[at]);
+        result.time = fromMicros(times_[at]);
+        prev = prevs_[at];
+    } else {
+        const BlockColumns& block = spilledBlock(sequence);
+        const auto at = static_cast<std::size_t>(sequence - block.first);
+        result.accountId = block.ids[at];
+        result.type = static_cast<OperationType>(block.types[at]);
+        result.amount = Money::fromMinorUnits(block.amounts[at]);
+        result.time = fromMicros(block.times[at]);
+        prev = block.prevs[at];
+    }
+    return result;
+}
+
+const TransactionHistory::BlockColumns& TransactionHistory::spilledBlock(std::uint64_t sequence) const {
+    if (sequence >= cache_.first && sequence - cache_.first < cache_.ids.size())
+        return cache_;
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), sequence,
+                               [](std::uint64_t value, const Block& block) { return value < block.first; });
+    if (it == blocks_.begin())
+        throw std::out_of_range("History entry no longer available");
+    const Block& block = *--it;
+
+    std::vector<char> data(block.count * kEntrySize);
+    readAll(fd_, data.data(), data.size(), block.offset, spillFile_);
+    cache_.ids.clear();  // invalid until every column is back
+    const char* at = data.data();
+    BlockColumns columns;
+    at = getColumn(at, columns.ids, block.count);
+    at = getColumn(at, columns.types, block.count);
+    at = getColumn(at, columns.amounts, block.count);
+    at = getColumn(at, columns.times, block.count);
+    getColumn(at, columns.prevs, block.count);
+    columns.first = block.first;
+    cache_ = std::move(columns);
+    return cache_;
+}
+
+std::uint64_t TransactionHistory::lowerBound(std::int64_t time) const {
+    auto block = std::partition_point(blocks_.begin(), blocks_.end(),
+                                      [time](const Block& b) { return b.maxTime < time; });
+    if (block != blocks_.end()) {
+        const BlockColumns& columns = spilledBlock(block->first);
+        auto at = std::lower_bound(columns.times.begin(), columns.times.end(), time);
+        return block->first + static_cast<std::uint64_t>(at - columns.times.begin());
+    }
+    std::uint64_t low = memoryFirst_;
+    std::uint64_t high = nextSequence_;
+    while (low < high) {
+        std::uint64_t mid = low + (high - low) / 2;
+        if (times_[slot(mid)] < time)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+void TransactionHistory::openSpillFile() {
+    fd_ = ::open(spillFile_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+        throw std::runtime_error("Error opening history: " + spillFile_ + ": " + std::strerror(errno));
+    struct stat st {};
+    if (::fstat(fd_, &st) != 0)
+        throw std::runtime_error("Error reading history: " + spillFile_ + ": " + std::strerror(errno));
+
+    const auto size = static_cast<std::uint64_t>(st.st_size);
+    if (size == 0) {
+        FileHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        writeAll(fd_, std::string_view(reinterpret_cast<const char*>(&header), sizeof(header)), spillFile_);
+        fileSize_ = sizeof(header);
+        return;
+    }
+
+    FileHeader header{};
+    if (size < sizeof(header))
+        throw std::runtime_error("Truncated history: " + spillFile_);
+    readAll(fd_, reinterpret_cast<char*>(&header), sizeof(header), 0, spillFile_);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion)
+        throw std::runtime_error("Not a history file: " + spillFile_);
+
+    // Rebuild the index from the account column of every intact block.
+    std::uint64_t offset = sizeof(header);
+    std::vector<std::int32_t> ids;
+    while (size - offset >= sizeof(BlockHeader)) {
+        BlockHeader block{};
+        readAll(fd_, reinterpret_cast<char*>(&block), sizeof(block), offset, spillFile_);
+        const std::uint64_t columnsOffset = offset + sizeof(block);
+        if (block.first != nextSequence_ || block.count == 0 || block.count > kSpillBlock ||
+            size - columnsOffset < block.count * kEntrySize)
+            break;
+        ids.resize(block.count);
+        readAll(fd_, reinterpret_cast<char*>(ids.data()), block.count * sizeof(std::int32_t), columnsOffset,
+                spillFile_);
+        for (std::uint32_t i = 0; i < block.count; ++i) {
+            const auto index = static_cast<std::size_t>(std::max(ids[i], 0));
+            if (index >= heads_.size())
+                heads_.resize(index + 1, 0);
+            heads_[index] = block.first + i;
+        }
+        blocks_.push_back({block.first, block.count, block.minTime, block.maxTime, columnsOffset});
+        nextSequence_ = block.first + block.count;
+        offset = columnsOffset + block.count * kEntrySize;
+    }
+    if (offset < size)
+        dropTornTail(fd_, offset, spillFile_);
+    fileSize_ = offset;
+    ringBase_ = memoryFirst_ = nextSequence_;
+}
+
+void TransactionHistory::evict(std::size_t count) {
+    count = std::min(count, inMemory());
+    if (count == 0)
+        return;
+    if (fd_ >= 0) {
+        try {
+            spill(count);
+            return;
+        } catch (const std::exception& ex) {
+            stopSpilling(ex.what());
+        }
+    }
+    memoryFirst_ += count;
+}
+
+void TransactionHistory::stopSpilling(const std::string& error) noexcept {
+    // A gap between the spilled blocks and the ring would break the chains
+    // that run through it, so the spilled blocks go out of reach as well.
+    // They stay in the file for the next run.
+    ::close(fd_);
+    fd_ = -1;
+    blocks_.clear();
+    cache_ = BlockColumns();
+    spillError_ = error;
+    BANK_METRIC_COUNT(HistorySpillFailures);
+}
+
+void TransactionHistory::spill(std::size_t count) {
+    // The oldest entries may wrap around the end of the ring; gather them
+    // column by column.
+    BlockHeader header{};
+    header.first = memoryFirst_;
+    header.count = static_cast<std::uint32_t>(count);
+    std::vector<std::pair<std::size_t, std::size_t>> runs;  // (slot, length)
+    for (std::size_t done = 0; done < count;) {
+        std::size_t at = slot(memoryFirst_ + done);
+        std::size_t length = std::min(count - done, ids_.size() - at);
+        runs.emplace_back(at, length);
+        done += length;
+    }
+    header.minTime = times_[slot(memoryFirst_)];
+    header.maxTime = times_[slot(memoryFirst_ + count - 1)];
+
+    std::vector<char> buffer;
+    buffer.reserve(sizeof(header) + count * kEntrySize);
+    buffer.insert(buffer.end(), reinterpret_cast<const char*>(&header),
+                  reinterpret_cast<const char*>(&header) + sizeof(header));
+    for (auto [at, length] : runs)
+        putColumn(buffer, ids_.data() + at, length);
+    for (auto [at, length] : runs)
+        putColumn(buffer, reinterpret_cast<const std::uint8_t*>(types_.data()) + at, length);
+    for (auto [at, length] : runs)
+        putColumn(buffer, amounts_.data() + at, length);
+    for (auto [at, length] : runs)
+        putColumn(buffer, times_.data() + at, length);
+    for (auto [at, length] : runs)
+        putColumn(buffer, prevs_.data() + at, length);
+
+    try {
+        appendRecords(fd_, fileSize_, std::string_view(buffer.data(), buffer.size()), spillFile_,
+                      Durability::Unsynced);
+    } catch (...) {
+        // The entries stay in memory. The file is back at fileSize_ unless it
+        // could not be cut back; then a reopen stops at the debris.
+        const off_t end = ::lseek(fd_, 0, SEEK_END);
+        if (end >= 0)
+            fileSize_ = static_cast<std::uint64_t>(end);
+        throw;
+    }
+    blocks_.push_back({header.first, header.count, header.minTime, header.maxTime, fileSize_ + sizeof(header)});
+    fileSize_ += buffer.size();
+    memoryFirst_ += count;
+    BANK_METRIC_ADD(HistorySpilled, count);
+}
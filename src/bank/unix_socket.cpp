@@ -0,0 +1,49 @@
+// unix_socket.cpp
+#include "unix_socket.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// True when `path` is a socket nobody listens on any more.
+bool isStaleSocket(const sockaddr_un& address) {
+    struct stat st {};
+    if (::lstat(address.sun_path, &st) != 0 || !S_ISSOCK(st.st_mode))
+        return false;
+    int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0)
+        return false;
+    const bool refused = ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 &&
+                         errno == ECONNREFUSED;
+    ::close(probe);
+    return refused;
+}
+
+} // namespace
+
+int listenOnUnixSocket(const std::string& path, int backlog, int flags) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Socket path too long: " + path);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | flags, 0);
+    if (fd < 0)
+        throw std::runtime_error("Cannot create socket " + path + ": " + std::strerror(errno));
+    auto bound = [&] { return ::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0; };
+    bool ok = bound();
+    if (!ok && errno == EADDRINUSE && isStaleSocket(address) && ::unlink(path.c_str()) == 0)
+        ok = bound();
+    if (!ok || ::listen(fd, backlog) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot listen on " + path + ": " + std::strerror(error));
+    }
+    return fd;
+}
@@ -0,0 +1,476 @@
+// workload.cpp
+#include "workload.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+constexpr const char* kOpNames[kWorkloadOps] = {"create", "delete", "deposit", "withdraw", "lookup"};
+
+constexpr const char* kFirstNames[] = {
+    "James", "Mary", "Mohamed", "Fatima", "Wei", "Li", "Maria", "Jose", "Anna", "Ahmed", "Olga", "David",
+    "Sarah", "Juan", "Yuki", "Hana", "Omar", "Laila", "Peter", "Elena", "Ivan", "Aisha", "Carlos", "Emma",
+};
+constexpr const char* kLastNames[] = {
+    "Smith", "Garcia", "Wang", "Hassan", "Kim", "Muller", "Rossi", "Silva", "Ivanov", "Nguyen", "Khan", "Brown",
+    "Lopez", "Sato", "Ali", "Novak", "Cohen", "Jones", "Martin", "Chen", "Ragab", "Haddad", "Costa", "Patel",
+};
+constexpr std::size_t kFirstNameCount = std::size(kFirstNames);
+constexpr std::size_t kLastNameCount = std::size(kLastNames);
+
+// Share of accounts opened by someone who does not hold one yet, and of
+// the others that share the owner's card.
+constexpr double kNewOwnerShare = 0.7;
+constexpr double kSharedCardShare = 0.1;
+constexpr std::uint64_t kCardBase = 10000000000000;  // smallest 14-digit number
+
+// Common names come up often, as they do in a real book; past the list,
+// a middle initial keeps owners apart.
+std::string ownerName(std::size_t index) {
+    std::string name = kFirstNames[index % kFirstNameCount];
+    std::size_t rest = index / kFirstNameCount;
+    if (rest >= kLastNameCount) {
+        name += ' ';
+        name += static_cast<char>('A' + (rest / kLastNameCount - 1) % 26);
+        name += '.';
+    }
+    name += ' ';
+    name += kLastNames[rest % kLastNameCount];
+    return name;
+}
+
+// Log-uniform between `low` and `high` whole units, in cents.
+Money logUniform(std::mt19937_64& rng, double low, double high) {
+    std::uniform_real_distribution<double> exponent(std::log(low), std::log(high));
+    return Money::fromMinorUnits(std::llround(std::exp(exponent(rng)) * 100));
+}
+
+// Zipf ranks 1..n by rejection-inversion (Hormann and Derflinger), in
+// constant time and memory whatever the population.
+class ZipfSampler {
+public:
+    ZipfSampler(std::size_t n, double exponent)
+        : n_(static_cast<double>(n)), s_(exponent), hX1_(hIntegral(1.5) - 1), hN_(hIntegral(n_ + 0.5)),
+          threshold_(2 - hIntegralInverse(hIntegral(2.5) - h(2))) {}
+
+    std::size_t operator()(std::mt19937_64& rng) const {
+        std::uniform_real_distribution<double> unit(0, 1);
+        while (true) {
+            double u = hN_ + unit(rng) * (hX1_ - hN_);
+            double x = hIntegralInverse(u);
+            double k = std::clamp(std::floor(x + 0.5), 1.0, n_);
+            if (k - x <= threshold_ || u >= hIntegral(k + 0.5) - h(k))
+                return static_cast<std::size_t>(k);
+        }
+    }
+
+private:
+    static double helper1(double x) {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+    static double helper2(double x) {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+    }
+    double h(double x) const { return std::exp(-s_ * std::log(x)); }
+    double hIntegral(double x) const {
+        double logX = std::log(x);
+        return helper2((1 - s_) * logX) * logX;
+    }
+    double hIntegralInverse(double x) const {
+        double t = std::max(x * (1 - s_), -1.0);
+        return std::exp(helper1(t) * x);
+    }
+
+    double n_;
+    double s_;
+    double hX1_;
+    double hN_;
+    double threshold_;
+};
+
+// Picks population positions by the configured distribution.
+class KeyPicker {
+public:
+    KeyPicker(const WorkloadOptions& options, std::mt19937_64& rng)
+        : size_(options.accounts), zipf_(std::max<std::size_t>(options.accounts, 1), options.zipfExponent) {
+        if (options.keys == KeyDistribution::Zipf) {
+            hot_.resize(size_);
+            std::iota(hot_.begin(), hot_.end(), 0u);
+            std::shuffle(hot_.begin(), hot_.end(), rng);
+        }
+    }
+
+    std::uint32_t operator()(std::mt19937_64& rng) const {
+        if (hot_.empty())
+            return static_cast<std::uint32_t>(std::uniform_int_distribution<std::size_t>(0, size_ - 1)(rng));
+        return hot_[zipf_(rng) - 1];
+    }
+
+private:
+    std::size_t size_;
+    ZipfSampler zipf_;
+    std::vector<std::uint32_t> hot_;  // population position by rank
+};
+
+// Owners and cards for new accounts, shared by the population and the
+// Create operations of every stream.
+class OwnerPicker {
+public:
+    explicit OwnerPicker(Workload& workload) : workload_(workload) {}
+
+    WorkloadAccount next(std::mt19937_64& rng) {
+        std::uniform_real_distribution<double> unit(0, 1);
+        std::uniform_int_distribution<std::uint64_t> card(kCardBase, 10 * kCardBase - 1);
+        WorkloadAccount account{};
+        if (workload_.owners.empty() || unit(rng) < kNewOwnerShare) {
+            account.owner = static_cast<std::uint32_t>(workload_.owners.size());
+            workload_.owners.push_back(ownerName(workload_.owners.size()));
+            lastCard_.push_back(card(rng));
+            account.card = lastCard_.back();
+            return account;
+        }
+        account.owner = static_cast<std::uint32_t>(
+            std::uniform_int_distribution<std::size_t>(0, workload_.owners.size() - 1)(rng));
+        if (unit(rng) >= kSharedCardShare)
+            lastCard_[account.owner] = card(rng);
+        account.card = lastCard_[account.owner];
+        return account;
+    }
+
+private:
+    Workload& workload_;
+    std::vector<std::uint64_t> lastCard_;  // by owner
+};
+
+std::uint64_t seedFor(std::uint64_t seed, std::size_t stream) {
+    return seed ^ (0x9e3779b97f4a7c15ULL * (stream + 1));
+}
+
+std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    std::size_t begin = 0;
+    while (true) {
+        std::size_t comma = line.find(',', begin);
+        fields.push_back(line.substr(begin, comma - begin));
+        if (comma == std::string::npos)
+            return fields;
+        begin = comma + 1;
+    }
+}
+
+std::uint64_t parseNumber(const std::string& text, std::size_t line) {
+    std::size_t used = 0;
+    unsigned long long value = 0;
+    try {
+        value = std::stoull(text, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (text.empty() || used != text.size() || text[0] == '-')
+        throw std::runtime_error("Trace line " + std::to_string(line) + ": invalid number '" + text + "'");
+    return value;
+}
+
+Money parseAmount(const std::string& text, std::size_t line) {
+    Money amount;
+    if (!Money::parse(text, amount))
+        throw std::runtime_error("Trace line " + std::to_string(line) + ": invalid amount '" + text + "'");
+    return amount;
+}
+
+// Runs one operation; false when it failed.
+bool apply(IBank& bank, const Workload& workload, const std::vector<int>& ids, const WorkloadOperation& op) {
+    try {
+        switch (op.op) {
+        case WorkloadOp::Create:
+            bank.createAccount(workload.owners[op.account], cardText(op.card), op.amount);
+            return true;
+        case WorkloadOp::Delete:
+            return bank.deleteAccount(ids[op.account]);
+        case WorkloadOp::Deposit:
+            bank.deposit(ids[op.account], op.amount);
+            return true;
+        case WorkloadOp::Withdraw:
+            bank.withdraw(ids[op.account], op.amount);
+            return true;
+        case WorkloadOp::Lookup:
+            bank.getAccount(ids[op.account]);
+            return true;
+        case WorkloadOp::kCount:
+            break;
+        }
+    } catch (const std::exception&) {
+    }
+    return false;
+}
+
+// One stream's results; the latency totals are in ticks until merged.
+struct StreamResult {
+    std::array<std::uint64_t, kWorkloadOps> failed{};
+    std::array<metrics::TimerSnapshot, kWorkloadOps> latency{};
+    std::array<std::uint64_t, kWorkloadOps> totalTicks{};
+};
+
+} // namespace
+
+const char* toString(WorkloadOp op) {
+    auto index = static_cast<std::size_t>(op);
+    return index < kWorkloadOps ? kOpNames[index] : "unknown";
+}
+
+bool parseWorkloadOp(const std::string& name, WorkloadOp& op) {
+    for (std::size_t i = 0; i < kWorkloadOps; ++i) {
+        if (name == kOpNames[i]) {
+            op = static_cast<WorkloadOp>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t Workload::operationCount() const {
+    std::size_t count = 0;
+    for (const auto& stream : streams)
+        count += stream.size();
+    return count;
+}
+
+std::string cardText(std::uint64_t card) {
+    std::string text = std::to_string(card);
+    if (text.size() < 14)
+        text.insert(0, 14 - text.size(), '0');
+    return text;
+}
+
+Workload generateWorkload(const WorkloadOptions& options) {
+    const bool targeted = options.mix[static_cast<std::size_t>(WorkloadOp::Delete)] +
+                              options.mix[static_cast<std::size_t>(WorkloadOp::Deposit)] +
+                              options.mix[static_cast<std::size_t>(WorkloadOp::Withdraw)] +
+                              options.mix[static_cast<std::size_t>(WorkloadOp::Lookup)] >
+                          0;
+    if (std::accumulate(options.mix.begin(), options.mix.end(), 0u) == 0)
+        throw std::invalid_argument("Workload mix has no operations");
+    if (targeted && options.accounts == 0)
+        throw std::invalid_argument("Workload needs accounts to operate on");
+    if (options.accounts > UINT32_MAX)
+        throw std::invalid_argument("Workload population too large");
+
+    Workload workload;
+    OwnerPicker owners(workload);
+    std::mt19937_64 rng(options.seed);
+    workload.population.reserve(options.accounts);
+    for (std::size_t i = 0; i < options.accounts; ++i) {
+        WorkloadAccount account = owners.next(rng);
+        account.balance = logUniform(rng, 10, 50000);
+        workload.population.push_back(account);
+    }
+    KeyPicker keys(options, rng);
+
+    // Streams are generated one after the other, each from its own seed,
+    // so that owners opened by Create operations are numbered the same way
+    // every time.
+    std::discrete_distribution<std::size_t> pickOp(options.mix.begin(), options.mix.end());
+    workload.streams.resize(options.threads);
+    for (std::size_t t = 0; t < options.threads; ++t) {
+        std::mt19937_64 streamRng(seedFor(options.seed, t));
+        std::vector<WorkloadOperation>& stream = workload.streams[t];
+        stream.reserve(options.operations);
+        for (std::size_t i = 0; i < options.operations; ++i) {
+            WorkloadOperation op{};
+            op.op = static_cast<WorkloadOp>(pickOp(streamRng));
+            switch (op.op) {
+            case WorkloadOp::Create: {
+                WorkloadAccount account = owners.next(streamRng);
+                op.account = account.owner;
+                op.card = account.card;
+                op.amount = logUniform(streamRng, 10, 50000);
+                break;
+            }
+            case WorkloadOp::Deposit:
+            case WorkloadOp::Withdraw:
+                op.account = keys(streamRng);
+                op.amount = logUniform(streamRng, 1, 500);
+                break;
+            default:
+                op.account = keys(streamRng);
+                break;
+            }
+            stream.push_back(op);
+        }
+    }
+    return workload;
+}
+
+void writeTrace(const Workload& workload, const std::string& filename) {
+    std::ofstream file(filename, std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error("Cannot open trace for writing: " + filename);
+    file << "# bank_load trace: " << workload.population.size() << " accounts, " << workload.streams.size()
+         << " streams, " << workload.operationCount() << " operations\n";
+    for (const std::string& owner : workload.owners)
+        file << "owner," << owner << '\n';
+    for (const WorkloadAccount& account : workload.population)
+        file << "account," << account.owner << ',' << cardText(account.card) << ',' << account.balance << '\n';
+    for (std::size_t t = 0; t < workload.streams.size(); ++t) {
+        for (const WorkloadOperation& op : workload.streams[t]) {
+            file << t << ',' << toString(op.op) << ',' << op.account << ',';
+            if (op.op == WorkloadOp::Create || op.op == WorkloadOp::Deposit || op.op == WorkloadOp::Withdraw)
+                file << op.amount;
+            file << ',';
+            if (op.op == WorkloadOp::Create)
+                file << cardText(op.card);
+            file << '\n';
+        }
+    }
+    if (!file.flush())
+        throw std::runtime_error("Error writing trace: " + filename);
+}
+
+Workload readTrace(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open())
+        throw std::runtime_error("Cannot open trace: " + filename);
+
+    Workload workload;
+    std::string text;
+    std::size_t line = 0;
+    auto fail = [&](const std::string& message) {
+        throw std::runtime_error("Trace line " + std::to_string(line) + ": " + message);
+    };
+    while (std::getline(file, text)) {
+        ++line;
+        if (!text.empty() && text.back() == '\r')
+            text.pop_back();
+        if (text.empty() || text[0] == '#')
+            continue;
+        if (text.compare(0, 6, "owner,") == 0) {
+            workload.owners.push_back(text.substr(6));
+            continue;
+        }
+
+        std::vector<std::string> fields = splitFields(text);
+        if (fields[0] == "account") {
+            if (fields.size() != 4)
+                fail("expected account,<owner>,<card>,<balance>");
+            WorkloadAccount account{};
+            std::uint64_t owner = parseNumber(fields[1], line);
+            if (owner >= workload.owners.size())
+                fail("unknown owner " + fields[1]);
+            account.owner = static_cast<std::uint32_t>(owner);
+            account.card = parseNumber(fields[2], line);
+            account.balance = parseAmount(fields[3], line);
+            workload.population.push_back(account);
+            continue;
+        }
+
+        if (fields.size() != 5)
+            fail("expected <thread>,<op>,<account>,<amount>,<card>");
+        std::uint64_t thread = parseNumber(fields[0], line);
+        WorkloadOperation op{};
+        if (!parseWorkloadOp(fields[1], op.op))
+            fail("unknown operation '" + fields[1] + "'");
+        std::uint64_t account = parseNumber(fields[2], line);
+        if (account >= (op.op == WorkloadOp::Create ? workload.owners.size() : workload.population.size()))
+            fail((op.op == WorkloadOp::Create ? "unknown owner " : "unknown account ") + fields[2]);
+        op.account = static_cast<std::uint32_t>(account);
+        if (op.op == WorkloadOp::Create || op.op == WorkloadOp::Deposit || op.op == WorkloadOp::Withdraw)
+            op.amount = parseAmount(fields[3], line);
+        if (op.op == WorkloadOp::Create)
+            op.card = parseNumber(fields[4], line);
+        // Streams are numbered densely; a gap would be an idle thread.
+        if (thread > workload.streams.size())
+            fail("stream " + fields[0] + " before stream " + std::to_string(workload.streams.size()));
+        if (thread == workload.streams.size())
+            workload.streams.emplace_back();
+        workload.streams[thread].push_back(op);
+    }
+    return workload;
+}
+
+std::uint64_t WorkloadReport::operations() const {
+    std::uint64_t count = 0;
+    for (const metrics::TimerSnapshot& timer : latency)
+        count += timer.count;
+    return count;
+}
+
+WorkloadReport runWorkload(const Workload& workload, const std::vector<IBank*>& banks) {
+    if (banks.size() != workload.streams.size())
+        throw std::invalid_argument("runWorkload needs one bank per stream");
+
+    WorkloadReport report;
+    if (banks.empty())
+        return report;
+    std::vector<int> ids;
+    ids.reserve(workload.population.size());
+    for (const WorkloadAccount& account : workload.population)
+        ids.push_back(banks[0]->createAccount(workload.owners[account.owner], cardText(account.card), account.balance));
+
+    std::vector<StreamResult> results(workload.streams.size());
+    std::atomic<std::size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> abandoned{false};
+    std::vector<std::thread> threads;
+    threads.reserve(workload.streams.size());
+    try {
+        for (std::size_t t = 0; t < workload.streams.size(); ++t) {
+            threads.emplace_back([&, t] {
+                StreamResult& result = results[t];
+                IBank& bank = *banks[t];
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                if (abandoned.load(std::memory_order_relaxed))
+                    return;
+                for (const WorkloadOperation& op : workload.streams[t]) {
+                    auto index = static_cast<std::size_t>(op.op);
+                    std::uint64_t start = metrics::ticks();
+                    bool ok = apply(bank, workload, ids, op);
+                    std::uint64_t elapsed = metrics::ticks() - start;
+                    metrics::TimerSnapshot& timer = result.latency[index];
+                    ++timer.buckets[metrics::bucketFor(elapsed)];
+                    ++timer.count;
+                    result.totalTicks[index] += elapsed;
+                    if (!ok)
+                        ++result.failed[index];
+                }
+            });
+        }
+    } catch (...) {
+        // A thread that could not be started: release the ones that were,
+        // with nothing to do, rather than leave them spinning.
+        abandoned.store(true, std::memory_order_relaxed);
+        go.store(true, std::memory_order_release);
+        for (std::thread& thread : threads)
+            thread.join();
+        throw;
+    }
+    while (ready.load() < threads.size())
+        std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& thread : threads)
+        thread.join();
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double nsPerTick = metrics::nanosecondsPerTick();
+    for (const StreamResult& result : results) {
+        for (std::size_t i = 0; i < kWorkloadOps; ++i) {
+            metrics::TimerSnapshot& timer = report.latency[i];
+            timer.count += result.latency[i].count;
+            timer.totalNs += static_cast<double>(result.totalTicks[i]) * nsPerTick;
+            for (std::size_t b = 0; b < metrics::kBuckets; ++b)
+                timer.buckets[b] += result.latency[i].buckets[b];
+            report.failed[i] += result.failed[i];
+        }
+    }
+    return report;
+}
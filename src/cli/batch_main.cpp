@@ -0,0 +1,45 @@
+// batch_main.cpp
+// Non-interactive settlement runner:
+//   bank_batch <operations.csv|operations.jsonl> [accounts.json]
+//   bank_batch --connect <socket> <operations.csv|operations.jsonl>
+// Applies the file against the book (snapshot plus journal) using the
+// sharded bank, prints a summary and compacts the journal on success. With
+// --connect it sends the file to a running bank_daemon instead, which owns
+// the book.
+#include "cli.h"
+#include "concurrent_bank.h"
+#include "journal_persistence.h"
+#include "json_persistence.h"
+#include "remote_bank.h"
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    const bool remote = argc >= 2 && std::string(argv[1]) == "--connect";
+    if (remote ? argc != 4 : (argc < 2 || argc > 3)) {
+        std::cerr << "Usage: " << argv[0] << " <operations.csv|operations.jsonl> [accounts.json]\n"
+                  << "       " << argv[0] << " --connect <socket> <operations.csv|operations.jsonl>\n";
+        return 2;
+    }
+
+    try {
+        if (remote) {
+            RemoteBank bank(argv[2]);
+            CLI cli(bank);
+            return cli.runBatch(argv[3]).failures.empty() ? 0 : 1;
+        }
+
+        std::string accountsFile = argc == 3 ? argv[2] : "accounts.json";
+        std::string journalFile = accountsFile.substr(0, accountsFile.rfind(".json")) + ".journal";
+        JsonPersistence snapshot(accountsFile);
+        JournalPersistence persistence(snapshot, journalFile, 4096);
+        ConcurrentBank bank(persistence);
+        CLI cli(bank);
+        BatchReport report = cli.runBatch(argv[1]);
+        bank.save();
+        return report.failures.empty() ? 0 : 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 2;
+    }
+}
@@ -1,5 +1,20 @@
 #include "cli.h"
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
+
+namespace {
+
+Money readAmount() {
+    std::string text;
+    std::cin >> text;
+    Money amount;
+    if (!Money::parse(text, amount))
+        throw std::invalid_argument("Invalid amount: " + text);
+    return amount;
+}
+
+} // namespace
 
 void CLI::run() {
     while (true) {
@@ -15,12 +30,60 @@ void CLI::run() {
     }
 }
 
+BatchReport CLI::runBatch(const std::string& filename, std::ostream& out) {
+    auto start = std::chrono::steady_clock::now();
+    BatchReader reader(filename);
+    BatchReport report;
+    std::vector<BatchOperation> operations;
+    std::vector<BatchFailure> parseFailures;
+    while (reader.next(operations, parseFailures))
+        report.merge(bank_.applyBatch(operations));
+    report.merge({0, std::move(parseFailures)});
+    report.sortFailuresByLine();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::size_t total = report.applied + report.failures.size();
+    out << "Applied: " << report.applied << ", Failed: " << report.failures.size() << '\n'
+        << "Time: " << elapsed.count() << " s";
+    if (elapsed.count() > 0)
+        out << " (" << static_cast<long long>(total / elapsed.count()) << " ops/sec)";
+    out << '\n';
+    for (const auto& failure : report.failures)
+        out << "  line " << failure.line << ": " << failure.message << '\n';
+    return report;
+}
+
+PostingReport CLI::runPostings(const std::string& scheduleFile, PostingCheckpoint& checkpoint, std::ostream& out,
+                               const std::atomic<bool>* interrupted) {
+    PostingSchedule schedule = PostingSchedule::load(scheduleFile);
+    auto start = std::chrono::steady_clock::now();
+    PostingReport report = bank_.applyPostings(schedule, checkpoint, [&](const PostingCheckpoint& progress) {
+        out << "\rPosted through account " << progress.nextAccountId - 1 << " of " << progress.endAccountId - 1
+            << std::flush;
+        return !interrupted || !interrupted->load();
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    out << '\n'
+        << (report.complete ? "Posting complete" : "Posting interrupted") << ": " << report.posted << " posted, "
+        << report.unchanged << " unchanged, " << report.skipped << " skipped, " << report.failed.size()
+        << " failed\n"
+        << "Interest: " << report.interest << ", Fees: " << report.fees << ", Waived: " << report.waived << '\n'
+        << "Time: " << elapsed.count() << " s\n";
+    for (int accountId : report.failed)
+        out << "  account " << accountId << ": balance would overflow\n";
+    return report;
+}
+
 void CLI::showMenu() const {
     std::cout << "\n1. Create Account\n"
               << "2. Delete Account\n"
               << "3. Deposit\n"
               << "4. Withdraw\n"
               << "5. Show Account\n"
+              << "6. Transfer\n"
+              << "7. Run Batch File\n"
+              << "8. Post Interest and Fees\n"
               << "0. Exit\n"
               << "Choice: ";
 }
@@ -30,14 +93,13 @@ bool CLI::handleChoice(int choice) {
     case 1: {
         std::string name;
         std::string cardId;
-        double initial;
         std::cout << "Enter person name: ";
         std::cin >> std::ws;
         std::getline(std::cin, name);
         std::cout << "Enter national card ID: ";
         std::cin >> cardId;
         std::cout << "Initial deposit (or 0): ";
-        std::cin >> initial;
+        Money initial = readAmount();
         int accountId = bank_.createAccount(name, cardId, initial);
         std::cout << "The Account ID is: " << accountId << "\n";
         break;
@@ -56,11 +118,10 @@ bool CLI::handleChoice(int choice) {
 
     case 3: {
         int accountId;
-        double amount;
         std::cout << "Enter Account ID: ";
         std::cin >> accountId;
         std::cout << "Amount: ";
-        std::cin >> amount;
+        Money amount = readAmount();
         bank_.deposit(accountId, amount);
         std::cout << "Deposit successful\n";
         break;
@@ -68,11 +129,10 @@ bool CLI::handleChoice(int choice) {
 
     case 4: {
         int accountId;
-        double amount;
         std::cout << "Enter Account ID: ";
         std::cin >> accountId;
         std::cout << "Amount: ";
-        std::cin >> amount;
+        Money amount = readAmount();
         bank_.withdraw(accountId, amount);
         std::cout << "Withdraw successful\n";
         break;
@@ -82,7 +142,40 @@ bool CLI::handleChoice(int choice) {
         int accountId;
         std::cout << "Enter Account ID: ";
         std::cin >> accountId;
-        std::cout << "Balance: " << bank_.getAccount(accountId).balance() << '\n';
+        std::cout << "Balance: " << bank_.getBalance(accountId) << '\n';
+        break;
+    }
+
+    case 6: {
+        int fromAccountId;
+        int toAccountId;
+        std::cout << "From Account ID: ";
+        std::cin >> fromAccountId;
+        std::cout << "To Account ID: ";
+        std::cin >> toAccountId;
+        std::cout << "Amount: ";
+        Money amount = readAmount();
+        bank_.transfer(fromAccountId, toAccountId, amount);
+        std::cout << "Transfer successful\n";
+        break;
+    }
+
+    case 7: {
+        std::string filename;
+        std::cout << "Batch file (CSV or .jsonl): ";
+        std::cin >> std::ws;
+        std::getline(std::cin, filename);
+        runBatch(filename);
+        break;
+    }
+
+    case 8: {
+        std::string filename;
+        std::cout << "Posting schedule (min,max,rate%,fee per line): ";
+        std::cin >> std::ws;
+        std::getline(std::cin, filename);
+        PostingCheckpoint checkpoint;
+        runPostings(filename, checkpoint);
         break;
     }
 
@@ -0,0 +1,25 @@
+// client_main.cpp
+// The interactive menu against a running bank_daemon:
+//   bank_client [socket]
+// Every choice is a request to the daemon, so any number of clients (and
+// bank_batch/bank_post --connect) can work on the same book at once.
+#include "cli.h"
+#include "remote_bank.h"
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc > 2) {
+        std::cerr << "Usage: " << argv[0] << " [socket]\n";
+        return 2;
+    }
+    try {
+        RemoteBank bank(argc == 2 ? argv[1] : "bank.sock");
+        CLI cli(bank);
+        cli.run();
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 2;
+    }
+}
@@ -0,0 +1,60 @@
+// daemon_main.cpp
+// Headless bank server:
+//   bank_daemon [accounts.json] [socket]
+// Owns the book (snapshot plus journal, as the GUI keeps it) and serves it
+// on a Unix socket, bank.sock by default, to bank_client, the --connect
+// mode of bank_batch and bank_post, and anything else built on RemoteBank.
+// SIGINT or SIGTERM stops it and compacts the journal into the snapshot.
+#include "bank.h"
+#include "bank_server.h"
+#include "journal_persistence.h"
+#include "json_persistence.h"
+#include "transaction_history.h"
+#include <csignal>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " [accounts.json] [socket]\n";
+        return 2;
+    }
+    std::string accountsFile = argc >= 2 ? argv[1] : "accounts.json";
+    std::string base = accountsFile.substr(0, accountsFile.rfind(".json"));
+    BankServerOptions options;
+    if (argc == 3)
+        options.socketPath = argv[2];
+
+    // Taken by sigwait() below rather than by a handler; blocked before any
+    // thread starts so that none of them receives the signal instead.
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    try {
+        JsonPersistence snapshot(accountsFile);
+        JournalPersistence persistence(snapshot, base + ".journal");
+        HistoryOptions historyOptions;
+        historyOptions.spillFile = base + ".history";
+        TransactionHistory history(historyOptions);
+        BankOptions bankOptions;
+        bankOptions.lazyLoad = true;
+        Bank bank(persistence, bankOptions);
+        bank.setHistory(&history);
+        options.journal = &persistence;
+        {
+            BankServer server(bank, options);
+            std::cout << "Serving " << bank.accountCount() << " accounts on " << options.socketPath << std::endl;
+            int signal = 0;
+            sigwait(&stopSignals, &signal);
+        }
+        // The journal already holds every change; the snapshot compacts it.
+        bank.save();
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 2;
+    }
+}
@@ -0,0 +1,261 @@
+// load_main.cpp
+// Synthetic load generator and trace replayer:
+//   bank_load [options]
+// Creates a population of accounts, drives a mix of operations against a
+// bank from one or more threads and prints throughput and latency
+// percentiles per operation. See workload.h for the trace format.
+//
+//   --accounts N        population size (default 10000)
+//   --ops N             operations per thread (default 100000)
+//   --threads N         client threads (default 1)
+//   --mix C,D,P,W,L     relative weights of create, delete, deposit,
+//                       withdraw and lookup (default 1,1,30,20,48)
+//   --zipf S            Zipf-skewed hot accounts with exponent S
+//                       (default: uniform)
+//   --seed N            generator seed (default 1)
+//   --record FILE       write the workload to FILE before running it
+//   --replay FILE       run a recorded workload; the options above are
+//                       ignored
+//   --bank single|concurrent
+//                       in-memory Bank behind one mutex, or ConcurrentBank
+//                       (default concurrent)
+//   --book FILE         use the book FILE (snapshot plus journal, as
+//                       bank_batch does) instead of an in-memory one; the
+//                       population and every change are kept
+//   --connect SOCKET    drive a running bank_daemon, one connection per
+//                       thread
+//   --dry-run           generate (and record) only
+#include "bank.h"
+#include "concurrent_bank.h"
+#include "journal_persistence.h"
+#include "json_persistence.h"
+#include "memory_persistence.h"
+#include "remote_bank.h"
+#include "workload.h"
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The single-map Bank, serialized externally the way callers must.
+class LockedBank : public IBank {
+public:
+    explicit LockedBank(Bank& bank) : bank_(bank) {}
+
+    int createAccount(const std::string& personName, const std::string& cardId, Money initialBalance) override {
+        std::lock_guard lock(mutex_);
+        return bank_.createAccount(personName, cardId, initialBalance);
+    }
+    bool deleteAccount(int accountId) override {
+        std::lock_guard lock(mutex_);
+        return bank_.deleteAccount(accountId);
+    }
+    void deposit(int accountId, Money amount) override {
+        std::lock_guard lock(mutex_);
+        bank_.deposit(accountId, amount);
+    }
+    void withdraw(int accountId, Money amount) override {
+        std::lock_guard lock(mutex_);
+        bank_.withdraw(accountId, amount);
+    }
+    Account getAccount(int accountId) const override {
+        std::lock_guard lock(mutex_);
+        return bank_.getAccount(accountId);
+    }
+    Money getBalance(int accountId) const override {
+        std::lock_guard lock(mutex_);
+        return bank_.getBalance(accountId);
+    }
+    void transfer(int fromAccountId, int toAccountId, Money amount) override {
+        std::lock_guard lock(mutex_);
+        bank_.transfer(fromAccountId, toAccountId, amount);
+    }
+    void transferMany(const std::vector<Transfer>& transfers) override {
+        std::lock_guard lock(mutex_);
+        bank_.transferMany(transfers);
+    }
+    BatchReport applyBatch(const std::vector<BatchOperation>& operations) override {
+        std::lock_guard lock(mutex_);
+        return bank_.applyBatch(operations);
+    }
+    PostingReport applyPostings(const PostingSchedule& schedule, PostingCheckpoint& checkpoint,
+                                const PostingProgress& progress) override {
+        std::lock_guard lock(mutex_);
+        return bank_.applyPostings(schedule, checkpoint, progress);
+    }
+
+private:
+    Bank& bank_;
+    mutable std::mutex mutex_;
+};
+
+struct Arguments {
+    WorkloadOptions workload;
+    std::string record;
+    std::string replay;
+    std::string bank = "concurrent";
+    std::string book;
+    std::string connect;
+    bool dryRun = false;
+};
+
+void usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--accounts N] [--ops N] [--threads N] [--mix C,D,P,W,L]\n"
+              << "       [--zipf S] [--seed N] [--record FILE] [--replay FILE]\n"
+              << "       [--bank single|concurrent] [--book FILE] [--connect SOCKET] [--dry-run]\n";
+}
+
+std::size_t parseCount(const std::string& text) {
+    std::size_t used = 0;
+    unsigned long long value = std::stoull(text, &used);
+    if (used != text.size() || text[0] == '-')
+        throw std::invalid_argument("invalid number: " + text);
+    return static_cast<std::size_t>(value);
+}
+
+std::array<unsigned, kWorkloadOps> parseMix(const std::string& text) {
+    std::array<unsigned, kWorkloadOps> mix{};
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < kWorkloadOps; ++i) {
+        std::size_t comma = text.find(',', begin);
+        if ((comma == std::string::npos) != (i + 1 == kWorkloadOps))
+            throw std::invalid_argument("--mix takes " + std::to_string(kWorkloadOps) + " weights");
+        mix[i] = static_cast<unsigned>(parseCount(text.substr(begin, comma - begin)));
+        begin = comma + 1;
+    }
+    return mix;
+}
+
+// False on a usage error.
+bool parseArguments(int argc, char* argv[], Arguments& args) {
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--dry-run") {
+            args.dryRun = true;
+            continue;
+        }
+        if (i + 1 == argc)
+            return false;
+        std::string value = argv[++i];
+        if (flag == "--accounts")
+            args.workload.accounts = parseCount(value);
+        else if (flag == "--ops")
+            args.workload.operations = parseCount(value);
+        else if (flag == "--threads")
+            args.workload.threads = parseCount(value);
+        else if (flag == "--mix")
+            args.workload.mix = parseMix(value);
+        else if (flag == "--zipf") {
+            args.workload.keys = KeyDistribution::Zipf;
+            args.workload.zipfExponent = std::stod(value);
+        } else if (flag == "--seed")
+            args.workload.seed = parseCount(value);
+        else if (flag == "--record")
+            args.record = value;
+        else if (flag == "--replay")
+            args.replay = value;
+        else if (flag == "--bank")
+            args.bank = value;
+        else if (flag == "--book")
+            args.book = value;
+        else if (flag == "--connect")
+            args.connect = value;
+        else
+            return false;
+    }
+    return args.workload.threads > 0 && (args.bank == "single" || args.bank == "concurrent");
+}
+
+void printReport(const WorkloadReport& report, std::ostream& out) {
+    out << report.operations() << " operations in " << report.seconds << " s ("
+        << static_cast<long long>(report.throughput()) << " ops/sec)\n";
+    char line[160];
+    std::snprintf(line, sizeof line, "%-9s %10s %8s %9s %9s %9s %9s %9s %9s\n", "op", "count", "failed",
+                  "mean us", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+    out << line;
+    for (std::size_t i = 0; i < kWorkloadOps; ++i) {
+        const metrics::TimerSnapshot& timer = report.latency[i];
+        if (timer.count == 0)
+            continue;
+        std::snprintf(line, sizeof line, "%-9s %10llu %8llu %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+                      toString(static_cast<WorkloadOp>(i)), static_cast<unsigned long long>(timer.count),
+                      static_cast<unsigned long long>(report.failed[i]), timer.meanNs() / 1000,
+                      timer.percentileNs(0.5) / 1000, timer.percentileNs(0.9) / 1000,
+                      timer.percentileNs(0.99) / 1000, timer.percentileNs(0.999) / 1000, timer.maxNs() / 1000);
+        out << line;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Arguments args;
+    try {
+        if (!parseArguments(argc, argv, args)) {
+            usage(argv[0]);
+            return 2;
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        Workload workload = args.replay.empty() ? generateWorkload(args.workload) : readTrace(args.replay);
+        std::cout << workload.population.size() << " accounts, " << workload.streams.size() << " threads, "
+                  << workload.operationCount() << " operations\n";
+        if (!args.record.empty())
+            writeTrace(workload, args.record);
+        if (args.dryRun)
+            return 0;
+
+        std::vector<IBank*> banks;
+        if (!args.connect.empty()) {
+            std::vector<std::unique_ptr<RemoteBank>> connections;
+            for (std::size_t t = 0; t < workload.streams.size(); ++t) {
+                connections.push_back(std::make_unique<RemoteBank>(args.connect));
+                banks.push_back(connections.back().get());
+            }
+            printReport(runWorkload(workload, banks), std::cout);
+            return 0;
+        }
+
+        // The load itself is what is measured; without --book the in-memory
+        // book never touches disk.
+        NullPersistence nullPersistence;
+        std::unique_ptr<JsonPersistence> snapshot;
+        std::unique_ptr<JournalPersistence> journal;
+        IPersistence* persistence = &nullPersistence;
+        if (!args.book.empty()) {
+            snapshot = std::make_unique<JsonPersistence>(args.book);
+            journal = std::make_unique<JournalPersistence>(
+                *snapshot, args.book.substr(0, args.book.rfind(".json")) + ".journal", 4096);
+            persistence = journal.get();
+        }
+
+        if (args.bank == "single") {
+            Bank bank(*persistence);
+            LockedBank locked(bank);
+            banks.assign(workload.streams.size(), &locked);
+            printReport(runWorkload(workload, banks), std::cout);
+            if (journal)
+                bank.save();
+        } else {
+            ConcurrentBank bank(*persistence);
+            banks.assign(workload.streams.size(), &bank);
+            printReport(runWorkload(workload, banks), std::cout);
+            if (journal)
+                bank.save();
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,38 @@
+// snapshot_convert.cpp
+// Converts account snapshots between the JSON and binary formats.
+// The format of each file is chosen by extension: ".json" is JSON,
+// anything else is the binary snapshot.
+#include "binary_persistence.h"
+#include "json_persistence.h"
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+std::unique_ptr<IPersistence> openSnapshot(const std::string& filename) {
+    const std::string ext = ".json";
+    if (filename.size() >= ext.size() && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0)
+        return std::make_unique<JsonPersistence>(filename);
+    return std::make_unique<BinaryPersistence>(filename);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input> <output>\n"
+                  << "  e.g. " << argv[0] << " accounts.json accounts.bin\n";
+        return 2;
+    }
+
+    try {
+        auto from = openSnapshot(argv[1]);
+        auto to = openSnapshot(argv[2]);
+        convertSnapshot(*from, *to);
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
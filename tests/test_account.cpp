@@ -2,25 +2,31 @@
 #include "account.h"
 
 TEST_CASE("Account creation", "[account]") {
-    Account acc("user1", 100.0);
-    REQUIRE(acc.id() == "user1");
-    REQUIRE(acc.balance() == 100.0);
+    Account acc(1, Money(100.0), "Alice", "11111111111111");
+    REQUIRE(acc.getAccountId() == 1);
+    REQUIRE(acc.getPersonName() == "Alice");
+    REQUIRE(acc.getCardId() == "11111111111111");
+    REQUIRE(acc.balance() == Money(100.0));
+    REQUIRE(acc.lastOperationType() == OperationType::None);
 }
 
 TEST_CASE("Account deposit", "[account]") {
-    Account acc("user1", 100.0);
-    acc.deposit(50.0);
-    REQUIRE(acc.balance() == 150.0);
+    Account acc(1, Money(100.0));
+    acc.deposit(Money(50.0));
+    REQUIRE(acc.balance() == Money(150.0));
+    REQUIRE(acc.lastOperationType() == OperationType::Deposit);
 }
 
 TEST_CASE("Account withdraw", "[account]") {
-    Account acc("user1", 100.0);
-    acc.withdraw(30.0);
-    REQUIRE(acc.balance() == 70.0);
+    Account acc(1, Money(100.0));
+    acc.withdraw(Money(30.0));
+    REQUIRE(acc.balance() == Money(70.0));
+    REQUIRE(acc.lastOperationType() == OperationType::Withdrawal);
 }
 
 TEST_CASE("Account withdraw insufficient funds", "[account]") {
-    Account acc("user1", 50.0);
-    REQUIRE_THROWS_AS(acc.withdraw(100.0), std::runtime_error);
-    REQUIRE(acc.balance() == 50.0);
-}
\ No newline at end of file
+    Account acc(1, Money(50.0));
+    REQUIRE_THROWS_AS(acc.withdraw(Money(100.0)), std::runtime_error);
+    REQUIRE(acc.balance() == Money(50.0));
+    REQUIRE(acc.lastOperationType() == OperationType::None);
+}
@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "json_persistence.h"
+#include <filesystem>
+
+TEST_CASE("Bank indexes accounts by owner and card", "[index]") {
+    std::string testFile = "test_index.json";
+    std::filesystem::remove(testFile);
+    int alice1 = 0;
+    int alice2 = 0;
+    int bob = 0;
+    {
+        JsonPersistence persistence(testFile);
+        Bank bank(persistence);
+        alice1 = bank.createAccount("Alice", "111", Money(1.0));
+        bob = bank.createAccount("Bob", "222", Money(2.0));
+        alice2 = bank.createAccount("Alice", "111", Money(3.0));
+
+        REQUIRE(bank.findByOwner("Alice") == std::vector<int>{alice1, alice2});
+        REQUIRE(bank.findByCard("222") == std::vector<int>{bob});
+        REQUIRE(bank.findByOwner("Carol").empty());
+
+        bank.deleteAccount(alice1);
+        REQUIRE(bank.findByOwner("Alice") == std::vector<int>{alice2});
+        REQUIRE(bank.findByCard("111") == std::vector<int>{alice2});
+        bank.save();
+    }
+
+    // Indexes are rebuilt from the snapshot on load.
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    REQUIRE(bank.findByOwner("Alice") == std::vector<int>{alice2});
+    REQUIRE(bank.findByCard("222") == std::vector<int>{bob});
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("AccountIndex prefix search ignores case", "[index]") {
+    AccountIndex index;
+    index.add(Account(1, Money(), "alice", "1"));
+    index.add(Account(2, Money(), "Alicia", "2"));
+    index.add(Account(3, Money(), "Bob", "3"));
+    index.add(Account(4, Money(), "ALI", "4"));
+
+    REQUIRE(index.byOwnerPrefix("ali", 10) == std::vector<int>{4, 1, 2});
+    REQUIRE(index.byOwnerPrefix("ALIC", 10) == std::vector<int>{1, 2});
+    REQUIRE(index.byOwnerPrefix("ali", 2).size() == 2);
+    REQUIRE(index.byOwnerPrefix("z", 10).empty());
+    REQUIRE(index.byOwnerPrefix("", 10).size() == 4);
+
+    index.remove(Account(1, Money(), "alice", "1"));
+    REQUIRE(index.byOwnerPrefix("alic", 10) == std::vector<int>{2});
+}
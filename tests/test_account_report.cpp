@@ -0,0 +1,34 @@
+#include <catch2/catch_test_macros.hpp>
+#include "account_report.h"
+#include "json_persistence.h"
+#include <filesystem>
+
+TEST_CASE("Account reports list every account", "[report]") {
+    std::string testFile = "test_report.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    REQUIRE(describeAllAccounts(bank) == "No accounts in system");
+
+    int a = bank.createAccount("Alice", "1", Money(10.0));
+    bank.createAccount("Bob", "2", Money(20.0));
+    bank.deposit(a, Money(2.5));
+
+    std::string all = describeAllAccounts(bank);
+    REQUIRE(all.find("Owner: Alice\nBalance: $ 12.50\n") != std::string::npos);
+    REQUIRE(all.find("Owner: Bob\nBalance: $ 20.00\n") != std::string::npos);
+    REQUIRE(all.find("Last Operation: Deposit") != std::string::npos);
+}
+
+TEST_CASE("Account reports filter by owner", "[report]") {
+    std::string testFile = "test_report_person.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    int a = bank.createAccount("Alice", "1", Money(10.0));
+    bank.createAccount("Bob", "2", Money(20.0));
+
+    REQUIRE(describePersonAccounts(bank, "Alice") ==
+            "Account ID: " + std::to_string(a) + "\n  Owner: Alice\n  Balance: $ 10.00\n\n");
+    REQUIRE(describePersonAccounts(bank, "Carol") == "No accounts found for person: Carol");
+}
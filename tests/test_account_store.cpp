@@ -0,0 +1,85 @@
+#include <catch2/catch_test_macros.hpp>
+#include "account_store.h"
+#include <cstdint>
+#include <limits>
+#include <set>
+
+TEST_CASE("AccountStore finds accounts by ID without hashing", "[store]") {
+    AccountStore store;
+    REQUIRE(store.find(1) == nullptr);
+    REQUIRE(store.find(-1) == nullptr);
+
+    REQUIRE(store.insert(Account(1, Money(10.0), "Alice", "A")) != nullptr);
+    REQUIRE(store.insert(Account(3, Money(30.0), "Carol", "C")) != nullptr);
+    REQUIRE(store.insert(Account(1, Money(99.0), "Dup", "D")) == nullptr);
+    REQUIRE_THROWS_AS(store.insert(Account(-5)), std::invalid_argument);
+
+    REQUIRE(store.size() == 2);
+    REQUIRE(store.find(1)->getPersonName() == "Alice");
+    REQUIRE(store.find(2) == nullptr);
+    REQUIRE(store.find(3)->balance() == Money(30.0));
+    REQUIRE(store.find(1000) == nullptr);
+}
+
+TEST_CASE("AccountStore keeps its columns in step with the records", "[store]") {
+    AccountStore store;
+    for (int id = 1; id <= 5; ++id)
+        store.insert(Account(id, Money(static_cast<double>(id)), "P", "C"));
+
+    Account* account = store.find(2);
+    account->deposit(Money(100.0));
+    store.refresh(*account);
+
+    // Erasing moves the last account into the hole; columns follow it.
+    REQUIRE(store.erase(1));
+    REQUIRE_FALSE(store.erase(1));
+    REQUIRE(store.size() == 4);
+    REQUIRE(store.find(1) == nullptr);
+    REQUIRE(store.find(5)->balance() == Money(5.0));
+
+    std::set<int> ids;
+    std::size_t slot = 0;
+    for (const Account& record : store) {
+        ids.insert(record.getAccountId());
+        REQUIRE(store.balances()[slot] == record.balance());
+        REQUIRE(store.lastOperationTypes()[slot] == record.lastOperationType());
+        REQUIRE(store.lastOperationTimes()[slot] == record.lastOperationTime());
+        ++slot;
+    }
+    REQUIRE(ids == std::set<int>{2, 3, 4, 5});
+    REQUIRE(store.find(2)->balance() == Money(102.0));
+    REQUIRE(store.find(2)->lastOperationType() == OperationType::Deposit);
+
+    auto map = store.toMap();
+    REQUIRE(map.size() == 4);
+    REQUIRE(map.at(5).balance() == Money(5.0));
+
+    store.clear();
+    REQUIRE(store.empty());
+    REQUIRE(store.find(2) == nullptr);
+}
+
+TEST_CASE("AccountStore keeps far-off IDs out of its table", "[store]") {
+    constexpr int kHighest = std::numeric_limits<std::int32_t>::max();
+    AccountStore store;
+    // Sized by ID, a table reaching this one would take 8 GB.
+    REQUIRE(store.insert(Account(kHighest, Money(1.0), "Far", "1")) != nullptr);
+    REQUIRE(store.insert(Account(kHighest, Money(1.0), "Far", "1")) == nullptr);
+    REQUIRE(store.insert(Account(70000, Money(2.0), "Near", "2")) != nullptr);
+    for (int id = 1; id <= 66000; ++id)
+        store.insert(Account(id, Money(3.0), "Owner", "3"));
+    REQUIRE(store.size() == 66002);
+
+    // The table has grown past 70000, which has moved into it.
+    REQUIRE(store.find(kHighest)->getPersonName() == "Far");
+    REQUIRE(store.find(70000)->balance() == Money(2.0));
+    REQUIRE(store.find(69999) == nullptr);
+    REQUIRE(store.find(66000)->balance() == Money(3.0));
+
+    // Erasing slot 0 moves the last account, 66000, into it.
+    REQUIRE(store.erase(kHighest));
+    REQUIRE(store.find(kHighest) == nullptr);
+    REQUIRE(store.find(66000)->getAccountId() == 66000);
+    REQUIRE(store.erase(70000));
+    REQUIRE(store.size() == 66000);
+}
@@ -0,0 +1,186 @@
+#include <catch2/catch_test_macros.hpp>
+#include "autosaver.h"
+#include "bank.h"
+#include "binary_persistence.h"
+#include "journal_persistence.h"
+#include "json_persistence.h"
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Files {
+    std::string snapshot;
+    std::string journal;
+
+    Files(std::string s, std::string j) : snapshot(std::move(s)), journal(std::move(j)) { remove(); }
+    ~Files() { remove(); }
+    void remove() const {
+        std::filesystem::remove(snapshot);
+        std::filesystem::remove(journal);
+    }
+};
+
+// Reloads copies of the files, as a restart after a crash would see them;
+// the originals stay locked while their stores are open.
+Money balanceAfterReload(const Files& files, int accountId) {
+    Files copies(files.snapshot + ".copy", files.journal + ".copy");
+    if (std::filesystem::exists(files.snapshot))
+        std::filesystem::copy_file(files.snapshot, copies.snapshot);
+    std::filesystem::copy_file(files.journal, copies.journal);
+    JsonPersistence snapshot(copies.snapshot, false);
+    JournalPersistence persistence(snapshot, copies.journal);
+    Bank bank(persistence);
+    return bank.getAccount(accountId).balance();
+}
+
+} // namespace
+
+TEST_CASE("Deferred persistence tracks dirty accounts", "[autosave]") {
+    Files files("test_autosave_dirty.json", "test_autosave_dirty.journal");
+    JsonPersistence snapshot(files.snapshot);
+    JournalPersistence persistence(snapshot, files.journal);
+    Bank bank(persistence);
+    int a = bank.createAccount("A", "1", Money(10.0));
+    int b = bank.createAccount("B", "2", Money(10.0));
+    REQUIRE(bank.dirtyCount() == 0);  // write-through
+
+    bank.setDeferredPersistence(true);
+    REQUIRE(bank.deferredPersistence());
+    bank.transfer(a, b, Money(1.0));
+    bank.deposit(a, Money(1.0));
+    int c = bank.createAccount("C", "3");
+    bank.deleteAccount(c);
+    REQUIRE(bank.dirtyCount() == 3);
+
+    AccountDelta delta = bank.takeDirty();
+    REQUIRE(delta.changed.size() == 2);
+    REQUIRE(delta.deleted == std::vector<int>{c});
+    REQUIRE(bank.dirtyCount() == 0);
+
+    bank.deposit(a, Money(1.0));
+    bank.save();
+    REQUIRE(bank.dirtyCount() == 0);
+}
+
+TEST_CASE("AutoSaver flushes only what changed", "[autosave]") {
+    Files files("test_autosave.json", "test_autosave.journal");
+    int id = 0;
+    {
+        JsonPersistence snapshot(files.snapshot);
+        JournalPersistence persistence(snapshot, files.journal);
+        Bank bank(persistence);
+        BankWorker worker(bank);
+        AutoSaver saver(worker, persistence, {std::chrono::hours(1), 1000000});
+
+        worker.post([&id](Bank& b) { id = b.createAccount("A", "1", Money(0.0)); });
+        for (int i = 0; i < 500; ++i)
+            worker.post([&id](Bank& b) { b.deposit(id, Money(1.0)); });
+        saver.flush();
+        REQUIRE(saver.deltasWritten() == 1);
+        REQUIRE(persistence.journaledRecords() == 1);
+        REQUIRE(balanceAfterReload(files, id) == Money(500.0));
+
+        saver.flush();  // nothing dirty, nothing written
+        REQUIRE(saver.deltasWritten() == 1);
+
+        worker.post([&id](Bank& b) { b.withdraw(id, Money(100.0)); });
+    }
+    // The destructor persists the tail.
+    REQUIRE(balanceAfterReload(files, id) == Money(400.0));
+}
+
+TEST_CASE("AutoSaver flushes on its own once enough changes pile up", "[autosave]") {
+    Files files("test_autosave_threshold.json", "test_autosave_threshold.journal");
+    JsonPersistence snapshot(files.snapshot);
+    JournalPersistence persistence(snapshot, files.journal);
+    Bank bank(persistence);
+    BankWorker worker(bank);
+    AutoSaver saver(worker, persistence, {std::chrono::hours(1), 50});
+
+    worker.post([](Bank& b) {
+        int id = b.createAccount("A", "1");
+        for (int i = 0; i < 60; ++i)
+            b.deposit(id, Money(1.0));
+    });
+    for (int i = 0; i < 200 && saver.deltasWritten() == 0; ++i)
+        std::this_thread::sleep_for(10ms);
+    REQUIRE(saver.deltasWritten() >= 1);
+}
+
+TEST_CASE("AutoSaver writes snapshots to stores without delta support", "[autosave]") {
+    Files files("test_autosave_json.json", "unused.journal");
+    int id = 0;
+    {
+        JsonPersistence persistence(files.snapshot);
+        Bank bank(persistence);
+        BankWorker worker(bank);
+        AutoSaver saver(worker, persistence, {std::chrono::hours(1), 1000000});
+        worker.post([&id](Bank& b) { id = b.createAccount("A", "1", Money(7.0)); });
+        saver.flush();
+        REQUIRE(saver.snapshotsWritten() == 1);
+        REQUIRE(saver.deltasWritten() == 0);
+
+        bool saved = false;
+        saver.saveNow([&saved](const std::string& error) { saved = error.empty(); });
+        saver.flush();
+        REQUIRE(saved);
+    }
+    JsonPersistence persistence(files.snapshot);
+    Bank bank(persistence);
+    REQUIRE(bank.getAccount(id).balance() == Money(7.0));
+}
+
+TEST_CASE("AutoSaver reports failed background writes", "[autosave]") {
+    struct FullDisk : IPersistence {
+        void save(const std::unordered_map<int, Account>&) override { throw std::runtime_error("Disk full"); }
+        std::unordered_map<int, Account> load() override { return {}; }
+    } persistence;
+    Bank bank(persistence);
+    BankWorker worker(bank);
+    AutoSaver saver(worker, persistence, {std::chrono::hours(1), 1000000});
+    REQUIRE(saver.failedWrites() == 0);
+
+    worker.post([](Bank& b) { b.createAccount("A", "1"); });
+    saver.flush();
+    REQUIRE(saver.failedWrites() == 1);
+    REQUIRE(saver.lastError() == "Disk full");
+}
+
+TEST_CASE("AutoSaver lets a lazily loading bank release what it saved", "[autosave]") {
+    Files files("test_autosave_lazy.bin", "unused.journal");
+    {
+        BinaryPersistence persistence(files.snapshot);
+        Bank bank(persistence);
+        for (int i = 1; i <= 100; ++i)
+            bank.createAccount("Owner", "C", Money(1.0));
+        bank.save();
+    }
+    BinaryPersistence persistence(files.snapshot);
+    BankOptions options;
+    options.lazyLoad = true;
+    options.residentAccounts = 10;
+    Bank bank(persistence, options);
+    BankWorker worker(bank);
+    AutoSaver saver(worker, persistence, {std::chrono::hours(1), 1000000});
+
+    worker.post([](Bank& b) {
+        for (int id = 1; id <= 100; ++id)
+            b.deposit(id, Money(1.0));
+    });
+    worker.waitIdle();
+    REQUIRE(bank.residentCount() == 100);
+
+    saver.flush();
+    REQUIRE(saver.snapshotsWritten() == 1);
+    worker.waitIdle();  // the bank takes the new source on its own thread
+    REQUIRE(bank.residentCount() == 10);
+    REQUIRE(bank.accountCount() == 100);
+    Money balance;
+    worker.post([&balance](Bank& b) { balance = b.getBalance(50); });
+    worker.waitIdle();
+    REQUIRE(balance == Money(2.0));
+}
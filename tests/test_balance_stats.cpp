@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+#include "balance_stats.h"
+#include "bank.h"
+#include "json_persistence.h"
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <random>
+
+using namespace balance_stats;
+
+namespace {
+
+std::vector<SimdLevel> supportedLevels() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512})
+        if (level <= detectSimdLevel())
+            levels.push_back(level);
+    return levels;
+}
+
+std::vector<Money> randomBalances(std::size_t count, unsigned seed) {
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<std::int64_t> minor(-500'000, 5'000'000);
+    std::vector<Money> balances;
+    for (std::size_t i = 0; i < count; ++i)
+        balances.push_back(Money::fromMinorUnits(minor(random)));
+    return balances;
+}
+
+} // namespace
+
+TEST_CASE("Every kernel agrees with a plain loop", "[balance_stats]") {
+    // Odd sizes leave a scalar tail after the vector lanes.
+    for (std::size_t size : {std::size_t{1}, std::size_t{7}, std::size_t{33}, std::size_t{10'001}}) {
+        std::vector<Money> balances = randomBalances(size, static_cast<unsigned>(size));
+        Money total;
+        for (Money balance : balances)
+            total += balance;
+        auto [min, max] = std::minmax_element(balances.begin(), balances.end());
+        Money threshold = Money(100.0);
+        auto below = static_cast<std::size_t>(std::count_if(
+            balances.begin(), balances.end(), [&](Money balance) { return balance < threshold; }));
+
+        for (SimdLevel level : supportedLevels()) {
+            for (unsigned threads : {1u, 3u}) {
+                Options options{level, threads};
+                Summary summary = summarize(balances, options);
+                REQUIRE(summary.count == size);
+                REQUIRE(summary.total == total);
+                REQUIRE(summary.min == *min);
+                REQUIRE(summary.max == *max);
+                REQUIRE(countBelow(balances, threshold, options) == below);
+            }
+        }
+    }
+}
+
+TEST_CASE("Summaries handle empty columns and totals near the limit", "[balance_stats]") {
+    Summary empty = summarize({});
+    REQUIRE(empty.count == 0);
+    REQUIRE(empty.total == Money());
+    REQUIRE(empty.min == Money());
+
+    const std::int64_t big = std::numeric_limits<std::int64_t>::max() / 2;
+    for (SimdLevel level : supportedLevels()) {
+        Options options{level, 1};
+        // Intermediate sums overflow, but the total fits.
+        std::vector<Money> fits = {Money::fromMinorUnits(big), Money::fromMinorUnits(big),
+                                   Money::fromMinorUnits(-big), Money::fromMinorUnits(5)};
+        REQUIRE(summarize(fits, options).total == Money::fromMinorUnits(big + 5));
+
+        std::vector<Money> overflows(3, Money::fromMinorUnits(big));
+        REQUIRE_THROWS_AS(summarize(overflows, options), std::overflow_error);
+    }
+}
+
+TEST_CASE("Histograms and ranges bucket by half-open intervals", "[balance_stats]") {
+    std::vector<Money> balances;
+    for (int i = -5; i < 20; ++i)
+        balances.push_back(Money(static_cast<double>(i)));
+    std::vector<Money> edges = {Money(0.0), Money(10.0), Money(15.0)};
+
+    for (SimdLevel level : supportedLevels()) {
+        Options options{level, 2};
+        REQUIRE(histogram(balances, edges, options) == std::vector<std::size_t>{5, 10, 5, 5});
+        REQUIRE(histogram(balances, {}, options) == std::vector<std::size_t>{25});
+        REQUIRE(countInRange(balances, Money(0.0), Money(10.0), options) == 10);
+        REQUIRE(countInRange(balances, Money(10.0), Money(10.0), options) == 0);
+        REQUIRE(countInRange(balances, Money(10.0), Money(0.0), options) == 0);
+    }
+    REQUIRE_THROWS_AS(histogram(balances, {Money(10.0), Money(0.0)}), std::invalid_argument);
+}
+
+TEST_CASE("Bank aggregates its live balances", "[balance_stats]") {
+    std::string testFile = "test_balance_stats.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    int a = bank.createAccount("Alice", "1", Money(50.0));
+    int b = bank.createAccount("Bob", "2", Money(200.0));
+    bank.createAccount("Carol", "3", Money(1000.0));
+    bank.withdraw(a, Money(20.0));
+    bank.deleteAccount(b);
+
+    Summary summary = bank.balanceSummary();
+    REQUIRE(summary.count == 2);
+    REQUIRE(summary.total == Money(1030.0));
+    REQUIRE(summary.min == Money(30.0));
+    REQUIRE(summary.max == Money(1000.0));
+    REQUIRE(bank.countBalancesBelow(Money(100.0)) == 1);
+    REQUIRE(bank.countBalancesInRange(Money(30.0), Money(1000.0)) == 1);
+    REQUIRE(bank.balanceHistogram({Money(100.0)}) == std::vector<std::size_t>{1, 1});
+    std::filesystem::remove(testFile);
+}
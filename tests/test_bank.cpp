@@ -1,7 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include "bank.h"
 #include "json_persistence.h"
+#include "memory_persistence.h"
 #include <filesystem>
+#include <stdexcept>
 
 TEST_CASE("Bank create account", "[bank]") {
     std::string testFile = "test_bank.json";
@@ -10,11 +12,15 @@ TEST_CASE("Bank create account", "[bank]") {
     JsonPersistence persistence(testFile);
     Bank bank(persistence);
 
-    REQUIRE(bank.createAccount("user1"));
-    REQUIRE_FALSE(bank.createAccount("user1")); // Duplicate
+    int first = bank.createAccount("Alice", "11111111111111");
+    int second = bank.createAccount("Alice", "22222222222222");  // same owner, new account
+    REQUIRE(first > 0);
+    REQUIRE(second != first);
 
-    REQUIRE(bank.getAccount("user1").id() == "user1");
-    REQUIRE(bank.getAccount("user1").balance() == 0.0);
+    REQUIRE(bank.getAccount(first).getAccountId() == first);
+    REQUIRE(bank.getAccount(first).getPersonName() == "Alice");
+    REQUIRE(bank.getAccount(first).balance() == Money());
+    REQUIRE(bank.accountCount() == 2);
 
     bank.save();
     std::filesystem::remove(testFile);
@@ -27,14 +33,15 @@ TEST_CASE("Bank deposit and withdraw", "[bank]") {
     JsonPersistence persistence(testFile);
     Bank bank(persistence);
 
-    bank.createAccount("user1");
-    bank.deposit("user1", 100.0);
-    REQUIRE(bank.getAccount("user1").balance() == 100.0);
+    int id = bank.createAccount("Alice", "11111111111111");
+    bank.deposit(id, Money(100.0));
+    REQUIRE(bank.getBalance(id) == Money(100.0));
 
-    bank.withdraw("user1", 50.0);
-    REQUIRE(bank.getAccount("user1").balance() == 50.0);
+    bank.withdraw(id, Money(50.0));
+    REQUIRE(bank.getBalance(id) == Money(50.0));
 
-    REQUIRE_THROWS_AS(bank.withdraw("user1", 100.0), std::runtime_error);
+    REQUIRE_THROWS_AS(bank.withdraw(id, Money(100.0)), std::runtime_error);
+    REQUIRE_THROWS_AS(bank.deposit(id + 1, Money(1.0)), std::runtime_error);
 
     bank.save();
     std::filesystem::remove(testFile);
@@ -47,11 +54,11 @@ TEST_CASE("Bank delete account", "[bank]") {
     JsonPersistence persistence(testFile);
     Bank bank(persistence);
 
-    bank.createAccount("user1");
-    REQUIRE(bank.deleteAccount("user1"));
-    REQUIRE_FALSE(bank.deleteAccount("user1"));
+    int id = bank.createAccount("Alice", "11111111111111");
+    REQUIRE(bank.deleteAccount(id));
+    REQUIRE_FALSE(bank.deleteAccount(id));
 
-    REQUIRE_THROWS_AS(bank.getAccount("user1"), std::runtime_error);
+    REQUIRE_THROWS_AS(bank.getAccount(id), std::runtime_error);
 
     bank.save();
     std::filesystem::remove(testFile);
@@ -63,15 +70,40 @@ TEST_CASE("Bank load from persistence", "[bank]") {
 
     {
         JsonPersistence persistence(testFile);
-        std::unordered_map<UserId, Account> accounts;
-        accounts.emplace("user1", Account("user1", 150.0));
+        std::unordered_map<int, Account> accounts;
+        accounts.emplace(7, Account(7, Money(150.0), "Alice", "11111111111111"));
         persistence.save(accounts);
     }
 
     JsonPersistence loadPersistence(testFile);
     Bank bank(loadPersistence);
 
-    REQUIRE(bank.getAccount("user1").balance() == 150.0);
+    REQUIRE(bank.getBalance(7) == Money(150.0));
+    // New IDs continue after the highest loaded one.
+    REQUIRE(bank.createAccount("Bob", "22222222222222") == 8);
 
     std::filesystem::remove(testFile);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Bank takes a change back when its record cannot be written", "[bank]") {
+    FailingPersistence persistence;
+    Bank bank(persistence);
+    int id = bank.createAccount("Alice", "11111111111111", Money(100.0));
+    Account before = bank.getAccount(id);
+
+    persistence.failing = true;
+    REQUIRE_THROWS(bank.deposit(id, Money(5.0)));
+    REQUIRE_THROWS(bank.withdraw(id, Money(5.0)));
+    REQUIRE(bank.getBalance(id) == Money(100.0));
+    REQUIRE(bank.getAccount(id).lastOperationType() == before.lastOperationType());
+    REQUIRE(bank.store().balances().front() == Money(100.0));
+
+    REQUIRE_THROWS(bank.createAccount("Bob", "22222222222222"));
+    REQUIRE(bank.accountCount() == 1);
+    REQUIRE(bank.findByOwner("Bob").empty());
+    REQUIRE_THROWS(bank.deleteAccount(id));
+    REQUIRE(bank.getBalance(id) == Money(100.0));
+
+    persistence.failing = false;
+    REQUIRE(bank.createAccount("Bob", "22222222222222") == id + 1);
+}
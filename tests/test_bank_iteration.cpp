@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "json_persistence.h"
+#include <filesystem>
+#include <set>
+
+TEST_CASE("Bank iterates accounts without copying", "[iteration]") {
+    std::string testFile = "test_iteration.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    int a = bank.createAccount("Alice", "1", Money(10.0));
+    int b = bank.createAccount("Bob", "2", Money(20.0));
+
+    std::set<int> seen;
+    for (const Account& account : bank.accounts())
+        seen.insert(account.getAccountId());
+    REQUIRE(seen == std::set<int>{a, b});
+    REQUIRE(bank.accounts().size() == 2);
+
+    Money total;
+    const Account* alice = nullptr;
+    bank.forEachAccount([&](const Account& account) {
+        total += account.balance();
+        if (account.getAccountId() == a)
+            alice = &account;
+    });
+    REQUIRE(total == Money(30.0));
+    // The visitor sees the stored account, not a copy.
+    bank.deposit(a, Money(1.0));
+    REQUIRE(alice->balance() == Money(11.0));
+}
+
+TEST_CASE("Bank pages through accounts in ID order", "[iteration]") {
+    std::string testFile = "test_iteration_page.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    for (int i = 0; i < 10; ++i)
+        bank.createAccount("P" + std::to_string(i), "card", Money(1.0));
+    bank.deleteAccount(4);
+    bank.deleteAccount(5);
+
+    std::vector<int> ids;
+    int cursor = 0;
+    int pages = 0;
+    do {
+        Bank::AccountPage page = bank.page(cursor, 3);
+        for (const Account* account : page.accounts)
+            ids.push_back(account->getAccountId());
+        cursor = page.nextCursor;
+        ++pages;
+    } while (cursor != 0);
+
+    REQUIRE(ids == std::vector<int>{1, 2, 3, 6, 7, 8, 9, 10});
+    REQUIRE(pages == 3);
+    REQUIRE(bank.page(0, 0).accounts.empty());
+}
+
+TEST_CASE("Bank keeps the balance column in step with every mutation", "[iteration]") {
+    std::string testFile = "test_iteration_columns.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    int a = bank.createAccount("Alice", "1", Money(10.0));
+    int b = bank.createAccount("Bob", "2", Money(20.0));
+    int c = bank.createAccount("Carol", "3", Money(30.0));
+
+    bank.deposit(a, Money(5.0));
+    bank.withdraw(b, Money(5.0));
+    bank.transfer(c, a, Money(1.0));
+    bank.transferMany({{a, b, Money(2.0)}});
+    bank.applyBatch({{1, BatchOpType::Deposit, c, Money(4.0)}});
+    bank.deleteAccount(b);
+
+    const AccountStore& store = bank.store();
+    REQUIRE(store.size() == 2);
+    Money total;
+    for (Money balance : store.balances())
+        total += balance;
+    REQUIRE(total == Money(10.0 + 5.0 + 1.0 - 2.0 + 30.0 - 1.0 + 4.0));
+    std::size_t slot = 0;
+    for (const Account& account : bank.accounts()) {
+        REQUIRE(store.balances()[slot] == account.balance());
+        REQUIRE(store.lastOperationTimes()[slot] == account.lastOperationTime());
+        ++slot;
+    }
+}
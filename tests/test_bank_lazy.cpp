@@ -0,0 +1,202 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "binary_persistence.h"
+#include "journal_persistence.h"
+#include <filesystem>
+#include <set>
+
+namespace {
+
+// Saves `count` accounts, IDs 1..count, balance equal to the ID.
+void writeBook(const std::string& file, int count) {
+    std::filesystem::remove(file);
+    BinaryPersistence persistence(file);
+    Bank bank(persistence);
+    for (int i = 1; i <= count; ++i)
+        bank.createAccount("Person " + std::to_string(i), "card" + std::to_string(i % 7), Money(i * 1.0));
+    bank.save();
+}
+
+BankOptions lazy(std::size_t residentAccounts) {
+    BankOptions options;
+    options.lazyLoad = true;
+    options.residentAccounts = residentAccounts;
+    return options;
+}
+
+} // namespace
+
+TEST_CASE("Lazy bank starts without loading accounts", "[lazy]") {
+    std::string testFile = "test_lazy_start.bin";
+    writeBook(testFile, 50);
+
+    BinaryPersistence persistence(testFile);
+    Bank bank(persistence, lazy(10));
+    REQUIRE(bank.accountCount() == 50);
+    REQUIRE(bank.residentCount() == 0);
+
+    REQUIRE(bank.getBalance(17) == Money(17.0));
+    REQUIRE(bank.getAccount(3).getPersonName() == "Person 3");
+    REQUIRE(bank.residentCount() == 2);
+    REQUIRE(bank.find(99) == nullptr);
+    REQUIRE_THROWS(bank.getBalance(99));
+    // New IDs continue after the highest saved one.
+    REQUIRE(bank.createAccount("New", "card", Money(1.0)) == 51);
+    REQUIRE(bank.accountCount() == 51);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("Lazy bank keeps the resident set bounded", "[lazy]") {
+    std::string testFile = "test_lazy_evict.bin";
+    writeBook(testFile, 100);
+
+    BinaryPersistence persistence(testFile);
+    Bank bank(persistence, lazy(8));
+    for (int id = 1; id <= 100; ++id)
+        REQUIRE(bank.getBalance(id) == Money(id * 1.0));
+    REQUIRE(bank.residentCount() == 8);
+
+    // Changed accounts are kept until saved, however many there are.
+    for (int id = 1; id <= 20; ++id)
+        bank.deposit(id, Money(1.0));
+    REQUIRE(bank.residentCount() >= 20);
+    for (int id = 50; id <= 100; ++id)
+        bank.getBalance(id);
+    for (int id = 1; id <= 20; ++id)
+        REQUIRE(bank.find(id)->balance() == Money(id + 1.0));
+
+    bank.save();
+    REQUIRE(bank.residentCount() <= 8);
+    REQUIRE(bank.getBalance(5) == Money(6.0));
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("Lazy bank saves untouched, changed, new and deleted accounts", "[lazy]") {
+    std::string testFile = "test_lazy_save.bin";
+    writeBook(testFile, 30);
+    {
+        BinaryPersistence persistence(testFile);
+        Bank bank(persistence, lazy(4));
+        bank.deposit(2, Money(10.0));
+        bank.transfer(3, 4, Money(3.0));
+        REQUIRE(bank.deleteAccount(5));
+        REQUIRE_FALSE(bank.deleteAccount(5));
+        REQUIRE_FALSE(bank.deleteAccount(31));
+        int created = bank.createAccount("Zed", "z", Money(7.0));
+        REQUIRE(bank.accountCount() == 30);
+        REQUIRE(bank.balanceSummary().count == 30);
+        REQUIRE(bank.residentCount() < 30);
+        bank.save();
+        REQUIRE(created == 31);
+    }
+
+    BinaryPersistence persistence(testFile);
+    Bank bank(persistence);
+    REQUIRE(bank.accountCount() == 30);
+    REQUIRE(bank.getBalance(1) == Money(1.0));
+    REQUIRE(bank.getBalance(2) == Money(12.0));
+    REQUIRE(bank.getBalance(3) == Money(0.0));
+    REQUIRE(bank.getBalance(4) == Money(7.0));
+    REQUIRE(bank.find(5) == nullptr);
+    REQUIRE(bank.getBalance(31) == Money(7.0));
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("Lazy bank unpins what a snapshot saved elsewhere covers", "[lazy]") {
+    std::string testFile = "test_lazy_mark.bin";
+    writeBook(testFile, 50);
+    {
+        BinaryPersistence persistence(testFile);
+        Bank bank(persistence, lazy(5));
+        for (int id = 1; id <= 20; ++id)
+            bank.deposit(id, Money(100.0));
+        REQUIRE(bank.residentCount() == 20);
+
+        // As AutoSaver does: copy and mark, carry on, then write the copy.
+        std::unordered_map<int, Account> copy = bank.snapshot();
+        const std::uint64_t mark = bank.markSnapshot();
+        bank.deposit(30, Money(100.0));
+        REQUIRE(bank.deleteAccount(40));
+        REQUIRE(bank.deleteAccount(2));
+        const int created = bank.createAccount("New", "card", Money(5.0));
+        persistence.save(copy);
+        bank.snapshotSaved(persistence.openSource(), mark);
+
+        // Only 30 and the new account are still pinned.
+        REQUIRE(bank.residentCount() == 5);
+        REQUIRE(bank.accountCount() == 49);
+        REQUIRE(bank.find(40) == nullptr);
+        REQUIRE(bank.find(2) == nullptr);
+        REQUIRE(bank.getBalance(1) == Money(101.0));
+        REQUIRE(bank.getBalance(30) == Money(130.0));
+        REQUIRE(bank.getBalance(created) == Money(5.0));
+        bank.save();
+    }
+
+    BinaryPersistence persistence(testFile);
+    Bank bank(persistence);
+    REQUIRE(bank.accountCount() == 49);
+    REQUIRE(bank.getBalance(20) == Money(120.0));
+    REQUIRE(bank.getBalance(30) == Money(130.0));
+    REQUIRE(bank.find(40) == nullptr);
+    REQUIRE(bank.getBalance(51) == Money(5.0));
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("Lazy bank pages in ID order and loads everything for searches", "[lazy]") {
+    std::string testFile = "test_lazy_page.bin";
+    writeBook(testFile, 10);
+
+    BinaryPersistence persistence(testFile);
+    Bank bank(persistence, lazy(5));
+    bank.deleteAccount(4);
+    bank.createAccount("New", "card", Money(1.0));
+
+    std::vector<int> ids;
+    int cursor = 0;
+    do {
+        Bank::AccountPage page = bank.page(cursor, 3);
+        for (const Account* account : page.accounts)
+            ids.push_back(account->getAccountId());
+        cursor = page.nextCursor;
+    } while (cursor != 0);
+    REQUIRE(ids == std::vector<int>{1, 2, 3, 5, 6, 7, 8, 9, 10, 11});
+
+    REQUIRE(bank.findByOwner("Person 7") == std::vector<int>{7});
+    REQUIRE(bank.residentCount() == 10);
+    std::set<int> seen;
+    for (const Account& account : bank.accounts())
+        seen.insert(account.getAccountId());
+    REQUIRE(seen.size() == 10);
+    REQUIRE(seen.count(4) == 0);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("Lazy bank falls back to loading when the journal has records", "[lazy]") {
+    std::string snapshotFile = "test_lazy_journal.bin";
+    std::string journalFile = "test_lazy.journal";
+    writeBook(snapshotFile, 5);
+    std::filesystem::remove(journalFile);
+    {
+        BinaryPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile, 1);
+        Bank bank(persistence, lazy(2));
+        REQUIRE(bank.residentCount() == 0);
+        bank.deposit(1, Money(5.0));
+        // No save(): the deposit is only in the journal.
+    }
+
+    BinaryPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence, lazy(2));
+    REQUIRE(bank.residentCount() == 5);
+    REQUIRE(bank.getBalance(1) == Money(6.0));
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
@@ -0,0 +1,62 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "json_persistence.h"
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+struct RecordingObserver : IBankObserver {
+    std::vector<int> created;
+    std::vector<int> deleted;
+    std::vector<int> changed;
+
+    void accountCreated(const Account& account) override { created.push_back(account.getAccountId()); }
+    void accountDeleted(int accountId) override { deleted.push_back(accountId); }
+    void accountChanged(const Account& account) override { changed.push_back(account.getAccountId()); }
+};
+
+} // namespace
+
+TEST_CASE("Bank notifies observers of each change", "[observer]") {
+    std::string testFile = "test_observer.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    RecordingObserver observer;
+    bank.addObserver(&observer);
+
+    int a = bank.createAccount("A", "1", Money(10.0));
+    int b = bank.createAccount("B", "2", Money(10.0));
+    bank.deposit(a, Money(1.0));
+    bank.transfer(a, b, Money(2.0));
+    REQUIRE_THROWS(bank.withdraw(b, Money(100.0)));
+    bank.deleteAccount(a);
+
+    REQUIRE(observer.created == std::vector<int>{a, b});
+    REQUIRE(observer.changed == std::vector<int>{a, a, b});
+    REQUIRE(observer.deleted == std::vector<int>{a});
+
+    bank.removeObserver(&observer);
+    bank.deposit(b, Money(1.0));
+    REQUIRE(observer.changed.size() == 3);
+}
+
+TEST_CASE("Bank applyBatch notifies once per touched account", "[observer]") {
+    std::string testFile = "test_observer_batch.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    int a = bank.createAccount("A", "1", Money(10.0));
+    int b = bank.createAccount("B", "2", Money(10.0));
+    RecordingObserver observer;
+    bank.addObserver(&observer);
+
+    bank.applyBatch({
+        {1, BatchOpType::Deposit, b, Money(1.0)},
+        {2, BatchOpType::Deposit, a, Money(1.0)},
+        {3, BatchOpType::Withdraw, b, Money(1.0)},
+        {4, BatchOpType::Deposit, 999, Money(1.0)},
+    });
+    REQUIRE(observer.changed == std::vector<int>{a, b});
+}
@@ -0,0 +1,284 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "bank_server.h"
+#include "memory_persistence.h"
+#include "remote_bank.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* const kSocket = "test_bank_server.sock";
+
+// Counts syncs, or fails them, and notes how many accounts the bank held at
+// the last one.
+class SyncedPersistence : public MemoryPersistence {
+public:
+    void recordCreate(const Account&) override { ++created; }
+    void flush() override {
+        if (failing)
+            throw std::runtime_error("disk full");
+        ++syncs;
+        createdAtSync = created.load();
+    }
+
+    std::atomic<int> created{0};
+    std::atomic<int> syncs{0};
+    std::atomic<int> createdAtSync{0};
+    std::atomic<bool> failing{false};
+};
+
+BankServerOptions serverOptions() {
+    BankServerOptions options;
+    options.socketPath = kSocket;
+    return options;
+}
+
+int connectRaw() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, kSocket);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    return fd;
+}
+
+// Reads until `buffer` holds a whole frame or the server closes the
+// connection; returns false on close.
+bool readFrame(int fd, std::string& buffer, bank_protocol::Frame& frame) {
+    char chunk[4096];
+    while (!bank_protocol::nextFrame(buffer, frame)) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, static_cast<std::size_t>(n));
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("RemoteBank drives a served bank like a local one", "[server]") {
+    MemoryPersistence persistence;
+    Bank bank(persistence);
+    BankServer server(bank, serverOptions());
+    RemoteBank remote(kSocket);
+
+    int a = remote.createAccount("Alice", "C-1", Money(100.0));
+    int b = remote.createAccount("Bob", "C-2");
+    remote.deposit(b, Money(25.5));
+    remote.withdraw(a, Money(10.0));
+    remote.transfer(a, b, Money(40.0));
+    REQUIRE(remote.getBalance(a) == Money(50.0));
+    REQUIRE(remote.getBalance(b) == Money(65.5));
+
+    Account account = remote.getAccount(b);
+    REQUIRE(account.getAccountId() == b);
+    REQUIRE(account.getPersonName() == "Bob");
+    REQUIRE(account.getCardId() == "C-2");
+    REQUIRE(account.lastOperationType() == OperationType::TransferIn);
+
+    // Errors come back as the exceptions the bank threw.
+    REQUIRE_THROWS_AS(remote.deposit(a, Money(-1.0)), std::invalid_argument);
+    REQUIRE_THROWS_WITH(remote.withdraw(a, Money(1000.0)), "Insufficient balance");
+    REQUIRE_THROWS_WITH(remote.getBalance(999), "Account not found");
+    REQUIRE_THROWS_AS(remote.deposit(a, Money::fromMinorUnits(INT64_MAX)), std::overflow_error);
+
+    // transferMany stays all or nothing.
+    REQUIRE_THROWS(remote.transferMany({{a, b, Money(10.0)}, {b, a, Money(1000.0)}}));
+    REQUIRE(remote.getBalance(a) == Money(50.0));
+    remote.transferMany({{a, b, Money(10.0)}, {b, a, Money(5.0)}});
+    REQUIRE(remote.getBalance(a) == Money(45.0));
+
+    REQUIRE(remote.deleteAccount(b));
+    REQUIRE_FALSE(remote.deleteAccount(b));
+    REQUIRE(bank.accountCount() == 1);
+}
+
+TEST_CASE("RemoteBank runs batches and posting runs on the server", "[server]") {
+    MemoryPersistence persistence;
+    Bank bank(persistence);
+    constexpr int kAccounts = kPostingChunk + 100;
+    for (int i = 0; i < kAccounts; ++i)
+        bank.createAccount("Owner", "C", Money(1000.0));
+    BankServer server(bank, serverOptions());
+    RemoteBank remote(kSocket);
+
+    BatchReport batch = remote.applyBatch({
+        {1, BatchOpType::Deposit, 1, Money(5.0)},
+        {2, BatchOpType::Withdraw, 2, Money(5000.0)},
+        {3, BatchOpType::Withdraw, kAccounts + 1, Money(1.0)},
+    });
+    REQUIRE(batch.applied == 1);
+    REQUIRE(batch.failures.size() == 2);
+    REQUIRE(batch.failures[0].line == 2);
+    REQUIRE(batch.failures[1].message == "Account not found");
+
+    // A 1.00 fee on every account, stopped after the first chunk and resumed.
+    PostingSchedule schedule = PostingSchedule::parse("0,,0,1.00\n");
+    PostingCheckpoint checkpoint;
+    int chunks = 0;
+    PostingReport first = remote.applyPostings(schedule, checkpoint, [&](const PostingCheckpoint&) {
+        ++chunks;
+        return false;
+    });
+    REQUIRE(chunks == 1);
+    REQUIRE_FALSE(first.complete);
+    REQUIRE(first.posted == kPostingChunk);
+
+    PostingReport rest = remote.applyPostings(schedule, checkpoint);
+    REQUIRE(rest.complete);
+    REQUIRE(first.posted + rest.posted == kAccounts);
+    REQUIRE(rest.fees == Money(static_cast<double>(rest.posted)));
+    REQUIRE(remote.getBalance(1) == Money(1004.0));
+    REQUIRE(remote.getBalance(kAccounts) == Money(999.0));
+}
+
+TEST_CASE("Pipelined requests from several clients are all applied", "[server]") {
+    MemoryPersistence persistence;
+    Bank bank(persistence);
+    int shared = bank.createAccount("Shared", "S");
+    BankServer server(bank, serverOptions());
+
+    constexpr int kClients = 4;
+    constexpr int kDeposits = 20000;
+    // Catch assertions are not thread-safe: clients keep their results and
+    // the checks run once they are done.
+    std::vector<std::vector<PipelineResult>> results(kClients);
+    std::vector<Money> balancesAfter(kClients);
+    std::vector<std::thread> clients;
+    for (int c = 0; c < kClients; ++c)
+        clients.emplace_back([&, c] {
+            RemoteBank remote(kSocket);
+            RemotePipeline pipeline(remote);
+            for (int i = 0; i < kDeposits; ++i)
+                pipeline.deposit(shared, Money::fromMinorUnits(1));
+            pipeline.withdraw(shared, Money::fromMinorUnits(-1));  // invalid
+            pipeline.getBalance(shared);
+            results[c] = pipeline.run();
+            // The connection is still in step after a pipeline.
+            balancesAfter[c] = remote.getBalance(shared);
+        });
+    for (std::thread& client : clients)
+        client.join();
+
+    for (int c = 0; c < kClients; ++c) {
+        REQUIRE(results[c].size() == kDeposits + 2);
+        std::size_t failures = 0;
+        for (const PipelineResult& result : results[c])
+            failures += result.ok ? 0 : 1;
+        REQUIRE(failures == 1);
+        REQUIRE(results[c][kDeposits].error == "Withdraw amount must be positive");
+        REQUIRE(results[c].back().balance >= Money::fromMinorUnits(kDeposits));
+        REQUIRE(balancesAfter[c] >= results[c].back().balance);
+    }
+    REQUIRE(bank.getBalance(shared) == Money::fromMinorUnits(kClients * kDeposits));
+}
+
+TEST_CASE("BankServer rejects bad requests and drops broken streams", "[server]") {
+    MemoryPersistence persistence;
+    Bank bank(persistence);
+    BankServer server(bank, serverOptions());
+    using namespace bank_protocol;
+
+    int fd = connectRaw();
+    std::string requests;
+    Writer out(requests);
+    out.beginFrame(7, 99);  // no such operation
+    out.endFrame();
+    out.beginFrame(8, static_cast<std::uint8_t>(Op::Deposit));
+    out.put(std::int32_t{1});  // amount missing
+    out.endFrame();
+    out.beginFrame(9, static_cast<std::uint8_t>(Op::CreateAccount));
+    out.putString("A");
+    out.putString("1");
+    out.putMoney(Money(1.0));
+    out.endFrame();
+    REQUIRE(::send(fd, requests.data(), requests.size(), 0) == static_cast<ssize_t>(requests.size()));
+
+    std::string buffer;
+    Frame frame;
+    for (std::uint32_t tag : {7u, 8u}) {
+        REQUIRE(readFrame(fd, buffer, frame));
+        REQUIRE(frame.tag == tag);
+        REQUIRE(frame.code == static_cast<std::uint8_t>(Status::BadRequest));
+        buffer.erase(0, frame.size);
+    }
+    REQUIRE(readFrame(fd, buffer, frame));
+    REQUIRE(frame.tag == 9);
+    REQUIRE(frame.code == static_cast<std::uint8_t>(Status::Ok));
+    buffer.erase(0, frame.size);
+    REQUIRE(bank.accountCount() == 1);
+
+    // A frame size out of range cannot be skipped: the server hangs up.
+    const std::uint32_t hugeSize = kMaxFrame + 1;
+    REQUIRE(::send(fd, &hugeSize, sizeof(hugeSize), 0) == sizeof(hugeSize));
+    REQUIRE_FALSE(readFrame(fd, buffer, frame));
+    ::close(fd);
+
+    // Other clients are unaffected.
+    RemoteBank remote(kSocket);
+    REQUIRE(remote.getBalance(1) == Money(1.0));
+}
+
+TEST_CASE("BankServer syncs the journal before it replies", "[server]") {
+    SyncedPersistence persistence;
+    Bank bank(persistence);
+    BankServerOptions options = serverOptions();
+    options.journal = &persistence;
+    BankServer server(bank, options);
+    RemoteBank remote(kSocket);
+
+    remote.createAccount("Alice", "C-1");
+    remote.createAccount("Bob", "C-2");
+    REQUIRE(persistence.createdAtSync == 2);
+    REQUIRE(persistence.syncs >= 2);
+
+    // No reply for a change that did not reach the disk.
+    persistence.failing = true;
+    REQUIRE_THROWS(remote.createAccount("Carol", "C-3"));
+    persistence.failing = false;
+    RemoteBank again(kSocket);
+    REQUIRE(again.getBalance(1) == Money(0.0));
+}
+
+TEST_CASE("BankServer takes over only a stale socket", "[server]") {
+    MemoryPersistence persistence;
+    Bank bank(persistence);
+    {
+        BankServer server(bank, serverOptions());
+        // A live server keeps its socket.
+        REQUIRE_THROWS_AS(BankServer(bank, serverOptions()), std::runtime_error);
+        RemoteBank remote(kSocket);
+        REQUIRE(remote.createAccount("Alice", "C-1") == 1);
+    }
+
+    // A socket left behind by a server that crashed is replaced.
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, kSocket);
+    REQUIRE(::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    ::close(fd);
+    {
+        BankServer server(bank, serverOptions());
+        RemoteBank remote(kSocket);
+        REQUIRE(remote.getBalance(1) == Money(0.0));
+    }
+
+    // Anything else at the path is left alone.
+    std::ofstream(kSocket) << "not a socket";
+    REQUIRE_THROWS(BankServer(bank, serverOptions()));
+    std::ifstream kept(kSocket);
+    std::string text;
+    std::getline(kept, text);
+    REQUIRE(text == "not a socket");
+    std::remove(kSocket);
+}
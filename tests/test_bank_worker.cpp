@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank_worker.h"
+#include "json_persistence.h"
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("BankWorker runs jobs in order on its own thread", "[worker]") {
+    std::string testFile = "test_worker.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    std::vector<int> order;
+    std::thread::id jobThread;
+    {
+        BankWorker worker(bank);
+        for (int i = 0; i < 100; ++i)
+            worker.post([&order, &jobThread, i](Bank&) {
+                order.push_back(i);
+                jobThread = std::this_thread::get_id();
+            });
+        worker.waitIdle();
+        REQUIRE(order.size() == 100);
+        worker.post([](Bank& b) { b.createAccount("A", "1", Money(5.0)); });
+    }
+    // The destructor drains the queue.
+    REQUIRE(bank.accountCount() == 1);
+    REQUIRE(jobThread != std::this_thread::get_id());
+    for (int i = 0; i < 100; ++i)
+        REQUIRE(order[static_cast<std::size_t>(i)] == i);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("BankWorker coalesces jobs posted under the same key", "[worker]") {
+    std::string testFile = "test_worker.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    BankWorker worker(bank);
+
+    // Hold the worker so everything below queues up behind this job.
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    worker.post([gate](Bank&) { gate.wait(); });
+
+    std::vector<int> ran;
+    REQUIRE(worker.postCoalesced("refresh", [&ran](Bank&) { ran.push_back(1); }));
+    worker.post([&ran](Bank&) { ran.push_back(0); });
+    REQUIRE_FALSE(worker.postCoalesced("refresh", [&ran](Bank&) { ran.push_back(2); }));
+    REQUIRE_FALSE(worker.postCoalesced("refresh", [&ran](Bank&) { ran.push_back(3); }));
+    REQUIRE(worker.postCoalesced("save", [&ran](Bank&) { ran.push_back(4); }));
+    release.set_value();
+    worker.waitIdle();
+
+    // The latest refresh ran once, in the slot of the first.
+    REQUIRE(ran == std::vector<int>{3, 0, 4});
+
+    // Once a keyed job has started, the key is free again.
+    REQUIRE(worker.postCoalesced("refresh", [&ran](Bank&) { ran.push_back(5); }));
+    worker.waitIdle();
+    REQUIRE(ran.back() == 5);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("BankWorker survives a throwing job", "[worker]") {
+    std::string testFile = "test_worker.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    BankWorker worker(bank);
+
+    std::vector<std::string> errors;
+    worker.setErrorHandler([&errors](const std::string& error) { errors.push_back(error); });
+    std::atomic<bool> after{false};
+    worker.post([](Bank& b) { b.deposit(42, Money(1.0)); });
+    worker.post([](Bank&) { throw 42; });
+    worker.post([&after](Bank&) { after = true; });
+    worker.waitIdle();
+    REQUIRE(after);
+    REQUIRE(errors == std::vector<std::string>{"Account not found", "Unknown error"});
+
+    std::filesystem::remove(testFile);
+}
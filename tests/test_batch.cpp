@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "batch.h"
+#include "concurrent_bank.h"
+#include "json_persistence.h"
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE("BatchReader parses CSV and reports bad lines", "[batch]") {
+    std::string testFile = "test_batch.csv";
+    {
+        std::ofstream out(testFile);
+        out << "op,accountId,amount\n"
+            << "deposit,1,100.50\n"
+            << "\n"
+            << "# settlement adjustments\n"
+            << " Withdraw , 2 , 5\n"
+            << "refund,1,3\n"
+            << "deposit,abc,3\n"
+            << "deposit,1\n";
+    }
+
+    BatchReader reader(testFile);
+    std::vector<BatchOperation> operations;
+    std::vector<BatchFailure> failures;
+    REQUIRE(reader.next(operations, failures));
+
+    REQUIRE(operations.size() == 2);
+    REQUIRE(operations[0].line == 2);
+    REQUIRE(operations[0].type == BatchOpType::Deposit);
+    REQUIRE(operations[0].amount == Money(100.5));
+    REQUIRE(operations[1].type == BatchOpType::Withdraw);
+    REQUIRE(operations[1].accountId == 2);
+    REQUIRE(failures.size() == 3);
+    REQUIRE(failures[0].line == 6);
+    REQUIRE(failures[2].line == 8);
+    REQUIRE_FALSE(reader.next(operations, failures));
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("BatchReader parses JSON Lines in chunks", "[batch]") {
+    std::string testFile = "test_batch.jsonl";
+    {
+        std::ofstream out(testFile);
+        out << R"({"op": "deposit", "accountId": 1, "amount": 10})" << '\n'
+            << R"({"type": "withdrawal", "accountId": 1, "amount": 2.5})" << '\n'
+            << R"({"op": "deposit", "accountId": "x", "amount": 1})" << '\n';
+    }
+
+    BatchReader reader(testFile);
+    std::vector<BatchOperation> operations;
+    std::vector<BatchFailure> failures;
+    REQUIRE(reader.next(operations, failures, 1));
+    REQUIRE(operations.size() == 1);
+    REQUIRE(reader.next(operations, failures, 1));
+    REQUIRE(operations[0].type == BatchOpType::Withdraw);
+    REQUIRE(operations[0].amount == Money(2.5));
+    REQUIRE(reader.next(operations, failures, 1));
+    REQUIRE(operations.empty());
+    REQUIRE(failures.size() == 1);
+    REQUIRE(failures[0].line == 3);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("BatchReader reads JSON Lines numbers as exactly as CSV", "[batch]") {
+    std::string testFile = "test_batch_exact.jsonl";
+    {
+        std::ofstream out(testFile);
+        out << R"({"op": "deposit", "accountId": 4294967297, "amount": 1})" << '\n'
+            << R"({"op": "deposit", "accountId": 1.0, "amount": 1})" << '\n'
+            << R"({"op": "deposit", "accountId": 2, "amount": 0.29})" << '\n'
+            << R"({"op": "deposit", "accountId": 3, "amount": 10000000000000.01})" << '\n'
+            << R"({"op": "deposit", "accountId": 4, "amount": "5"})" << '\n'
+            << R"({"op": "deposit", "accountId": 5, "amount": 0.001})" << '\n'
+            << R"({"op": "deposit", "accountId": 6, "amount": 7, "note": {"amount": 1}})" << '\n';
+    }
+
+    BatchReader reader(testFile);
+    std::vector<BatchOperation> operations;
+    std::vector<BatchFailure> failures;
+    REQUIRE(reader.next(operations, failures, 100));
+    REQUIRE(operations.size() == 3);
+    REQUIRE(operations[0].accountId == 2);
+    REQUIRE(operations[0].amount == Money::fromMinorUnits(29));
+    REQUIRE(operations[1].amount == Money::fromMinorUnits(1000000000000001));
+    REQUIRE(operations[2].accountId == 6);
+    REQUIRE(operations[2].amount == Money(7.0));
+    // An ID out of range is refused, not wrapped onto account 1.
+    REQUIRE(failures.size() == 4);
+    REQUIRE(failures[0].line == 1);
+    REQUIRE(failures[0].message == "Invalid account ID");
+    REQUIRE(failures[1].message == "Invalid account ID");
+    REQUIRE(failures[2].message == "Invalid amount");
+    REQUIRE(failures[3].message == "Invalid amount");
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("Bank applyBatch keeps going past failures", "[batch]") {
+    std::string testFile = "test_batch_bank.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    int a = bank.createAccount("A", "1", Money(10.0));
+    int b = bank.createAccount("B", "2", Money(0.0));
+
+    BatchReport report = bank.applyBatch({
+        {1, BatchOpType::Withdraw, b, Money(5.0)},   // insufficient at this point
+        {2, BatchOpType::Deposit, a, Money(5.0)},
+        {3, BatchOpType::Deposit, b, Money(7.0)},
+        {4, BatchOpType::Withdraw, b, Money(5.0)},
+        {5, BatchOpType::Deposit, 999, Money(1.0)},
+        {6, BatchOpType::Withdraw, a, Money(15.0)},
+    });
+
+    REQUIRE(report.applied == 4);
+    REQUIRE(report.failures.size() == 2);
+    REQUIRE(report.failures[0].line == 1);
+    REQUIRE(report.failures[1].line == 5);
+    REQUIRE(report.failures[1].message == "Account not found");
+    REQUIRE(bank.getBalance(a) == Money(0.0));
+    REQUIRE(bank.getBalance(b) == Money(2.0));
+}
+
+TEST_CASE("ConcurrentBank applyBatch matches line-by-line application", "[batch]") {
+    std::string testFile = "test_batch_concurrent.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    ConcurrentBank bank(persistence, 8);
+    Bank reference(persistence);
+
+    std::vector<int> ids;
+    for (int i = 0; i < 100; ++i) {
+        ids.push_back(bank.createAccount("P", "card", Money(50.0)));
+        reference.createAccount("P", "card", Money(50.0));
+    }
+
+    std::vector<BatchOperation> operations;
+    for (std::size_t line = 1; line <= 20000; ++line) {
+        int id = ids[(line * 7) % ids.size()];
+        BatchOpType type = line % 3 == 0 ? BatchOpType::Withdraw : BatchOpType::Deposit;
+        operations.push_back({line, type, id, Money::fromMinorUnits(static_cast<std::int64_t>(line % 11) * 100)});
+    }
+
+    BatchReport report = bank.applyBatch(operations);
+    BatchReport expected = reference.applyBatch(operations);
+    REQUIRE(report.applied == expected.applied);
+    REQUIRE(report.failures.size() == expected.failures.size());
+    for (int id : ids)
+        REQUIRE(bank.getBalance(id) == reference.getBalance(id));
+}
+
+TEST_CASE("applyBatchGroups takes back operations it cannot record", "[batch]") {
+    // Records deposits but not withdrawals.
+    struct NoWithdrawals : IPersistence {
+        void save(const std::unordered_map<int, Account>&) override {}
+        std::unordered_map<int, Account> load() override { return {}; }
+        void recordWithdraw(const Account&, Money) override { throw std::runtime_error("Journal write failed"); }
+    } persistence;
+    Account account(1, Money(10.0));
+    std::vector<BatchOperation> operations{{1, BatchOpType::Deposit, 1, Money(5.0)},
+                                           {2, BatchOpType::Withdraw, 1, Money(3.0)}};
+    std::vector<std::size_t> order{0, 1};
+    BatchReport report;
+    applyBatchGroups(operations, order, [&](int) { return &account; }, persistence, report);
+
+    REQUIRE(report.applied == 1);
+    REQUIRE(report.failures.size() == 1);
+    REQUIRE(report.failures[0].line == 2);
+    REQUIRE(account.balance() == Money(15.0));
+    REQUIRE(account.lastOperationType() == OperationType::Deposit);
+}
@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+#include "binary_persistence.h"
+#include "json_persistence.h"
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+TEST_CASE("BinaryPersistence save and load", "[binary]") {
+    std::string testFile = "test_accounts.bin";
+    std::filesystem::remove(testFile);
+
+    std::unordered_map<int, Account> accounts;
+    accounts.emplace(2, Account(2, Money(200.0), "Bob", "22222222222222"));
+    accounts.emplace(1, Account(1, Money(100.5), "Alice", "11111111111111"));
+    BinaryPersistence(testFile).save(accounts);
+
+    auto loaded = BinaryPersistence(testFile).load();
+    REQUIRE(loaded.size() == 2);
+    REQUIRE(loaded.at(1).balance() == Money(100.5));
+    REQUIRE(loaded.at(1).getPersonName() == "Alice");
+    REQUIRE(loaded.at(2).getCardId() == "22222222222222");
+    REQUIRE(loaded.at(2).creationTime() == accounts.at(2).creationTime());
+    REQUIRE(loaded.at(2).lastOperationType() == OperationType::None);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("BinarySnapshotView looks up records without loading", "[binary]") {
+    std::string testFile = "test_view.bin";
+    std::unordered_map<int, Account> accounts;
+    for (int id = 1; id <= 100; id += 3)
+        accounts.emplace(id, Account(id, Money(id * 1.5), "Person " + std::to_string(id), "card"));
+    BinaryPersistence(testFile).save(accounts);
+
+    BinarySnapshotView view(testFile);
+    REQUIRE(view.size() == accounts.size());
+    REQUIRE(view.maxAccountId() == 100);
+    REQUIRE(view.find(2) == BinarySnapshotView::npos);
+
+    std::size_t index = view.find(40);
+    REQUIRE(index != BinarySnapshotView::npos);
+    REQUIRE(view.accountId(index) == 40);
+    REQUIRE(view.balance(index) == Money(60.0));
+    REQUIRE(view.personName(index) == "Person 40");
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("BinarySnapshotView rejects foreign files", "[binary]") {
+    std::string testFile = "test_garbage.bin";
+    {
+        std::ofstream out(testFile, std::ios::binary);
+        out << std::string(64, 'x');
+    }
+    REQUIRE_THROWS_AS(BinarySnapshotView{testFile}, std::runtime_error);
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("convertSnapshot round-trips JSON through binary", "[binary]") {
+    std::string jsonFile = "test_convert.json";
+    std::string binFile = "test_convert.bin";
+    std::string backFile = "test_convert_back.json";
+
+    std::unordered_map<int, Account> accounts;
+    accounts.emplace(5, Account(5, Money(42.0), "Carol", "33333333333333"));
+    JsonPersistence json(jsonFile);
+    json.save(accounts);
+
+    BinaryPersistence binary(binFile);
+    convertSnapshot(json, binary);
+    JsonPersistence back(backFile);
+    convertSnapshot(binary, back);
+
+    auto loaded = back.load();
+    REQUIRE(loaded.size() == 1);
+    REQUIRE(loaded.at(5).balance() == Money(42.0));
+    REQUIRE(loaded.at(5).getPersonName() == "Carol");
+
+    std::filesystem::remove(jsonFile);
+    std::filesystem::remove(binFile);
+    std::filesystem::remove(backFile);
+}
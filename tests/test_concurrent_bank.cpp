@@ -0,0 +1,172 @@
+#include <catch2/catch_test_macros.hpp>
+#include "concurrent_bank.h"
+#include "journal_persistence.h"
+#include "json_persistence.h"
+#include "memory_persistence.h"
+#include <atomic>
+#include <filesystem>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kThreads = 8;
+
+template <typename Fn>
+void runThreads(Fn fn) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+        threads.emplace_back(fn, t);
+    for (auto& thread : threads)
+        thread.join();
+}
+
+} // namespace
+
+TEST_CASE("ConcurrentBank hands out unique IDs under contention", "[concurrent]") {
+    std::string testFile = "test_concurrent1.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    ConcurrentBank bank(persistence, 8);
+
+    std::vector<std::vector<int>> ids(kThreads);
+    runThreads([&](int t) {
+        for (int i = 0; i < 1000; ++i)
+            ids[t].push_back(bank.createAccount("Person", "card", Money(1.0)));
+    });
+
+    std::set<int> unique;
+    for (const auto& list : ids)
+        unique.insert(list.begin(), list.end());
+    REQUIRE(unique.size() == kThreads * 1000u);
+    REQUIRE(bank.accountCount() == kThreads * 1000u);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("ConcurrentBank conserves money under concurrent deposits and withdrawals", "[concurrent]") {
+    std::string testFile = "test_concurrent2.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    ConcurrentBank bank(persistence, 4);
+
+    constexpr int kAccounts = 64;
+    std::vector<int> accounts;
+    for (int i = 0; i < kAccounts; ++i)
+        accounts.push_back(bank.createAccount("Person", "card", Money(100.0)));
+
+    std::atomic<long> deposits{0};
+    std::atomic<long> withdrawals{0};
+    runThreads([&](int t) {
+        std::mt19937 rng(t);
+        std::uniform_int_distribution<int> pick(0, kAccounts - 1);
+        for (int i = 0; i < 20000; ++i) {
+            int id = accounts[pick(rng)];
+            if (i % 3 == 0) {
+                try {
+                    bank.withdraw(id, Money(2.0));
+                    withdrawals.fetch_add(2);
+                } catch (const std::runtime_error&) {
+                    // Insufficient balance is expected under contention.
+                }
+            } else {
+                bank.deposit(id, Money(1.0));
+                deposits.fetch_add(1);
+            }
+        }
+    });
+
+    Money total;
+    for (int id : accounts) {
+        Money balance = bank.getBalance(id);
+        REQUIRE(balance >= Money());
+        total += balance;
+    }
+    REQUIRE(total == Money(100.0 * kAccounts + deposits.load() - withdrawals.load()));
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("ConcurrentBank saves and reloads a consistent snapshot", "[concurrent]") {
+    std::string testFile = "test_concurrent3.json";
+    std::filesystem::remove(testFile);
+
+    int id = 0;
+    {
+        JsonPersistence persistence(testFile);
+        ConcurrentBank bank(persistence);
+        id = bank.createAccount("Alice", "11111111111111", Money(10.0));
+        bank.deposit(id, Money(5.0));
+        REQUIRE(bank.deleteAccount(bank.createAccount("Bob", "22222222222222")));
+        bank.save();
+    }
+
+    JsonPersistence persistence(testFile);
+    ConcurrentBank bank(persistence);
+    REQUIRE(bank.accountCount() == 1);
+    REQUIRE(bank.getAccount(id).getPersonName() == "Alice");
+    REQUIRE(bank.getBalance(id) == Money(15.0));
+    REQUIRE_THROWS_AS(bank.getBalance(id + 1), std::runtime_error);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("ConcurrentBank journals concurrent operations", "[concurrent]") {
+    std::string snapshotFile = "test_concurrent4.json";
+    std::string journalFile = "test_concurrent4.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+
+    std::vector<int> accounts;
+    {
+        JsonPersistence snapshot(snapshotFile);
+        // A tiny compaction threshold makes snapshots race with writers.
+        JournalPersistence persistence(snapshot, journalFile, 16, 50);
+        ConcurrentBank bank(persistence, 4);
+        for (int i = 0; i < 16; ++i)
+            accounts.push_back(bank.createAccount("Person", "card"));
+        runThreads([&](int t) {
+            for (int i = 0; i < 500; ++i)
+                bank.deposit(accounts[(t + i) % accounts.size()], Money(1.0));
+        });
+    }
+
+    JsonPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    ConcurrentBank bank(persistence);
+    Money total;
+    for (int id : accounts)
+        total += bank.getBalance(id);
+    REQUIRE(total == Money(kThreads * 500.0));
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("ConcurrentBank takes a change back when its record cannot be written", "[concurrent]") {
+    FailingPersistence persistence;
+    ConcurrentBank bank(persistence, 4);
+    int a = bank.createAccount("Alice", "1", Money(100.0));
+    int b = bank.createAccount("Bob", "2", Money(50.0));
+    const OperationType lastType = bank.getAccount(a).lastOperationType();
+
+    persistence.failing = true;
+    REQUIRE_THROWS(bank.deposit(a, Money(5.0)));
+    REQUIRE_THROWS(bank.withdraw(a, Money(5.0)));
+    REQUIRE_THROWS(bank.transfer(a, b, Money(10.0)));
+    REQUIRE_THROWS(bank.transferMany({{a, b, Money(10.0)}}));
+    REQUIRE(bank.getBalance(a) == Money(100.0));
+    REQUIRE(bank.getBalance(b) == Money(50.0));
+    REQUIRE(bank.getAccount(a).lastOperationType() == lastType);
+
+    REQUIRE_THROWS(bank.createAccount("Carol", "3"));
+    REQUIRE(bank.accountCount() == 2);
+    REQUIRE_THROWS(bank.deleteAccount(b));
+    REQUIRE(bank.getBalance(b) == Money(50.0));
+
+    persistence.failing = false;
+    bank.transfer(a, b, Money(10.0));
+    REQUIRE(bank.getBalance(b) == Money(60.0));
+}
@@ -0,0 +1,261 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "journal_persistence.h"
+#include "json_persistence.h"
+#include "memory_persistence.h"
+#include <filesystem>
+
+TEST_CASE("Journal replays operations since the last snapshot", "[journal]") {
+    std::string snapshotFile = "test_journal_snapshot.json";
+    std::string journalFile = "test_journal.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+
+    int first = 0;
+    int second = 0;
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile, 1);
+        Bank bank(persistence);
+        first = bank.createAccount("Alice", "11111111111111", Money(100.0));
+        second = bank.createAccount("Bob", "22222222222222", Money(50.0));
+        bank.deposit(first, Money(25.0));
+        bank.withdraw(second, Money(20.0));
+        bank.deleteAccount(second);
+        // No save(): everything must come back from the journal alone.
+    }
+
+    JsonPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence);
+
+    REQUIRE(bank.getAccount(first).balance() == Money(125.0));
+    REQUIRE(bank.getAccount(first).getPersonName() == "Alice");
+    REQUIRE(bank.getAccount(first).getLastOperationType() == "Deposit");
+    REQUIRE_THROWS_AS(bank.getAccount(second), std::runtime_error);
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("Journal save compacts into the snapshot", "[journal]") {
+    std::string snapshotFile = "test_journal_snapshot2.json";
+    std::string journalFile = "test_journal2.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+
+    int id = 0;
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile);
+        Bank bank(persistence);
+        id = bank.createAccount("Alice", "11111111111111", Money(10.0));
+        bank.deposit(id, Money(5.0));
+        bank.save();
+        REQUIRE(persistence.journaledRecords() == 0);
+        bank.deposit(id, Money(1.0));
+    }
+
+    JsonPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence);
+    REQUIRE(bank.getAccount(id).balance() == Money(16.0));
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("Journal keeps records appended after beginSave", "[journal]") {
+    std::string snapshotFile = "test_journal_snapshot_mark.json";
+    std::string journalFile = "test_journal_mark.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+
+    int id = 0;
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile, 1);
+        Bank bank(persistence);
+        id = bank.createAccount("Alice", "11111111111111", Money(10.0));
+        // The copy is taken at the mark; the deposit lands before save().
+        std::unordered_map<int, Account> copy = bank.snapshot();
+        persistence.beginSave();
+        bank.deposit(id, Money(5.0));
+        persistence.save(copy);
+        REQUIRE(persistence.journaledRecords() == 1);
+    }
+
+    JsonPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence);
+    REQUIRE(bank.getAccount(id).balance() == Money(15.0));
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("Journal ignores a torn tail record", "[journal]") {
+    std::string snapshotFile = "test_journal_snapshot3.json";
+    std::string journalFile = "test_journal3.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+
+    int id = 0;
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile, 1);
+        Bank bank(persistence);
+        id = bank.createAccount("Alice", "11111111111111", Money(10.0));
+        bank.deposit(id, Money(5.0));
+    }
+    // Simulate a crash in the middle of writing the last record.
+    std::filesystem::resize_file(journalFile, std::filesystem::file_size(journalFile) - 3);
+
+    JsonPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence);
+    REQUIRE(bank.getAccount(id).balance() == Money(10.0));
+    REQUIRE(persistence.journaledRecords() == 1);
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("Journal replay keeps the original operation time", "[journal]") {
+    std::string snapshotFile = "test_journal_snapshot4.json";
+    std::string journalFile = "test_journal4.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+
+    int alice = 0;
+    int bob = 0;
+    Timestamp depositedAt;
+    Timestamp transferredAt;
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile, 1);
+        Bank bank(persistence);
+        alice = bank.createAccount("Alice", "11111111111111", Money(100.0));
+        bob = bank.createAccount("Bob", "22222222222222", Money(0.0));
+        bank.deposit(alice, Money(5.0));
+        depositedAt = bank.getAccount(alice).lastOperationTime();
+        bank.transfer(alice, bob, Money(10.0));
+        transferredAt = bank.getAccount(bob).lastOperationTime();
+    }
+
+    JsonPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence);
+    REQUIRE(bank.getAccount(alice).lastOperationType() == OperationType::TransferOut);
+    REQUIRE(bank.getAccount(alice).lastOperationTime() == transferredAt);
+    REQUIRE(bank.getAccount(bob).lastOperationType() == OperationType::TransferIn);
+    REQUIRE(bank.getAccount(bob).lastOperationTime() >= depositedAt);
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("Journal delta records upsert account state", "[journal]") {
+    std::string snapshotFile = "test_journal_delta.json";
+    std::string journalFile = "test_journal_delta.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+
+    int kept = 0;
+    int dropped = 0;
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile);
+        Bank bank(persistence);
+        kept = bank.createAccount("Alice", "11111111111111", Money(10.0));
+        dropped = bank.createAccount("Bob", "22222222222222", Money(20.0));
+        bank.save();
+
+        bank.setDeferredPersistence(true);
+        for (int i = 0; i < 100; ++i)
+            bank.deposit(kept, Money(1.0));
+        bank.deleteAccount(dropped);
+        REQUIRE(persistence.journaledRecords() == 0);
+
+        AccountDelta delta = bank.takeDirty();
+        REQUIRE(delta.changed.size() == 1);
+        REQUIRE(delta.deleted == std::vector<int>{dropped});
+        REQUIRE(persistence.saveDelta(delta));
+        // A hundred deposits cost one record.
+        REQUIRE(persistence.journaledRecords() == 2);
+    }
+
+    JsonPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence);
+    REQUIRE(bank.getAccount(kept).balance() == Money(110.0));
+    REQUIRE(bank.getAccount(kept).lastOperationType() == OperationType::Deposit);
+    REQUIRE(bank.getAccount(kept).getPersonName() == "Alice");
+    REQUIRE_THROWS_AS(bank.getAccount(dropped), std::runtime_error);
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("Journal counts accounts created through deltas", "[journal]") {
+    std::string snapshotFile = "test_journal_created.json";
+    std::string journalFile = "test_journal_created.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+    {
+        JsonPersistence snapshot(snapshotFile);
+        // Compaction is due once the records outnumber the live accounts.
+        JournalPersistence persistence(snapshot, journalFile, 64, 1);
+        persistence.load();
+        std::unordered_map<int, Account> book;
+        for (int id = 1; id <= 20; ++id)
+            book.emplace(id, Account(id));
+        persistence.save(book);
+
+        AccountDelta delta;
+        for (int id = 21; id <= 40; ++id)
+            delta.changed.emplace_back(id);
+        delta.created = 20;
+        REQUIRE(persistence.saveDelta(delta));
+        // Twenty records against a book of forty.
+        REQUIRE_FALSE(persistence.needsCompaction());
+    }
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(snapshotFile + ".idx");
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("Journal keeps buffered records when asked for a source", "[journal]") {
+    std::string snapshotFile = "test_journal_source.json";
+    std::string journalFile = "test_journal_source.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+    {
+        JsonPersistence snapshot(snapshotFile, true);
+        JournalPersistence persistence(snapshot, journalFile);
+        Bank bank(persistence);
+        int id = bank.createAccount("Alice", "1", Money(10.0));
+        bank.save();
+        bank.deposit(id, Money(5.0));  // buffered, not yet synced
+        // Offering a source would have to drop the deposit.
+        REQUIRE(persistence.openSource() == nullptr);
+    }
+
+    JsonPersistence snapshot(snapshotFile, true);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence);
+    REQUIRE(bank.getBalance(1) == Money(15.0));
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(snapshotFile + ".idx");
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("Journal refuses a file another store has open", "[journal]") {
+    std::string journalFile = "test_journal_locked.journal";
+    NullPersistence first;
+    NullPersistence second;
+    JournalPersistence persistence(first, journalFile);
+    REQUIRE_THROWS_AS(JournalPersistence(second, journalFile), std::runtime_error);
+    std::filesystem::remove(journalFile);
+}
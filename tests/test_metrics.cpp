@@ -0,0 +1,141 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "json_persistence.h"
+#include "metrics.h"
+#include "metrics_exporter.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Metrics buckets are ordered and tight", "[metrics]") {
+    std::size_t previous = 0;
+    for (std::uint64_t value : {0ull, 1ull, 7ull, 8ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+        std::size_t bucket = metrics::bucketFor(value);
+        REQUIRE(bucket < metrics::kBuckets);
+        REQUIRE(bucket >= previous);
+        previous = bucket;
+        REQUIRE(metrics::bucketLowerBound(bucket) <= value);
+        if (bucket + 1 < metrics::kBuckets)
+            REQUIRE(value < metrics::bucketLowerBound(bucket + 1));
+        // Within 12.5% of the bucket's lower bound.
+        REQUIRE(value - metrics::bucketLowerBound(bucket) <= value / 8);
+    }
+}
+
+TEST_CASE("Metrics sum counters across threads, including exited ones", "[metrics]") {
+    std::uint64_t before = metrics::collect().counter(metrics::Counter::BridgeRequests);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([] {
+            for (int i = 0; i < 1000; ++i)
+                metrics::increment(metrics::Counter::BridgeRequests);
+        });
+    for (auto& thread : threads)
+        thread.join();
+    metrics::increment(metrics::Counter::BridgeRequests, 5);
+    REQUIRE(metrics::collect().counter(metrics::Counter::BridgeRequests) - before == 4005);
+}
+
+TEST_CASE("Metrics timers report percentiles", "[metrics]") {
+    const double nsPerTick = metrics::nanosecondsPerTick();
+    metrics::TimerSnapshot before = metrics::collect().timer(metrics::Timer::BridgeRequest);
+    REQUIRE(before.count == 0);
+    for (std::uint64_t i = 1; i <= 100; ++i)
+        metrics::recordTicks(metrics::Timer::BridgeRequest, i * 1000);
+    metrics::TimerSnapshot timer = metrics::collect().timer(metrics::Timer::BridgeRequest);
+    REQUIRE(timer.count == 100);
+    double p50 = timer.percentileNs(0.5) / nsPerTick;
+    REQUIRE(p50 > 50000 * 0.9);
+    REQUIRE(p50 < 50000 * 1.1);
+    double max = timer.maxNs() / nsPerTick;
+    REQUIRE(max > 100000 * 0.9);
+    REQUIRE(max < 100000 * 1.1);
+    REQUIRE(std::abs(timer.meanNs() / nsPerTick - 50500) < 1);
+
+    std::string text = metrics::toPrometheus(metrics::collect());
+    REQUIRE(text.find("# TYPE bank_bridge_request_seconds histogram\n") != std::string::npos);
+    REQUIRE(text.find("bank_bridge_request_seconds_bucket{le=\"+Inf\"} 100\n") != std::string::npos);
+    REQUIRE(text.find("bank_bridge_request_seconds_count 100\n") != std::string::npos);
+}
+
+TEST_CASE("Sampled timers weight each sample by the sample period", "[metrics]") {
+    metrics::TimerSnapshot before = metrics::collect().timer(metrics::Timer::Deposit);
+    // A fresh thread starts a fresh sampling cycle.
+    std::thread([] {
+        for (std::uint32_t i = 0; i < 10 * metrics::kSamplePeriod; ++i)
+            metrics::SampledTimer timer(metrics::Timer::Deposit);
+    }).join();
+    REQUIRE(metrics::collect().timer(metrics::Timer::Deposit).count - before.count == 10 * metrics::kSamplePeriod);
+}
+
+TEST_CASE("Bank and JSON persistence record metrics", "[metrics]") {
+    std::string testFile = "test_metrics.json";
+    std::filesystem::remove(testFile);
+    std::filesystem::remove(testFile + ".idx");
+    metrics::Snapshot before = metrics::collect();
+    {
+        JsonPersistence persistence(testFile);
+        Bank bank(persistence);
+        int a = bank.createAccount("Alice", "1", Money(10.0));
+        bank.deposit(a, Money(1.0));
+        bank.withdraw(a, Money(2.0));
+        REQUIRE_THROWS(bank.withdraw(a, Money(100.0)));
+        bank.save();
+    }
+    {
+        JsonPersistence persistence(testFile);
+        Bank bank(persistence);
+    }
+    metrics::Snapshot after = metrics::collect();
+    std::filesystem::remove(testFile);
+    std::filesystem::remove(testFile + ".idx");
+    auto counted = [&](metrics::Counter c) { return after.counter(c) - before.counter(c); };
+    auto timed = [&](metrics::Timer t) { return after.timer(t).count - before.timer(t).count; };
+    if (!metrics::enabled()) {
+        REQUIRE(counted(metrics::Counter::Deposits) == 0);
+        return;
+    }
+    REQUIRE(counted(metrics::Counter::AccountsCreated) == 1);
+    REQUIRE(counted(metrics::Counter::Deposits) == 1);
+    REQUIRE(counted(metrics::Counter::Withdrawals) == 1);
+    REQUIRE(timed(metrics::Timer::JsonSave) == 1);
+    REQUIRE(timed(metrics::Timer::JsonLoad) == 2);
+    REQUIRE(counted(metrics::Counter::JsonCacheHits) == 1);
+}
+
+TEST_CASE("MetricsExporter writes a text file and answers on its socket", "[metrics]") {
+    std::string textFile = "test_metrics.prom";
+    std::string socketPath = "test_metrics.sock";
+    std::filesystem::remove(textFile);
+    {
+        MetricsExportOptions options;
+        options.textFile = textFile;
+        options.socketPath = socketPath;
+        MetricsExporter exporter(options);
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", socketPath.c_str());
+        REQUIRE(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+        std::string reply;
+        char buffer[4096];
+        for (ssize_t n; (n = ::read(fd, buffer, sizeof(buffer))) > 0;)
+            reply.append(buffer, static_cast<std::size_t>(n));
+        ::close(fd);
+        REQUIRE(reply.find("bank_deposits_total ") != std::string::npos);
+    }
+    // The file is written at start and again on shutdown; the socket is gone.
+    std::ifstream file(textFile);
+    std::stringstream text;
+    text << file.rdbuf();
+    REQUIRE(text.str().find("bank_deposit_seconds_count ") != std::string::npos);
+    REQUIRE_FALSE(std::filesystem::exists(socketPath));
+    std::filesystem::remove(textFile);
+}
@@ -0,0 +1,49 @@
+#include <catch2/catch_test_macros.hpp>
+#include "money.h"
+#include <cstdint>
+#include <limits>
+
+TEST_CASE("Money sums are exact", "[money]") {
+    Money total;
+    for (int i = 0; i < 1000000; ++i)
+        total += Money(0.1);
+    REQUIRE(total == Money(100000.0));
+    REQUIRE(total.minorUnits() == 10000000);
+}
+
+TEST_CASE("Money parses and prints decimal text", "[money]") {
+    Money value;
+    REQUIRE(Money::parse("100.07", value));
+    REQUIRE(value.minorUnits() == 10007);
+    REQUIRE(Money::parse("-0.5", value));
+    REQUIRE(value.toString() == "-0.50");
+    REQUIRE(Money::parse("12", value));
+    REQUIRE(value.toString() == "12.00");
+    REQUIRE(Money::parse("3.1400", value));
+    REQUIRE(value.minorUnits() == 314);
+
+    REQUIRE_FALSE(Money::parse("1.005", value));
+    REQUIRE_FALSE(Money::parse("1e3", value));
+    REQUIRE_FALSE(Money::parse("", value));
+    REQUIRE_FALSE(Money::parse("-", value));
+    REQUIRE_FALSE(Money::parse("12abc", value));
+    REQUIRE_FALSE(Money::parse("99999999999999999999", value));
+}
+
+TEST_CASE("Money rounds floating-point input to the nearest minor unit", "[money]") {
+    REQUIRE(Money(19.999).minorUnits() == 2000);
+    REQUIRE(Money(0.29).minorUnits() == 29);
+    REQUIRE(Money(-1.25).minorUnits() == -125);
+    REQUIRE_THROWS_AS(Money(std::numeric_limits<double>::quiet_NaN()), std::invalid_argument);
+    REQUIRE_THROWS_AS(Money(1e300), std::invalid_argument);
+}
+
+TEST_CASE("Money arithmetic throws instead of overflowing", "[money]") {
+    Money big = Money::fromMinorUnits(std::numeric_limits<std::int64_t>::max());
+    REQUIRE_THROWS_AS(big + Money::fromMinorUnits(1), std::overflow_error);
+    REQUIRE_THROWS_AS(-big - Money::fromMinorUnits(2), std::overflow_error);
+
+    Money unchanged = big;
+    REQUIRE_THROWS_AS(unchanged += Money(1.0), std::overflow_error);
+    REQUIRE(unchanged == big);
+}
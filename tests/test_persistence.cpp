@@ -1,30 +1,36 @@
 #include <catch2/catch_test_macros.hpp>
+#include "binary_persistence.h"
 #include "json_persistence.h"
+#include "parallel_chunks.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <unordered_map>
 
 TEST_CASE("JsonPersistence save and load", "[persistence]") {
     std::string testFile = "test_accounts.json";
-    JsonPersistence persistence(testFile);
-
     // Clean up before test
     std::filesystem::remove(testFile);
 
-    std::unordered_map<UserId, Account> accounts;
-    accounts.emplace("user1", Account("user1", 100.0));
-    accounts.emplace("user2", Account("user2", 200.0));
+    std::unordered_map<int, Account> accounts;
+    accounts.emplace(1, Account(1, Money(100.0), "Alice", "11111111111111"));
+    accounts.emplace(2, Account(2, Money(200.0), "Bob", "22222222222222"));
 
-    persistence.save(accounts);
+    JsonPersistence(testFile).save(accounts);
 
     // Load in new persistence instance
     JsonPersistence loadPersistence(testFile);
     auto loaded = loadPersistence.load();
 
     REQUIRE(loaded.size() == 2);
-    REQUIRE(loaded.at("user1").id() == "user1");
-    REQUIRE(loaded.at("user1").balance() == 100.0);
-    REQUIRE(loaded.at("user2").id() == "user2");
-    REQUIRE(loaded.at("user2").balance() == 200.0);
+    REQUIRE(loaded.at(1).getAccountId() == 1);
+    REQUIRE(loaded.at(1).balance() == Money(100.0));
+    REQUIRE(loaded.at(1).getPersonName() == "Alice");
+    REQUIRE(loaded.at(2).getAccountId() == 2);
+    REQUIRE(loaded.at(2).balance() == Money(200.0));
 
     // Clean up
     std::filesystem::remove(testFile);
@@ -40,4 +46,240 @@ TEST_CASE("JsonPersistence load empty", "[persistence]") {
     REQUIRE(loaded.empty());
 
     // No file to clean
-}
\ No newline at end of file
+}
+
+TEST_CASE("JsonPersistence load reports malformed JSON", "[persistence]") {
+    std::string testFile = "test_malformed.json";
+    {
+        std::ofstream out(testFile);
+        out << "[\n    {\"accountId\": 1, \"balance\": ";
+    }
+
+    JsonPersistence persistence(testFile);
+    REQUIRE_THROWS_AS(persistence.load(), std::runtime_error);
+
+    std::filesystem::remove(testFile);
+}
+TEST_CASE("JsonPersistence load restores metadata and skips unknown keys", "[persistence]") {
+    std::string testFile = "test_metadata.json";
+    {
+        std::ofstream out(testFile);
+        out << R"([
+            {"accountId": 7, "balance": 12.5, "personName": "Alice", "cardId": "11111111111111",
+             "creationTime": "2024-01-01 10:00:00", "extra": {"nested": [1, 2, 3]},
+             "lastOperationType": "Deposit", "lastOperationTime": "2024-01-02 11:30:00"},
+            {"accountId": 9, "balance": 3, "personName": "Bob", "cardId": "22222222222222"}
+        ])";
+    }
+
+    JsonPersistence persistence(testFile);
+    auto loaded = persistence.load();
+
+    REQUIRE(loaded.size() == 2);
+    REQUIRE(loaded.at(7).balance() == Money(12.5));
+    REQUIRE(loaded.at(7).getPersonName() == "Alice");
+    REQUIRE(loaded.at(7).getCreationTime() == "2024-01-01 10:00:00");
+    REQUIRE(loaded.at(7).getLastOperationType() == "Deposit");
+    REQUIRE(loaded.at(7).getLastOperationTime() == "2024-01-02 11:30:00");
+    REQUIRE(loaded.at(9).balance() == Money(3.0));
+    REQUIRE(loaded.at(9).getLastOperationType() == "None");
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("Timestamps format and parse symmetrically", "[persistence]") {
+    Timestamp parsed;
+    REQUIRE(parseTimestamp("2024-03-15 08:45:12", parsed));
+    REQUIRE(formatTimestamp(parsed) == "2024-03-15 08:45:12");
+    REQUIRE_FALSE(parseTimestamp("not a time", parsed));
+    REQUIRE(parseOperationType(toString(OperationType::TransferIn)) == OperationType::TransferIn);
+    REQUIRE(parseOperationType("garbage") == OperationType::None);
+}
+
+TEST_CASE("JsonPersistence rejects a snapshot whose checksum does not match", "[persistence]") {
+    std::string testFile = "test_checksum.json";
+    std::unordered_map<int, Account> accounts;
+    accounts.emplace(1, Account(1, Money(100.0), "Alice", "11111111111111"));
+    JsonPersistence(testFile, false).save(accounts);
+    REQUIRE(JsonPersistence(testFile, false).load().at(1).balance() == Money(100.0));
+
+    std::string text;
+    {
+        std::ifstream in(testFile, std::ios::binary);
+        text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    REQUIRE(text.find("\"checksum64:") != std::string::npos);
+    text.replace(text.find("100"), 3, "900");
+    {
+        std::ofstream out(testFile, std::ios::binary | std::ios::trunc);
+        out << text;
+    }
+    REQUIRE_THROWS_AS(JsonPersistence(testFile, false).load(), std::runtime_error);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("JsonPersistence loads from a matching index cache", "[persistence]") {
+    std::string testFile = "test_cache.json";
+    std::string cacheFile = testFile + ".idx";
+    std::unordered_map<int, Account> first;
+    first.emplace(1, Account(1, Money(1.0), "Alice", "11111111111111"));
+    std::unordered_map<int, Account> second;
+    second.emplace(2, Account(2, Money(2.0), "Bob", "22222222222222"));
+
+    JsonPersistence persistence(testFile);
+    persistence.save(first);
+    std::uint64_t firstChecksum = BinarySnapshotView(cacheFile).sourceChecksum();
+    REQUIRE(firstChecksum != 0);
+
+    // A cache stamped with the JSON's checksum is trusted without parsing.
+    BinaryPersistence(cacheFile).save(second, firstChecksum);
+    REQUIRE(persistence.load().count(2) == 1);
+
+    // A stale cache is ignored and rebuilt.
+    persistence.save(second);
+    BinaryPersistence(cacheFile).save(first, firstChecksum);
+    auto loaded = persistence.load();
+    REQUIRE(loaded.size() == 1);
+    REQUIRE(loaded.at(2).getPersonName() == "Bob");
+    REQUIRE(BinarySnapshotView(cacheFile).sourceChecksum() != firstChecksum);
+
+    // So is a damaged one.
+    {
+        std::ofstream out(cacheFile, std::ios::binary | std::ios::trunc);
+        out << "garbage";
+    }
+    REQUIRE(persistence.load().at(2).balance() == Money(2.0));
+
+    // And so is one damaged past its header.
+    std::string bytes;
+    {
+        std::ifstream in(cacheFile, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    REQUIRE(BinarySnapshotView(cacheFile).verify());
+    bytes.replace(bytes.rfind("Bob"), 3, "Rob");
+    {
+        std::ofstream out(cacheFile, std::ios::binary | std::ios::trunc);
+        out << bytes;
+    }
+    REQUIRE_FALSE(BinarySnapshotView(cacheFile).verify());
+    REQUIRE(persistence.load().at(2).getPersonName() == "Bob");
+    REQUIRE(persistence.openSource()->materialize(0).getPersonName() == "Bob");
+
+    std::filesystem::remove(testFile);
+    std::filesystem::remove(cacheFile);
+}
+
+TEST_CASE("JsonPersistence refuses a file another store has open", "[persistence]") {
+    std::string testFile = "test_locked.json";
+    {
+        JsonPersistence first(testFile, false);
+        REQUIRE_THROWS_AS(JsonPersistence(testFile, false), std::runtime_error);
+        REQUIRE(std::filesystem::exists(testFile + ".lock"));
+    }
+    REQUIRE_FALSE(std::filesystem::exists(testFile + ".lock"));
+    JsonPersistence(testFile, false).save({});
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("JsonPersistence save reports failure and keeps the old file", "[persistence]") {
+    REQUIRE_THROWS_AS(JsonPersistence("no_such_dir/accounts.json").save({}), std::runtime_error);
+
+    std::string testFile = "test_keep.json";
+    std::unordered_map<int, Account> accounts;
+    accounts.emplace(1, Account(1, Money(5.0), "Alice", "11111111111111"));
+    JsonPersistence(testFile, false).save(accounts);
+    // A crash mid-save leaves at most a stray temp file beside the target.
+    {
+        std::ofstream out(testFile + ".tmp");
+        out << "[{\"accountId\": 1, \"bal";
+    }
+    REQUIRE(JsonPersistence(testFile, false).load().at(1).balance() == Money(5.0));
+
+    std::filesystem::remove(testFile);
+    std::filesystem::remove(testFile + ".tmp");
+}
+
+TEST_CASE("JsonPersistence saves large books in parallel, indented or compact", "[persistence]") {
+    std::string testFile = "test_parallel.json";
+    // Enough accounts to split the save across threads, with timestamps
+    // spread over decades so every local time zone transition is crossed.
+    constexpr int kAccounts = 70000;
+    const Timestamp start{};  // the epoch
+    std::unordered_map<int, Account> accounts;
+    for (int id = 1; id <= kAccounts; ++id) {
+        Timestamp created = start + std::chrono::seconds(static_cast<std::int64_t>(id) * 28657);
+        accounts.emplace(id, Account(id, Money::fromMinorUnits((id % 2 ? -1 : 1) * id * 7), "Owner " + std::to_string(id),
+                                     std::to_string(id), created, OperationType::Deposit,
+                                     created + std::chrono::seconds(id)));
+    }
+
+    std::uintmax_t sizes[2];
+    int layout = 0;
+    for (JsonLayout format : {JsonLayout::Indented, JsonLayout::Compact}) {
+        JsonPersistence(testFile, false, format).save(accounts);
+        sizes[layout++] = std::filesystem::file_size(testFile);
+        auto loaded = JsonPersistence(testFile, false).load();
+        REQUIRE(loaded.size() == accounts.size());
+
+        // Every field reads back as a generic JSON parser sees it too.
+        std::ifstream in(testFile);
+        nlohmann::json document = nlohmann::json::parse(in);
+        REQUIRE(document.size() == kAccounts + 1);
+        for (std::size_t i = 0; i < kAccounts; ++i) {
+            const nlohmann::json& record = document[i];
+            const Account& account = accounts.at(record.at("accountId").get<int>());
+            const Account& reloaded = loaded.at(account.getAccountId());
+            REQUIRE(reloaded.balance() == account.balance());
+            REQUIRE(record.at("balance").get<double>() == account.balance().toDouble());
+            REQUIRE(record.at("creationTime") == account.getCreationTime());
+            REQUIRE(record.at("lastOperationTime") == account.getLastOperationTime());
+            REQUIRE(record.at("lastOperationType") == "Deposit");
+            REQUIRE(reloaded.getPersonName() == account.getPersonName());
+        }
+    }
+    REQUIRE(sizes[1] < sizes[0]);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("JsonPersistence escapes names and refuses invalid UTF-8", "[persistence]") {
+    std::string testFile = "test_escape.json";
+    const std::string name = "Zo\xc3\xab \"Q\" O'Neil\\\n\t\x01 \xe2\x82\xac";
+    std::unordered_map<int, Account> accounts;
+    accounts.emplace(1, Account(1, Money(1.5), name, "1/2"));
+    JsonPersistence(testFile, false).save(accounts);
+    REQUIRE(JsonPersistence(testFile, false).load().at(1).getPersonName() == name);
+    JsonPersistence(testFile, false, JsonLayout::Compact).save(accounts);
+    REQUIRE(JsonPersistence(testFile, false).load().at(1).getPersonName() == name);
+
+    // The file is left as it was.
+    accounts.emplace(2, Account(2, Money(), "Bad \xc3(", "2"));
+    REQUIRE_THROWS_AS(JsonPersistence(testFile, false).save(accounts), std::runtime_error);
+    REQUIRE(JsonPersistence(testFile, false).load().size() == 1);
+
+    std::filesystem::remove(testFile);
+}
+
+TEST_CASE("Parallel chunks hand a worker's exception to the caller", "[persistence]") {
+    // As a worker of the parallel save running out of memory would.
+    std::atomic<std::size_t> covered{0};
+    REQUIRE_THROWS_AS(forEachChunk(1000, 4,
+                                   [&](unsigned worker, std::size_t begin, std::size_t end) {
+                                       covered += end - begin;
+                                       if (worker == 2)
+                                           throw std::bad_alloc();
+                                   }),
+                      std::bad_alloc);
+    // The others still ran to the end of their chunks before it came back.
+    REQUIRE(covered == 1000);
+
+    // The first failing worker wins.
+    REQUIRE_THROWS_WITH(forEachChunk(10, 3,
+                                     [](unsigned worker, std::size_t, std::size_t) {
+                                         if (worker > 0)
+                                             throw std::runtime_error("worker " + std::to_string(worker));
+                                     }),
+                        "worker 1");
+}
@@ -0,0 +1,207 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "concurrent_bank.h"
+#include "journal_persistence.h"
+#include "json_persistence.h"
+#include "memory_persistence.h"
+#include <filesystem>
+
+namespace {
+
+// Overdrafts pay 1.5%, small balances 0.1% less a 2.00 fee, the rest 0.25%.
+const char* const kSchedule =
+    "# min,max,rate%,fee\n"
+    "min,max,rate,fee\n"
+    ",0,1.5,0\n"
+    "0,1000,0.1,2.00\n"
+    "1000,,0.25,0\n";
+
+} // namespace
+
+TEST_CASE("Posting schedules parse tiers and reject bad lines", "[posting]") {
+    PostingSchedule schedule = PostingSchedule::parse(kSchedule);
+    REQUIRE(schedule.rules.size() == 3);
+    REQUIRE(schedule.rules[0].ratePpm == 15000);
+    REQUIRE(schedule.rules[0].maxBalance == Money());
+    REQUIRE(schedule.rules[1].fee == Money(2.0));
+    REQUIRE(schedule.rules[2].ratePpm == 2500);
+    REQUIRE(schedule.ruleFor(Money(-0.01)) == &schedule.rules[0]);
+    REQUIRE(schedule.ruleFor(Money(999.99)) == &schedule.rules[1]);
+    REQUIRE(schedule.ruleFor(Money(1000.0)) == &schedule.rules[2]);
+
+    REQUIRE_THROWS_AS(PostingSchedule::parse("0,100,1\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(PostingSchedule::parse("0,100,abc,0\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(PostingSchedule::parse("0,100,1,-2\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(PostingSchedule::parse("100,0,1,0\n"), std::invalid_argument);
+}
+
+TEST_CASE("Posting rounds interest and never lets a fee overdraw", "[posting]") {
+    PostingSchedule schedule = PostingSchedule::parse(kSchedule);
+    Timestamp asOf = currentTimestamp() + std::chrono::seconds(1);
+    PostingReport report;
+
+    Account rich(1, Money(2000.10));  // 0.25% = 5.00025 -> 5.00
+    REQUIRE(postAccount(rich, schedule, asOf, report) == PostingOutcome::Posted);
+    REQUIRE(rich.balance() == Money(2005.10));
+    REQUIRE(rich.lastOperationType() == OperationType::Posting);
+    REQUIRE(rich.lastOperationTime() == asOf);
+
+    Account overdrawn(2, Money(-100.0));  // 1.5% of -100 = -1.50
+    REQUIRE(postAccount(overdrawn, schedule, asOf, report) == PostingOutcome::Posted);
+    REQUIRE(overdrawn.balance() == Money(-101.50));
+
+    Account small(3, Money(1.0));  // interest 0.001 rounds away; fee capped at 1.00
+    REQUIRE(postAccount(small, schedule, asOf, report) == PostingOutcome::Posted);
+    REQUIRE(small.balance() == Money());
+
+    Account empty(4);
+    REQUIRE(postAccount(empty, schedule, asOf, report) == PostingOutcome::Unchanged);
+
+    REQUIRE(report.interest == Money(5.00 - 1.50));
+    REQUIRE(report.fees == Money(1.0));
+    REQUIRE(report.waived == Money(3.0));
+
+    // Already stamped by this run: left alone.
+    REQUIRE(postAccount(rich, schedule, asOf, report) == PostingOutcome::Skipped);
+    REQUIRE(rich.balance() == Money(2005.10));
+
+    Account huge(5, Money::fromMinorUnits(std::numeric_limits<std::int64_t>::max() - 1));
+    REQUIRE(postAccount(huge, schedule, asOf, report) == PostingOutcome::Failed);
+    REQUIRE(huge.balance() == Money::fromMinorUnits(std::numeric_limits<std::int64_t>::max() - 1));
+}
+
+TEST_CASE("Bank posts every account and resumes from a checkpoint", "[posting]") {
+    PostingSchedule schedule = PostingSchedule::parse(kSchedule);
+    MemoryPersistence persistence;
+    Bank bank(persistence);
+    constexpr int kAccounts = 3 * kPostingChunk / 2;
+    for (int i = 0; i < kAccounts; ++i)
+        bank.createAccount("P", "C", Money(2000.0));
+    bank.deleteAccount(7);
+
+    // Stop after the first chunk, then create an account the run must skip.
+    PostingCheckpoint checkpoint;
+    PostingReport first = bank.applyPostings(schedule, checkpoint, [](const PostingCheckpoint&) { return false; });
+    REQUIRE_FALSE(first.complete);
+    REQUIRE(checkpoint.nextAccountId == 1 + kPostingChunk);
+    REQUIRE(first.posted == static_cast<std::size_t>(kPostingChunk - 1));
+    int late = bank.createAccount("Late", "L", Money(2000.0));
+
+    int progressCalls = 0;
+    PostingReport second = bank.applyPostings(schedule, checkpoint, [&](const PostingCheckpoint&) {
+        ++progressCalls;
+        return true;
+    });
+    REQUIRE(second.complete);
+    REQUIRE(checkpoint.done());
+    REQUIRE(progressCalls == 1);
+    REQUIRE(first.posted + second.posted == static_cast<std::size_t>(kAccounts - 1));
+    REQUIRE(second.interest == Money(5.0 * static_cast<double>(second.posted)));
+
+    REQUIRE(bank.getBalance(1) == Money(2005.0));
+    REQUIRE(bank.getBalance(kAccounts) == Money(2005.0));
+    REQUIRE(bank.getBalance(late) == Money(2000.0));
+    REQUIRE(bank.store().balances()[0] == bank.find(bank.accounts().begin()->getAccountId())->balance());
+}
+
+TEST_CASE("A posting chunk is one journal record that replays to the same book", "[posting]") {
+    std::string snapshotFile = "test_posting_snapshot.json";
+    std::string journalFile = "test_posting.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+    PostingSchedule schedule = PostingSchedule::parse(kSchedule);
+
+    std::vector<Money> expected;
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile, 1);
+        Bank bank(persistence);
+        for (double balance : {-100.0, 1.0, 500.0, 2000.10})
+            bank.createAccount("P", "C", Money(balance));
+        bank.save();
+
+        PostingCheckpoint checkpoint;
+        bank.applyPostings(schedule, checkpoint);
+        REQUIRE(persistence.journaledRecords() == 1);
+        bank.deposit(3, Money(1.0));
+        for (int id = 1; id <= 4; ++id)
+            expected.push_back(bank.getBalance(id));
+    }
+
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile);
+        Bank bank(persistence);
+        for (int id = 1; id <= 4; ++id)
+            REQUIRE(bank.getBalance(id) == expected[static_cast<std::size_t>(id - 1)]);
+        REQUIRE(bank.getAccount(1).lastOperationType() == OperationType::Posting);
+        // Snapshot the replayed book without truncating the journal, as a
+        // crash between the two steps of save() would.
+        snapshot.save(bank.store().toMap());
+    }
+
+    JsonPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence);
+    for (int id = 1; id <= 4; ++id)
+        REQUIRE(bank.getBalance(id) == expected[static_cast<std::size_t>(id - 1)]);
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("A posting chunk whose record fails is left unposted", "[posting]") {
+    PostingSchedule schedule = PostingSchedule::parse(kSchedule);
+    constexpr int kAccounts = 3 * kPostingChunk / 2;
+    FailingPersistence plainStore;
+    FailingPersistence shardedStore;
+    Bank plain(plainStore);
+    ConcurrentBank sharded(shardedStore, 4);
+    for (int i = 0; i < kAccounts; ++i) {
+        plain.createAccount("P", "C", Money(2000.0));
+        sharded.createAccount("P", "C", Money(2000.0));
+    }
+
+    // The first chunk is recorded and posted; the second one's record fails.
+    for (IBank* bank : {static_cast<IBank*>(&plain), static_cast<IBank*>(&sharded)}) {
+        FailingPersistence& store = bank == &plain ? plainStore : shardedStore;
+        PostingCheckpoint checkpoint;
+        REQUIRE_THROWS(bank->applyPostings(schedule, checkpoint, [&store](const PostingCheckpoint&) {
+            store.failing = true;
+            return true;
+        }));
+        REQUIRE(checkpoint.nextAccountId == 1 + kPostingChunk);
+        REQUIRE(bank->getBalance(1) == Money(2005.0));
+        REQUIRE(bank->getBalance(kAccounts) == Money(2000.0));
+
+        store.failing = false;
+        REQUIRE(bank->applyPostings(schedule, checkpoint).complete);
+        REQUIRE(bank->getBalance(1) == Money(2005.0));
+        REQUIRE(bank->getBalance(kAccounts) == Money(2005.0));
+    }
+    REQUIRE(plain.store().balances().back() == Money(2005.0));
+}
+
+TEST_CASE("ConcurrentBank posts the same amounts as Bank", "[posting]") {
+    PostingSchedule schedule = PostingSchedule::parse(kSchedule);
+    MemoryPersistence plainStore;
+    MemoryPersistence shardedStore;
+    Bank plain(plainStore);
+    ConcurrentBank sharded(shardedStore, 4);
+    for (int i = 0; i < 5000; ++i) {
+        Money balance = Money::fromMinorUnits((i * 7919) % 500000 - 50000);
+        plain.createAccount("P", "C", balance);
+        sharded.createAccount("P", "C", balance);
+    }
+
+    PostingCheckpoint plainCheckpoint;
+    PostingCheckpoint shardedCheckpoint;
+    PostingReport plainReport = plain.applyPostings(schedule, plainCheckpoint);
+    PostingReport shardedReport = sharded.applyPostings(schedule, shardedCheckpoint);
+    REQUIRE(shardedReport.complete);
+    REQUIRE(shardedReport.posted == plainReport.posted);
+    REQUIRE(shardedReport.interest == plainReport.interest);
+    REQUIRE(shardedReport.fees == plainReport.fees);
+    for (int id = 1; id <= 5000; ++id)
+        REQUIRE(sharded.getBalance(id) == plain.getBalance(id));
+}
@@ -0,0 +1,111 @@
+#include <catch2/catch_test_macros.hpp>
+#include "account.h"
+#include "string_pool.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Interned strings share one copy", "[string_pool]") {
+    std::string name = "Interned Owner With A Long Name";
+    PooledString first = string_pool::intern(name);
+    std::size_t strings = string_pool::stats().strings;
+    PooledString second = string_pool::intern(std::string(name));
+
+    REQUIRE(first == second);
+    REQUIRE(first.view() == name);
+    REQUIRE(first.view().data() == second.view().data());
+    REQUIRE(string_pool::stats().strings == strings);
+    REQUIRE(string_pool::intern("Another Owner") != first);
+
+    // The copy does not depend on the caller's buffer.
+    name.assign(name.size(), 'x');
+    REQUIRE(first.view() == "Interned Owner With A Long Name");
+
+    REQUIRE(string_pool::intern("") == PooledString());
+    REQUIRE(PooledString().empty());
+}
+
+TEST_CASE("Accounts hold pooled metadata", "[string_pool]") {
+    Account a(1, Money(), "Pooled Holder", "4000000000000001");
+    Account b(2, Money(), "Pooled Holder", "4000000000000002");
+    REQUIRE(a.getPersonName().data() == b.getPersonName().data());
+    REQUIRE(a.getCardId() == "4000000000000001");
+
+    Account copy = a;
+    a.setPersonName("Renamed Holder");
+    REQUIRE(copy.getPersonName() == "Pooled Holder");
+    REQUIRE(a.getPersonName() == "Renamed Holder");
+}
+
+TEST_CASE("Interning from several threads agrees on one copy", "[string_pool]") {
+    constexpr int kThreads = 4;
+    constexpr int kNames = 5000;
+    std::vector<std::vector<PooledString>> seen(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t, &seen] {
+            for (int i = 0; i < kNames; ++i)
+                seen[t].push_back(string_pool::intern("Threaded Owner " + std::to_string(i)));
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (int i = 0; i < kNames; ++i) {
+        REQUIRE(seen[0][i].view() == "Threaded Owner " + std::to_string(i));
+        for (int t = 1; t < kThreads; ++t)
+            REQUIRE(seen[t][i] == seen[0][i]);
+    }
+}
+
+TEST_CASE("Strings no handle refers to are reclaimed and their space reused", "[string_pool]") {
+    const string_pool::Stats before = string_pool::stats();
+    auto internAll = [] {
+        std::vector<PooledString> names;
+        for (int i = 0; i < 1000; ++i)
+            names.push_back(string_pool::intern("Transient Owner " + std::to_string(i)));
+        names.push_back(string_pool::intern(std::string(1000, 'L')));  // allocated on its own
+        return names;
+    };
+    {
+        std::vector<PooledString> names = internAll();
+        std::vector<PooledString> copies = names;
+        REQUIRE(string_pool::stats().strings == before.strings + 1001);
+        names.clear();
+        REQUIRE(copies[7].view() == "Transient Owner 7");
+    }
+    const string_pool::Stats released = string_pool::stats();
+    REQUIRE(released.strings == before.strings);
+    REQUIRE(released.usedBytes == before.usedBytes);
+
+    // The same sizes again fit in the freed space.
+    std::vector<PooledString> again = internAll();
+    REQUIRE(string_pool::stats().arenaBytes == released.arenaBytes + 1008);
+    REQUIRE(again[999].view() == "Transient Owner 999");
+}
+
+TEST_CASE("Handles are copied and dropped from several threads", "[string_pool]") {
+    constexpr int kThreads = 4;
+    const std::size_t strings = string_pool::stats().strings;
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&wrong] {
+            for (int round = 0; round < 200; ++round) {
+                // Every thread interns, copies and drops the same few names,
+                // so last references race with fresh interns.
+                std::vector<PooledString> held;
+                for (int i = 0; i < 20; ++i)
+                    held.push_back(string_pool::intern("Shared Owner " + std::to_string(i)));
+                std::vector<PooledString> copies(held.begin(), held.end());
+                if (copies[round % 20].view() != "Shared Owner " + std::to_string(round % 20))
+                    ++wrong;
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    REQUIRE(wrong == 0);
+    REQUIRE(string_pool::stats().strings == strings);
+}
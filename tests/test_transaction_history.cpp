@@ -0,0 +1,194 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "json_persistence.h"
+#include "transaction_history.h"
+#include <csignal>
+#include <filesystem>
+#include <sys/resource.h>
+
+namespace {
+
+Timestamp at(std::int64_t micros) {
+    return Timestamp(std::chrono::microseconds(micros));
+}
+
+std::vector<std::uint64_t> sequences(const std::vector<HistoryEntry>& entries) {
+    std::vector<std::uint64_t> result;
+    for (const HistoryEntry& entry : entries)
+        result.push_back(entry.sequence);
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("TransactionHistory answers per-account and time-range queries", "[history]") {
+    TransactionHistory history;
+    // Account 1 gets every third entry, account 2 the rest.
+    for (int i = 0; i < 30; ++i)
+        history.append(i % 3 == 0 ? 1 : 2, OperationType::Deposit, Money::fromMinorUnits(i), at(1000 + i));
+    REQUIRE(history.size() == 30);
+
+    auto newest = history.forAccount(1, 3);
+    REQUIRE(sequences(newest) == std::vector<std::uint64_t>{28, 25, 22});
+    REQUIRE(newest[0].accountId == 1);
+    REQUIRE(newest[0].amount == Money::fromMinorUnits(27));
+    REQUIRE(newest[0].time == at(1027));
+
+    auto older = history.forAccount(1, 3, newest.back().sequence);
+    REQUIRE(sequences(older) == std::vector<std::uint64_t>{19, 16, 13});
+    REQUIRE(history.forAccount(1, 100).size() == 10);
+    REQUIRE(history.forAccount(3, 10).empty());
+
+    auto range = history.inRange(at(1005), at(1009), 100);
+    REQUIRE(sequences(range) == std::vector<std::uint64_t>{6, 7, 8, 9});
+    REQUIRE(history.inRange(at(1005), at(1009), 2).size() == 2);
+    REQUIRE(history.inRange(at(2000), at(3000), 10).empty());
+
+    auto accountRange = history.forAccountInRange(2, at(1010), at(1015), 100);
+    REQUIRE(sequences(accountRange) == std::vector<std::uint64_t>{15, 14, 12, 11});
+}
+
+TEST_CASE("TransactionHistory keeps only its retention without a spill file", "[history]") {
+    HistoryOptions options;
+    options.retainInMemory = 100;
+    TransactionHistory history(options);
+    for (int i = 0; i < 10000; ++i)
+        history.append(i % 7, OperationType::Withdrawal, Money::fromMinorUnits(-i), at(i));
+
+    REQUIRE(history.size() == 10000);
+    REQUIRE(history.inMemory() >= 100);
+    REQUIRE(history.oldestAvailable() == 10001 - history.inMemory());
+    auto all = history.forAccount(3, 100000);
+    REQUIRE_FALSE(all.empty());
+    REQUIRE(all.back().sequence >= history.oldestAvailable());
+    REQUIRE(all.front().amount == Money::fromMinorUnits(-9999));
+}
+
+TEST_CASE("TransactionHistory spills to disk and reopens where it left off", "[history]") {
+    std::string historyFile = "test_history.bin";
+    std::filesystem::remove(historyFile);
+    HistoryOptions options;
+    options.retainInMemory = 1000;
+    options.spillFile = historyFile;
+
+    constexpr int kEntries = 20000;
+    {
+        TransactionHistory history(options);
+        for (int i = 0; i < kEntries; ++i)
+            history.append(1 + i % 10, OperationType::Deposit, Money::fromMinorUnits(i), at(i));
+        REQUIRE(history.oldestAvailable() == 1);
+        REQUIRE(history.inMemory() < kEntries);
+
+        // The chain runs from the ring into spilled blocks.
+        auto all = history.forAccount(4, kEntries);
+        REQUIRE(all.size() == kEntries / 10);
+        REQUIRE(all.back().sequence == 4);
+        REQUIRE(all.back().amount == Money::fromMinorUnits(3));
+
+        auto range = history.inRange(at(5000), at(5003), 10);
+        REQUIRE(sequences(range) == std::vector<std::uint64_t>{5001, 5002, 5003});
+    }
+
+    TransactionHistory reopened(options);
+    REQUIRE(reopened.size() == kEntries);
+    REQUIRE(reopened.inMemory() == 0);
+    reopened.append(4, OperationType::Withdrawal, Money::fromMinorUnits(-5), at(kEntries));
+
+    auto newest = reopened.forAccount(4, 2);
+    REQUIRE(sequences(newest) == std::vector<std::uint64_t>{kEntries + 1, kEntries - 6});
+    REQUIRE(newest[0].type == OperationType::Withdrawal);
+    REQUIRE(reopened.forAccount(4, kEntries).size() == kEntries / 10 + 1);
+    REQUIRE(reopened.inRange(at(19998), at(30000), 10).size() == 3);
+
+    std::filesystem::remove(historyFile);
+}
+
+TEST_CASE("TransactionHistory stops spilling after a block it could not write", "[history]") {
+    std::string historyFile = "test_history_torn.bin";
+    std::filesystem::remove(historyFile);
+    HistoryOptions options;
+    options.retainInMemory = 1000;
+    options.spillFile = historyFile;
+
+    constexpr int kEntries = 12000;
+    rlimit saved{};
+    REQUIRE(::getrlimit(RLIMIT_FSIZE, &saved) == 0);
+    // Past the limit a write comes up short, then fails with EFBIG.
+    auto handler = std::signal(SIGXFSZ, SIG_IGN);
+    {
+        TransactionHistory history(options);
+        rlimit limited = saved;
+        limited.rlim_cur = 64 * 1024;  // about half a block
+        REQUIRE(::setrlimit(RLIMIT_FSIZE, &limited) == 0);
+        for (int i = 0; i < kEntries; ++i)
+            history.append(1 + i % 10, OperationType::Deposit, Money::fromMinorUnits(i), at(i));
+        REQUIRE(::setrlimit(RLIMIT_FSIZE, &saved) == 0);
+        REQUIRE_FALSE(history.spillError().empty());
+        REQUIRE(std::filesystem::file_size(historyFile) == 8);  // the header alone
+
+        // What no longer fits in memory is dropped, as without a spill file.
+        REQUIRE(history.size() == kEntries);
+        REQUIRE(history.oldestAvailable() == kEntries + 1 - history.inMemory());
+        REQUIRE(history.inRange(at(0), at(3), 10).empty());
+        auto all = history.forAccount(4, kEntries);
+        REQUIRE(all.back().sequence >= history.oldestAvailable());
+        REQUIRE(all.back().sequence < history.oldestAvailable() + 10);
+        REQUIRE(all.front().amount == Money::fromMinorUnits(kEntries - 7));
+    }
+    std::signal(SIGXFSZ, handler);
+
+    TransactionHistory reopened(options);
+    REQUIRE(reopened.size() == 0);
+    REQUIRE(reopened.spillError().empty());
+
+    std::filesystem::remove(historyFile);
+}
+
+TEST_CASE("Bank records every balance change in its history", "[history]") {
+    std::string testFile = "test_history_bank.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+    TransactionHistory history;
+    bank.setHistory(&history);
+
+    int a = bank.createAccount("A", "1", Money(100.0));
+    int b = bank.createAccount("B", "2");
+    bank.deposit(b, Money(50.0));
+    bank.withdraw(a, Money(30.0));
+    bank.transfer(a, b, Money(20.0));
+    bank.transferMany({{b, a, Money(5.0)}});
+    bank.applyBatch({
+        {1, BatchOpType::Deposit, a, Money(1.0)},
+        {2, BatchOpType::Withdraw, b, Money(1000.0)},  // fails: not recorded
+        {3, BatchOpType::Withdraw, b, Money(2.0)},
+    });
+    PostingCheckpoint checkpoint;
+    bank.applyPostings(PostingSchedule::parse("0,,0,1.00\n"), checkpoint);
+
+    auto entries = history.forAccount(a, 100);
+    REQUIRE(entries.size() == 6);
+    REQUIRE(entries[0].type == OperationType::Posting);
+    REQUIRE(entries[0].amount == Money(-1.0));
+    REQUIRE(entries[1].type == OperationType::Deposit);
+    REQUIRE(entries[2].type == OperationType::TransferIn);
+    REQUIRE(entries[2].amount == Money(5.0));
+    REQUIRE(entries[3].type == OperationType::TransferOut);
+    REQUIRE(entries[3].amount == Money(-20.0));
+    REQUIRE(entries[4].type == OperationType::Withdrawal);
+    REQUIRE(entries[4].amount == Money(-30.0));
+    REQUIRE(entries[5].amount == Money(100.0));
+
+    // Replaying the entries gives the balance.
+    for (int id : {a, b}) {
+        Money total;
+        for (const HistoryEntry& entry : history.forAccount(id, 100))
+            total += entry.amount;
+        REQUIRE(total == bank.getBalance(id));
+    }
+
+    bank.setHistory(nullptr);
+    bank.deposit(a, Money(1.0));
+    REQUIRE(history.forAccount(a, 100).size() == 6);
+    std::filesystem::remove(testFile);
+}
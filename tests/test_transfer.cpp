@@ -0,0 +1,155 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "concurrent_bank.h"
+#include "journal_persistence.h"
+#include "json_persistence.h"
+#include <filesystem>
+#include <limits>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Bank transfer moves money atomically", "[transfer]") {
+    std::string testFile = "test_transfer1.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+
+    int alice = bank.createAccount("Alice", "11111111111111", Money(100.0));
+    int bob = bank.createAccount("Bob", "22222222222222", Money(10.0));
+
+    bank.transfer(alice, bob, Money(40.0));
+    REQUIRE(bank.getBalance(alice) == Money(60.0));
+    REQUIRE(bank.getBalance(bob) == Money(50.0));
+    REQUIRE(bank.getAccount(alice).getLastOperationType() == "Transfer Out");
+    REQUIRE(bank.getAccount(bob).getLastOperationType() == "Transfer In");
+
+    REQUIRE_THROWS_AS(bank.transfer(alice, bob, Money(1000.0)), std::runtime_error);
+    REQUIRE_THROWS_AS(bank.transfer(alice, alice, Money(1.0)), std::invalid_argument);
+    REQUIRE_THROWS_AS(bank.transfer(alice, bob, Money(-5.0)), std::invalid_argument);
+    REQUIRE_THROWS_AS(bank.transfer(alice, 999, Money(1.0)), std::runtime_error);
+    REQUIRE(bank.getBalance(alice) == Money(60.0));
+    REQUIRE(bank.getBalance(bob) == Money(50.0));
+}
+
+TEST_CASE("Bank transferMany is all or nothing", "[transfer]") {
+    std::string testFile = "test_transfer2.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    Bank bank(persistence);
+
+    int a = bank.createAccount("A", "1", Money(10.0));
+    int b = bank.createAccount("B", "2", Money(0.0));
+    int c = bank.createAccount("C", "3", Money(0.0));
+
+    // b can only pay c because a paid b earlier in the same batch.
+    bank.transferMany({{a, b, Money(10.0)}, {b, c, Money(7.0)}});
+    REQUIRE(bank.getBalance(a) == Money(0.0));
+    REQUIRE(bank.getBalance(b) == Money(3.0));
+    REQUIRE(bank.getBalance(c) == Money(7.0));
+
+    REQUIRE_THROWS_AS(bank.transferMany({{c, a, Money(5.0)}, {b, a, Money(4.0)}}), std::runtime_error);
+    REQUIRE(bank.getBalance(a) == Money(0.0));
+    REQUIRE(bank.getBalance(b) == Money(3.0));
+    REQUIRE(bank.getBalance(c) == Money(7.0));
+}
+
+TEST_CASE("Transfers survive a journal replay", "[transfer]") {
+    std::string snapshotFile = "test_transfer3.json";
+    std::string journalFile = "test_transfer3.journal";
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+
+    int a = 0;
+    int b = 0;
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile, 1);
+        Bank bank(persistence);
+        a = bank.createAccount("A", "1", Money(10.0));
+        b = bank.createAccount("B", "2", Money(0.0));
+        bank.transfer(a, b, Money(4.0));
+        bank.transferMany({{a, b, Money(3.0)}, {b, a, Money(1.0)}});
+    }
+
+    {
+        JsonPersistence snapshot(snapshotFile);
+        JournalPersistence persistence(snapshot, journalFile);
+        Bank bank(persistence);
+        REQUIRE(bank.getBalance(a) == Money(4.0));
+        REQUIRE(bank.getBalance(b) == Money(6.0));
+        REQUIRE(bank.getAccount(a).getLastOperationType() == "Transfer In");
+    }
+
+    // A batch torn by a crash replays as a whole or not at all.
+    std::filesystem::resize_file(journalFile, std::filesystem::file_size(journalFile) - 3);
+    JsonPersistence snapshot(snapshotFile);
+    JournalPersistence persistence(snapshot, journalFile);
+    Bank bank(persistence);
+    REQUIRE(bank.getBalance(a) == Money(6.0));
+    REQUIRE(bank.getBalance(b) == Money(4.0));
+
+    std::filesystem::remove(snapshotFile);
+    std::filesystem::remove(journalFile);
+}
+
+TEST_CASE("Bank transferMany changes nothing when its record cannot be written", "[transfer]") {
+    struct FailingTransfers : IPersistence {
+        void save(const std::unordered_map<int, Account>&) override {}
+        std::unordered_map<int, Account> load() override { return {}; }
+        void recordTransfers(const std::vector<TransferRecord>&, Timestamp) override {
+            throw std::runtime_error("Journal write failed");
+        }
+    } persistence;
+    Bank bank(persistence);
+    int a = bank.createAccount("A", "1", Money(10.0));
+    int b = bank.createAccount("B", "2", Money(0.0));
+
+    REQUIRE_THROWS(bank.transferMany({{a, b, Money(4.0)}, {b, a, Money(1.0)}}));
+    REQUIRE(bank.getBalance(a) == Money(10.0));
+    REQUIRE(bank.getBalance(b) == Money(0.0));
+    REQUIRE(bank.getAccount(b).lastOperationType() == OperationType::None);
+}
+
+TEST_CASE("ConcurrentBank opposite-direction transfers neither deadlock nor leak money", "[transfer]") {
+    std::string testFile = "test_transfer4.json";
+    std::filesystem::remove(testFile);
+    JsonPersistence persistence(testFile);
+    ConcurrentBank bank(persistence, 4);
+
+    std::vector<int> ids;
+    for (int i = 0; i < 8; ++i)
+        ids.push_back(bank.createAccount("P", "card", Money(1000.0)));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 5000; ++i) {
+                int from = ids[(t + i) % ids.size()];
+                int to = ids[(t + 3 * i + 1) % ids.size()];
+                try {
+                    if (i % 4 == 0)
+                        bank.transferMany({{from, to, Money(1.0)}, {to, from, Money(2.0)}});
+                    else
+                        bank.transfer(from, to, Money(1.0));
+                } catch (const std::exception&) {
+                    // Same-account picks and empty accounts are expected.
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    Money total;
+    for (int id : ids)
+        total += bank.getBalance(id);
+    REQUIRE(total == Money(8000.0));
+}
+
+TEST_CASE("Transfer that would overflow the target changes nothing", "[transfer]") {
+    Account from(1, Money(10.0));
+    Account to(2, Money::fromMinorUnits(std::numeric_limits<std::int64_t>::max()));
+    REQUIRE_THROWS_AS(from.transferTo(to, Money(1.0)), std::overflow_error);
+    REQUIRE(from.balance() == Money(10.0));
+    REQUIRE(to.balance() == Money::fromMinorUnits(std::numeric_limits<std::int64_t>::max()));
+}
@@ -0,0 +1,159 @@
+#include <catch2/catch_test_macros.hpp>
+#include "bank.h"
+#include "concurrent_bank.h"
+#include "memory_persistence.h"
+#include "workload.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+namespace {
+
+bool sameOperations(const Workload& a, const Workload& b) {
+    if (a.streams.size() != b.streams.size())
+        return false;
+    for (std::size_t t = 0; t < a.streams.size(); ++t) {
+        if (!std::equal(a.streams[t].begin(), a.streams[t].end(), b.streams[t].begin(), b.streams[t].end(),
+                        [](const WorkloadOperation& x, const WorkloadOperation& y) {
+                            return x.op == y.op && x.account == y.account && x.card == y.card &&
+                                   x.amount == y.amount;
+                        }))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Workload generation is deterministic and follows the mix", "[workload]") {
+    WorkloadOptions options;
+    options.accounts = 500;
+    options.operations = 2000;
+    options.threads = 3;
+    options.mix = {0, 0, 1, 0, 1};
+
+    Workload a = generateWorkload(options);
+    Workload b = generateWorkload(options);
+    REQUIRE(a.population.size() == 500);
+    REQUIRE(a.streams.size() == 3);
+    REQUIRE(a.operationCount() == 6000);
+    REQUIRE(a.owners == b.owners);
+    REQUIRE(sameOperations(a, b));
+    // Some owners hold several accounts.
+    REQUIRE(a.owners.size() < a.population.size());
+
+    std::size_t deposits = 0;
+    for (const auto& stream : a.streams) {
+        for (const WorkloadOperation& op : stream) {
+            REQUIRE((op.op == WorkloadOp::Deposit || op.op == WorkloadOp::Lookup));
+            REQUIRE(op.account < a.population.size());
+            deposits += op.op == WorkloadOp::Deposit ? 1 : 0;
+        }
+    }
+    REQUIRE(deposits > 2500);
+    REQUIRE(deposits < 3500);
+
+    options.seed = 2;
+    REQUIRE_FALSE(sameOperations(a, generateWorkload(options)));
+    REQUIRE(cardText(42) == "00000000000042");
+}
+
+TEST_CASE("Zipf keys concentrate on a few hot accounts", "[workload]") {
+    WorkloadOptions options;
+    options.accounts = 10000;
+    options.operations = 20000;
+    options.mix = {0, 0, 0, 0, 1};
+    options.keys = KeyDistribution::Zipf;
+
+    Workload workload = generateWorkload(options);
+    std::map<std::uint32_t, std::size_t> hits;
+    for (const WorkloadOperation& op : workload.streams[0])
+        ++hits[op.account];
+    std::vector<std::size_t> counts;
+    for (const auto& [account, count] : hits)
+        counts.push_back(count);
+    std::sort(counts.rbegin(), counts.rend());
+    std::size_t top = 0;
+    for (std::size_t i = 0; i < 10; ++i)
+        top += counts[i];
+    // Uniform keys would give the ten hottest accounts well under 1%.
+    REQUIRE(top > 20000 / 5);
+}
+
+TEST_CASE("Workload traces round-trip and reject bad records", "[workload]") {
+    std::string traceFile = "test_workload.trace";
+    WorkloadOptions options;
+    options.accounts = 50;
+    options.operations = 300;
+    options.threads = 2;
+    Workload workload = generateWorkload(options);
+    writeTrace(workload, traceFile);
+
+    Workload replayed = readTrace(traceFile);
+    REQUIRE(replayed.owners == workload.owners);
+    REQUIRE(replayed.population.size() == workload.population.size());
+    REQUIRE(replayed.population[7].card == workload.population[7].card);
+    REQUIRE(replayed.population[7].balance == workload.population[7].balance);
+    REQUIRE(sameOperations(replayed, workload));
+
+    {
+        std::ofstream file(traceFile, std::ios::trunc);
+        file << "owner,Ann Smith\n"
+             << "account,0,00000000000001,10.00\n"
+             << "0,deposit,3,1.00,\n";
+    }
+    REQUIRE_THROWS_WITH(readTrace(traceFile), "Trace line 3: unknown account 3");
+    std::filesystem::remove(traceFile);
+}
+
+TEST_CASE("Workload runs against a bank and counts failures", "[workload]") {
+    Workload workload;
+    workload.owners = {"Ann Smith", "Bo Chen"};
+    workload.population = {{0, 11111111111111, Money(100.0)}, {1, 22222222222222, Money(5.0)}};
+    workload.streams = {{
+        {WorkloadOp::Deposit, 0, 0, Money(10.0)},
+        {WorkloadOp::Withdraw, 1, 0, Money(50.0)},  // overdraft
+        {WorkloadOp::Lookup, 1, 0, Money()},
+        {WorkloadOp::Delete, 1, 0, Money()},
+        {WorkloadOp::Delete, 1, 0, Money()},        // already gone
+        {WorkloadOp::Create, 1, 33333333333333, Money(1.0)},
+    }};
+
+    NullPersistence persistence;
+    Bank bank(persistence);
+    int existing = bank.createAccount("Zed", "card", Money(1.0));
+    std::vector<IBank*> banks{&bank};
+    WorkloadReport report = runWorkload(workload, banks);
+
+    REQUIRE(report.operations() == 6);
+    REQUIRE(report.failed[static_cast<std::size_t>(WorkloadOp::Withdraw)] == 1);
+    REQUIRE(report.failed[static_cast<std::size_t>(WorkloadOp::Delete)] == 1);
+    REQUIRE(report.failed[static_cast<std::size_t>(WorkloadOp::Deposit)] == 0);
+    REQUIRE(bank.accountCount() == 3);
+    // Population positions map to the IDs the bank handed out.
+    REQUIRE(bank.getBalance(existing + 1) == Money(110.0));
+    REQUIRE(bank.findByCard("33333333333333").size() == 1);
+    REQUIRE_THROWS(runWorkload(workload, {}));
+}
+
+TEST_CASE("Workload streams run in parallel on a shared bank", "[workload]") {
+    WorkloadOptions options;
+    options.accounts = 1000;
+    options.operations = 5000;
+    options.threads = 4;
+    options.mix = {1, 0, 5, 0, 4};
+    Workload workload = generateWorkload(options);
+
+    NullPersistence persistence;
+    ConcurrentBank bank(persistence);
+    std::vector<IBank*> banks(options.threads, &bank);
+    WorkloadReport report = runWorkload(workload, banks);
+
+    REQUIRE(report.operations() == 20000);
+    REQUIRE(report.throughput() > 0);
+    std::size_t creates = report.latency[static_cast<std::size_t>(WorkloadOp::Create)].count;
+    REQUIRE(bank.accountCount() == 1000 + creates);
+    for (std::uint64_t failed : report.failed)
+        REQUIRE(failed == 0);
+}